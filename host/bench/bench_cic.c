@@ -0,0 +1,103 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "cic.h"
+
+// LDR acquisition filter: cost per ADC sample of the CIC decimator at the
+// firmware's 20 kHz -> 10 Hz setting, the noise it removes compared with the
+// previous 10-sample block mean, and its step response.
+
+#define SAMPLE_HZ       20000
+#define OUTPUT_HZ       10
+#define DECIMATION      (SAMPLE_HZ / OUTPUT_HZ)
+#define INPUTS          (SAMPLE_HZ * 60)    // One minute of conversions
+#define FRAME           256
+#define LEVEL           2000
+#define NOISE           25                  // Peak counts, triangular like the simulator
+#define OLD_BLOCK       10
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint16_t noisy(int level) {
+    int noise = rand() % (NOISE + 1) + rand() % (NOISE + 1) - NOISE;
+    return (uint16_t)(level + noise);
+}
+
+static double std_dev(const double *v, size_t n) {
+    double mean = 0, var = 0;
+    for (size_t i = 0; i < n; i++) {
+        mean += v[i];
+    }
+    mean /= n;
+    for (size_t i = 0; i < n; i++) {
+        var += (v[i] - mean) * (v[i] - mean);
+    }
+    return sqrt(var / n);
+}
+
+int main(void) {
+    static uint16_t in[INPUTS];
+    static uint16_t out[INPUTS / DECIMATION];
+    static double raw_d[INPUTS];
+    static double block_d[INPUTS / OLD_BLOCK];
+    static double cic_d[INPUTS / DECIMATION];
+    srand(1);
+    for (size_t i = 0; i < INPUTS; i++) {
+        in[i] = noisy(LEVEL);
+        raw_d[i] = in[i];
+    }
+
+    // Throughput, fed a DMA frame at a time
+    cic_t cic;
+    cic_init(&cic, DECIMATION);
+    size_t outputs = 0;
+    double t0 = now_ns();
+    for (size_t i = 0; i < INPUTS; i += FRAME) {
+        size_t n = INPUTS - i < FRAME ? INPUTS - i : FRAME;
+        outputs += cic_process(&cic, &in[i], n, &out[outputs], sizeof(out) / sizeof(out[0]) - outputs);
+    }
+    double t1 = now_ns();
+    printf("cic R=%d order %d: %.2f ns per input, %zu outputs from %d inputs (%.3f%% of a core at %d Hz)\n",
+           DECIMATION, CIC_ORDER, (t1 - t0) / INPUTS, outputs, INPUTS,
+           (t1 - t0) / INPUTS * SAMPLE_HZ / 1e7, SAMPLE_HZ);
+
+    // Noise: skip the start-up outputs, which still see the zero state
+    size_t settled = outputs - CIC_ORDER;
+    for (size_t i = 0; i < settled; i++) {
+        cic_d[i] = out[i + CIC_ORDER];
+    }
+    size_t blocks = INPUTS / OLD_BLOCK;
+    for (size_t b = 0; b < blocks; b++) {
+        int sum = 0;
+        for (int i = 0; i < OLD_BLOCK; i++) {
+            sum += in[b * OLD_BLOCK + i];
+        }
+        block_d[b] = (sum + OLD_BLOCK / 2) / OLD_BLOCK;
+    }
+    printf("noise std dev (counts): raw %.2f, %d-sample mean %.2f, cic %.2f\n",
+           std_dev(raw_d, INPUTS), OLD_BLOCK, std_dev(block_d, blocks), std_dev(cic_d, settled));
+
+    // Step response: outputs until within one count of a 1000-count step
+    cic_init(&cic, DECIMATION);
+    static uint16_t step[DECIMATION * 8];
+    uint16_t step_out[8];
+    for (size_t i = 0; i < sizeof(step) / sizeof(step[0]); i++) {
+        step[i] = i < DECIMATION * 2 ? LEVEL : LEVEL + 1000;
+    }
+    size_t n = cic_process(&cic, step, sizeof(step) / sizeof(step[0]), step_out, 8);
+    printf("step %d -> %d:", LEVEL, LEVEL + 1000);
+    int settle = -1;
+    for (size_t i = 0; i < n; i++) {
+        printf(" %u", step_out[i]);
+        if (settle < 0 && i >= 2 && abs(step_out[i] - (LEVEL + 1000)) <= 1) {
+            settle = (int)i - 2;
+        }
+    }
+    printf("\nsettles %d outputs (%d ms) after the step\n", settle + 1, (settle + 1) * 1000 / OUTPUT_HZ);
+    return 0;
+}
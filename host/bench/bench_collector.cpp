@@ -0,0 +1,162 @@
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include "collector.h"
+#include "desk_json.h"
+#include "fake_desk.h"
+#include "series_store.h"
+
+// Fleet collector: /data parse and store append cost, then sustained
+// scrape throughput against simulated desks on loopback with one
+// connection per scrape, keep-alive, and keep-alive with pipelining. The
+// desks add a sample per request, so every scrape stores exactly the
+// samples it has not seen and any lost or duplicated one shows as a gap.
+//
+// usage: bench_collector
+
+#define DESKS           100
+#define RUN_MS          2000
+#define PARSE_ITERS     200000
+
+using namespace collector;
+
+static int failures;
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void bench_parse() {
+    FakeDeskOptions fo;
+    FakeDesks desks(fo);
+    std::string full = desks.render(0, 0);
+    std::string tail = desks.render(0, 59);  // What a steady-state scrape carries
+
+    DeskData data;
+    check(parse_desk_data(full, data) && data.history_count == 60 && data.first_seq == 1 &&
+          data.seq == 60 && data.temp_history.size() == 60, "full document parses");
+    check(parse_desk_data(tail, data) && data.history_count == 1 && data.first_seq == 60,
+          "incremental document parses");
+    check(!parse_desk_data(full.substr(0, full.size() - 2), data), "truncated document rejected");
+
+    const std::string *docs[] = {&full, &tail};
+    for (const std::string *doc : docs) {
+        double t0 = now_ns();
+        size_t ok = 0;
+        for (int i = 0; i < PARSE_ITERS; i++) {
+            ok += parse_desk_data(*doc, data);
+        }
+        double ns = (now_ns() - t0) / PARSE_ITERS;
+        check(ok == PARSE_ITERS, "parse in loop");
+        printf("parse %4zu-byte /data (%2u samples): %6.0f ns, %5.0f MB/s\n",
+               doc->size(), data.history_count, ns, doc->size() * 1e3 / ns);
+    }
+
+    SeriesStore store(1, 3600);
+    parse_desk_data(tail, data);
+    double t0 = now_ns();
+    for (int i = 0; i < PARSE_ITERS; i++) {
+        data.seq++;
+        data.first_seq++;
+        store.append(0, data, 1000000 + i);
+    }
+    printf("store append, 1 new sample: %.1f ns; %zu bytes for 3600 rows\n",
+           (now_ns() - t0) / PARSE_ITERS, store.memory_bytes());
+    check(store.count(0) == 3600 && store.next_row(0) == PARSE_ITERS, "store keeps the newest rows");
+}
+
+static void run_scrape(const char *label, bool keep_alive, int pipeline) {
+    FakeDeskOptions fo;
+    fo.count = DESKS;
+    fo.tick_per_request = true;
+    FakeDesks desks(fo);
+    if (!desks.start()) {
+        failures++;
+        return;
+    }
+    std::atomic<bool> stop{false};
+    std::thread server([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            desks.poll(10);
+        }
+    });
+
+    std::vector<DeskConfig> configs;
+    for (size_t i = 0; i < DESKS; i++) {
+        configs.push_back(DeskConfig{"desk" + std::to_string(i), "127.0.0.1", desks.port(i)});
+    }
+    CollectorOptions options;
+    options.interval_ms = 0;
+    options.keep_alive = keep_alive;
+    options.pipeline = pipeline;
+    options.capacity = 1 << 16;
+    Collector c(configs, options);
+    check(c.start(), "collector starts");
+
+    double t0 = now_ns();
+    double cpu0 = thread_cpu_ns();
+    while (now_ns() - t0 < RUN_MS * 1e6) {
+        c.poll(10);
+    }
+    double wall_s = (now_ns() - t0) / 1e9;
+    double cpu_s = (thread_cpu_ns() - cpu0) / 1e9;
+    stop = true;
+    server.join();
+
+    uint64_t bytes = 0, connects = 0, samples = 0;
+    size_t gaps = 0, idle = 0;
+    for (size_t i = 0; i < DESKS; i++) {
+        const DeskStats &s = c.stats(i);
+        bytes += s.bytes_in;
+        connects += s.connects;
+        samples += s.samples;
+        idle += s.scrapes == 0;
+        const SeriesStore &store = c.store();
+        Sample prev{}, cur{};
+        for (uint64_t r = store.first_row(i); r < store.next_row(i); r++) {
+            store.get(i, r, &cur);
+            if (r > store.first_row(i) && (cur.seq != prev.seq + 1 || cur.epoch != prev.epoch)) {
+                gaps++;
+            }
+            prev = cur;
+        }
+    }
+    uint64_t scrapes = c.total_scrapes();
+    printf("%-22s %7.0f desks/s wall, %7.0f per collector CPU s, %4.0f B/scrape, %llu connects\n", label,
+           scrapes / wall_s, scrapes / cpu_s, scrapes ? static_cast<double>(bytes) / scrapes : 0.0,
+           static_cast<unsigned long long>(connects));
+    check(c.total_errors() == 0, "no scrape errors");
+    check(idle == 0, "every desk scraped");
+    check(gaps == 0, "stored series have no gaps");
+    // Each desk starts with a full 60-sample ring; every request adds one.
+    // Pipelined requests repeat a since and get overlap the store drops.
+    check(samples == scrapes + 59 * DESKS, "one new sample stored per scrape");
+}
+
+int main() {
+    bench_parse();
+    printf("%d desks, %d ms per run, collector and desks on separate threads\n", DESKS, RUN_MS);
+    run_scrape("connection per scrape", false, 1);
+    run_scrape("keep-alive", true, 1);
+    run_scrape("keep-alive, pipeline 4", true, 4);
+    printf(failures == 0 ? "PASS\n" : "%d checks FAILED\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dht22.h"
+
+// Runs dht22_decode() against recorded DHT22 waveforms and times it.
+//
+// A fixture is a text file of "level:microseconds" pulses, whitespace
+// separated, as logged by the firmware (DEBUG level) when a capture fails to
+// decode. A "# expect:" line gives either the five frame bytes in hex or the
+// expected error name. Other "#" lines are comments.
+//
+// usage: bench_dht22 [fixture...]   (default: every file in DHT22_FIXTURE_DIR)
+
+#define DECODE_ITERATIONS   200000
+
+typedef struct {
+    dht22_pulse_t pulses[DHT22_MAX_PULSES];
+    size_t count;
+    char expect[64];
+} fixture_t;
+
+static bool load_fixture(const char *path, fixture_t *fx) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    memset(fx, 0, sizeof(*fx));
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') {
+            if (strncmp(line, "# expect:", 9) == 0) {
+                snprintf(fx->expect, sizeof(fx->expect), "%.63s", line + 10);
+                fx->expect[strcspn(fx->expect, "\r\n")] = '\0';
+            }
+            continue;
+        }
+        for (char *tok = strtok(line, " \t\r\n"); tok != NULL; tok = strtok(NULL, " \t\r\n")) {
+            unsigned level, us;
+            if (sscanf(tok, "%u:%u", &level, &us) != 2 || fx->count == DHT22_MAX_PULSES) {
+                fclose(f);
+                return false;
+            }
+            fx->pulses[fx->count++] = (dht22_pulse_t){ .duration_us = (uint16_t)us, .level = (uint8_t)level };
+        }
+    }
+    fclose(f);
+    return fx->expect[0] != '\0';
+}
+
+static bool run_fixture(const char *path) {
+    fixture_t fx;
+    if (!load_fixture(path, &fx)) {
+        printf("%-28s cannot parse\n", path);
+        return false;
+    }
+    uint8_t data[5];
+    esp_err_t err = dht22_decode(fx.pulses, fx.count, data);
+    char got[64];
+    if (err == ESP_OK) {
+        snprintf(got, sizeof(got), "%02x %02x %02x %02x %02x", data[0], data[1], data[2], data[3], data[4]);
+    } else {
+        snprintf(got, sizeof(got), "%s", esp_err_to_name(err));
+    }
+    bool ok = strcmp(got, fx.expect) == 0;
+    const char *name = strrchr(path, '/') != NULL ? strrchr(path, '/') + 1 : path;
+    printf("%-24s %-4s %s\n", name, ok ? "ok" : "FAIL", got);
+    if (!ok) {
+        printf("%-24s      expected %s\n", "", fx.expect);
+    }
+    return ok;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+int main(int argc, char **argv) {
+    char *paths[64];
+    int count = 0;
+    if (argc > 1) {
+        for (int i = 1; i < argc && count < 64; i++) {
+            paths[count++] = strdup(argv[i]);
+        }
+    } else {
+        DIR *dir = opendir(DHT22_FIXTURE_DIR);
+        if (dir == NULL) {
+            printf("cannot open %s\n", DHT22_FIXTURE_DIR);
+            return 1;
+        }
+        struct dirent *de;
+        while ((de = readdir(dir)) != NULL && count < 64) {
+            if (strstr(de->d_name, ".txt") != NULL) {
+                char path[1024];
+                snprintf(path, sizeof(path), "%s/%s", DHT22_FIXTURE_DIR, de->d_name);
+                paths[count++] = strdup(path);
+            }
+        }
+        closedir(dir);
+        qsort(paths, count, sizeof(paths[0]), compare_names);
+    }
+
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        failures += run_fixture(paths[i]) ? 0 : 1;
+    }
+
+    // Decode cost for a full frame, the only CPU time a read now needs
+    // besides the start pulse
+    fixture_t fx;
+    if (count > 0 && load_fixture(paths[0], &fx)) {
+        uint8_t data[5];
+        unsigned sink = 0;
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int i = 0; i < DECODE_ITERATIONS; i++) {
+            sink += dht22_decode(fx.pulses, fx.count, data) + data[4];
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / DECODE_ITERATIONS;
+        printf("decode: %.0f ns per frame (%u)\n", ns, sink & 1);
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(paths[i]);
+    }
+    printf(failures == 0 ? "PASS\n" : "%d fixtures FAILED\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "envstats.h"
+
+// Feeds the environmental statistics a synthetic channel (a random walk
+// with sensor noise, single-sample spikes and 3-minute ramps) with rolling
+// windows from one minute to 16 hours. Each window is checked against
+// plain recomputation: min/max against a rescan of the window at
+// checkpoints, the mean and std against a double-precision weighted
+// reference, and the flags against the injected events. Then it times a
+// sample for each window, next to rescanning the window every sample, to
+// show the cost stays flat as the window grows.
+//
+// usage: bench_envstats [samples]
+
+#define SPIKE_EVERY     7919    // Samples between injected spikes (prime, so they drift through the day)
+#define SPIKE_DECI      60
+#define RAMP_EVERY      50021
+#define RAMP_LEN        180
+#define RAMP_SETTLE     512     // Samples after a ramp before a spike must stand out again
+#define CHECKPOINTS     1000
+#define NAIVE_BUDGET    200000000.0     // Window slots rescanned by the naive timing run
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } \
+    } while (0)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const envstats_config_t base_config = {
+    .ewma_shift = 6,
+    .z_limit_deci = 50,
+    .std_floor_deci = 2,
+    .roc_limit_deci = 30,
+};
+
+typedef struct {
+    uint32_t rng;
+    int32_t level;
+} signal_t;
+
+static uint32_t sig_rand(signal_t *s) {
+    s->rng = s->rng * 1664525u + 1013904223u;
+    return s->rng >> 8;
+}
+
+// Sample n; *spike says whether it is an injected spike
+static int16_t sig_next(signal_t *s, uint32_t n, bool *spike) {
+    s->level += (int32_t)(sig_rand(s) % 3) - 1;
+    s->level = s->level < 150 ? 150 : s->level > 350 ? 350 : s->level;
+    int32_t v = s->level + (int32_t)(sig_rand(s) % 5) - 2;
+    if (n % RAMP_EVERY >= RAMP_EVERY - RAMP_LEN) {
+        v += (int32_t)(n % RAMP_EVERY - (RAMP_EVERY - RAMP_LEN));  // 1 deci per sample
+    }
+    *spike = n > 0 && n % SPIKE_EVERY == 0;
+    if (*spike) {
+        v += sig_rand(s) % 2 ? SPIKE_DECI : -SPIKE_DECI;
+    }
+    return (int16_t)v;
+}
+
+static void verify(uint16_t window, uint32_t samples) {
+    envstats_config_t config = base_config;
+    config.window = window;
+    envstats_slot_t *slots = malloc(ENVSTATS_SLOTS(window) * sizeof(envstats_slot_t));
+    int16_t *values = malloc(samples * sizeof(int16_t));
+    envstats_t st;
+    envstats_init(&st, &config, slots);
+
+    signal_t sig = { .rng = 1 };
+    double a = 1.0 / (1 << config.ewma_shift);
+    double mean = 0, var = 0;
+    uint32_t spikes = 0, caught = 0, false_spikes = 0, ramps_seen = 0;
+    uint32_t bad_minmax = 0, bad_mean = 0, bad_std = 0;
+    for (uint32_t n = 0; n < samples; n++) {
+        bool spike;
+        int16_t v = sig_next(&sig, n, &spike);
+        values[n] = v;
+        uint8_t flags = envstats_add(&st, v);
+
+        if (n == 0) {
+            mean = v;
+        } else {
+            double diff = v - mean;
+            mean += a * diff;
+            var = (1 - a) * (var + a * diff * diff);
+        }
+        if (fabs(envstats_mean(&st) - mean) > 1.0) {
+            bad_mean++;
+        }
+        if (fabs(envstats_std(&st) - sqrt(var)) > 1.0 + 0.01 * sqrt(var)) {
+            bad_std++;
+        }
+        // A spike on a ramp, or while the statistics catch up after one,
+        // stands out less and is not required to be flagged
+        uint32_t since_ramp = (n + RAMP_LEN) % RAMP_EVERY;
+        bool quiet = since_ramp >= RAMP_LEN + RAMP_SETTLE || n < RAMP_EVERY - RAMP_LEN;
+        if (n >= (1u << config.ewma_shift) && quiet) {
+            spikes += spike;
+            caught += spike && (flags & ENVSTATS_SPIKE);
+        }
+        false_spikes += !spike && (flags & ENVSTATS_SPIKE);
+        ramps_seen += (flags & ENVSTATS_RISING) && n % RAMP_EVERY == RAMP_EVERY - 1;
+
+        if (n % (samples / CHECKPOINTS) == 0 || n == samples - 1) {
+            uint32_t from = n + 1 >= window ? n + 1 - window : 0;
+            int16_t lo = values[from], hi = values[from];
+            for (uint32_t i = from; i <= n; i++) {
+                lo = values[i] < lo ? values[i] : lo;
+                hi = values[i] > hi ? values[i] : hi;
+            }
+            bad_minmax += envstats_min(&st) != lo || envstats_max(&st) != hi;
+        }
+    }
+    CHECK(bad_minmax == 0, "window %u: %u min/max checkpoints differ from a rescan", window, bad_minmax);
+    CHECK(bad_mean == 0 && bad_std == 0, "window %u: mean off %u times, std off %u times", window, bad_mean,
+          bad_std);
+    CHECK(caught == spikes, "window %u: %u of %u spikes flagged", window, caught, spikes);
+    CHECK(ramps_seen == samples / RAMP_EVERY, "window %u: %u of %u ramps flagged", window, ramps_seen,
+          samples / RAMP_EVERY);
+    if (window == 600) {
+        printf("spikes on a quiet signal flagged %u/%u, other spike flags %u (%.4f%% of samples), ramps flagged %u/%u\n", caught,
+               spikes, false_spikes, 100.0 * false_spikes / samples, ramps_seen, samples / RAMP_EVERY);
+    }
+    free(values);
+    free(slots);
+}
+
+static double time_stream(uint16_t window, uint32_t samples, const int16_t *values) {
+    envstats_config_t config = base_config;
+    config.window = window;
+    envstats_slot_t *slots = malloc(ENVSTATS_SLOTS(window) * sizeof(envstats_slot_t));
+    envstats_t st;
+    envstats_init(&st, &config, slots);
+    uint32_t flagged = 0;
+    double start = now_s();
+    for (uint32_t n = 0; n < samples; n++) {
+        flagged += envstats_add(&st, values[n]) != 0;
+    }
+    double elapsed = now_s() - start;
+    free(slots);
+    return flagged > samples ? 0 : elapsed * 1e9 / samples;
+}
+
+// Min and max by rescanning the window on every sample
+static double time_rescan(uint16_t window, uint32_t samples, const int16_t *values) {
+    volatile int32_t sink = 0;
+    double start = now_s();
+    for (uint32_t n = window; n < window + samples; n++) {
+        int16_t lo = values[n], hi = values[n];
+        for (uint32_t i = n + 1 - window; i < n; i++) {
+            lo = values[i] < lo ? values[i] : lo;
+            hi = values[i] > hi ? values[i] : hi;
+        }
+        sink += lo + hi;
+    }
+    return (now_s() - start) * 1e9 / samples;
+}
+
+int main(int argc, char **argv) {
+    uint32_t samples = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 5000000;
+    static const uint16_t windows[] = { 60, 600, 6000, 60000 };
+    if (samples < 2 * windows[3]) {
+        samples = 2 * windows[3];
+    }
+
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        verify(windows[w], samples < 1000000 ? samples : 1000000);
+    }
+
+    int16_t *values = malloc(samples * sizeof(int16_t));
+    signal_t sig = { .rng = 1 };
+    for (uint32_t n = 0; n < samples; n++) {
+        bool spike;
+        values[n] = sig_next(&sig, n, &spike);
+    }
+    printf("%8s %12s %14s\n", "window", "ns/sample", "rescan ns");
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        uint32_t rescan = (uint32_t)(NAIVE_BUDGET / windows[w]);
+        if (rescan > samples - windows[w]) {
+            rescan = samples - windows[w];
+        }
+        printf("%8u %12.2f %14.1f\n", windows[w], time_stream(windows[w], samples, values),
+               time_rescan(windows[w], rescan, values));
+    }
+    free(values);
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "fan.h"
+
+// Closed-loop run of the fan controller against a lumped thermal model of
+// the desk enclosure: a heat load that steps and drifts over four hours,
+// cooling that grows with fan duty, and a DHT22 read every 2 s with 0.1 °C
+// resolution and noise. Compares LEDC writes and duty reversals (hunting)
+// of the old curve, written on every reading, with the table controller in
+// curve and PI mode, and checks that both settle.
+//
+// usage: bench_fan
+
+#define SIM_SECONDS     (4 * 3600)
+#define PHYSICS_MS      100
+#define DHT_PERIOD_S    2
+#define AMBIENT_C       22.0
+#define HEAT_CAP        600.0       // J/K
+#define G_PASSIVE       0.9         // W/K with the fan off
+#define G_FAN           3.6         // Extra W/K at full duty
+#define NOISE_C         0.15        // Peak sensor noise
+
+typedef enum { MODE_OLD, MODE_CURVE, MODE_PI } run_mode_t;
+
+typedef struct {
+    const char *name;
+    unsigned writes;
+    unsigned reversals;
+    double t_max;
+    double abs_err_sum;     // |T - PI target| over the settled windows
+    unsigned err_samples;
+} result_t;
+
+static int failures;
+
+// Heat load in W: idle, a work session and a heavy stretch, with drift
+static double load_w(int s) {
+    double base = s < 3600 ? 4.0 : s < 7200 ? 9.0 : s < 10800 ? 13.0 : 6.0;
+    return base + 0.8 * sin(s / 700.0);
+}
+
+// True for the last 20 minutes of each load level, once the loop has settled
+static bool settled(int s) {
+    return s % 3600 >= 2400;
+}
+
+static void run(run_mode_t mode, result_t *r) {
+    fan_ctrl_t ctrl;
+    fan_config_t config = fan_config_default;
+    config.pi = mode == MODE_PI;
+    fan_ctrl_init(&ctrl, &config);
+
+    srand(7);
+    double t = AMBIENT_C;
+    int16_t reading = (int16_t)lround(t * 10);
+    uint8_t duty = 0;
+    int last_dir = 0;
+    r->t_max = t;
+    for (int s = 0; s < SIM_SECONDS; s++) {
+        for (int ms = 0; ms < 1000; ms += PHYSICS_MS) {
+            double g = G_PASSIVE + G_FAN * duty / 255.0;
+            t += (load_w(s) - g * (t - AMBIENT_C)) * PHYSICS_MS / 1000.0 / HEAT_CAP;
+        }
+        if (t > r->t_max) {
+            r->t_max = t;
+        }
+        bool new_reading = s % DHT_PERIOD_S == 0;
+        if (new_reading) {
+            double noise = ((double)rand() / RAND_MAX * 2.0 - 1.0) * NOISE_C;
+            reading = (int16_t)lround((t + noise) * 10);
+        }
+
+        uint8_t next;
+        if (mode == MODE_OLD) {
+            // Old firmware: curve straight from the reading, written every time
+            if (!new_reading) {
+                continue;
+            }
+            fan_config_t raw = fan_config_default;
+            next = fan_curve_duty(&raw, reading);
+            r->writes++;
+        } else {
+            next = fan_ctrl_update(&ctrl, reading, (int64_t)s * 1000000);
+            if (next != duty) {
+                r->writes++;
+            }
+        }
+        if (next != duty) {
+            int dir = next > duty ? 1 : -1;
+            if (last_dir != 0 && dir != last_dir) {
+                r->reversals++;
+            }
+            last_dir = dir;
+        }
+        duty = next;
+        if (settled(s)) {
+            r->abs_err_sum += fabs(t - config.target_deci / 10.0);
+            r->err_samples++;
+        }
+    }
+}
+
+int main(void) {
+    result_t results[] = {
+        [MODE_OLD] = { .name = "old curve, every read" },
+        [MODE_CURVE] = { .name = "table + hysteresis" },
+        [MODE_PI] = { .name = "PI to 26.0 C" },
+    };
+    for (int m = MODE_OLD; m <= MODE_PI; m++) {
+        run((run_mode_t)m, &results[m]);
+    }
+
+    printf("%d h of load steps, DHT22 every %d s (+-%.2f C noise):\n", SIM_SECONDS / 3600, DHT_PERIOD_S, NOISE_C);
+    printf("  %-22s %8s %10s %8s %14s\n", "controller", "writes", "reversals", "max C", "|T - 26 C|");
+    for (int m = MODE_OLD; m <= MODE_PI; m++) {
+        const result_t *r = &results[m];
+        printf("  %-22s %8u %10u %8.2f %12.2f C\n", r->name, r->writes, r->reversals, r->t_max,
+               r->abs_err_sum / r->err_samples);
+    }
+
+    // Table mode must write far less than the old firmware and not hunt
+    if (results[MODE_CURVE].writes * 10 > results[MODE_OLD].writes) {
+        printf("FAIL: table controller writes more than a tenth of the old count\n");
+        failures++;
+    }
+    if (results[MODE_CURVE].reversals * 4 > results[MODE_OLD].reversals) {
+        printf("FAIL: table controller still hunts\n");
+        failures++;
+    }
+    // PI must hold the target to within half a degree once settled
+    if (results[MODE_PI].abs_err_sum / results[MODE_PI].err_samples > 0.5) {
+        printf("FAIL: PI does not settle on the target\n");
+        failures++;
+    }
+    printf(failures == 0 ? "PASS\n" : "%d checks FAILED\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "flashlog.h"
+
+// Drives the flash log at full speed against the file-backed partition:
+// appends enough samples to wrap the log several times, then checks range
+// reads, remount after a "reboot", torn-record handling and sector wear.
+//
+// usage: bench_flashlog [samples] [image]
+
+#define IMAGE_SIZE      0x100000
+#define QUERY_COUNT     2000
+#define QUERY_SPAN      3600
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } \
+    } while (0)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void expected(uint32_t seq, int16_t values[HISTORY_CHANNELS], bool *motion) {
+    values[HISTORY_TEMP] = (int16_t)((seq * 7) % 600) - 100;
+    values[HISTORY_HUMID] = (int16_t)(seq % 1000);
+    values[HISTORY_LIGHT] = (int16_t)((seq * 13) % 1001);
+    *motion = seq % 3 == 0;
+}
+
+typedef struct {
+    uint32_t next;      // Next seq expected (0 = any)
+    uint32_t samples;
+    uint32_t gaps;
+    uint32_t mismatches;
+    uint16_t boot;
+} verify_t;
+
+static bool verify_sample(const flashlog_sample_t *s, void *ctx) {
+    verify_t *v = ctx;
+    int16_t values[HISTORY_CHANNELS];
+    bool motion;
+    expected(s->seq, values, &motion);
+    if (v->next != 0 && s->seq != v->next) {
+        v->gaps++;
+    }
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        if (s->values[c] != values[c]) {
+            v->mismatches++;
+        }
+    }
+    if (s->motion != motion) {
+        v->mismatches++;
+    }
+    v->next = s->seq + 1;
+    v->boot = s->boot;
+    v->samples++;
+    return true;
+}
+
+static void append(uint32_t first_seq, uint32_t count) {
+    for (uint32_t seq = first_seq; seq < first_seq + count; seq++) {
+        int16_t values[HISTORY_CHANNELS];
+        bool motion;
+        expected(seq, values, &motion);
+        flashlog_add(values, motion);
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t samples = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 2000000;
+    const char *image = argc > 2 ? argv[2] : "/tmp/bench_flashlog.bin";
+    unlink(image);
+    esp_partition_posix_set_image(image, IMAGE_SIZE);
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    // Fill: the log holds ~127k samples, so the default run wraps it ~16 times
+    if (flashlog_init(false) != ESP_OK) {
+        printf("FAIL: cannot mount %s\n", image);
+        return 1;
+    }
+    double t0 = now_s();
+    append(1, samples);
+    double t1 = now_s();
+    uint32_t first, last;
+    flashlog_range(&first, &last);
+    uint32_t flushed = samples / FLASHLOG_RECORD_SAMPLES * FLASHLOG_RECORD_SAMPLES;
+    printf("append: %u samples in %.2f s (%.0f samples/s), log holds %u..%u\n",
+           (unsigned)samples, t1 - t0, samples / (t1 - t0), (unsigned)first, (unsigned)last);
+    CHECK(last == flushed, "last seq %u, expected %u", (unsigned)last, (unsigned)flushed);
+
+    // Full scan
+    verify_t v = { .next = first };
+    t0 = now_s();
+    flashlog_read(0, UINT32_MAX, verify_sample, &v);
+    t1 = now_s();
+    printf("scan: %u samples in %.3f s (%.0f samples/s)\n",
+           (unsigned)v.samples, t1 - t0, v.samples / (t1 - t0));
+    CHECK(v.samples == last - first + 1, "scan returned %u samples, expected %u",
+          (unsigned)v.samples, (unsigned)(last - first + 1));
+    CHECK(v.gaps == 0 && v.mismatches == 0, "scan: %u gaps, %u mismatches",
+          (unsigned)v.gaps, (unsigned)v.mismatches);
+
+    // Random hour-long range queries
+    srand(1);
+    uint32_t bad = 0;
+    t0 = now_s();
+    for (int q = 0; q < QUERY_COUNT; q++) {
+        uint32_t from = first + (uint32_t)rand() % (last - first - QUERY_SPAN);
+        verify_t rv = { .next = from };
+        flashlog_read(from, from + QUERY_SPAN - 1, verify_sample, &rv);
+        if (rv.samples != QUERY_SPAN || rv.gaps != 0 || rv.mismatches != 0) {
+            bad++;
+        }
+    }
+    t1 = now_s();
+    printf("query: %d x %d-sample ranges, %.1f us each\n",
+           QUERY_COUNT, QUERY_SPAN, (t1 - t0) * 1e6 / QUERY_COUNT);
+    CHECK(bad == 0, "%u of %d range queries wrong", (unsigned)bad, QUERY_COUNT);
+
+    // Reboot: the unflushed batch is lost, numbering and boot id continue
+    flashlog_init(false);
+    uint32_t first2, last2;
+    flashlog_range(&first2, &last2);
+    CHECK(first2 == first && last2 == last, "remount range %u..%u, expected %u..%u",
+          (unsigned)first2, (unsigned)last2, (unsigned)first, (unsigned)last);
+    append(last + 1, FLASHLOG_RECORD_SAMPLES * 4);
+    verify_t bv = { .next = last + 1 };
+    flashlog_read(last + 1, UINT32_MAX, verify_sample, &bv);
+    CHECK(bv.samples == FLASHLOG_RECORD_SAMPLES * 4 && bv.gaps == 0 && bv.mismatches == 0 && bv.boot == 2,
+          "after remount: %u samples, boot %u", (unsigned)bv.samples, (unsigned)bv.boot);
+    flashlog_range(&first, &last);
+
+    // Torn record: clear a few bits in the middle of the log and remount
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, "history");
+    static const uint8_t zeros[8] = { 0 };
+    esp_partition_write(part, part->size / 2 + 3 * FLASHLOG_RECORD_SIZE + 40, zeros, sizeof(zeros));
+    flashlog_init(false);
+    flashlog_stats_t stats;
+    flashlog_get_stats(&stats);
+    verify_t cv = { .next = 0 };
+    flashlog_read(0, UINT32_MAX, verify_sample, &cv);
+    CHECK(stats.crc_errors == 1, "%u corrupt records found, expected 1", (unsigned)stats.crc_errors);
+    CHECK(cv.samples == last - first + 1 - FLASHLOG_RECORD_SAMPLES && cv.mismatches == 0 && cv.gaps == 1,
+          "corrupt record not skipped cleanly: %u samples, %u gaps", (unsigned)cv.samples, (unsigned)cv.gaps);
+
+    esp_partition_posix_stats_t flash;
+    esp_partition_posix_get_stats(&flash);
+    printf("flash: %.1f MiB written, %u sector erases (per sector %u..%u), %u bit-set violations\n",
+           flash.bytes_written / 1048576.0, (unsigned)flash.erases, (unsigned)flash.min_sector_erases,
+           (unsigned)flash.max_sector_erases, (unsigned)flash.bit_set_violations);
+    CHECK(flash.max_sector_erases - flash.min_sector_erases <= 1, "uneven wear");
+    CHECK(flash.bit_set_violations == 0, "log relies on overwriting programmed bits");
+
+    unlink(image);
+    printf(failures == 0 ? "PASS\n" : "%d checks FAILED\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "lcd.h"
+
+// Runs an hour of the session clock through the shadow-framebuffer LCD
+// driver against the simulated HD44780, checks after every frame that the
+// modelled screen matches what was drawn, and compares the I2C traffic with
+// the old driver (cursor move plus 16 characters, one transaction each).
+// A second pass injects I2C failures to check that the driver redraws.
+//
+// usage: bench_lcd
+
+#define FRAMES          3600
+#define LCD_ADDR        0x27
+
+// Previous driver, per session clock update: 17 controller bytes of 4 PCF
+// bytes, each its own I2C write
+#define OLD_TRANSACTIONS_PER_FRAME  17
+#define OLD_BYTES_PER_FRAME         (17 * 4)
+
+static int failures;
+
+static void render(uint32_t seconds, char line[17]) {
+    snprintf(line, 17, "    %02" PRIu32 ":%02" PRIu32 ":%02" PRIu32 "    ",
+             (seconds / 3600) % 100, (seconds % 3600) / 60, seconds % 60);
+}
+
+// Compare the modelled screen with the expected rows
+static bool screen_matches(const char *row0, const char *row1) {
+    char rows[2][17];
+    char want[2][17];
+    hal_sim_lcd_read(rows);
+    snprintf(want[0], sizeof(want[0]), "%-16.16s", row0);
+    snprintf(want[1], sizeof(want[1]), "%-16.16s", row1);
+    return memcmp(rows, want, sizeof(rows)) == 0;
+}
+
+static void run(uint32_t frames, bool check_every_frame) {
+    char line[17];
+    lcd_write_line(0, "Session Time:");
+    for (uint32_t s = 0; s < frames; s++) {
+        render(s, line);
+        lcd_write_line(1, line);
+        esp_err_t err = lcd_flush();
+        if (err == ESP_OK && check_every_frame && !screen_matches("Session Time:", line)) {
+            printf("FAIL: screen mismatch at %" PRIu32 " s\n", s);
+            failures++;
+            return;
+        }
+    }
+    // One clean flush must always leave the right picture
+    while (lcd_flush() != ESP_OK) {
+    }
+    if (!screen_matches("Session Time:", line)) {
+        printf("FAIL: screen mismatch after %" PRIu32 " frames\n", frames);
+        failures++;
+    }
+}
+
+int main(void) {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    hal_sim_config_t config = { .seed = 1 };
+    hal_sim_configure(&config);
+    hal_board_init();
+    lcd_init(LCD_ADDR);
+
+    lcd_stats_t before, after;
+    lcd_get_stats(&before);
+    run(FRAMES, true);
+    lcd_get_stats(&after);
+
+    uint32_t frames = after.frames - before.frames;
+    uint32_t transactions = after.transactions - before.transactions;
+    uint32_t bytes = after.bytes - before.bytes;
+    uint32_t cells = after.cells - before.cells;
+    printf("session clock, %d updates:\n", FRAMES);
+    printf("  old driver   %7d transactions %8d bytes\n",
+           FRAMES * OLD_TRANSACTIONS_PER_FRAME, FRAMES * OLD_BYTES_PER_FRAME);
+    printf("  shadow fb    %7" PRIu32 " transactions %8" PRIu32 " bytes  (%" PRIu32 " frames, %.2f cells/frame, %.1f bytes/frame)\n",
+           transactions, bytes, frames, (double)cells / frames, (double)bytes / frames);
+
+    // Flaky bus: every failed frame must be repaired by a later one
+    config.i2c_fail_rate = 0.2f;
+    hal_sim_configure(&config);
+    lcd_get_stats(&before);
+    run(FRAMES, false);
+    lcd_get_stats(&after);
+    printf("  20%% I2C NACKs: %" PRIu32 " errors, %" PRIu32 " transactions\n",
+           after.errors - before.errors, after.transactions - before.transactions);
+
+    printf(failures == 0 ? "PASS\n" : "%d checks FAILED\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "numfmt.h"
+
+// Compares the cost of formatting one full /data history (three 60-sample
+// series) with snprintf("%.1f") on floats against put_deci on deci-units.
+
+#define SERIES          3
+#define SAMPLES         60
+#define ITERATIONS      20000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void) {
+    static float values_f[SERIES][SAMPLES];
+    static int16_t values_d[SERIES][SAMPLES];
+    static char out[SERIES * SAMPLES * 8];
+    srand(1);
+    for (int s = 0; s < SERIES; s++) {
+        for (int i = 0; i < SAMPLES; i++) {
+            values_d[s][i] = (int16_t)(rand() % 1000 - 100);
+            values_f[s][i] = values_d[s][i] / 10.0f;
+        }
+    }
+
+    size_t sink = 0;
+    double t0 = now_ns();
+    for (int it = 0; it < ITERATIONS; it++) {
+        int len = 0;
+        for (int s = 0; s < SERIES; s++) {
+            for (int i = 0; i < SAMPLES; i++) {
+                len += snprintf(out + len, sizeof(out) - len, "%.1f,", values_f[s][i]);
+            }
+        }
+        sink += len;
+    }
+    double t1 = now_ns();
+    for (int it = 0; it < ITERATIONS; it++) {
+        char *p = out;
+        for (int s = 0; s < SERIES; s++) {
+            for (int i = 0; i < SAMPLES; i++) {
+                p = put_deci(p, values_d[s][i]);
+                *p++ = ',';
+            }
+        }
+        sink += p - out;
+    }
+    double t2 = now_ns();
+
+    double per_snprintf = (t1 - t0) / ITERATIONS;
+    double per_deci = (t2 - t1) / ITERATIONS;
+    printf("history of %d values: snprintf %.0f ns, put_deci %.0f ns (%.1fx faster)\n",
+           SERIES * SAMPLES, per_snprintf, per_deci, per_snprintf / per_deci);
+    printf("history RAM: float %zu bytes, deci + motion bitset %zu bytes\n",
+           SERIES * SAMPLES * sizeof(float) + SAMPLES * sizeof(int),
+           SERIES * SAMPLES * sizeof(int16_t) + (SAMPLES + 31) / 32 * sizeof(uint32_t));
+    return sink == 0;
+}
@@ -0,0 +1,292 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "config.h"
+#include "trace.h"
+#include "replay.h"
+
+// Replay of a synthesized study day: checks its timeline against the golden
+// fixture and reports the replay rate in simulated hours per second.
+//
+// The day is built the way a board records one: LDR readings at 10 Hz,
+// DHT22 frames every 2 s (a few missing, a few with a bad checksum), a
+// sample tick every second and PIR edges, some of them bouncing, from a
+// seated user who takes breaks, goes to lunch and now and then sits still
+// long enough to set off the away alarm. Daylight fades towards the evening
+// (the LED) and the room warms through the afternoon (the fan). The
+// generator is seeded, so the trace and its timeline never change unless
+// the logic does.
+//
+// usage: bench_replay [--write] [--trace PATH]
+//   --write        regenerate the golden timeline after a deliberate change
+//   --trace PATH   also save the synthesized trace, e.g. for replay
+
+#define DAY_HOURS       12
+#define START_US        4000000LL       // The recording starts 4 s after boot
+#define LDR_PERIOD_US   100000
+#define ZERO_MV         142             // hal_sim's calibration
+#define FULL_MV         3340
+#define LUNCH_US        (START_US + 4 * 3600 * 1000000LL)
+#define REPEATS         20
+#define GOLDEN          REPLAY_FIXTURE_DIR "/study_day.txt"
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    trace_codec_t codec;
+    uint32_t records;
+} synth_t;
+
+typedef struct {
+    int64_t next_us;            // Next PIR transition
+    bool level;
+    bool present;
+    bool lunched;
+    int64_t presence_until_us;
+} pir_model_t;
+
+static uint32_t rng_state = 20240917;
+
+static uint32_t rnd(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+static double rnd_unit(void) {
+    return rnd() / 4294967296.0;
+}
+
+static void emit(synth_t *s, const trace_record_t *rec) {
+    if (s->cap - s->len < TRACE_RECORD_MAX) {
+        s->cap = s->cap * 2;
+        s->buf = realloc(s->buf, s->cap);
+        if (s->buf == NULL) {
+            abort();
+        }
+    }
+    s->len += trace_encode(&s->codec, rec, s->buf + s->len);
+    s->records++;
+}
+
+static void emit_pir(synth_t *s, int64_t time_us, bool level) {
+    const trace_record_t rec = { .type = level ? TRACE_PIR_HIGH : TRACE_PIR_LOW, .time_us = time_us };
+    emit(s, &rec);
+}
+
+// A seated user trips the PIR in pulses of 50 ms to 3 s between 0.2-4 s of
+// stillness, and once in a while reads without moving for 8-20 s. Sessions
+// run 20-80 minutes with 3-15 minute breaks, and lunch takes 50 minutes.
+static void pir_run(synth_t *s, pir_model_t *m, int64_t until_us) {
+    while (m->next_us < until_us) {
+        int64_t t = m->next_us;
+        if (m->present && !m->lunched && t >= LUNCH_US) {
+            m->present = false;
+            m->lunched = true;
+            m->presence_until_us = t + 50 * 60 * 1000000LL;
+        } else if (t >= m->presence_until_us) {
+            m->present = !m->present;
+            double span_s = m->present ? 1200 + rnd_unit() * 3600 : 180 + rnd_unit() * 720;
+            m->presence_until_us = t + (int64_t)(span_s * 1e6);
+        }
+        bool level = m->present && !m->level;
+        if (level != m->level) {
+            emit_pir(s, t, level);
+            if (rnd_unit() < 0.05) {
+                int64_t at = t;
+                for (int i = 1 + rnd() % 3; i > 0; i--) {
+                    at += 200 + rnd() % 2000;
+                    emit_pir(s, at, !level);
+                    at += 100 + rnd() % 1000;
+                    emit_pir(s, at, level);
+                }
+            }
+            m->level = level;
+        }
+        int64_t hold_us;
+        if (level) {
+            hold_us = rnd_unit() < 0.3 ? 50000 + (int64_t)(rnd_unit() * 250000)
+                                       : 300000 + (int64_t)(rnd_unit() * 2700000);
+        } else if (rnd_unit() < 0.006) {
+            hold_us = 8000000 + (int64_t)(rnd_unit() * 12000000);
+        } else {
+            hold_us = 200000 + (int64_t)(rnd_unit() * 3800000);
+        }
+        if (t + hold_us > m->presence_until_us) {
+            hold_us = m->presence_until_us - t;
+        }
+        m->next_us = t + (hold_us > 10000 ? hold_us : 10000);
+    }
+}
+
+// Daylight from 08:00, fading towards 20:00, with passing clouds
+static double light_at(int64_t t_us) {
+    double h = (t_us - START_US) / 3.6e9;
+    double sun = sin(M_PI * (h + 2) / 14);
+    double cloud = pow(fmax(0, sin(t_us / 1.3e9)), 8);
+    return 0.15 + 0.75 * fmax(0, sun) - 0.2 * cloud;
+}
+
+// Room temperature in °C: warmest mid-afternoon, a little up with someone in
+static double temperature_at(int64_t t_us, bool present) {
+    double h = (t_us - START_US) / 3.6e9;
+    return 21.5 + 6.0 * exp(-pow((h - 7) / 3.5, 2)) + (present ? 0.6 : 0);
+}
+
+static void emit_dht(synth_t *s, int64_t time_us, bool present) {
+    trace_record_t rec = { .type = TRACE_DHT, .time_us = time_us };
+    double r = rnd_unit();
+    if (r < 0.02) {
+        rec.type = TRACE_DHT_FAIL;
+        emit(s, &rec);
+        return;
+    }
+    double t = temperature_at(time_us, present) + (rnd_unit() * 2 - 1) * 0.15;
+    int temp = (int)lround(t * 10);
+    int humid = (int)lround((45 - (t - 21) * 1.5 + (rnd_unit() * 2 - 1) * 0.5) * 10);
+    uint16_t temp_bits = temp < 0 ? (uint16_t)(0x8000 | -temp) : (uint16_t)temp;
+    rec.frame[0] = (uint8_t)(humid >> 8);
+    rec.frame[1] = (uint8_t)humid;
+    rec.frame[2] = (uint8_t)(temp_bits >> 8);
+    rec.frame[3] = (uint8_t)temp_bits;
+    rec.frame[4] = (uint8_t)(rec.frame[0] + rec.frame[1] + rec.frame[2] + rec.frame[3]);
+    if (r < 0.025) {
+        rec.frame[3] ^= 0x04;   // A bit flipped on the wire
+    }
+    emit(s, &rec);
+}
+
+static void synthesize(synth_t *s) {
+    const trace_header_t header = {
+        .pir_level = false,
+        .zero_mv = ZERO_MV,
+        .full_mv = FULL_MV,
+        .start_us = START_US,
+    };
+    s->cap = 1 << 20;
+    s->buf = malloc(s->cap);
+    s->len = trace_encode_header(&header, s->buf);
+    trace_codec_init(&s->codec, &header);
+
+    pir_model_t pir = { .next_us = START_US + 1500000, .presence_until_us = START_US + 1000000 };
+    int64_t steps = (int64_t)DAY_HOURS * 3600 * 1000000 / LDR_PERIOD_US;
+    for (int64_t k = 0; k < steps; k++) {
+        int64_t t = START_US + k * LDR_PERIOD_US;
+        pir_run(s, &pir, t);
+
+        // CIC output: little noise is left after the decimation
+        double raw = (1.0 - light_at(t)) * 4095.0 + (rnd_unit() * 2 - 1) * 3;
+        uint16_t count = (uint16_t)(raw < 0 ? 0 : raw > 4095 ? 4095 : lround(raw));
+        const trace_record_t ldr = {
+            .type = TRACE_LDR,
+            .time_us = t + rnd() % 200,
+            .raw = count,
+            .mv = ZERO_MV + (count * 781 + 500) / 1000,
+        };
+        emit(s, &ldr);
+        if (k % 10 == 0) {
+            const trace_record_t sample = { .type = TRACE_SAMPLE, .time_us = t + 300 + rnd() % 400 };
+            emit(s, &sample);
+        }
+        if (k % 20 == 5) {
+            emit_dht(s, t + 5000 + rnd() % 3000, pir.present);
+        }
+    }
+}
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *len = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc(*len + 1);
+    if (buf != NULL && fread(buf, 1, *len, f) != *len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    bool write = false;
+    const char *trace_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--write") == 0) {
+            write = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--write] [--trace PATH]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    synth_t s = { 0 };
+    synthesize(&s);
+    printf("synthesized %d h: %u records, %zu bytes (%.0f KB/h)\n", DAY_HOURS, s.records, s.len,
+           s.len / 1024.0 / DAY_HOURS);
+    if (trace_path != NULL) {
+        FILE *f = fopen(trace_path, "wb");
+        if (f == NULL || fwrite(s.buf, 1, s.len, f) != s.len || fclose(f) != 0) {
+            perror(trace_path);
+            return 1;
+        }
+    }
+
+    desk_config_t config;
+    config_defaults(&config);
+    replay_timeline_t timeline = { 0 };
+    replay_stats_t stats;
+    replay_run(s.buf, s.len, &config, &timeline, &stats);
+    printf("  %u samples, %u PIR edges, %u DHT22 failures: %u away, %u LED on, %u fan writes\n", stats.samples,
+           stats.pir_edges, stats.dht_failures, stats.aways, stats.led_ons, stats.fan_writes);
+
+    int status = 0;
+    if (write) {
+        FILE *f = fopen(GOLDEN, "w");
+        if (f == NULL || fwrite(timeline.text, 1, timeline.len, f) != timeline.len || fclose(f) != 0) {
+            perror(GOLDEN);
+            return 1;
+        }
+        printf("wrote %s\n", GOLDEN);
+    } else {
+        size_t want_len;
+        char *want = read_file(GOLDEN, &want_len);
+        size_t differ = want != NULL ? replay_diff(timeline.text, timeline.len, want, want_len, 10) : 1;
+        printf("timeline vs %s: %s\n", GOLDEN, want == NULL ? "missing" : differ == 0 ? "match" : "DIFFERS");
+        status = differ == 0 ? 0 : 1;
+        free(want);
+    }
+
+    double best = 0;
+    for (int i = 0; i < REPEATS; i++) {
+        replay_timeline_free(&timeline);
+        double start = now_s();
+        replay_run(s.buf, s.len, &config, &timeline, &stats);
+        double elapsed = now_s() - start;
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    double hours = stats.span_us / 3.6e9;
+    printf("replay: %.1f ms per %.0f h trace, %.0f simulated hours per second (%.1f M records/s)\n", best * 1e3,
+           hours, hours / best, stats.records / best / 1e6);
+    replay_timeline_free(&timeline);
+    free(s.buf);
+    return status;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sessions.h"
+
+// Drives the session analytics with synthetic presence traces of up to
+// millions of one-second ticks: sessions of minutes to hours, short breaks
+// by day and long ones at night, and the odd one-second flicker. After
+// each trace every aggregate and the period log are checked against a
+// reference that regenerates the trace and rescans it second by second.
+// Reports the cost per tick, which should not grow with the trace, and the
+// time to render /sessions.
+//
+// usage: bench_sessions [ticks]
+
+#define RENDER_ROUNDS   10000
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } \
+    } while (0)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Deterministic presence trace, one call per second
+typedef struct {
+    uint32_t rng;
+    uint32_t t;
+    bool present;
+    uint32_t left;      // Seconds left in the current period
+} trace_gen_t;
+
+static uint32_t gen_rand(trace_gen_t *g, uint32_t lo, uint32_t hi) {
+    g->rng = g->rng * 1664525u + 1013904223u;
+    return lo + (g->rng >> 8) % (hi - lo + 1);
+}
+
+static void gen_init(trace_gen_t *g, uint32_t seed) {
+    *g = (trace_gen_t){ .rng = seed, .present = true };
+    g->left = gen_rand(g, 300, 10800);
+}
+
+static bool gen_next(trace_gen_t *g) {
+    if (g->left == 0) {
+        g->present = !g->present;
+        uint32_t hour = g->t / 3600 % 24;
+        if (gen_rand(g, 0, 99) < 3) {
+            g->left = gen_rand(g, 1, 10);
+        } else if (g->present) {
+            g->left = gen_rand(g, 300, 10800);
+        } else if (hour < 8) {
+            g->left = gen_rand(g, 3600, 28800);
+        } else {
+            g->left = gen_rand(g, 20, 2700);
+        }
+    }
+    g->left--;
+    g->t++;
+    return g->present;
+}
+
+static double run(uint32_t ticks, uint32_t seed, sessions_t *s) {
+    trace_gen_t g;
+    gen_init(&g, seed);
+    sessions_init(s, true);
+    double start = now_s();
+    for (uint32_t t = 0; t < ticks; t++) {
+        sessions_tick(s, gen_next(&g));
+    }
+    return now_s() - start;
+}
+
+// Rescan the regenerated trace and compare every aggregate
+static void verify(uint32_t ticks, uint32_t seed, const sessions_t *s) {
+    static uint32_t day_focused[SESSIONS_DAYS];
+    uint32_t hour_present[SESSIONS_HOURS] = { 0 };
+    uint32_t hour_total[SESSIONS_HOURS] = { 0 };
+    session_period_t log[SESSIONS_LOG_LEN];
+    uint32_t completed = 0, sessions = 0, breaks = 0, longest = 0;
+    uint64_t break_total = 0, focused = 0;
+    memset(day_focused, 0, sizeof(day_focused));
+
+    trace_gen_t g;
+    gen_init(&g, seed);
+    bool present = true;
+    uint32_t start = 0;
+    for (uint32_t t = 0; t < ticks; t++) {
+        bool p = gen_next(&g);
+        if (p != present) {
+            uint32_t length = t - start;
+            log[completed % SESSIONS_LOG_LEN] = (session_period_t){ start, length, present };
+            completed++;
+            if (present) {
+                sessions++;
+                longest = length > longest ? length : longest;
+            } else {
+                breaks++;
+                break_total += length;
+            }
+            present = p;
+            start = t;
+        }
+        uint32_t day = t / SESSIONS_DAY_S;
+        if (t % SESSIONS_DAY_S == 0) {
+            day_focused[day % SESSIONS_DAYS] = 0;
+        }
+        hour_total[t / 3600 % 24]++;
+        if (p) {
+            hour_present[t / 3600 % 24]++;
+            day_focused[day % SESSIONS_DAYS]++;
+            focused++;
+        }
+    }
+
+    CHECK(s->now_s == ticks, "uptime %u, expected %u", s->now_s, ticks);
+    CHECK(s->present == present && s->period_start_s == start, "running period");
+    CHECK(s->completed == completed, "%u periods, expected %u", s->completed, completed);
+    CHECK(s->sessions == sessions && s->breaks == breaks, "session and break counts");
+    CHECK(s->longest_s == longest, "longest session %u, expected %u", s->longest_s, longest);
+    CHECK(s->break_total_s == break_total, "break total");
+    CHECK(s->focused_s == focused, "focused seconds");
+    uint32_t days = s->day + 1 < SESSIONS_DAYS ? s->day + 1 : SESSIONS_DAYS;
+    for (uint32_t d = s->day + 1 - days; d <= s->day; d++) {
+        CHECK(s->day_focused_s[d % SESSIONS_DAYS] == day_focused[d % SESSIONS_DAYS], "focused time of day %u", d);
+    }
+    CHECK(memcmp(s->hour_present_s, hour_present, sizeof(hour_present)) == 0 &&
+          memcmp(s->hour_total_s, hour_total, sizeof(hour_total)) == 0, "hour-of-day presence");
+    for (uint32_t n = 0; n < SESSIONS_LOG_LEN && n < completed; n++) {
+        session_period_t got;
+        const session_period_t *want = &log[(completed - 1 - n) % SESSIONS_LOG_LEN];
+        CHECK(sessions_period(s, n, &got) && got.start_s == want->start_s && got.length_s == want->length_s &&
+              got.focus == want->focus, "period %u back", n);
+    }
+}
+
+// Every number at its widest must still fit SESSIONS_JSON_MAX
+static void check_json_bound(void) {
+    static sessions_t s;
+    static char buf[SESSIONS_JSON_MAX + 1024];
+    memset(&s, 0xff, sizeof(s));
+    s.present = true;
+    s.period_start_s = 0;
+    s.completed = UINT32_MAX;
+    s.breaks = 1;
+    s.day = UINT32_MAX - 1;
+    for (int i = 0; i < SESSIONS_LOG_LEN; i++) {
+        s.log[i].focus = true;
+    }
+    size_t len = sessions_put_json(buf, &s) - buf;
+    printf("widest /sessions body: %zu of %d bytes\n", len, SESSIONS_JSON_MAX);
+    CHECK(len <= SESSIONS_JSON_MAX, "widest body is %zu bytes", len);
+}
+
+int main(int argc, char **argv) {
+    uint32_t ticks_max = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000000;
+    static sessions_t s;
+    static char buf[SESSIONS_JSON_MAX];
+    size_t body_len = 0;
+
+    printf("%10s %8s %8s %9s %10s\n", "ticks", "days", "periods", "ns/tick", "render us");
+    for (uint32_t ticks = 10000; ticks <= ticks_max; ticks *= 10) {
+        double elapsed = run(ticks, ticks, &s);
+        verify(ticks, ticks, &s);
+
+        double start = now_s();
+        size_t len = 0;
+        for (int i = 0; i < RENDER_ROUNDS; i++) {
+            len += sessions_put_json(buf, &s) - buf;
+        }
+        double render = (now_s() - start) / RENDER_ROUNDS;
+        body_len = len / RENDER_ROUNDS;
+        CHECK(len / RENDER_ROUNDS <= SESSIONS_JSON_MAX, "body of %zu bytes", len / RENDER_ROUNDS);
+        printf("%10u %8u %8u %9.2f %10.2f\n", ticks, s.day + 1, s.completed, elapsed * 1e9 / ticks, render * 1e6);
+        if (ticks > ticks_max / 10) {
+            break;
+        }
+    }
+    printf("%.*s...\n", (int)(body_len < 240 ? body_len : 240), buf);
+    check_json_bound();
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "history.h"
+#include "json_stream.h"
+#include "series_json.h"
+
+// Streams the /data sample series out of a 1 s tier built with a large
+// HISTORY_SIZE, through the same 1536-byte window the server uses, for
+// ranges from one minute to the whole tier. Each range is also rendered
+// into one buffer big enough for all of it and the two outputs must match
+// byte for byte. Time per point should stay flat as the range grows and the
+// stream should allocate nothing: both heap use and peak RSS are reported
+// before and after the streamed runs. Last, the tier is advanced while a
+// stream is in flight: up to HISTORY_SPARE rows the output must be intact,
+// one more and the stream must fail rather than end as if complete.
+//
+// usage: bench_stream [rounds]
+
+#define WINDOW_SIZE     1536
+#define POINTS_MAX      HISTORY_SIZE
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } \
+    } while (0)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long max_rss_kb(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// Sink that only counts, standing in for httpd_resp_send_chunk
+typedef struct {
+    size_t bytes;
+    uint32_t calls;
+} count_sink_t;
+
+static bool count_sink(void *ctx, const char *buf, size_t len) {
+    count_sink_t *c = ctx;
+    c->bytes += len;
+    c->calls++;
+    return true;
+}
+
+// Sink that appends to a buffer, for comparing against the one-piece render
+typedef struct {
+    char *out;
+    size_t len;
+} copy_sink_t;
+
+static bool copy_sink(void *ctx, const char *buf, size_t len) {
+    copy_sink_t *c = ctx;
+    memcpy(c->out + c->len, buf, len);
+    c->len += len;
+    return true;
+}
+
+static void add_row(uint32_t seq) {
+    int16_t values[HISTORY_CHANNELS] = {
+        (int16_t)((seq * 7) % 600) - 100,
+        (int16_t)(seq % 1000),
+        (int16_t)((seq * 13) % 1001),
+    };
+    history_add(values, seq % 3 == 0);
+}
+
+// Sink that adds a row to the tier on every flush until its budget is
+// spent, as the sensor task would while a slow client is being served
+typedef struct {
+    copy_sink_t copy;
+    uint32_t left;
+} advance_sink_t;
+
+static bool advance_sink(void *ctx, const char *buf, size_t len) {
+    advance_sink_t *a = ctx;
+    if (a->left > 0) {
+        add_row(history_seq(HISTORY_RES_SECOND) + 1);
+        a->left--;
+    }
+    return copy_sink(&a->copy, buf, len);
+}
+
+// Stream the whole tier as advertised now while it moves on by rows
+static void check_advance(uint32_t rows, bool want_ok) {
+    static char window[WINDOW_SIZE];
+    size_t whole_size = (size_t)POINTS_MAX * 4 * SERIES_JSON_VALUE_MAX + 256;
+    char *whole = malloc(whole_size);
+    char *streamed = malloc(whole_size);
+    uint32_t last = history_seq(HISTORY_RES_SECOND);
+    uint32_t first = last - POINTS_MAX + 1;
+    json_stream_t js;
+    copy_sink_t one = { .out = whole };
+    json_stream_init(&js, whole, whole_size, copy_sink, &one);
+    series_json_write(&js, first, last);
+    size_t whole_len = js.p - whole;
+
+    advance_sink_t adv = { .copy = { .out = streamed }, .left = rows };
+    json_stream_init(&js, window, sizeof(window), advance_sink, &adv);
+    bool ok = series_json_write(&js, first, last) && json_stream_flush(&js);
+    if (want_ok) {
+        CHECK(ok && adv.left == 0 && adv.copy.len == whole_len && memcmp(streamed, whole, whole_len) == 0,
+              "tier advanced %u rows mid-stream: output differs", rows);
+    } else {
+        CHECK(!ok && js.failed && adv.left == 0, "tier advanced %u rows mid-stream: stream did not fail", rows);
+    }
+    printf("tier advanced %u rows mid-stream: %s\n", rows, ok ? "intact" : "failed");
+    free(streamed);
+    free(whole);
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    history_init();
+    for (uint32_t seq = 1; seq <= POINTS_MAX; seq++) {
+        add_row(seq);
+    }
+    uint32_t last = history_seq(HISTORY_RES_SECOND);
+
+    static const uint32_t ranges[] = { 60, 600, 6000, 60000, POINTS_MAX };
+    size_t whole_size = (size_t)POINTS_MAX * 4 * SERIES_JSON_VALUE_MAX + 256;
+    char *whole = malloc(whole_size);
+    char *streamed = malloc(whole_size);
+    static char window[WINDOW_SIZE];
+
+    // Correctness: streamed output equals a render through one huge window
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        uint32_t first = last - ranges[r] + 1;
+        json_stream_t js;
+        copy_sink_t one = { .out = whole };
+        json_stream_init(&js, whole, whole_size, copy_sink, &one);
+        CHECK(series_json_write(&js, first, last) && js.flushes == 0, "%u points: one-piece render", ranges[r]);
+        size_t whole_len = js.p - whole;
+
+        copy_sink_t copy = { .out = streamed };
+        json_stream_init(&js, window, sizeof(window), copy_sink, &copy);
+        CHECK(series_json_write(&js, first, last) && json_stream_flush(&js), "%u points: streamed", ranges[r]);
+        CHECK(copy.len == whole_len && memcmp(streamed, whole, whole_len) == 0,
+              "%u points: streamed output differs from the one-piece render", ranges[r]);
+    }
+    free(streamed);
+    free(whole);
+
+    // Cost: a counting sink, so only the encoder and the tier reads are
+    // timed. Heap is sampled after the first printf allocates stdout's buffer.
+    printf("%8s %10s %8s %10s %9s\n", "points", "bytes", "chunks", "ms/resp", "ns/point");
+    struct mallinfo2 heap_before = mallinfo2();
+    long rss_before = max_rss_kb();
+    double ns_first = 0, ns_last = 0;
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        uint32_t first = last - ranges[r] + 1;
+        count_sink_t count = { 0 };
+        double start = now_s();
+        for (int i = 0; i < rounds; i++) {
+            count = (count_sink_t){ 0 };
+            json_stream_t js;
+            json_stream_init(&js, window, sizeof(window), count_sink, &count);
+            if (!series_json_write(&js, first, last) || !json_stream_flush(&js)) {
+                CHECK(false, "%u points: stream failed", ranges[r]);
+                break;
+            }
+        }
+        double elapsed = (now_s() - start) / rounds;
+        double ns_point = elapsed * 1e9 / ranges[r];
+        printf("%8u %10zu %8u %10.3f %9.1f\n", ranges[r], count.bytes, count.calls, elapsed * 1e3, ns_point);
+        if (r == 0) {
+            ns_first = ns_point;
+        }
+        ns_last = ns_point;
+    }
+    struct mallinfo2 heap_after = mallinfo2();
+    long rss_after = max_rss_kb();
+    printf("heap in use: %zu -> %zu bytes, peak RSS: %ld -> %ld KiB, window: %d bytes\n", heap_before.uordblks,
+           heap_after.uordblks, rss_before, rss_after, WINDOW_SIZE);
+    printf("ns/point, %u points vs %u: %.2fx\n", (unsigned)POINTS_MAX, ranges[0], ns_last / ns_first);
+    CHECK(heap_after.uordblks == heap_before.uordblks, "streaming allocated from the heap");
+    CHECK(rss_after == rss_before, "peak RSS grew while streaming");
+
+    check_advance(HISTORY_SPARE, true);
+    check_advance(HISTORY_SPARE + 1, false);
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
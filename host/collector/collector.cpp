@@ -0,0 +1,770 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "numfmt.h"
+#include "http_response.h"
+#include "collector.h"
+
+namespace collector {
+
+namespace {
+
+constexpr int kTimerPeriodMs = 10;
+constexpr int kBackoffMinMs = 1000;
+constexpr int kBackoffMaxMs = 30000;
+constexpr size_t kReadSize = 65536;
+constexpr size_t kApiRequestMax = 4096;
+
+int64_t now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+void append_u64(std::string &out, uint64_t v) {
+    char buf[24];
+    out.append(buf, put_u64(buf, v) - buf);
+}
+
+void append_deci(std::string &out, int32_t v) {
+    char buf[16];
+    out.append(buf, put_deci(buf, v) - buf);
+}
+
+void append_json_string(std::string &out, const std::string &s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// Value of key in a query string ("a=1&b=2"), without percent-decoding
+bool query_value(const std::string &query, const char *key, std::string *out) {
+    size_t key_len = strlen(key);
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) {
+            amp = query.size();
+        }
+        if (amp - pos > key_len && query.compare(pos, key_len, key) == 0 && query[pos + key_len] == '=') {
+            out->assign(query, pos + key_len + 1, amp - pos - key_len - 1);
+            return true;
+        }
+        pos = amp + 1;
+    }
+    return false;
+}
+
+}  // namespace
+
+struct Collector::Handle {
+    enum Kind { DESK, API_LISTEN, API_CLIENT } kind;
+    void *ptr;
+};
+
+struct Collector::Desk {
+    DeskConfig config;
+    size_t index = 0;
+    sockaddr_storage addr{};
+    socklen_t addr_len = 0;
+    std::string address;            // "host:port", also the Host header
+    Handle handle{};
+    int fd = -1;
+    bool connected = false;
+    uint32_t events = 0;            // Registered with epoll
+    std::string out;                // Requests not yet written
+    size_t out_off = 0;
+    ResponseParser parser;
+    int in_flight = 0;              // Requests written or queued, not yet answered
+    bool closing = false;           // Server asked to close after this response
+    int64_t next_scrape_ms = 0;
+    int64_t last_io_ms = 0;
+    int backoff_ms = 0;
+    DeskData parsed;
+    DeskStats stats;
+};
+
+struct Collector::ApiClient {
+    int fd = -1;
+    Handle handle{};
+    std::string in;
+    std::string out;
+    size_t out_off = 0;
+    bool close_after = false;
+};
+
+Collector::Collector(std::vector<DeskConfig> desks, const CollectorOptions &options)
+    : options_(options), store_(desks.size(), options.capacity) {
+    if (!options_.keep_alive || options_.pipeline < 1) {
+        options_.pipeline = 1;
+    }
+    for (size_t i = 0; i < desks.size(); i++) {
+        Desk *d = new Desk();
+        d->config = std::move(desks[i]);
+        d->index = i;
+        d->handle = Handle{Handle::DESK, d};
+        desks_.push_back(d);
+    }
+}
+
+Collector::~Collector() {
+    for (Desk *d : desks_) {
+        desk_close(*d);
+        delete d;
+    }
+    for (ApiClient *c : api_clients_) {
+        close(c->fd);
+        delete c;
+    }
+    if (api_fd_ >= 0) {
+        close(api_fd_);
+    }
+    delete api_handle_;
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+size_t Collector::desk_count() const {
+    return desks_.size();
+}
+
+const DeskConfig &Collector::desk(size_t i) const {
+    return desks_[i]->config;
+}
+
+const DeskStats &Collector::stats(size_t i) const {
+    return desks_[i]->stats;
+}
+
+uint64_t Collector::total_scrapes() const {
+    uint64_t n = 0;
+    for (const Desk *d : desks_) {
+        n += d->stats.scrapes;
+    }
+    return n;
+}
+
+uint64_t Collector::total_errors() const {
+    uint64_t n = 0;
+    for (const Desk *d : desks_) {
+        n += d->stats.errors;
+    }
+    return n;
+}
+
+bool Collector::start() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        perror("epoll_create1");
+        return false;
+    }
+
+    int64_t now = now_ms();
+    for (Desk *d : desks_) {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *res = nullptr;
+        std::string port = std::to_string(d->config.port);
+        int err = getaddrinfo(d->config.host.c_str(), port.c_str(), &hints, &res);
+        if (err != 0) {
+            fprintf(stderr, "desk %s: cannot resolve %s: %s\n", d->config.name.c_str(),
+                    d->config.host.c_str(), gai_strerror(err));
+            return false;
+        }
+        memcpy(&d->addr, res->ai_addr, res->ai_addrlen);
+        d->addr_len = res->ai_addrlen;
+        freeaddrinfo(res);
+        d->address = d->config.host + ":" + port;
+        // Spread the first round over one interval so the desks are not all
+        // scraped in the same instant forever after
+        d->next_scrape_ms = now + (options_.interval_ms * static_cast<int64_t>(d->index)) /
+                                  static_cast<int64_t>(desks_.size());
+    }
+
+    if (options_.api_port != 0) {
+        api_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(api_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_ANY);
+        sa.sin_port = htons(options_.api_port);
+        if (bind(api_fd_, reinterpret_cast<sockaddr *>(&sa), sizeof(sa)) != 0 || listen(api_fd_, 64) != 0) {
+            fprintf(stderr, "cannot listen on port %u: %s\n", options_.api_port, strerror(errno));
+            return false;
+        }
+        socklen_t len = sizeof(sa);
+        getsockname(api_fd_, reinterpret_cast<sockaddr *>(&sa), &len);
+        api_port_ = ntohs(sa.sin_port);
+        api_handle_ = new Handle{Handle::API_LISTEN, nullptr};
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = api_handle_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, api_fd_, &ev);
+    }
+    next_timer_ms_ = now;
+    return true;
+}
+
+void Collector::poll(int max_wait_ms) {
+    int64_t now = now_ms();
+    int wait = max_wait_ms;
+    if (next_timer_ms_ - now < wait) {
+        wait = next_timer_ms_ <= now ? 0 : static_cast<int>(next_timer_ms_ - now);
+    }
+    epoll_event events[256];
+    int n = epoll_wait(epoll_fd_, events, 256, wait);
+    now = now_ms();
+    for (int i = 0; i < n; i++) {
+        Handle *h = static_cast<Handle *>(events[i].data.ptr);
+        uint32_t ev = events[i].events;
+        if (h->kind == Handle::API_LISTEN) {
+            api_accept();
+        } else if (h->kind == Handle::API_CLIENT) {
+            ApiClient *c = static_cast<ApiClient *>(h->ptr);
+            if (ev & (EPOLLERR | EPOLLHUP)) {
+                api_close(c);
+                continue;
+            }
+            api_read(*c);
+        } else {
+            Desk &d = *static_cast<Desk *>(h->ptr);
+            if (d.fd < 0) {
+                continue;
+            }
+            if (!d.connected && (ev & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(d.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0) {
+                    desk_fail(d, now, strerror(err));
+                    continue;
+                }
+                d.connected = true;
+                d.last_io_ms = now;
+            }
+            if (ev & EPOLLIN) {
+                desk_read(d, now);
+            }
+            if (d.fd >= 0 && d.connected && (ev & EPOLLOUT)) {
+                desk_flush(d);
+            }
+            if (d.fd >= 0 && (ev & EPOLLERR)) {
+                desk_fail(d, now, "socket error");
+            }
+        }
+    }
+    if (now >= next_timer_ms_) {
+        run_timers(now);
+        next_timer_ms_ = now + kTimerPeriodMs;
+    }
+}
+
+void Collector::run_timers(int64_t now) {
+    for (Desk *dp : desks_) {
+        Desk &d = *dp;
+        if (d.fd >= 0 && (d.in_flight > 0 || !d.connected) && now - d.last_io_ms > options_.timeout_ms) {
+            desk_fail(d, now, "timeout");
+        }
+        if (now >= d.next_scrape_ms) {
+            desk_send(d, now);
+        }
+    }
+}
+
+void Collector::desk_update_events(Desk &d) {
+    uint32_t want = EPOLLIN | EPOLLRDHUP;
+    if (!d.connected || d.out_off < d.out.size()) {
+        want |= EPOLLOUT;
+    }
+    if (want == d.events) {
+        return;
+    }
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.ptr = &d.handle;
+    epoll_ctl(epoll_fd_, d.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, d.fd, &ev);
+    d.events = want;
+}
+
+void Collector::desk_connect(Desk &d, int64_t now) {
+    d.fd = socket(d.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (d.fd < 0) {
+        desk_fail(d, now, strerror(errno));
+        return;
+    }
+    int one = 1;
+    setsockopt(d.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    d.connected = false;
+    d.events = 0;
+    d.last_io_ms = now;
+    d.stats.connects++;
+    if (connect(d.fd, reinterpret_cast<sockaddr *>(&d.addr), d.addr_len) != 0 && errno != EINPROGRESS) {
+        desk_fail(d, now, strerror(errno));
+        return;
+    }
+    desk_update_events(d);
+}
+
+void Collector::desk_close(Desk &d) {
+    if (d.fd >= 0) {
+        close(d.fd);  // Also removes it from the epoll set
+    }
+    d.fd = -1;
+    d.connected = false;
+    d.events = 0;
+    d.out.clear();
+    d.out_off = 0;
+    d.in_flight = 0;
+    d.closing = false;
+    d.parser.reset();
+}
+
+void Collector::desk_fail(Desk &d, int64_t now, const char *why) {
+    if (d.stats.up || d.backoff_ms == 0) {
+        fprintf(stderr, "desk %s (%s): %s\n", d.config.name.c_str(), d.address.c_str(), why);
+    }
+    d.stats.errors++;
+    d.stats.up = false;
+    desk_close(d);
+    d.backoff_ms = d.backoff_ms == 0 ? kBackoffMinMs : std::min(d.backoff_ms * 2, kBackoffMaxMs);
+    d.next_scrape_ms = now + d.backoff_ms;
+}
+
+// Queue as many requests as the schedule and the pipeline depth allow
+void Collector::desk_send(Desk &d, int64_t now) {
+    if (d.closing) {
+        return;
+    }
+    if (d.fd < 0) {
+        desk_connect(d, now);
+        if (d.fd < 0) {
+            return;
+        }
+    }
+    bool queued = false;
+    while (d.in_flight < options_.pipeline && now >= d.next_scrape_ms) {
+        char req[256];
+        int len = snprintf(req, sizeof(req), "GET /data?since=%u HTTP/1.1\r\nHost: %s\r\n%s\r\n",
+                           d.stats.last_seq, d.address.c_str(),
+                           options_.keep_alive ? "" : "Connection: close\r\n");
+        d.out.append(req, len);
+        d.in_flight++;
+        queued = true;
+        if (options_.interval_ms > 0) {
+            // Keep the cadence, but do not try to catch up on missed rounds
+            d.next_scrape_ms += options_.interval_ms;
+            if (d.next_scrape_ms <= now) {
+                d.next_scrape_ms = now + options_.interval_ms;
+            }
+        }
+        if (!options_.keep_alive) {
+            break;
+        }
+    }
+    if (queued && d.connected) {
+        desk_flush(d);
+    } else if (queued) {
+        desk_update_events(d);
+    }
+}
+
+void Collector::desk_flush(Desk &d) {
+    while (d.out_off < d.out.size()) {
+        ssize_t n = send(d.fd, d.out.data() + d.out_off, d.out.size() - d.out_off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            desk_fail(d, now_ms(), strerror(errno));
+            return;
+        }
+        d.out_off += static_cast<size_t>(n);
+    }
+    if (d.out_off == d.out.size()) {
+        d.out.clear();
+        d.out_off = 0;
+    }
+    desk_update_events(d);
+}
+
+void Collector::desk_read(Desk &d, int64_t now) {
+    static char buf[kReadSize];
+    // A response can close the connection and start the next one; stop
+    // reading when the socket is no longer the one that was readable
+    int fd = d.fd;
+    while (d.fd == fd) {
+        ssize_t n = recv(d.fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                desk_fail(d, now, strerror(errno));
+            }
+            return;
+        }
+        if (n == 0) {
+            if (d.closing) {
+                desk_close(d);  // Expected: the desk said it would close
+                desk_send(d, now);
+            } else if (d.in_flight > 0) {
+                desk_fail(d, now, "connection closed mid-response");
+            } else {
+                desk_close(d);  // Idle keep-alive connection dropped by the desk
+            }
+            return;
+        }
+        d.last_io_ms = now;
+        d.stats.bytes_in += static_cast<uint64_t>(n);
+        size_t off = 0;
+        while (off < static_cast<size_t>(n) && d.fd == fd) {
+            size_t used;
+            ResponseParser::Result r = d.parser.feed(buf + off, n - off, &used);
+            off += used;
+            if (r == ResponseParser::Result::Error || (r == ResponseParser::Result::Done && d.in_flight == 0)) {
+                desk_fail(d, now, "malformed response");
+                return;
+            }
+            if (r == ResponseParser::Result::NeedMore) {
+                break;
+            }
+            desk_response(d, now);
+        }
+        if (static_cast<size_t>(n) < sizeof(buf)) {
+            return;
+        }
+    }
+}
+
+void Collector::desk_response(Desk &d, int64_t now) {
+    d.in_flight--;
+    bool keep = d.parser.keep_alive() && options_.keep_alive;
+    if (d.parser.status() != 200) {
+        d.stats.errors++;
+    } else if (!parse_desk_data(d.parser.body(), d.parsed)) {
+        d.stats.errors++;
+    } else {
+        size_t added = store_.append(d.index, d.parsed, static_cast<uint32_t>(time(nullptr)));
+        std::swap(d.stats.latest, d.parsed);
+        d.stats.scrapes++;
+        d.stats.samples += added;
+        d.stats.last_seq = d.stats.latest.seq;
+        d.stats.up = true;
+        d.backoff_ms = 0;
+    }
+    d.parser.reset();
+    if (!keep) {
+        // Anything pipelined behind this response is lost with the
+        // connection; the next round reconnects and asks again
+        if (d.in_flight == 0) {
+            desk_close(d);
+        } else {
+            d.closing = true;
+        }
+    }
+    if (options_.interval_ms == 0) {
+        d.next_scrape_ms = now;
+    }
+    desk_send(d, now);
+}
+
+// API server
+
+void Collector::api_accept() {
+    while (true) {
+        int fd = accept4(api_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        ApiClient *c = new ApiClient();
+        c->fd = fd;
+        c->handle = Handle{Handle::API_CLIENT, c};
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = &c->handle;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        api_clients_.push_back(c);
+    }
+}
+
+void Collector::api_close(ApiClient *c) {
+    close(c->fd);
+    for (size_t i = 0; i < api_clients_.size(); i++) {
+        if (api_clients_[i] == c) {
+            api_clients_[i] = api_clients_.back();
+            api_clients_.pop_back();
+            break;
+        }
+    }
+    delete c;
+}
+
+void Collector::api_read(ApiClient &c) {
+    char buf[4096];
+    while (true) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            api_close(&c);
+            return;
+        }
+        if (n < 0) {
+            break;
+        }
+        c.in.append(buf, n);
+        if (c.in.size() > kApiRequestMax) {
+            api_close(&c);
+            return;
+        }
+    }
+
+    size_t end;
+    while ((end = c.in.find("\r\n\r\n")) != std::string::npos) {
+        // "GET /path?query HTTP/1.1"
+        size_t sp1 = c.in.find(' ');
+        size_t sp2 = sp1 == std::string::npos ? sp1 : c.in.find(' ', sp1 + 1);
+        if (sp2 == std::string::npos || sp2 > end || c.in.compare(0, sp1, "GET") != 0) {
+            c.out += "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            c.close_after = true;
+            break;
+        }
+        std::string head = c.in.substr(0, end);
+        for (char &ch : head) {
+            ch = static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+        }
+        if (head.find("\r\nconnection: close") != std::string::npos) {
+            c.close_after = true;
+        }
+        api_route(c, c.in.substr(sp1 + 1, sp2 - sp1 - 1));
+        c.in.erase(0, end + 4);
+        if (c.close_after) {
+            break;
+        }
+    }
+
+    // Responses are small; a client that cannot take one in a single send
+    // gets it in blocking mode rather than through write readiness
+    if (!c.out.empty()) {
+        int flags = fcntl(c.fd, F_GETFL);
+        fcntl(c.fd, F_SETFL, flags & ~O_NONBLOCK);
+        bool ok = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(c.out.size());
+        fcntl(c.fd, F_SETFL, flags);
+        c.out.clear();
+        if (!ok) {
+            c.close_after = true;
+        }
+    }
+    if (c.close_after) {
+        api_close(&c);
+    }
+}
+
+void Collector::api_route(ApiClient &c, const std::string &target) {
+    size_t q = target.find('?');
+    std::string path = target.substr(0, q);
+    std::string query = q == std::string::npos ? "" : target.substr(q + 1);
+    std::string body;
+    const char *status = "200 OK";
+    if (path == "/fleet") {
+        api_fleet(body);
+    } else if (path == "/series") {
+        if (!api_series(body, query)) {
+            status = "404 Not Found";
+            body = "{\"error\":\"unknown desk or bad since\"}";
+        }
+    } else {
+        status = "404 Not Found";
+        body = "{\"error\":\"not found\"}";
+    }
+    c.out += "HTTP/1.1 ";
+    c.out += status;
+    c.out += "\r\nContent-Type: application/json\r\nContent-Length: ";
+    append_u64(c.out, body.size());
+    c.out += "\r\n\r\n";
+    c.out += body;
+}
+
+void Collector::api_fleet(std::string &out) {
+    struct Range {
+        int32_t min = INT32_MAX, max = INT32_MIN;
+        int64_t sum = 0;
+        void add(int32_t v) {
+            min = std::min(min, v);
+            max = std::max(max, v);
+            sum += v;
+        }
+    } temp, humid, light;
+    size_t up = 0;
+    size_t motion = 0;
+
+    out += "{\"desks\":[";
+    for (size_t i = 0; i < desks_.size(); i++) {
+        const Desk &d = *desks_[i];
+        const DeskData &l = d.stats.latest;
+        if (i > 0) {
+            out += ',';
+        }
+        out += "{\"name\":";
+        append_json_string(out, d.config.name);
+        out += ",\"address\":";
+        append_json_string(out, d.address);
+        out += d.stats.up ? ",\"up\":true" : ",\"up\":false";
+        out += ",\"scrapes\":";
+        append_u64(out, d.stats.scrapes);
+        out += ",\"errors\":";
+        append_u64(out, d.stats.errors);
+        out += ",\"rows\":";
+        append_u64(out, store_.count(i));
+        out += ",\"next\":";
+        append_u64(out, store_.next_row(i));
+        if (d.stats.scrapes > 0) {
+            out += ",\"seq\":";
+            append_u64(out, l.seq);
+            out += ",\"temperature\":";
+            append_deci(out, l.temperature);
+            out += ",\"humidity\":";
+            append_deci(out, l.humidity);
+            out += ",\"light\":";
+            append_deci(out, l.light);
+            out += l.motion_detected ? ",\"motionDetected\":true" : ",\"motionDetected\":false";
+            out += ",\"fanSpeed\":";
+            append_u64(out, l.fan_speed);
+            out += ",\"sessionSeconds\":";
+            append_u64(out, l.session_seconds);
+            out += ",\"uptimeUs\":";
+            append_u64(out, l.uptime_us);
+        }
+        out += '}';
+        if (d.stats.up) {
+            up++;
+            temp.add(l.temperature);
+            humid.add(l.humidity);
+            light.add(l.light);
+            motion += l.motion_detected;
+        }
+    }
+    out += "],\"summary\":{\"desks\":";
+    append_u64(out, desks_.size());
+    out += ",\"up\":";
+    append_u64(out, up);
+    out += ",\"motionDetected\":";
+    append_u64(out, motion);
+    if (up > 0) {
+        const std::pair<const char *, const Range *> ranges[] = {
+            {"temperature", &temp}, {"humidity", &humid}, {"light", &light},
+        };
+        for (const auto &r : ranges) {
+            out += ",\"";
+            out += r.first;
+            out += "\":{\"min\":";
+            append_deci(out, r.second->min);
+            out += ",\"avg\":";
+            int64_t n = static_cast<int64_t>(up);
+            append_deci(out, static_cast<int32_t>((r.second->sum + (r.second->sum < 0 ? -n / 2 : n / 2)) / n));
+            out += ",\"max\":";
+            append_deci(out, r.second->max);
+            out += '}';
+        }
+    }
+    out += "}}";
+}
+
+bool Collector::api_series(std::string &out, const std::string &query) {
+    std::string name, since_text;
+    if (!query_value(query, "desk", &name)) {
+        return false;
+    }
+    size_t desk = desks_.size();
+    for (size_t i = 0; i < desks_.size(); i++) {
+        if (desks_[i]->config.name == name) {
+            desk = i;
+        }
+    }
+    if (desk == desks_.size()) {
+        return false;
+    }
+    uint64_t first = store_.first_row(desk);
+    uint64_t next = store_.next_row(desk);
+    uint64_t since = first;
+    if (query_value(query, "since", &since_text)) {
+        char *end;
+        since = strtoull(since_text.c_str(), &end, 10);
+        if (end == since_text.c_str() || *end != '\0') {
+            return false;
+        }
+        since = std::max(since, first);
+    }
+
+    std::vector<Sample> rows;
+    for (uint64_t r = since; r < next; r++) {
+        Sample s;
+        if (store_.get(desk, r, &s)) {
+            rows.push_back(s);
+        }
+    }
+    out += "{\"desk\":";
+    append_json_string(out, name);
+    out += ",\"first\":";
+    append_u64(out, rows.empty() ? next : rows.front().row);
+    out += ",\"next\":";
+    append_u64(out, next);
+    out += ",\"count\":";
+    append_u64(out, rows.size());
+
+    // One array per column, in the store's layout
+    auto column = [&](const char *key, auto get, bool deci) {
+        out += ",\"";
+        out += key;
+        out += "\":[";
+        for (size_t i = 0; i < rows.size(); i++) {
+            if (i > 0) {
+                out += ',';
+            }
+            int64_t v = get(rows[i]);
+            if (deci) {
+                append_deci(out, static_cast<int32_t>(v));
+            } else {
+                append_u64(out, static_cast<uint64_t>(v));
+            }
+        }
+        out += ']';
+    };
+    column("seq", [](const Sample &s) { return static_cast<int64_t>(s.seq); }, false);
+    column("epoch", [](const Sample &s) { return static_cast<int64_t>(s.epoch); }, false);
+    column("time", [](const Sample &s) { return static_cast<int64_t>(s.time_s); }, false);
+    column("temperature", [](const Sample &s) { return static_cast<int64_t>(s.temperature); }, true);
+    column("humidity", [](const Sample &s) { return static_cast<int64_t>(s.humidity); }, true);
+    column("light", [](const Sample &s) { return static_cast<int64_t>(s.light); }, true);
+    column("motion", [](const Sample &s) { return static_cast<int64_t>(s.motion); }, false);
+    out += '}';
+    return true;
+}
+
+}  // namespace collector
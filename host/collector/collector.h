@@ -0,0 +1,109 @@
+#pragma once
+
+// Fleet collector: scrapes /data from many desks and serves the merged series.
+//
+// One thread runs everything from a single epoll loop. Each desk has one
+// persistent HTTP/1.1 connection. Requests ask for /data?since=<last seq>,
+// so a steady-state scrape carries the live values and only the samples
+// the collector has not seen yet. With pipeline > 1, up to that many
+// requests are written back to back before the responses come in, which
+// hides the round trip when a desk is scraped faster than its latency
+// allows. Failed desks are retried with exponential backoff; a slow or dead
+// desk never blocks the others.
+//
+// The same loop serves the aggregated API (see api_port):
+//   GET /fleet                    every desk's state and latest values, and
+//                                 fleet-wide min/avg/max
+//   GET /series?desk=<name>&since=<row>
+//                                 stored samples as columns; page with the
+//                                 returned "next"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "series_store.h"
+
+namespace collector {
+
+struct DeskConfig {
+    std::string name;
+    std::string host;
+    uint16_t port = 80;
+};
+
+struct CollectorOptions {
+    int interval_ms = 2000;     // Per desk; 0 scrapes continuously (benchmarks)
+    int pipeline = 1;           // Requests in flight per connection
+    bool keep_alive = true;     // false: one connection per scrape
+    int timeout_ms = 5000;      // No response bytes for this long fails the desk
+    size_t capacity = 3600;     // Samples kept per desk
+    uint16_t api_port = 0;      // 0: no API server
+};
+
+struct DeskStats {
+    uint64_t scrapes = 0;       // Responses parsed and stored
+    uint64_t errors = 0;        // Connect, I/O, HTTP or parse failures
+    uint64_t connects = 0;
+    uint64_t bytes_in = 0;
+    uint64_t samples = 0;       // Samples added to the store
+    bool up = false;
+    uint32_t last_seq = 0;
+    DeskData latest;            // Newest parsed document
+};
+
+class Collector {
+public:
+    Collector(std::vector<DeskConfig> desks, const CollectorOptions &options);
+    ~Collector();
+    Collector(const Collector &) = delete;
+    Collector &operator=(const Collector &) = delete;
+
+    // Resolve the desks and open the API socket; false with a message on stderr
+    bool start();
+
+    // Wait up to max_wait_ms for I/O and run what is due
+    void poll(int max_wait_ms);
+
+    size_t desk_count() const;
+    const DeskConfig &desk(size_t i) const;
+    const DeskStats &stats(size_t i) const;
+    uint64_t total_scrapes() const;
+    uint64_t total_errors() const;
+    const SeriesStore &store() const { return store_; }
+    uint16_t api_port() const { return api_port_; }
+
+private:
+    struct Desk;
+    struct ApiClient;
+    struct Handle;
+
+    void desk_connect(Desk &d, int64_t now_ms);
+    void desk_fail(Desk &d, int64_t now_ms, const char *why);
+    void desk_close(Desk &d);
+    void desk_send(Desk &d, int64_t now_ms);
+    void desk_flush(Desk &d);
+    void desk_read(Desk &d, int64_t now_ms);
+    void desk_response(Desk &d, int64_t now_ms);
+    void desk_update_events(Desk &d);
+    void run_timers(int64_t now_ms);
+
+    void api_accept();
+    void api_read(ApiClient &c);
+    void api_close(ApiClient *c);
+    void api_route(ApiClient &c, const std::string &target);
+    void api_fleet(std::string &out);
+    bool api_series(std::string &out, const std::string &query);
+
+    CollectorOptions options_;
+    std::vector<Desk *> desks_;
+    std::vector<ApiClient *> api_clients_;
+    SeriesStore store_;
+    int epoll_fd_ = -1;
+    int api_fd_ = -1;
+    uint16_t api_port_ = 0;
+    Handle *api_handle_ = nullptr;
+    int64_t next_timer_ms_ = 0;
+};
+
+}  // namespace collector
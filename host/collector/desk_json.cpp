@@ -0,0 +1,295 @@
+#include "desk_json.h"
+
+namespace collector {
+
+void DeskData::clear() {
+    std::vector<int16_t> t = std::move(temp_history);
+    std::vector<int16_t> h = std::move(humid_history);
+    std::vector<int16_t> l = std::move(light_history);
+    std::vector<uint8_t> m = std::move(motion_history);
+    *this = DeskData();
+    temp_history = std::move(t);
+    humid_history = std::move(h);
+    light_history = std::move(l);
+    motion_history = std::move(m);
+    temp_history.clear();
+    humid_history.clear();
+    light_history.clear();
+    motion_history.clear();
+}
+
+namespace {
+
+// A number as written by numfmt.h: optional sign, digits, and for deci
+// values one fractional digit
+struct Number {
+    int64_t mantissa = 0;
+    int frac_digits = 0;
+
+    int64_t deci() const { return frac_digits == 0 ? mantissa * 10 : mantissa; }
+    int64_t integer() const { return frac_digits == 0 ? mantissa : mantissa / 10; }
+};
+
+class Cursor {
+public:
+    explicit Cursor(std::string_view s) : p_(s.data()), end_(s.data() + s.size()) {}
+
+    void skip_ws() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            p_++;
+        }
+    }
+
+    bool eat(char c) {
+        skip_ws();
+        if (p_ < end_ && *p_ == c) {
+            p_++;
+            return true;
+        }
+        return false;
+    }
+
+    char peek() {
+        skip_ws();
+        return p_ < end_ ? *p_ : '\0';
+    }
+
+    // Keys and string values; escapes are kept as-is, which is enough to
+    // compare against the ASCII keys the desk sends
+    bool string(std::string_view *out) {
+        if (!eat('"')) {
+            return false;
+        }
+        const char *start = p_;
+        while (p_ < end_ && *p_ != '"') {
+            p_ += *p_ == '\\' ? 2 : 1;
+        }
+        if (p_ >= end_) {
+            return false;
+        }
+        *out = std::string_view(start, p_ - start);
+        p_++;
+        return true;
+    }
+
+    bool number(Number *out) {
+        skip_ws();
+        bool neg = p_ < end_ && *p_ == '-';
+        p_ += neg;
+        if (p_ >= end_ || *p_ < '0' || *p_ > '9') {
+            return false;
+        }
+        int64_t v = 0;
+        int frac = -1;
+        for (; p_ < end_; p_++) {
+            if (*p_ >= '0' && *p_ <= '9') {
+                if (v > INT64_MAX / 10 - 10) {
+                    return false;
+                }
+                v = v * 10 + (*p_ - '0');
+                if (frac >= 0) {
+                    frac++;
+                }
+            } else if (*p_ == '.' && frac < 0) {
+                frac = 0;
+            } else {
+                break;
+            }
+        }
+        // Deci values have exactly one fractional digit; round anything finer
+        while (frac > 1) {
+            v = (v + 5) / 10;
+            frac--;
+        }
+        out->mantissa = neg ? -v : v;
+        out->frac_digits = frac < 0 ? 0 : frac;
+        return true;
+    }
+
+    bool boolean(bool *out) {
+        skip_ws();
+        if (end_ - p_ >= 4 && std::string_view(p_, 4) == "true") {
+            p_ += 4;
+            *out = true;
+            return true;
+        }
+        if (end_ - p_ >= 5 && std::string_view(p_, 5) == "false") {
+            p_ += 5;
+            *out = false;
+            return true;
+        }
+        return false;
+    }
+
+    // Skip one value of any type
+    bool skip_value() {
+        char c = peek();
+        if (c == '"') {
+            std::string_view s;
+            return string(&s);
+        }
+        if (c == '{' || c == '[') {
+            int depth = 0;
+            while (p_ < end_) {
+                char d = *p_;
+                if (d == '"') {
+                    std::string_view s;
+                    if (!string(&s)) {
+                        return false;
+                    }
+                    continue;
+                }
+                p_++;
+                if (d == '{' || d == '[') {
+                    depth++;
+                } else if ((d == '}' || d == ']') && --depth == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (c == 't' || c == 'f') {
+            bool b;
+            return boolean(&b);
+        }
+        if (c == 'n') {
+            if (end_ - p_ >= 4 && std::string_view(p_, 4) == "null") {
+                p_ += 4;
+                return true;
+            }
+            return false;
+        }
+        Number n;
+        return number(&n);
+    }
+
+    template <typename T>
+    bool deci_array(std::vector<T> *out) {
+        if (!eat('[')) {
+            return false;
+        }
+        if (eat(']')) {
+            return true;
+        }
+        do {
+            Number n;
+            if (!number(&n)) {
+                return false;
+            }
+            out->push_back(static_cast<T>(n.deci()));
+        } while (eat(','));
+        return eat(']');
+    }
+
+    bool flag_array(std::vector<uint8_t> *out) {
+        if (!eat('[')) {
+            return false;
+        }
+        if (eat(']')) {
+            return true;
+        }
+        do {
+            Number n;
+            if (!number(&n)) {
+                return false;
+            }
+            out->push_back(n.integer() != 0);
+        } while (eat(','));
+        return eat(']');
+    }
+
+    bool at_end() {
+        skip_ws();
+        return p_ == end_;
+    }
+
+private:
+    const char *p_;
+    const char *end_;
+};
+
+bool read_value(Cursor &c, std::string_view key, DeskData &out) {
+    Number n;
+    if (key == "temperature") {
+        if (!c.number(&n)) return false;
+        out.temperature = static_cast<int32_t>(n.deci());
+    } else if (key == "humidity") {
+        if (!c.number(&n)) return false;
+        out.humidity = static_cast<int32_t>(n.deci());
+    } else if (key == "lightPercentage") {
+        if (!c.number(&n)) return false;
+        out.light = static_cast<int32_t>(n.deci());
+    } else if (key == "motionDetected") {
+        return c.boolean(&out.motion_detected);
+    } else if (key == "motionCount") {
+        if (!c.number(&n)) return false;
+        out.motion_count = static_cast<uint32_t>(n.integer());
+    } else if (key == "fanSpeed") {
+        if (!c.number(&n)) return false;
+        out.fan_speed = static_cast<uint32_t>(n.integer());
+    } else if (key == "sessionActive") {
+        return c.boolean(&out.session_active);
+    } else if (key == "sessionSeconds") {
+        if (!c.number(&n)) return false;
+        out.session_seconds = static_cast<uint32_t>(n.integer());
+    } else if (key == "dhtFailures") {
+        if (!c.number(&n)) return false;
+        out.dht_failures = static_cast<uint32_t>(n.integer());
+    } else if (key == "uptimeUs") {
+        if (!c.number(&n)) return false;
+        out.uptime_us = static_cast<uint64_t>(n.integer());
+    } else if (key == "seq") {
+        if (!c.number(&n)) return false;
+        out.seq = static_cast<uint32_t>(n.integer());
+    } else if (key == "firstSeq") {
+        if (!c.number(&n)) return false;
+        out.first_seq = static_cast<uint32_t>(n.integer());
+    } else if (key == "historyCount") {
+        if (!c.number(&n)) return false;
+        out.history_count = static_cast<uint32_t>(n.integer());
+    } else if (key == "tempHistory") {
+        return c.deci_array(&out.temp_history);
+    } else if (key == "humidHistory") {
+        return c.deci_array(&out.humid_history);
+    } else if (key == "lightHistory") {
+        return c.deci_array(&out.light_history);
+    } else if (key == "motionHistory") {
+        return c.flag_array(&out.motion_history);
+    } else {
+        return c.skip_value();
+    }
+    return true;
+}
+
+}  // namespace
+
+bool parse_desk_data(std::string_view json, DeskData &out) {
+    out.clear();
+    Cursor c(json);
+    if (!c.eat('{')) {
+        return false;
+    }
+    if (!c.eat('}')) {
+        do {
+            std::string_view key;
+            if (!c.string(&key) || !c.eat(':') || !read_value(c, key, out)) {
+                return false;
+            }
+        } while (c.eat(','));
+        if (!c.eat('}')) {
+            return false;
+        }
+    }
+    if (!c.at_end()) {
+        return false;
+    }
+
+    size_t count = out.history_count;
+    if (out.temp_history.size() != count || out.humid_history.size() != count ||
+        out.light_history.size() != count || out.motion_history.size() != count) {
+        return false;
+    }
+    return count == 0 || out.seq - out.first_seq + 1 == count;
+}
+
+}  // namespace collector
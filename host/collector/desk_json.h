@@ -0,0 +1,46 @@
+#pragma once
+
+// Parser for the /data document a desk serves (main.c, snapshot_render()).
+//
+// Not a general JSON parser: it walks the flat top-level object, keeps the
+// fields the collector stores and skips everything else, so new fields on
+// the desk side do not break older collectors. Sensor values are read as
+// deci-units, matching the firmware, and never go through floating point.
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace collector {
+
+struct DeskData {
+    // Live values of the newest sample
+    int32_t temperature = 0;        // °C x10
+    int32_t humidity = 0;           // %RH x10
+    int32_t light = 0;              // % x10
+    bool motion_detected = false;
+    uint32_t motion_count = 0;
+    uint32_t fan_speed = 0;
+    bool session_active = false;
+    uint32_t session_seconds = 0;
+    uint32_t dht_failures = 0;
+    uint64_t uptime_us = 0;
+
+    // Samples first_seq..seq, oldest first
+    uint32_t seq = 0;
+    uint32_t first_seq = 0;
+    uint32_t history_count = 0;
+    std::vector<int16_t> temp_history;
+    std::vector<int16_t> humid_history;
+    std::vector<int16_t> light_history;
+    std::vector<uint8_t> motion_history;
+
+    void clear();
+};
+
+// false on malformed input or series that disagree with historyCount.
+// out's vectors keep their capacity across calls.
+bool parse_desk_data(std::string_view json, DeskData &out);
+
+}  // namespace collector
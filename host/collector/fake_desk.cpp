@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "numfmt.h"
+#include "fake_desk.h"
+
+namespace collector {
+
+namespace {
+
+constexpr uint32_t kHistorySize = 60;   // HISTORY_SIZE in history.h
+constexpr size_t kRequestMax = 8192;
+constexpr size_t kRenderSize = 4096;
+
+int64_t now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+int32_t walk(uint32_t *rng, int32_t v, int32_t step, int32_t lo, int32_t hi) {
+    // xorshift32
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 17;
+    *rng ^= *rng << 5;
+    v += static_cast<int32_t>(*rng % (2 * step + 1)) - step;
+    return std::min(std::max(v, lo), hi);
+}
+
+}  // namespace
+
+struct FakeDesks::Handle {
+    enum Kind { LISTEN, CONN } kind;
+    void *ptr;
+};
+
+struct FakeDesks::Desk {
+    size_t index = 0;
+    int fd = -1;
+    uint16_t port = 0;
+    Handle handle{};
+    uint32_t rng = 1;
+    uint64_t ticks = 0;
+
+    // Ring of the last kHistorySize samples, indexed by seq
+    uint32_t seq = 0;
+    uint32_t count = 0;
+    int16_t temp[kHistorySize] = {};
+    int16_t humid[kHistorySize] = {};
+    int16_t light[kHistorySize] = {};
+    bool motion[kHistorySize] = {};
+
+    uint32_t motion_count = 0;
+    bool session_active = false;
+    uint32_t session_seconds = 0;
+    uint32_t dht_reads = 0;
+};
+
+struct FakeDesks::Conn {
+    int fd = -1;
+    Desk *desk = nullptr;
+    Handle handle{};
+    std::string in;
+    std::string out;
+    size_t out_off = 0;
+    bool close_after = false;
+    bool want_write = false;
+};
+
+FakeDesks::FakeDesks(const FakeDeskOptions &options) : options_(options) {
+    for (size_t i = 0; i < options.count; i++) {
+        Desk *d = new Desk();
+        d->index = i;
+        d->handle = Handle{Handle::LISTEN, d};
+        d->rng = options.seed * 2654435761u + static_cast<uint32_t>(i) * 40503u + 1;
+        d->temp[0] = 220;
+        d->humid[0] = 450;
+        d->light[0] = 500;
+        advance(*d, kHistorySize);
+        desks_.push_back(d);
+    }
+}
+
+FakeDesks::~FakeDesks() {
+    for (Conn *c : conns_) {
+        close(c->fd);
+        delete c;
+    }
+    for (Desk *d : desks_) {
+        if (d->fd >= 0) {
+            close(d->fd);
+        }
+        delete d;
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+uint16_t FakeDesks::port(size_t i) const {
+    return desks_[i]->port;
+}
+
+bool FakeDesks::start() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        perror("epoll_create1");
+        return false;
+    }
+    for (Desk *d : desks_) {
+        d->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(d->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sa.sin_port = htons(options_.base_port == 0 ? 0 : options_.base_port + d->index);
+        if (bind(d->fd, reinterpret_cast<sockaddr *>(&sa), sizeof(sa)) != 0 || listen(d->fd, 128) != 0) {
+            fprintf(stderr, "fake desk %zu: cannot listen: %s\n", d->index, strerror(errno));
+            return false;
+        }
+        socklen_t len = sizeof(sa);
+        getsockname(d->fd, reinterpret_cast<sockaddr *>(&sa), &len);
+        d->port = ntohs(sa.sin_port);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &d->handle;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, d->fd, &ev);
+    }
+    start_ms_ = now_ms();
+    return true;
+}
+
+void FakeDesks::advance(Desk &d, uint32_t samples) {
+    for (uint32_t n = 0; n < samples; n++) {
+        uint32_t prev = d.seq % kHistorySize;
+        d.seq++;
+        uint32_t at = d.seq % kHistorySize;
+        d.temp[at] = static_cast<int16_t>(walk(&d.rng, d.temp[prev], 2, 150, 350));
+        d.humid[at] = static_cast<int16_t>(walk(&d.rng, d.humid[prev], 5, 200, 800));
+        d.light[at] = static_cast<int16_t>(walk(&d.rng, d.light[prev], 20, 0, 1000));
+        bool motion = walk(&d.rng, 0, 10, 0, 10) >= 9 ? !d.motion[prev] : d.motion[prev];
+        d.motion[at] = motion;
+        if (motion && !d.motion[prev]) {
+            d.motion_count++;
+            d.session_active = true;
+        }
+        if (d.session_active) {
+            d.session_seconds++;
+        }
+        d.dht_reads++;
+        d.count = std::min(d.count + 1, kHistorySize);
+        d.ticks++;
+    }
+}
+
+std::string FakeDesks::render(size_t i, uint32_t since) const {
+    const Desk &d = *desks_[i];
+    uint32_t oldest = d.seq - d.count + 1;
+    uint32_t first = oldest;
+    if (since >= oldest && since <= d.seq) {
+        first = since + 1;
+    }
+    int32_t temp = d.temp[d.seq % kHistorySize];
+    int32_t humid = d.humid[d.seq % kHistorySize];
+    int32_t light = d.light[d.seq % kHistorySize];
+    uint32_t ldr = 4095 - static_cast<uint32_t>(light) * 4095 / 1000;
+
+    char buf[kRenderSize];
+    char *p = PUT_LIT(buf, "{\"temperature\":");
+    p = put_deci(p, temp);
+    p = PUT_LIT(p, ",\"temperatureF\":");
+    p = put_deci(p, temp * 9 / 5 + 320);
+    p = PUT_LIT(p, ",\"humidity\":");
+    p = put_deci(p, humid);
+    p = PUT_LIT(p, ",\"ldrValue\":");
+    p = put_i32(p, static_cast<int32_t>(ldr));
+    p = PUT_LIT(p, ",\"ldrMillivolts\":");
+    p = put_u32(p, ldr * 3300 / 4095);
+    p = PUT_LIT(p, ",\"lightPercentage\":");
+    p = put_deci(p, light);
+    p = PUT_LIT(p, ",\"motionDetected\":");
+    p = put_bool(p, d.motion[d.seq % kHistorySize]);
+    p = PUT_LIT(p, ",\"motionCount\":");
+    p = put_i32(p, static_cast<int32_t>(d.motion_count));
+    p = PUT_LIT(p, ",\"motionEvents\":[],\"uptimeUs\":");
+    p = put_u64(p, d.ticks * 1000000);
+    p = PUT_LIT(p, ",\"ledOn\":");
+    p = put_bool(p, light < 500);
+    p = PUT_LIT(p, ",\"buzzerOn\":false,\"fanSpeed\":");
+    p = put_u32(p, temp >= 300 ? 255 : temp >= 260 ? 128 : 0);
+    p = PUT_LIT(p, ",\"sessionActive\":");
+    p = put_bool(p, d.session_active);
+    p = PUT_LIT(p, ",\"sessionSeconds\":");
+    p = put_u32(p, d.session_seconds);
+    p = PUT_LIT(p, ",\"dhtReads\":");
+    p = put_u32(p, d.dht_reads);
+    p = PUT_LIT(p, ",\"dhtFailures\":0,\"lcdTransactions\":0,\"lcdBytes\":0,\"sampleMaxUs\":0,\"seq\":");
+    p = put_u32(p, d.seq);
+    p = PUT_LIT(p, ",\"historySize\":");
+    p = put_u32(p, kHistorySize);
+    p = PUT_LIT(p, ",\"firstSeq\":");
+    p = put_u32(p, first);
+
+    static const char *const keys[] = {
+        ",\"tempHistory\":[", "],\"humidHistory\":[", "],\"lightHistory\":[", "],\"motionHistory\":[",
+    };
+    for (int s = 0; s < 4; s++) {
+        p = put_bytes(p, keys[s], strlen(keys[s]));
+        for (uint32_t n = first; n <= d.seq; n++) {
+            uint32_t at = n % kHistorySize;
+            if (n != first) {
+                *p++ = ',';
+            }
+            if (s == 0) {
+                p = put_deci(p, d.temp[at]);
+            } else if (s == 1) {
+                p = put_deci(p, d.humid[at]);
+            } else if (s == 2) {
+                p = put_deci(p, d.light[at]);
+            } else {
+                *p++ = d.motion[at] ? '1' : '0';
+            }
+        }
+    }
+    p = PUT_LIT(p, "],\"historyCount\":");
+    p = put_u32(p, d.seq + 1 - first);
+    *p++ = '}';
+    return std::string(buf, p - buf);
+}
+
+void FakeDesks::poll(int max_wait_ms) {
+    if (!options_.tick_per_request) {
+        uint64_t due = static_cast<uint64_t>(now_ms() - start_ms_) / 1000 + kHistorySize;
+        for (Desk *d : desks_) {
+            if (due > d->ticks) {
+                advance(*d, static_cast<uint32_t>(due - d->ticks));
+            }
+        }
+    }
+
+    epoll_event events[256];
+    int n = epoll_wait(epoll_fd_, events, 256, max_wait_ms);
+    for (int i = 0; i < n; i++) {
+        Handle *h = static_cast<Handle *>(events[i].data.ptr);
+        if (h->kind == Handle::LISTEN) {
+            accept_all(*static_cast<Desk *>(h->ptr));
+        } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            drop(static_cast<Conn *>(h->ptr));
+        } else {
+            serve(static_cast<Conn *>(h->ptr));
+        }
+    }
+}
+
+void FakeDesks::accept_all(Desk &d) {
+    while (true) {
+        int fd = accept4(d.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Conn *c = new Conn();
+        c->fd = fd;
+        c->desk = &d;
+        c->handle = Handle{Handle::CONN, c};
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = &c->handle;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        conns_.push_back(c);
+    }
+}
+
+void FakeDesks::drop(Conn *c) {
+    close(c->fd);
+    auto it = std::find(conns_.begin(), conns_.end(), c);
+    if (it != conns_.end()) {
+        *it = conns_.back();
+        conns_.pop_back();
+    }
+    delete c;
+}
+
+void FakeDesks::serve(Conn *c) {
+    char buf[16384];
+    bool peer_closed = false;
+    while (true) {
+        ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c->in.append(buf, n);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            peer_closed = true;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+
+    // Answer every complete request, in order
+    size_t pos = 0;
+    size_t end;
+    while (!c->close_after && (end = c->in.find("\r\n\r\n", pos)) != std::string::npos) {
+        std::string head = c->in.substr(pos, end - pos);
+        pos = end + 4;
+        requests_++;
+        for (char &ch : head) {
+            ch = static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+        }
+        c->close_after = head.find("\r\nconnection: close") != std::string::npos;
+
+        std::string body;
+        const char *status = "200 OK";
+        if (head.compare(0, 10, "get /data ") == 0 || head.compare(0, 10, "get /data?") == 0) {
+            uint32_t since = 0;
+            size_t q = head.find("since=");
+            size_t eol = head.find(' ', 4);
+            if (q != std::string::npos && q < eol) {
+                since = static_cast<uint32_t>(strtoul(head.c_str() + q + 6, nullptr, 10));
+            }
+            if (options_.tick_per_request) {
+                advance(*c->desk, 1);
+            }
+            body = render(c->desk->index, since);
+        } else {
+            status = "404 Not Found";
+            body = "Not Found";
+        }
+
+        char hdr[160];
+        int len = snprintf(hdr, sizeof(hdr), "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n",
+                           status, body[0] == '{' ? "application/json" : "text/html", body.size(),
+                           c->close_after ? "Connection: close\r\n" : "");
+        c->out.append(hdr, len);
+        c->out += body;
+    }
+    c->in.erase(0, pos);
+    if (c->in.size() > kRequestMax) {
+        drop(c);
+        return;
+    }
+
+    while (c->out_off < c->out.size()) {
+        ssize_t n = send(c->fd, c->out.data() + c->out_off, c->out.size() - c->out_off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                drop(c);
+                return;
+            }
+            break;
+        }
+        c->out_off += static_cast<size_t>(n);
+    }
+    bool pending = c->out_off < c->out.size();
+    if (!pending) {
+        c->out.clear();
+        c->out_off = 0;
+        if (c->close_after || peer_closed) {
+            drop(c);
+            return;
+        }
+    } else if (peer_closed) {
+        drop(c);
+        return;
+    }
+    if (pending != c->want_write) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        if (pending) {
+            ev.events |= EPOLLOUT;
+        }
+        ev.data.ptr = &c->handle;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c->fd, &ev);
+        c->want_write = pending;
+    }
+}
+
+}  // namespace collector
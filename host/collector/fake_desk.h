@@ -0,0 +1,64 @@
+#pragma once
+
+// Simulated desks for exercising the collector without hardware.
+//
+// Each desk listens on its own port and answers GET /data[?since=<seq>]
+// with the document data_handler() produces, byte for byte in format:
+// the same keys in the same order, the same deci-unit numbers, a 60-sample
+// ring and the same since/firstSeq rules. Values follow a slow random walk.
+// Connections are HTTP/1.1 keep-alive and pipelined requests are answered
+// in order, with all responses to one read written together.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace collector {
+
+struct FakeDeskOptions {
+    size_t count = 1;
+    uint16_t base_port = 0;         // Desk i listens on base_port + i; 0: ephemeral ports
+    bool tick_per_request = false;  // Add one sample per request instead of per second
+    uint32_t seed = 1;
+};
+
+class FakeDesks {
+public:
+    explicit FakeDesks(const FakeDeskOptions &options);
+    ~FakeDesks();
+    FakeDesks(const FakeDesks &) = delete;
+    FakeDesks &operator=(const FakeDesks &) = delete;
+
+    // Open the listening sockets; false with a message on stderr
+    bool start();
+
+    // Wait up to max_wait_ms for I/O and serve what arrived
+    void poll(int max_wait_ms);
+
+    size_t count() const { return desks_.size(); }
+    uint16_t port(size_t i) const;
+    uint64_t requests() const { return requests_; }
+
+    // Render desk i's /data document as data_handler() would for since
+    std::string render(size_t i, uint32_t since) const;
+
+private:
+    struct Desk;
+    struct Conn;
+    struct Handle;
+
+    void accept_all(Desk &d);
+    void serve(Conn *c);
+    void drop(Conn *c);
+    void advance(Desk &d, uint32_t samples);
+
+    FakeDeskOptions options_;
+    std::vector<Desk *> desks_;
+    std::vector<Conn *> conns_;
+    int epoll_fd_ = -1;
+    int64_t start_ms_ = 0;
+    uint64_t requests_ = 0;
+};
+
+}  // namespace collector
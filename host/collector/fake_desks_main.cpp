@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "fake_desk.h"
+
+// Serves simulated desks on consecutive ports, for running the collector
+// against a fleet without starting one desk_sim per desk.
+
+int main(int argc, char **argv) {
+    collector::FakeDeskOptions options;
+    options.base_port = 9000;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--port") == 0 && val != nullptr) {
+            options.base_port = static_cast<uint16_t>(atoi(val));
+            i++;
+        } else if (strcmp(arg, "--count") == 0 && val != nullptr) {
+            options.count = strtoul(val, nullptr, 10);
+            i++;
+        } else if (strcmp(arg, "--seed") == 0 && val != nullptr) {
+            options.seed = static_cast<uint32_t>(strtoul(val, nullptr, 0));
+            i++;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  --port N   first desk's port; desk i listens on N+i (default 9000)\n"
+                    "  --count N  number of desks (default 1)\n"
+                    "  --seed N   PRNG seed for the sensor values (default 1)\n",
+                    argv[0]);
+            return arg[2] == 'h' ? 0 : 2;
+        }
+    }
+
+    collector::FakeDesks desks(options);
+    if (!desks.start()) {
+        return 1;
+    }
+    printf("%zu desks on 127.0.0.1:%u-%u\n", desks.count(), desks.port(0), desks.port(desks.count() - 1));
+    fflush(stdout);
+    while (true) {
+        desks.poll(100);
+    }
+}
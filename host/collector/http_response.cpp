@@ -0,0 +1,192 @@
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include "http_response.h"
+
+namespace collector {
+
+namespace {
+
+constexpr size_t kMaxHead = 8192;
+constexpr size_t kMaxBody = 1 << 20;
+
+// Case-insensitive header lookup in the header block; the value is trimmed
+bool header_value(const std::string &head, const char *field, std::string *out) {
+    size_t field_len = strlen(field);
+    size_t pos = head.find("\r\n");
+    while (pos != std::string::npos && pos + 2 < head.size()) {
+        size_t line = pos + 2;
+        size_t eol = head.find("\r\n", line);
+        if (eol == std::string::npos) {
+            eol = head.size();
+        }
+        if (eol - line > field_len && head[line + field_len] == ':' &&
+            strncasecmp(head.data() + line, field, field_len) == 0) {
+            size_t v = line + field_len + 1;
+            while (v < eol && (head[v] == ' ' || head[v] == '\t')) {
+                v++;
+            }
+            size_t e = eol;
+            while (e > v && (head[e - 1] == ' ' || head[e - 1] == '\t')) {
+                e--;
+            }
+            out->assign(head, v, e - v);
+            return true;
+        }
+        pos = eol;
+    }
+    return false;
+}
+
+}  // namespace
+
+void ResponseParser::reset() {
+    state_ = State::Headers;
+    head_.clear();
+    line_.clear();
+    body_.clear();
+    remaining_ = 0;
+    status_ = 0;
+    keep_alive_ = true;
+    chunked_ = false;
+}
+
+bool ResponseParser::parse_headers() {
+    // "HTTP/1.1 200 OK"
+    if (head_.compare(0, 5, "HTTP/") != 0 || head_.size() < 12) {
+        return false;
+    }
+    bool http10 = head_.compare(5, 3, "1.0") == 0;
+    status_ = atoi(head_.c_str() + 9);
+    if (status_ < 100 || status_ > 599) {
+        return false;
+    }
+
+    std::string value;
+    keep_alive_ = !http10;
+    if (header_value(head_, "Connection", &value)) {
+        if (strcasecmp(value.c_str(), "close") == 0) {
+            keep_alive_ = false;
+        } else if (strcasecmp(value.c_str(), "keep-alive") == 0) {
+            keep_alive_ = true;
+        }
+    }
+    if (header_value(head_, "Transfer-Encoding", &value) && strcasecmp(value.c_str(), "chunked") == 0) {
+        chunked_ = true;
+        state_ = State::ChunkSize;
+        return true;
+    }
+    if (header_value(head_, "Content-Length", &value)) {
+        char *end;
+        unsigned long long n = strtoull(value.c_str(), &end, 10);
+        if (*end != '\0' || n > kMaxBody) {
+            return false;
+        }
+        remaining_ = static_cast<size_t>(n);
+        state_ = State::Body;
+        return true;
+    }
+    // Neither: a bodiless status, or a body up to connection close, which a
+    // keep-alive scraper cannot use
+    if (status_ == 204 || status_ == 304 || status_ < 200) {
+        remaining_ = 0;
+        state_ = State::Body;
+        return true;
+    }
+    return false;
+}
+
+ResponseParser::Result ResponseParser::feed(const char *data, size_t len, size_t *consumed) {
+    size_t i = 0;
+    while (true) {
+        switch (state_) {
+        case State::Headers: {
+            // Scan only the new bytes, with three of the old ones for a
+            // terminator split across reads
+            size_t old = head_.size();
+            head_.append(data + i, len - i);
+            size_t from = old < 3 ? 0 : old - 3;
+            size_t end = head_.find("\r\n\r\n", from);
+            if (end == std::string::npos) {
+                i = len;
+                if (head_.size() > kMaxHead) {
+                    *consumed = i;
+                    return Result::Error;
+                }
+                *consumed = i;
+                return Result::NeedMore;
+            }
+            i += end + 4 - old;
+            head_.resize(end + 2);  // Keep the last header's CRLF
+            if (!parse_headers()) {
+                *consumed = i;
+                return Result::Error;
+            }
+            break;
+        }
+        case State::Body: {
+            size_t n = len - i < remaining_ ? len - i : remaining_;
+            body_.append(data + i, n);
+            i += n;
+            remaining_ -= n;
+            *consumed = i;
+            return remaining_ == 0 ? Result::Done : Result::NeedMore;
+        }
+        case State::ChunkSize:
+        case State::ChunkEnd:
+        case State::Trailers: {
+            // Line-oriented states; a partial line waits in line_
+            const char *nl = static_cast<const char *>(memchr(data + i, '\n', len - i));
+            if (nl == nullptr) {
+                line_.append(data + i, len - i);
+                i = len;
+                *consumed = i;
+                return line_.size() > 256 ? Result::Error : Result::NeedMore;
+            }
+            line_.append(data + i, nl - (data + i));
+            i = nl - data + 1;
+            if (!line_.empty() && line_.back() == '\r') {
+                line_.pop_back();
+            }
+            std::string line;
+            line.swap(line_);
+            if (state_ == State::ChunkEnd) {
+                if (!line.empty()) {
+                    *consumed = i;
+                    return Result::Error;
+                }
+                state_ = State::ChunkSize;
+            } else if (state_ == State::Trailers) {
+                if (line.empty()) {
+                    *consumed = i;
+                    return Result::Done;
+                }
+            } else {
+                char *end;
+                unsigned long n = strtoul(line.c_str(), &end, 16);
+                if (end == line.c_str() || body_.size() + n > kMaxBody) {
+                    *consumed = i;
+                    return Result::Error;
+                }
+                remaining_ = n;
+                state_ = n == 0 ? State::Trailers : State::ChunkData;
+            }
+            break;
+        }
+        case State::ChunkData: {
+            size_t n = len - i < remaining_ ? len - i : remaining_;
+            body_.append(data + i, n);
+            i += n;
+            remaining_ -= n;
+            if (remaining_ > 0) {
+                *consumed = i;
+                return Result::NeedMore;
+            }
+            state_ = State::ChunkEnd;
+            break;
+        }
+        }
+    }
+}
+
+}  // namespace collector
@@ -0,0 +1,43 @@
+#pragma once
+
+// Incremental HTTP/1.1 response parser for the scraper.
+//
+// Bytes are fed as they arrive; a response can end anywhere in a read and
+// the next pipelined response can start in the same one. Bodies are framed
+// by Content-Length or chunked transfer encoding, the two the desks' server
+// uses (/data is sent whole, /history and /metrics in chunks).
+
+#include <cstddef>
+#include <string>
+
+namespace collector {
+
+class ResponseParser {
+public:
+    enum class Result { NeedMore, Done, Error };
+
+    // Parse from data; *consumed is set to the bytes used. After Done, the
+    // response is available until the next reset().
+    Result feed(const char *data, size_t len, size_t *consumed);
+    void reset();
+
+    int status() const { return status_; }
+    bool keep_alive() const { return keep_alive_; }
+    const std::string &body() const { return body_; }
+
+private:
+    enum class State { Headers, Body, ChunkSize, ChunkData, ChunkEnd, Trailers };
+
+    bool parse_headers();
+
+    State state_ = State::Headers;
+    std::string head_;
+    std::string line_;
+    std::string body_;
+    size_t remaining_ = 0;
+    int status_ = 0;
+    bool keep_alive_ = true;
+    bool chunked_ = false;
+};
+
+}  // namespace collector
@@ -0,0 +1,163 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include "collector.h"
+
+// Linux entry point for the fleet collector: scrapes the configured desks
+// and serves /fleet and /series until interrupted.
+
+using collector::Collector;
+using collector::CollectorOptions;
+using collector::DeskConfig;
+
+namespace {
+
+volatile sig_atomic_t stopping = 0;
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options] --desk NAME=HOST:PORT ...\n"
+            "  --desk NAME=HOST:PORT  scrape one desk (repeatable)\n"
+            "  --desks FILE           desk list, one \"NAME HOST:PORT\" per line, # comments\n"
+            "  --interval MS          scrape interval per desk (default 2000)\n"
+            "  --pipeline N           requests in flight per connection (default 1)\n"
+            "  --no-keepalive         one connection per scrape\n"
+            "  --timeout MS           fail a desk silent for this long (default 5000)\n"
+            "  --capacity N           samples kept per desk (default 3600)\n"
+            "  --api-port N           aggregated API listen port (default 8090)\n"
+            "  --status S             print a fleet summary every S seconds (default 10, 0 off)\n",
+            prog);
+}
+
+// "HOST:PORT", the port defaulting to 80
+bool parse_address(const std::string &text, DeskConfig *desk) {
+    size_t colon = text.rfind(':');
+    desk->host = text.substr(0, colon);
+    desk->port = 80;
+    if (colon != std::string::npos) {
+        char *end;
+        unsigned long port = strtoul(text.c_str() + colon + 1, &end, 10);
+        if (*end != '\0' || port == 0 || port > 65535) {
+            return false;
+        }
+        desk->port = static_cast<uint16_t>(port);
+    }
+    return !desk->host.empty();
+}
+
+bool load_desks(const char *path, std::vector<DeskConfig> *desks) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.resize(hash);
+        }
+        std::istringstream fields(line);
+        std::string name, address;
+        if (!(fields >> name)) {
+            continue;
+        }
+        DeskConfig desk;
+        desk.name = name;
+        if (!(fields >> address) || !parse_address(address, &desk)) {
+            fprintf(stderr, "%s:%d: expected \"NAME HOST:PORT\"\n", path, number);
+            return false;
+        }
+        desks->push_back(desk);
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    CollectorOptions options;
+    options.api_port = 8090;
+    std::vector<DeskConfig> desks;
+    int status_s = 10;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--desk") == 0 && val != nullptr) {
+            const char *eq = strchr(val, '=');
+            DeskConfig desk;
+            if (eq == nullptr || eq == val || !parse_address(eq + 1, &desk)) {
+                fprintf(stderr, "bad --desk %s, expected NAME=HOST:PORT\n", val);
+                return 2;
+            }
+            desk.name.assign(val, eq - val);
+            desks.push_back(desk);
+            i++;
+        } else if (strcmp(arg, "--desks") == 0 && val != nullptr) {
+            if (!load_desks(val, &desks)) {
+                return 2;
+            }
+            i++;
+        } else if (strcmp(arg, "--interval") == 0 && val != nullptr) {
+            options.interval_ms = atoi(val);
+            i++;
+        } else if (strcmp(arg, "--pipeline") == 0 && val != nullptr) {
+            options.pipeline = atoi(val);
+            i++;
+        } else if (strcmp(arg, "--no-keepalive") == 0) {
+            options.keep_alive = false;
+        } else if (strcmp(arg, "--timeout") == 0 && val != nullptr) {
+            options.timeout_ms = atoi(val);
+            i++;
+        } else if (strcmp(arg, "--capacity") == 0 && val != nullptr) {
+            options.capacity = strtoul(val, nullptr, 10);
+            i++;
+        } else if (strcmp(arg, "--api-port") == 0 && val != nullptr) {
+            options.api_port = static_cast<uint16_t>(atoi(val));
+            i++;
+        } else if (strcmp(arg, "--status") == 0 && val != nullptr) {
+            status_s = atoi(val);
+            i++;
+        } else {
+            usage(argv[0]);
+            return arg[2] == 'h' ? 0 : 2;
+        }
+    }
+    if (desks.empty() || options.capacity == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Collector collector(desks, options);
+    if (!collector.start()) {
+        return 1;
+    }
+    signal(SIGINT, [](int) { stopping = 1; });
+    signal(SIGTERM, [](int) { stopping = 1; });
+    printf("collecting from %zu desks, API on port %u\n", collector.desk_count(), collector.api_port());
+    fflush(stdout);
+
+    time_t next_status = time(nullptr) + status_s;
+    while (!stopping) {
+        collector.poll(100);
+        if (status_s > 0 && time(nullptr) >= next_status) {
+            next_status += status_s;
+            size_t up = 0;
+            for (size_t i = 0; i < collector.desk_count(); i++) {
+                up += collector.stats(i).up;
+            }
+            printf("%zu/%zu desks up, %llu scrapes, %llu errors\n", up, collector.desk_count(),
+                   static_cast<unsigned long long>(collector.total_scrapes()),
+                   static_cast<unsigned long long>(collector.total_errors()));
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "series_store.h"
+
+namespace collector {
+
+SeriesStore::SeriesStore(size_t desks, size_t capacity) : capacity_(capacity), desks_(desks) {
+    for (Columns &c : desks_) {
+        c.seq.resize(capacity);
+        c.time_s.resize(capacity);
+        c.temperature.resize(capacity);
+        c.humidity.resize(capacity);
+        c.light.resize(capacity);
+        c.motion.resize(capacity);
+        c.epoch.resize(capacity);
+    }
+}
+
+size_t SeriesStore::append(size_t desk, const DeskData &data, uint32_t now_s) {
+    Columns &c = desks_[desk];
+    if (data.history_count == 0) {
+        return 0;
+    }
+    uint32_t first = data.first_seq;
+    if (c.any && data.seq < c.last_seq) {
+        c.current_epoch++;  // The desk restarted its sequence
+    } else if (c.any && first <= c.last_seq) {
+        first = c.last_seq + 1;  // Overlap with what is stored already
+    }
+    if (c.any && data.seq == c.last_seq) {
+        return 0;
+    }
+
+    size_t added = 0;
+    for (uint32_t seq = first; seq - data.first_seq < data.history_count && seq <= data.seq; seq++) {
+        size_t i = seq - data.first_seq;
+        size_t slot = c.next_row % capacity_;
+        c.seq[slot] = seq;
+        c.time_s[slot] = now_s - (data.seq - seq);
+        c.temperature[slot] = data.temp_history[i];
+        c.humidity[slot] = data.humid_history[i];
+        c.light[slot] = data.light_history[i];
+        c.motion[slot] = data.motion_history[i];
+        c.epoch[slot] = c.current_epoch;
+        c.next_row++;
+        added++;
+    }
+    c.any = true;
+    c.last_seq = data.seq;
+    return added;
+}
+
+size_t SeriesStore::count(size_t desk) const {
+    uint64_t n = desks_[desk].next_row;
+    return n < capacity_ ? static_cast<size_t>(n) : capacity_;
+}
+
+uint64_t SeriesStore::first_row(size_t desk) const {
+    return desks_[desk].next_row - count(desk);
+}
+
+bool SeriesStore::get(size_t desk, uint64_t row, Sample *out) const {
+    const Columns &c = desks_[desk];
+    if (row < first_row(desk) || row >= c.next_row) {
+        return false;
+    }
+    size_t slot = row % capacity_;
+    *out = Sample{
+        row, c.seq[slot], c.time_s[slot], c.temperature[slot], c.humidity[slot],
+        c.light[slot], c.motion[slot] != 0, c.epoch[slot],
+    };
+    return true;
+}
+
+size_t SeriesStore::memory_bytes() const {
+    size_t per_sample = sizeof(uint32_t) * 2 + sizeof(int16_t) * 3 + sizeof(uint8_t) + sizeof(uint16_t);
+    return desks_.size() * (capacity_ * per_sample + sizeof(Columns));
+}
+
+}  // namespace collector
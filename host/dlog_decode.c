@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+#include "dlog_format.h"
+
+// Expands deferred log records in a captured console log. Lines of the form
+// "#DL <hex>" (written by the dlog task in binary mode) are decoded with the
+// format table this tool was built with and printed as the ESP_LOGx line
+// they stand for; every other line passes through unchanged. Undecodable
+// records are kept as they are and counted on stderr.
+//
+// usage: dlog_decode [capture.txt ...]    (standard input without files)
+
+static unsigned bad_records;
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void decode_line(const char *line) {
+    const char *hex = strstr(line, DLOG_BINARY_LINE);
+    if (hex == NULL) {
+        fputs(line, stdout);
+        return;
+    }
+    uint8_t wire[DLOG_WIRE_MAX];
+    size_t len = 0;
+    const char *s = hex + strlen(DLOG_BINARY_LINE);
+    bool ok = true;
+    while (*s != '\0' && *s != '\n' && *s != '\r') {
+        int hi = hex_digit(s[0]);
+        int lo = hi < 0 ? -1 : hex_digit(s[1]);
+        if (lo < 0 || len == sizeof(wire)) {
+            ok = false;
+            break;
+        }
+        wire[len++] = (uint8_t)(hi << 4 | lo);
+        s += 2;
+    }
+    dlog_record_t rec;
+    if (!ok || !dlog_decode(wire, len, &rec)) {
+        bad_records++;
+        fputs(line, stdout);
+        return;
+    }
+    char text[DLOG_TEXT_MAX];
+    dlog_render(&rec, text, sizeof(text));
+    // Keep whatever the console put in front of the record (e.g. a monitor prefix)
+    fwrite(line, 1, hex - line, stdout);
+    fputs(text, stdout);
+}
+
+static void decode_stream(FILE *in) {
+    char line[512];
+    while (fgets(line, sizeof(line), in) != NULL) {
+        decode_line(line);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        decode_stream(stdin);
+    }
+    for (int i = 1; i < argc; i++) {
+        FILE *in = fopen(argv[i], "r");
+        if (in == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+        decode_stream(in);
+        fclose(in);
+    }
+    if (bad_records > 0) {
+        fprintf(stderr, "dlog_decode: %u records could not be decoded\n", bad_records);
+    }
+    return bad_records > 0 ? 1 : 0;
+}
@@ -0,0 +1,362 @@
+#include <math.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "hal.h"
+#include "dht22.h"
+#include "hal_sim.h"
+
+// Simulated board: smooth sensor waveforms with noise, a presence model
+// driving the PIR, and an HD44780-behind-PCF8574 model for the I2C LCD.
+
+#define SIM_LCD_ADDR        0x27
+#define SIM_TWO_PI          6.283185307179586
+
+// PCF8574 pin mapping used by the LCD backpack
+#define PCF_RS              0x01
+#define PCF_EN              0x04
+
+static const char *TAG = "HAL_SIM";
+
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static hal_sim_config_t sim_config = { .seed = 1 };
+static unsigned int rng_state = 1;
+static hal_sim_stats_t stats;
+static int64_t boot_us;
+
+// Presence model: the user sits at the desk for a while, then walks away.
+// A thread standing in for the GPIO interrupt turns it into PIR edges.
+static bool user_present = true;
+static int64_t presence_until_us;
+static bool pir_level;
+static hal_pir_edge_cb_t pir_edge_cb;
+static void *pir_edge_arg;
+
+// HD44780 model
+static char lcd_ddram[0x80];
+static uint8_t lcd_addr_counter;
+static bool lcd_have_high_nibble;
+static uint8_t lcd_high_nibble;
+static uint8_t lcd_last_pcf;
+
+static double rand_unit(void) {
+    return (double)rand_r(&rng_state) / (double)RAND_MAX;
+}
+
+static double sim_seconds(void) {
+    return (esp_timer_get_time() - boot_us) / 1e6;
+}
+
+void hal_sim_configure(const hal_sim_config_t *config) {
+    pthread_mutex_lock(&sim_lock);
+    sim_config = *config;
+    rng_state = config->seed != 0 ? config->seed : 1;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void hal_sim_lcd_read(char rows[2][17]) {
+    pthread_mutex_lock(&sim_lock);
+    memcpy(rows[0], &lcd_ddram[0x00], 16);
+    memcpy(rows[1], &lcd_ddram[0x40], 16);
+    rows[0][16] = '\0';
+    rows[1][16] = '\0';
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void hal_sim_get_stats(hal_sim_stats_t *out) {
+    pthread_mutex_lock(&sim_lock);
+    *out = stats;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+esp_err_t hal_board_init(void) {
+    memset(lcd_ddram, ' ', sizeof(lcd_ddram));
+    boot_us = esp_timer_get_time();
+    presence_until_us = boot_us + 120 * 1000000LL;
+    ESP_LOGI(TAG, "Simulated board initialized (seed %u)", (unsigned)sim_config.seed);
+    return ESP_OK;
+}
+
+void hal_wifi_connect(const char *ssid, const char *password) {
+    ESP_LOGI(TAG, "Simulated network up (as \"%s\"), serving on the host loopback", ssid);
+}
+
+void hal_wifi_set_credentials(const char *ssid, const char *password) {
+    ESP_LOGI(TAG, "Simulated network rejoined as \"%s\"", ssid);
+}
+
+void hal_wifi_set_power_save(bool enable) {
+    ESP_LOGI(TAG, "Simulated WiFi power save %s", enable ? "on" : "off");
+}
+
+void hal_buzzer_set(bool on) {
+    pthread_mutex_lock(&sim_lock);
+    stats.buzzer_on = on;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void hal_led_set(bool on) {
+    pthread_mutex_lock(&sim_lock);
+    stats.led_on = on;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+bool hal_pir_read(void) {
+    pthread_mutex_lock(&sim_lock);
+    bool level = pir_level;
+    pthread_mutex_unlock(&sim_lock);
+    return level;
+}
+
+static void sleep_us(int64_t us) {
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+// Set the PIR output and raise the "interrupt"; called without sim_lock
+static void pir_edge(bool level) {
+    pthread_mutex_lock(&sim_lock);
+    pir_level = level;
+    stats.pir_edges++;
+    pthread_mutex_unlock(&sim_lock);
+    pir_edge_cb(level, esp_timer_get_time(), pir_edge_arg);
+}
+
+// A seated user trips the PIR in bursts: pulses of 50 ms to 3 s (a good
+// share of them far shorter than a second) separated by 0.2-4 s of
+// stillness. Each edge may ring for a few milliseconds.
+static void *pir_thread(void *arg) {
+    while (1) {
+        pthread_mutex_lock(&sim_lock);
+        int64_t now = esp_timer_get_time();
+        if (now >= presence_until_us) {
+            user_present = !user_present;
+            // Present for 1-5 minutes, away for 5-40 seconds
+            double span_s = user_present ? 60 + rand_unit() * 240 : 5 + rand_unit() * 35;
+            presence_until_us = now + (int64_t)(span_s * 1e6);
+        }
+        bool level = user_present && !pir_level;
+        int64_t hold_us;
+        if (level) {
+            hold_us = rand_unit() < 0.3 ? 50000 + (int64_t)(rand_unit() * 250000)
+                                        : 300000 + (int64_t)(rand_unit() * 2700000);
+        } else {
+            hold_us = 200000 + (int64_t)(rand_unit() * 3800000);
+        }
+        if (now + hold_us > presence_until_us) {
+            hold_us = presence_until_us - now;
+        }
+        int bounces = rand_unit() < sim_config.pir_bounce_rate ? 1 + rand_r(&rng_state) % 3 : 0;
+        int ring_us[3][2];
+        for (int i = 0; i < bounces; i++) {
+            ring_us[i][0] = 200 + rand_r(&rng_state) % 2000;
+            ring_us[i][1] = 100 + rand_r(&rng_state) % 1000;
+        }
+        bool changed = level != pir_level;
+        pthread_mutex_unlock(&sim_lock);
+
+        if (changed) {
+            pir_edge(level);
+            for (int i = 0; i < bounces; i++) {
+                sleep_us(ring_us[i][0]);
+                pir_edge(!level);
+                sleep_us(ring_us[i][1]);
+                pir_edge(level);
+            }
+        }
+        sleep_us(hold_us > 0 ? hold_us : 1000);
+    }
+    return NULL;
+}
+
+esp_err_t hal_pir_set_edge_callback(hal_pir_edge_cb_t cb, void *arg) {
+    pir_edge_cb = cb;
+    pir_edge_arg = arg;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, pir_thread, NULL) != 0) {
+        return ESP_FAIL;
+    }
+    pthread_detach(thread);
+    return ESP_OK;
+}
+
+// LDR: the continuous ADC is modelled as a sample clock started by
+// hal_ldr_start(). Each read waits until a DMA-sized frame would be complete
+// and renders it from the light model plus ADC noise.
+#define SIM_LDR_FRAME       256
+#define SIM_LDR_NOISE       25.0    // Peak counts of conversion noise
+
+static uint32_t ldr_sample_hz;
+static int64_t ldr_next_us;         // Time the next sample is converted
+
+static uint16_t ldr_sample(double seconds) {
+    double light = 0.55 + 0.35 * sin(SIM_TWO_PI * seconds / 300.0);
+    double raw = (1.0 - light) * 4095.0 + (rand_unit() + rand_unit() - 1.0) * SIM_LDR_NOISE;
+    if (raw < 0) raw = 0;
+    if (raw > 4095) raw = 4095;
+    return (uint16_t)lround(raw);
+}
+
+esp_err_t hal_ldr_start(uint32_t sample_hz) {
+    if (sample_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ldr_sample_hz = sample_hz;
+    ldr_next_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "LDR ADC running at %u Hz", (unsigned)sample_hz);
+    return ESP_OK;
+}
+
+size_t hal_ldr_read(uint16_t *raw, size_t max, uint32_t timeout_ms) {
+    if (ldr_sample_hz == 0) {
+        return 0;
+    }
+    size_t n = max < SIM_LDR_FRAME ? max : SIM_LDR_FRAME;
+    int64_t frame_end = ldr_next_us + (int64_t)n * 1000000 / ldr_sample_hz;
+    int64_t wait = frame_end - esp_timer_get_time();
+    if (wait > (int64_t)timeout_ms * 1000) {
+        sleep_us((int64_t)timeout_ms * 1000);
+        return 0;
+    }
+    if (wait > 0) {
+        sleep_us(wait);
+    }
+    pthread_mutex_lock(&sim_lock);
+    for (size_t i = 0; i < n; i++) {
+        int64_t t = ldr_next_us + (int64_t)i * 1000000 / ldr_sample_hz;
+        raw[i] = ldr_sample((t - boot_us) / 1e6);
+    }
+    pthread_mutex_unlock(&sim_lock);
+    ldr_next_us = frame_end;
+    return n;
+}
+
+// Linear fit of a typical eFuse two-point characteristic at 12 dB
+uint32_t hal_ldr_raw_to_mv(uint32_t raw) {
+    return 142 + (raw * 781 + 500) / 1000;
+}
+
+// Pulse with +-jitter_us of sensor timing noise; called with sim_lock held
+static dht22_pulse_t dht_pulse(uint8_t level, int nominal_us, int jitter_us) {
+    int us = nominal_us + (int)lround((rand_unit() * 2.0 - 1.0) * jitter_us);
+    return (dht22_pulse_t){ .duration_us = (uint16_t)us, .level = level };
+}
+
+// The DHT22 is modelled at the waveform level: each frame is rendered as the
+// pulse train the RMT capture records and decoded by the real dht22_decode().
+// Injected failures mimic the field: no answer, a stretched pulse or a
+// flipped data bit (caught by the checksum).
+esp_err_t hal_dht22_read_frame(uint8_t data[5]) {
+    pthread_mutex_lock(&sim_lock);
+    stats.dht_reads++;
+    double t = sim_seconds();
+    double temp = 26.0 + 6.0 * sin(SIM_TWO_PI * t / 600.0) + (rand_unit() - 0.5) * 0.4;
+    double humid = 45.0 + 10.0 * sin(SIM_TWO_PI * t / 900.0) + (rand_unit() - 0.5) * 1.0;
+
+    uint8_t frame[5];
+    uint16_t h = (uint16_t)lround(humid * 10.0);
+    uint16_t tc = (uint16_t)lround(fabs(temp) * 10.0);
+    frame[0] = h >> 8;
+    frame[1] = h & 0xFF;
+    frame[2] = ((tc >> 8) & 0x7F) | (temp < 0 ? 0x80 : 0);
+    frame[3] = tc & 0xFF;
+    frame[4] = (frame[0] + frame[1] + frame[2] + frame[3]) & 0xFF;
+
+    int fault = -1;
+    if (rand_unit() < sim_config.dht_fail_rate) {
+        stats.dht_failures++;
+        fault = rand_r(&rng_state) % 3;
+    }
+    if (fault == 2) {
+        frame[rand_r(&rng_state) % 4] ^= 1 << (rand_r(&rng_state) % 8);
+    }
+
+    dht22_pulse_t pulses[DHT22_MAX_PULSES];
+    size_t count = 0;
+    pulses[count++] = dht_pulse(1, 30, 10);     // Release until the sensor answers
+    if (fault != 0) {
+        pulses[count++] = dht_pulse(0, 80, 3);
+        pulses[count++] = dht_pulse(1, 80, 3);
+        for (int bit = 0; bit < 40; bit++) {
+            bool one = frame[bit / 8] & (1 << (7 - bit % 8));
+            pulses[count++] = dht_pulse(0, 50, 3);
+            pulses[count++] = dht_pulse(1, one ? 70 : 27, 3);
+        }
+        pulses[count++] = dht_pulse(0, 50, 3);
+        if (fault == 1) {
+            pulses[3 + 2 * (rand_r(&rng_state) % 40)].duration_us = 150;
+        }
+    }
+    pthread_mutex_unlock(&sim_lock);
+
+    return dht22_decode(pulses, count, data);
+}
+
+// Called with sim_lock held for each byte latched into the HD44780
+static void lcd_model_byte(uint8_t value, bool is_data) {
+    if (is_data) {
+        lcd_ddram[lcd_addr_counter & 0x7F] = (char)value;
+        lcd_addr_counter = (lcd_addr_counter + 1) & 0x7F;
+    } else if (value == 0x01) {
+        memset(lcd_ddram, ' ', sizeof(lcd_ddram));
+        lcd_addr_counter = 0;
+    } else if ((value & 0xFE) == 0x02) {
+        lcd_addr_counter = 0;
+    } else if (value & 0x80) {
+        lcd_addr_counter = value & 0x7F;
+    }
+}
+
+static void lcd_model_write(const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t pcf = buf[i];
+        // The controller latches the data nibble on the falling edge of EN
+        if ((lcd_last_pcf & PCF_EN) && !(pcf & PCF_EN)) {
+            uint8_t nibble = lcd_last_pcf >> 4;
+            if (!lcd_have_high_nibble) {
+                lcd_high_nibble = nibble;
+                lcd_have_high_nibble = true;
+            } else {
+                lcd_have_high_nibble = false;
+                lcd_model_byte((uint8_t)((lcd_high_nibble << 4) | nibble), lcd_last_pcf & PCF_RS);
+            }
+        }
+        lcd_last_pcf = pcf;
+    }
+}
+
+esp_err_t hal_i2c_write(uint8_t addr, const uint8_t *buf, size_t len, uint32_t timeout_ms) {
+    pthread_mutex_lock(&sim_lock);
+    stats.i2c_transactions++;
+    if (addr != SIM_LCD_ADDR) {
+        stats.i2c_errors++;
+        pthread_mutex_unlock(&sim_lock);
+        return ESP_FAIL;  // Nobody acknowledges the address
+    }
+    if (rand_unit() < sim_config.i2c_fail_rate) {
+        stats.i2c_errors++;
+        bool hang = sim_config.i2c_fail_hangs;
+        pthread_mutex_unlock(&sim_lock);
+        if (hang) {
+            // A slave holding SCL low: the driver gives up at the timeout
+            sleep_us((int64_t)timeout_ms * 1000);
+            return ESP_ERR_TIMEOUT;
+        }
+        return ESP_FAIL;
+    }
+    stats.i2c_bytes += (uint32_t)len;
+    lcd_model_write(buf, len);
+    pthread_mutex_unlock(&sim_lock);
+    return ESP_OK;
+}
+
+void hal_fan_set_duty(uint32_t duty) {
+    pthread_mutex_lock(&sim_lock);
+    stats.fan_duty = duty;
+    pthread_mutex_unlock(&sim_lock);
+}
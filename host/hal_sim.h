@@ -0,0 +1,34 @@
+#pragma once
+
+// Host-only controls and introspection for the simulated board (hal_sim.c)
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t seed;          // PRNG seed for sensor noise and presence model
+    float dht_fail_rate;    // Probability of a bad DHT22 frame (no answer, bad timing, bit flip)
+    float i2c_fail_rate;    // Probability that an I2C transaction fails
+    bool i2c_fail_hangs;    // Failures stall for the full timeout instead of a fast NACK
+    float pir_bounce_rate;  // Probability that a PIR edge rings for a few ms
+} hal_sim_config_t;
+
+typedef struct {
+    uint32_t i2c_transactions;
+    uint32_t i2c_bytes;
+    uint32_t i2c_errors;
+    uint32_t dht_reads;
+    uint32_t dht_failures;
+    uint32_t pir_edges;
+    uint32_t fan_duty;
+    bool led_on;
+    bool buzzer_on;
+} hal_sim_stats_t;
+
+// Must be called before hal_board_init()
+void hal_sim_configure(const hal_sim_config_t *config);
+
+// Copy the two visible LCD rows (16 characters each, NUL terminated)
+void hal_sim_lcd_read(char rows[2][17]);
+
+void hal_sim_get_stats(hal_sim_stats_t *out);
@@ -0,0 +1,346 @@
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+// HTTP load generator for a desk (desk_sim or a board). For each client
+// count it runs that many closed-loop clients for a fixed time, each
+// requesting the same path over and over on a keep-alive connection, and
+// reports throughput, p50/p99/max latency and the share of requests that
+// failed. A request fails when it gets no complete response or a non-2xx
+// status; 503s (the server shedding load) are also shown on their own.
+//
+// Like a browser, a client whose kept-alive connection was closed before
+// any of the response arrived (the server purged it as idle) reconnects and
+// sends the request again; those retries are counted but are not failures.
+//
+// usage: http_load [--host ADDR] [--port N] [--path PATH] [--seconds S]
+//                  [--clients 1,2,4,8,16,32] [--close]
+//   --close   a new connection for every request, no keep-alive
+
+#define LOAD_BUF_SIZE       16384
+#define LOAD_TIMEOUT_S      10
+#define LOAD_LEVELS_MAX     16
+#define LOAD_CLIENTS_MAX    256
+
+typedef struct {
+    int fd;
+    size_t len;
+    char buf[LOAD_BUF_SIZE];
+} conn_t;
+
+typedef struct {
+    pthread_t thread;
+    conn_t conn;
+    uint32_t *latency_us;
+    size_t count;           // Completed requests, including failed ones
+    size_t cap;
+    uint32_t failed;
+    uint32_t busy;          // 503s, also in failed
+    uint32_t retries;
+} client_t;
+
+static const char *host = "127.0.0.1";
+static const char *port = "8080";
+static const char *path = "/data";
+static bool close_each;
+static struct addrinfo *addr;
+static char request[512];
+static size_t request_len;
+static double deadline;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool conn_open(conn_t *c) {
+    c->len = 0;
+    c->fd = socket(addr->ai_family, SOCK_STREAM, 0);
+    if (c->fd < 0) {
+        return false;
+    }
+    struct timeval tv = { .tv_sec = LOAD_TIMEOUT_S };
+    setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(c->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(c->fd, addr->ai_addr, addr->ai_addrlen) != 0) {
+        close(c->fd);
+        c->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+static void conn_close(conn_t *c) {
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    c->fd = -1;
+    c->len = 0;
+}
+
+static bool conn_fill(conn_t *c) {
+    if (c->len == sizeof(c->buf)) {
+        return false;
+    }
+    ssize_t n;
+    do {
+        n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return false;
+    }
+    c->len += (size_t)n;
+    return true;
+}
+
+static void conn_drop(conn_t *c, size_t n) {
+    memmove(c->buf, c->buf + n, c->len - n);
+    c->len -= n;
+}
+
+// Consume n bytes of body, reading as needed
+static bool conn_skip(conn_t *c, size_t n) {
+    while (n > 0) {
+        if (c->len == 0 && !conn_fill(c)) {
+            return false;
+        }
+        size_t take = n < c->len ? n : c->len;
+        conn_drop(c, take);
+        n -= take;
+    }
+    return true;
+}
+
+// Length of the next line including its CRLF, reading until it is buffered
+static size_t conn_line(conn_t *c) {
+    while (1) {
+        char *nl = memmem(c->buf, c->len, "\r\n", 2);
+        if (nl != NULL) {
+            return nl + 2 - c->buf;
+        }
+        if (!conn_fill(c)) {
+            return 0;
+        }
+    }
+}
+
+// Read one response. Returns its status, 0 if the connection failed
+// before the end of it; *got_any tells whether any of it had arrived.
+static int read_response(conn_t *c, bool *keep_alive, bool *got_any) {
+    char *end;
+    *got_any = c->len > 0;
+    while ((end = memmem(c->buf, c->len, "\r\n\r\n", 4)) == NULL) {
+        if (!conn_fill(c)) {
+            return 0;
+        }
+        *got_any = true;
+    }
+    size_t hdr_len = end + 4 - c->buf;
+    char headers[2048];
+    if (hdr_len >= sizeof(headers) || strncmp(c->buf, "HTTP/1.", 7) != 0) {
+        return 0;
+    }
+    memcpy(headers, c->buf, hdr_len);
+    headers[hdr_len] = '\0';
+    conn_drop(c, hdr_len);
+
+    int status = atoi(headers + 9);
+    *keep_alive = strcasestr(headers, "\r\nConnection: close") == NULL;
+    const char *cl = strcasestr(headers, "\r\nContent-Length:");
+    if (cl != NULL) {
+        return conn_skip(c, strtoul(cl + 17, NULL, 10)) ? status : 0;
+    }
+    if (strcasestr(headers, "\r\nTransfer-Encoding: chunked") == NULL) {
+        return 0;
+    }
+    while (1) {
+        size_t line = conn_line(c);
+        if (line == 0) {
+            return 0;
+        }
+        size_t size = strtoul(c->buf, NULL, 16);
+        conn_drop(c, line);
+        if (!conn_skip(c, size + 2)) {  // Data and its CRLF; the last chunk has none
+            return 0;
+        }
+        if (size == 0) {
+            return status;
+        }
+    }
+}
+
+static bool send_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// One request, from the connect (if one is needed) to the end of the body
+static int client_request(client_t *cl) {
+    conn_t *c = &cl->conn;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = c->fd >= 0;
+        if (!reused && !conn_open(c)) {
+            return 0;
+        }
+        bool keep_alive = false;
+        bool got_any = false;
+        int status = send_all(c->fd, request, request_len) ? read_response(c, &keep_alive, &got_any) : 0;
+        if (status == 0 || !keep_alive || close_each) {
+            conn_close(c);
+        }
+        if (status != 0 || !reused || got_any) {
+            return status;
+        }
+        cl->retries++;
+    }
+    return 0;
+}
+
+static void *client_run(void *arg) {
+    client_t *cl = arg;
+    cl->conn.fd = -1;
+    while (now_s() < deadline) {
+        double start = now_s();
+        int status = client_request(cl);
+        double elapsed = now_s() - start;
+        if (cl->count == cl->cap) {
+            cl->cap = cl->cap == 0 ? 4096 : cl->cap * 2;
+            cl->latency_us = realloc(cl->latency_us, cl->cap * sizeof(uint32_t));
+            if (cl->latency_us == NULL) {
+                abort();
+            }
+        }
+        cl->latency_us[cl->count++] = (uint32_t)(elapsed * 1e6);
+        if (status < 200 || status > 299) {
+            cl->failed++;
+            cl->busy += status == 503;
+            if (status == 0) {
+                usleep(10000);  // Refused or reset: don't spin on a dead server
+            }
+        }
+    }
+    conn_close(&cl->conn);
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run_level(int clients, double seconds) {
+    static client_t pool[LOAD_CLIENTS_MAX];
+    memset(pool, 0, sizeof(pool[0]) * clients);
+    deadline = now_s() + seconds;
+    for (int i = 0; i < clients; i++) {
+        pthread_create(&pool[i].thread, NULL, client_run, &pool[i]);
+    }
+    size_t total = 0;
+    uint32_t failed = 0, busy = 0, retries = 0;
+    for (int i = 0; i < clients; i++) {
+        pthread_join(pool[i].thread, NULL);
+        total += pool[i].count;
+        failed += pool[i].failed;
+        busy += pool[i].busy;
+        retries += pool[i].retries;
+    }
+
+    uint32_t *all = malloc((total > 0 ? total : 1) * sizeof(uint32_t));
+    size_t n = 0;
+    for (int i = 0; i < clients; i++) {
+        memcpy(all + n, pool[i].latency_us, pool[i].count * sizeof(uint32_t));
+        n += pool[i].count;
+        free(pool[i].latency_us);
+    }
+    qsort(all, n, sizeof(uint32_t), cmp_u32);
+    double p50 = n > 0 ? all[n / 2] / 1e3 : 0;
+    double p99 = n > 0 ? all[n * 99 / 100] / 1e3 : 0;
+    double max = n > 0 ? all[n - 1] / 1e3 : 0;
+    printf("%7d %9zu %9.1f %8.2f %8.2f %8.1f %7.2f%% %6u %7u\n", clients, n, n / seconds, p50, p99, max,
+           n > 0 ? 100.0 * failed / n : 0, busy, retries);
+    fflush(stdout);
+    free(all);
+}
+
+int main(int argc, char **argv) {
+    double seconds = 5;
+    const char *levels_arg = "1,2,4,8,16,32";
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--host") == 0 && val != NULL) {
+            host = argv[++i];
+        } else if (strcmp(arg, "--port") == 0 && val != NULL) {
+            port = argv[++i];
+        } else if (strcmp(arg, "--path") == 0 && val != NULL) {
+            path = argv[++i];
+        } else if (strcmp(arg, "--seconds") == 0 && val != NULL) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(arg, "--clients") == 0 && val != NULL) {
+            levels_arg = argv[++i];
+        } else if (strcmp(arg, "--close") == 0) {
+            close_each = true;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--host ADDR] [--port N] [--path PATH] [--seconds S] [--clients 1,2,4,...] "
+                    "[--close]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    int levels[LOAD_LEVELS_MAX];
+    int level_count = 0;
+    for (const char *p = levels_arg; *p != '\0' && level_count < LOAD_LEVELS_MAX;) {
+        int n = atoi(p);
+        if (n < 1 || n > LOAD_CLIENTS_MAX) {
+            fprintf(stderr, "client counts must be 1-%d\n", LOAD_CLIENTS_MAX);
+            return 2;
+        }
+        levels[level_count++] = n;
+        p += strcspn(p, ",");
+        p += *p == ',';
+    }
+
+    const struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    int err = getaddrinfo(host, port, &hints, &addr);
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", host, gai_strerror(err));
+        return 1;
+    }
+    request_len = (size_t)snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\n%s\r\n", path, host,
+                                   close_each ? "Connection: close\r\n" : "");
+
+    printf("GET http://%s:%s%s, %.0f s per level%s\n", host, port, path, seconds,
+           close_each ? ", a connection per request" : "");
+    printf("clients  requests     req/s   p50 ms   p99 ms   max ms   failed    503 retries\n");
+    for (int i = 0; i < level_count; i++) {
+        run_level(levels[i], seconds);
+    }
+    freeaddrinfo(addr);
+    return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host port of the ESP-IDF placement attributes. Everything lives in
+// ordinary memory on Linux, so they expand to nothing.
+
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,154 @@
+#pragma once
+
+// Host port of the subset of esp_http_server used by the application.
+//
+// Semantics follow the ESP-IDF server: a single server task multiplexes all
+// sockets with select() and runs URI handlers and queued work one at a time,
+// connections are kept alive between requests, and a handler returning
+// anything other than ESP_OK closes the underlying socket. A handler that
+// returns ESP_OK without responding leaves the socket open and silent.
+// With lru_purge_enable, a connection arriving with every slot taken closes
+// the one that has gone longest without a request.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+#define HTTPD_MAX_URI_LEN       512
+#define HTTPD_RESP_USE_STRLEN   -1
+
+#define ESP_ERR_HTTPD_BASE          0xb000
+#define ESP_ERR_HTTPD_RESULT_TRUNC  (ESP_ERR_HTTPD_BASE + 3)
+
+#define HTTPD_TYPE_JSON         "application/json"
+#define HTTPD_TYPE_TEXT         "text/html"
+#define HTTPD_TYPE_OCTET        "application/octet-stream"
+
+#define HTTPD_SOCK_ERR_FAIL     -1
+#define HTTPD_SOCK_ERR_INVALID  -2
+#define HTTPD_SOCK_ERR_TIMEOUT  -3
+
+typedef void *httpd_handle_t;
+typedef void (*httpd_work_fn_t)(void *arg);
+typedef void (*httpd_close_func_t)(httpd_handle_t hd, int sockfd);
+
+typedef enum {
+    HTTP_DELETE = 0,
+    HTTP_GET    = 1,
+    HTTP_HEAD   = 2,
+    HTTP_POST   = 3,
+    HTTP_PUT    = 4,
+} httpd_method_t;
+
+typedef enum {
+    HTTPD_400_BAD_REQUEST,
+    HTTPD_404_NOT_FOUND,
+    HTTPD_405_METHOD_NOT_ALLOWED,
+    HTTPD_408_REQ_TIMEOUT,
+    HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE,
+    HTTPD_500_INTERNAL_SERVER_ERROR,
+} httpd_err_code_t;
+
+typedef struct httpd_req {
+    httpd_handle_t handle;
+    int method;
+    const char uri[HTTPD_MAX_URI_LEN + 1];
+    size_t content_len;
+    void *aux;
+    void *user_ctx;
+    void *sess_ctx;
+} httpd_req_t;
+
+typedef struct httpd_uri {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *r);
+    void *user_ctx;
+} httpd_uri_t;
+
+typedef struct httpd_config {
+    unsigned task_priority;
+    size_t stack_size;
+    int core_id;
+    uint16_t server_port;
+    uint16_t max_open_sockets;
+    uint16_t max_uri_handlers;
+    uint16_t backlog_conn;
+    bool lru_purge_enable;
+    uint16_t recv_wait_timeout;
+    uint16_t send_wait_timeout;
+    httpd_close_func_t close_fn;
+    bool keep_alive_enable;             // TCP keep-alive probes on every session
+    int keep_alive_idle;                // Seconds idle before the first probe (0: 5)
+    int keep_alive_interval;            // Seconds between probes (0: 5)
+    int keep_alive_count;               // Unanswered probes before the close (0: 3)
+} httpd_config_t;
+
+#define HTTPD_DEFAULT_CONFIG() {            \
+        .task_priority      = 5,            \
+        .stack_size         = 4096,         \
+        .core_id            = 0x7FFFFFFF,   \
+        .server_port        = 80,           \
+        .max_open_sockets   = 7,            \
+        .max_uri_handlers   = 8,            \
+        .backlog_conn       = 5,            \
+        .lru_purge_enable   = false,        \
+        .recv_wait_timeout  = 5,            \
+        .send_wait_timeout  = 5,            \
+        .close_fn           = NULL,         \
+        .keep_alive_enable  = false,        \
+        .keep_alive_idle    = 0,            \
+        .keep_alive_interval = 0,           \
+        .keep_alive_count   = 0,            \
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler);
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status);
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value);
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg);
+
+// Read up to buf_len bytes of the request body (content_len in total).
+// Returns the bytes read, 0 once the body is exhausted or the peer closed,
+// or HTTPD_SOCK_ERR_TIMEOUT / HTTPD_SOCK_ERR_FAIL.
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len);
+
+// Raw socket access, used for long-lived responses such as event streams
+int httpd_send(httpd_req_t *r, const char *buf, size_t buf_len);
+int httpd_req_to_sockfd(httpd_req_t *r);
+int httpd_socket_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags);
+
+// Run work in the server task's context; safe to call from any task
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg);
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd);
+
+// Hand a request over to another task. The copy in *out stays valid, and
+// the server leaves its socket alone, until httpd_req_async_handler_complete;
+// the handler that called begin returns ESP_OK without responding.
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out);
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *r);
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r);
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t buf_len);
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size);
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size);
+
+static inline esp_err_t httpd_resp_send_404(httpd_req_t *r) {
+    return httpd_resp_send_err(r, HTTPD_404_NOT_FOUND, NULL);
+}
+
+static inline esp_err_t httpd_resp_send_500(httpd_req_t *r) {
+    return httpd_resp_send_err(r, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+}
+
+// Host-only: override the listening port of every server started afterwards
+// (the target always listens on config->server_port). 0 restores the default.
+void httpd_posix_set_port_override(uint16_t port);
@@ -0,0 +1,842 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_http_server.h"
+
+static const char *TAG = "httpd";
+
+#define HTTPD_RX_BUF_SIZE       2048
+#define HTTPD_MAX_RESP_HDRS     8
+
+typedef struct {
+    int fd;
+    uint64_t lru;               // Server's request count when this socket last sent one
+    bool async;                 // A request on it is out with another task
+    bool close_pending;         // Close it once that request completes
+    size_t rx_len;
+    char rx[HTTPD_RX_BUF_SIZE];
+} httpd_sock_t;
+
+#define HTTPD_WORK_QUEUE_LEN    16
+
+typedef struct {
+    httpd_work_fn_t fn;
+    void *arg;
+} httpd_work_t;
+
+typedef struct {
+    httpd_config_t config;
+    int listen_fd;
+    volatile bool running;
+    httpd_uri_t *handlers;
+    size_t handler_count;
+    httpd_sock_t *socks;
+    uint64_t lru_counter;
+
+    // Work queued from other tasks; the pipe wakes the server's select()
+    pthread_mutex_t work_lock;
+    httpd_work_t work[HTTPD_WORK_QUEUE_LEN];
+    size_t work_head;
+    size_t work_count;
+    int wake_pipe[2];
+} httpd_server_t;
+
+// Per-request state behind httpd_req_t::aux
+typedef struct {
+    httpd_sock_t *sock;
+    const char *headers;        // Request header block (NUL terminated)
+    const char *body;           // Request body bytes that arrived with the headers...
+    size_t body_buffered;       // ...and how many are still unread
+    size_t body_left;           // Unread request body bytes still on the socket
+    size_t consumed;            // Bytes of rx the request takes up once its body is read
+    bool keep_alive;
+    bool headers_sent;
+    bool chunked;
+    const char *status;
+    const char *content_type;
+    size_t resp_hdr_count;
+    const char *resp_hdr_field[HTTPD_MAX_RESP_HDRS];
+    const char *resp_hdr_value[HTTPD_MAX_RESP_HDRS];
+} httpd_req_aux_t;
+
+static uint16_t port_override;
+
+void httpd_posix_set_port_override(uint16_t port) {
+    port_override = port;
+}
+
+static esp_err_t sock_send_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return ESP_FAIL;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return ESP_OK;
+}
+
+static void sock_close(httpd_server_t *server, httpd_sock_t *sock) {
+    sock->async = false;
+    sock->close_pending = false;
+    if (sock->fd >= 0) {
+        // As on the target, a close_fn takes over closing the descriptor
+        if (server->config.close_fn != NULL) {
+            server->config.close_fn(server, sock->fd);
+        } else {
+            close(sock->fd);
+        }
+    }
+    sock->fd = -1;
+    sock->rx_len = 0;
+}
+
+static httpd_sock_t *sock_find(httpd_server_t *server, int fd) {
+    for (size_t i = 0; i < server->config.max_open_sockets; i++) {
+        if (server->socks[i].fd == fd) {
+            return &server->socks[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t send_headers(httpd_req_t *r, ssize_t content_length) {
+    httpd_req_aux_t *aux = r->aux;
+    char hdr[1024];
+    int len = snprintf(hdr, sizeof(hdr), "HTTP/1.1 %s\r\nContent-Type: %s\r\n",
+                       aux->status, aux->content_type);
+    if (content_length >= 0) {
+        len += snprintf(hdr + len, sizeof(hdr) - len, "Content-Length: %zd\r\n", content_length);
+    } else {
+        len += snprintf(hdr + len, sizeof(hdr) - len, "Transfer-Encoding: chunked\r\n");
+    }
+    for (size_t i = 0; i < aux->resp_hdr_count; i++) {
+        len += snprintf(hdr + len, sizeof(hdr) - len, "%s: %s\r\n",
+                        aux->resp_hdr_field[i], aux->resp_hdr_value[i]);
+    }
+    if (!aux->keep_alive) {
+        len += snprintf(hdr + len, sizeof(hdr) - len, "Connection: close\r\n");
+    }
+    len += snprintf(hdr + len, sizeof(hdr) - len, "\r\n");
+    if (len >= (int)sizeof(hdr)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    aux->headers_sent = true;
+    return sock_send_all(aux->sock->fd, hdr, (size_t)len);
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status) {
+    if (r == NULL || status == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ((httpd_req_aux_t *)r->aux)->status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+    if (r == NULL || type == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ((httpd_req_aux_t *)r->aux)->content_type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value) {
+    if (r == NULL || field == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_req_aux_t *aux = r->aux;
+    if (aux->resp_hdr_count >= HTTPD_MAX_RESP_HDRS) {
+        return ESP_ERR_NO_MEM;
+    }
+    aux->resp_hdr_field[aux->resp_hdr_count] = field;
+    aux->resp_hdr_value[aux->resp_hdr_count] = value;
+    aux->resp_hdr_count++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+    if (r == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf != NULL ? (ssize_t)strlen(buf) : 0;
+    }
+    httpd_req_aux_t *aux = r->aux;
+    if (send_headers(r, buf_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (buf_len > 0 && sock_send_all(aux->sock->fd, buf, (size_t)buf_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+    if (r == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (buf != NULL && buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = (ssize_t)strlen(buf);
+    }
+    httpd_req_aux_t *aux = r->aux;
+    if (!aux->headers_sent) {
+        aux->chunked = true;
+        if (send_headers(r, -1) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    int fd = aux->sock->fd;
+    if (buf == NULL || buf_len <= 0) {
+        return sock_send_all(fd, "0\r\n\r\n", 5);
+    }
+    char size_line[16];
+    int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", (size_t)buf_len);
+    if (sock_send_all(fd, size_line, (size_t)n) != ESP_OK ||
+        sock_send_all(fd, buf, (size_t)buf_len) != ESP_OK ||
+        sock_send_all(fd, "\r\n", 2) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg) {
+    const char *status;
+    const char *text;
+    switch (error) {
+        case HTTPD_400_BAD_REQUEST:
+            status = "400 Bad Request";
+            text = "Bad request syntax";
+            break;
+        case HTTPD_404_NOT_FOUND:
+            status = "404 Not Found";
+            text = "This URI does not exist";
+            break;
+        case HTTPD_405_METHOD_NOT_ALLOWED:
+            status = "405 Method Not Allowed";
+            text = "Request method for this URI is not handled by server";
+            break;
+        case HTTPD_408_REQ_TIMEOUT:
+            status = "408 Request Timeout";
+            text = "Server closed this connection";
+            break;
+        case HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE:
+            status = "431 Request Header Fields Too Large";
+            text = "Header fields are too long";
+            break;
+        case HTTPD_500_INTERNAL_SERVER_ERROR:
+        default:
+            status = "500 Internal Server Error";
+            text = "Server has encountered an unexpected error";
+            break;
+    }
+    httpd_req_aux_t *aux = req->aux;
+    if (aux->headers_sent) {
+        return ESP_FAIL;
+    }
+    aux->status = status;
+    aux->content_type = HTTPD_TYPE_TEXT;
+    return httpd_resp_send(req, msg != NULL ? msg : text, HTTPD_RESP_USE_STRLEN);
+}
+
+int httpd_send(httpd_req_t *r, const char *buf, size_t buf_len) {
+    if (r == NULL || buf == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+    httpd_req_aux_t *aux = r->aux;
+    return sock_send_all(aux->sock->fd, buf, buf_len) == ESP_OK ? (int)buf_len : HTTPD_SOCK_ERR_FAIL;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r) {
+    if (r == NULL) {
+        return -1;
+    }
+    return ((httpd_req_aux_t *)r->aux)->sock->fd;
+}
+
+int httpd_socket_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags) {
+    if (hd == NULL || buf == NULL || sock_find(hd, sockfd) == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+    ssize_t n;
+    do {
+        n = send(sockfd, buf, buf_len, flags | MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+    }
+    return (int)n;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg) {
+    httpd_server_t *server = handle;
+    if (server == NULL || work == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&server->work_lock);
+    if (server->work_count == HTTPD_WORK_QUEUE_LEN) {
+        pthread_mutex_unlock(&server->work_lock);
+        return ESP_FAIL;
+    }
+    size_t slot = (server->work_head + server->work_count) % HTTPD_WORK_QUEUE_LEN;
+    server->work[slot] = (httpd_work_t){ .fn = work, .arg = arg };
+    server->work_count++;
+    pthread_mutex_unlock(&server->work_lock);
+    char wake = 0;
+    (void)write(server->wake_pipe[1], &wake, 1);
+    return ESP_OK;
+}
+
+static void run_queued_work(httpd_server_t *server) {
+    char drain[16];
+    while (read(server->wake_pipe[0], drain, sizeof(drain)) > 0) {
+    }
+    while (1) {
+        pthread_mutex_lock(&server->work_lock);
+        if (server->work_count == 0) {
+            pthread_mutex_unlock(&server->work_lock);
+            return;
+        }
+        httpd_work_t work = server->work[server->work_head];
+        server->work_head = (server->work_head + 1) % HTTPD_WORK_QUEUE_LEN;
+        server->work_count--;
+        pthread_mutex_unlock(&server->work_lock);
+        work.fn(work.arg);
+    }
+}
+
+typedef struct {
+    httpd_server_t *server;
+    int fd;
+} httpd_close_req_t;
+
+static void close_work(void *arg) {
+    httpd_close_req_t *close_req = arg;
+    httpd_sock_t *sock = sock_find(close_req->server, close_req->fd);
+    if (sock != NULL && sock->async) {
+        sock->close_pending = true;  // Another task may still be writing to it
+    } else if (sock != NULL) {
+        sock_close(close_req->server, sock);
+    }
+    free(close_req);
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd) {
+    httpd_server_t *server = handle;
+    if (server == NULL || sock_find(server, sockfd) == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    httpd_close_req_t *close_req = malloc(sizeof(*close_req));
+    if (close_req == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    close_req->server = server;
+    close_req->fd = sockfd;
+    esp_err_t ret = httpd_queue_work(server, close_work, close_req);
+    if (ret != ESP_OK) {
+        free(close_req);
+    }
+    return ret;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r) {
+    const char *q = r != NULL ? strchr(r->uri, '?') : NULL;
+    return q != NULL ? strlen(q + 1) : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t buf_len) {
+    if (r == NULL || buf == NULL || buf_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *q = strchr(r->uri, '?');
+    if (q == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t len = strlen(q + 1);
+    size_t copy = len < buf_len - 1 ? len : buf_len - 1;
+    memcpy(buf, q + 1, copy);
+    buf[copy] = '\0';
+    return copy < len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size) {
+    if (qry == NULL || key == NULL || val == NULL || val_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t key_len = strlen(key);
+    const char *p = qry;
+    while (*p != '\0') {
+        size_t pair_len = strcspn(p, "&");
+        if (pair_len > key_len && strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+            const char *v = p + key_len + 1;
+            size_t len = pair_len - key_len - 1;
+            size_t copy = len < val_size - 1 ? len : val_size - 1;
+            memcpy(val, v, copy);
+            val[copy] = '\0';
+            return copy < len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+        }
+        p += pair_len;
+        if (*p == '&') {
+            p++;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static const char *find_header(const char *headers, const char *field) {
+    size_t field_len = strlen(field);
+    const char *line = strstr(headers, "\r\n");
+    while (line != NULL && line[2] != '\0') {
+        line += 2;
+        if (strncasecmp(line, field, field_len) == 0 && line[field_len] == ':') {
+            const char *value = line + field_len + 1;
+            while (*value == ' ' || *value == '\t') {
+                value++;
+            }
+            return value;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+static bool header_value_equals(const char *headers, const char *field, const char *expected) {
+    const char *value = find_header(headers, field);
+    return value != NULL && strncasecmp(value, expected, strlen(expected)) == 0;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field) {
+    if (r == NULL || field == NULL) {
+        return 0;
+    }
+    httpd_req_aux_t *aux = r->aux;
+    const char *value = find_header(aux->headers, field);
+    return value != NULL ? strcspn(value, "\r") : 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size) {
+    if (r == NULL || field == NULL || val == NULL || val_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_req_aux_t *aux = r->aux;
+    const char *value = find_header(aux->headers, field);
+    if (value == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t len = strcspn(value, "\r");
+    size_t copy = len < val_size - 1 ? len : val_size - 1;
+    memcpy(val, value, copy);
+    val[copy] = '\0';
+    return copy < len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+static httpd_method_t parse_method(const char *s, size_t len) {
+    static const struct { const char *name; httpd_method_t method; } methods[] = {
+        { "GET", HTTP_GET }, { "POST", HTTP_POST }, { "PUT", HTTP_PUT },
+        { "DELETE", HTTP_DELETE }, { "HEAD", HTTP_HEAD },
+    };
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strlen(methods[i].name) == len && strncmp(methods[i].name, s, len) == 0) {
+            return methods[i].method;
+        }
+    }
+    return (httpd_method_t)-1;
+}
+
+static const httpd_uri_t *find_handler(httpd_server_t *server, const char *uri, int method,
+                                       bool *uri_known) {
+    size_t path_len = strcspn(uri, "?");
+    *uri_known = false;
+    for (size_t i = 0; i < server->handler_count; i++) {
+        const httpd_uri_t *h = &server->handlers[i];
+        if (strlen(h->uri) == path_len && strncmp(h->uri, uri, path_len) == 0) {
+            *uri_known = true;
+            if ((int)h->method == method) {
+                return h;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Parse and dispatch one complete request whose header block ends at hdr_end.
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len) {
+    httpd_req_aux_t *aux = r->aux;
+    if (aux->body_buffered > 0) {
+        size_t n = buf_len < aux->body_buffered ? buf_len : aux->body_buffered;
+        memcpy(buf, aux->body, n);
+        aux->body += n;
+        aux->body_buffered -= n;
+        return (int)n;
+    }
+    if (aux->body_left == 0) {
+        return 0;
+    }
+    size_t want = buf_len < aux->body_left ? buf_len : aux->body_left;
+    ssize_t n = recv(aux->sock->fd, buf, want, 0);
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+    }
+    if (n == 0) {
+        aux->keep_alive = false;
+        return 0;
+    }
+    aux->body_left -= (size_t)n;
+    return (int)n;
+}
+
+// Discard any request body the handler did not read and drop the request
+// from the receive buffer. false if the socket failed on the way.
+static bool request_finish(httpd_req_aux_t *aux) {
+    httpd_sock_t *sock = aux->sock;
+    while (aux->body_left > 0) {
+        char scratch[256];
+        size_t want = aux->body_left < sizeof(scratch) ? aux->body_left : sizeof(scratch);
+        ssize_t n = recv(sock->fd, scratch, want, 0);
+        if (n <= 0) {
+            return false;
+        }
+        aux->body_left -= (size_t)n;
+    }
+    memmove(sock->rx, sock->rx + aux->consumed, sock->rx_len - aux->consumed);
+    sock->rx_len -= aux->consumed;
+    return true;
+}
+
+// Returns false when the connection must be closed.
+static bool handle_request(httpd_server_t *server, httpd_sock_t *sock, size_t hdr_end) {
+    char *headers = sock->rx;
+    headers[hdr_end - 2] = '\0';  // Keep the final header's CRLF for find_header
+
+    httpd_req_t req = { .handle = server };
+    httpd_req_aux_t aux = {
+        .sock = sock,
+        .headers = headers,
+        .status = "200 OK",
+        .content_type = HTTPD_TYPE_TEXT,
+    };
+    req.aux = &aux;
+
+    const char *sp1 = strchr(headers, ' ');
+    const char *sp2 = sp1 != NULL ? strchr(sp1 + 1, ' ') : NULL;
+    if (sp1 == NULL || sp2 == NULL || (size_t)(sp2 - sp1 - 1) > HTTPD_MAX_URI_LEN) {
+        aux.keep_alive = false;
+        httpd_resp_send_err(&req, HTTPD_400_BAD_REQUEST, NULL);
+        return false;
+    }
+    req.method = parse_method(headers, (size_t)(sp1 - headers));
+    memcpy((char *)req.uri, sp1 + 1, (size_t)(sp2 - sp1 - 1));
+    ((char *)req.uri)[sp2 - sp1 - 1] = '\0';
+
+    bool http10 = strncmp(sp2 + 1, "HTTP/1.0", 8) == 0;
+    aux.keep_alive = http10 ? header_value_equals(headers, "Connection", "keep-alive")
+                            : !header_value_equals(headers, "Connection", "close");
+    const char *cl = find_header(headers, "Content-Length");
+    req.content_len = cl != NULL ? strtoul(cl, NULL, 10) : 0;
+
+    // Move any pipelined bytes after the header block out of the way
+    size_t consumed = hdr_end;
+    size_t leftover = sock->rx_len - consumed;
+    size_t body_in_buf = leftover < req.content_len ? leftover : req.content_len;
+    aux.body = sock->rx + hdr_end;
+    aux.body_buffered = body_in_buf;
+    aux.body_left = req.content_len - body_in_buf;
+    aux.consumed = consumed + body_in_buf;
+
+    bool uri_known;
+    const httpd_uri_t *h = find_handler(server, req.uri, req.method, &uri_known);
+    esp_err_t ret;
+    if (h == NULL) {
+        // Error replies keep the connection open, as on the target
+        httpd_resp_send_err(&req, uri_known ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND, NULL);
+        ret = ESP_OK;
+    } else {
+        req.user_ctx = h->user_ctx;
+        ret = h->handler(&req);
+    }
+    if (sock->async) {
+        return true;  // httpd_req_async_handler_complete finishes it
+    }
+    return request_finish(&aux) && ret == ESP_OK && aux.keep_alive;
+}
+
+// Serve every complete request already buffered (pipelining), up to one
+// that is handed to another task
+static void sock_serve(httpd_server_t *server, httpd_sock_t *sock) {
+    while (sock->fd >= 0 && !sock->async) {
+        sock->rx[sock->rx_len] = '\0';
+        char *end = strstr(sock->rx, "\r\n\r\n");
+        if (end == NULL) {
+            if (sock->rx_len >= sizeof(sock->rx) - 1) {
+                ESP_LOGW(TAG, "Request header too large, closing socket %d", sock->fd);
+                sock_close(server, sock);
+            }
+            return;
+        }
+        sock->lru = ++server->lru_counter;
+        if (!handle_request(server, sock, (size_t)(end - sock->rx) + 4)) {
+            sock_close(server, sock);
+        }
+    }
+}
+
+static void sock_on_readable(httpd_server_t *server, httpd_sock_t *sock) {
+    ssize_t n = recv(sock->fd, sock->rx + sock->rx_len, sizeof(sock->rx) - sock->rx_len - 1, 0);
+    if (n <= 0) {
+        sock_close(server, sock);
+        return;
+    }
+    sock->rx_len += (size_t)n;
+    sock_serve(server, sock);
+}
+
+// An async request: a copy of the handler's httpd_req_t and its state,
+// owned by the task that took it over
+typedef struct {
+    httpd_req_t req;
+    httpd_req_aux_t aux;
+    int fd;
+} httpd_async_req_t;
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out) {
+    if (r == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_async_req_t *async = malloc(sizeof(*async));
+    if (async == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    // The header block and any buffered body stay in the socket's rx,
+    // which the server leaves alone until the request completes
+    memcpy(&async->req, r, sizeof(*r));
+    async->aux = *(httpd_req_aux_t *)r->aux;
+    async->req.aux = &async->aux;
+    async->fd = async->aux.sock->fd;
+    async->aux.sock->async = true;
+    *out = &async->req;
+    return ESP_OK;
+}
+
+// Back on the server task: watch the socket again, or close it
+static void async_resume(void *arg) {
+    httpd_async_req_t *async = arg;
+    httpd_server_t *server = async->req.handle;
+    httpd_sock_t *sock = async->aux.sock;
+    if (sock->fd == async->fd && sock->async) {
+        sock->async = false;
+        if (!async->aux.keep_alive || sock->close_pending) {
+            sock_close(server, sock);
+        } else {
+            sock_serve(server, sock);
+        }
+    }
+    free(async);
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *r) {
+    if (r == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_async_req_t *async = (httpd_async_req_t *)r;
+    if (!request_finish(&async->aux)) {
+        async->aux.keep_alive = false;
+    }
+    while (httpd_queue_work(r->handle, async_resume, async) != ESP_OK) {
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+static void sock_accept(httpd_server_t *server) {
+    int fd = accept(server->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    httpd_sock_t *slot = NULL;
+    for (size_t i = 0; i < server->config.max_open_sockets; i++) {
+        if (server->socks[i].fd < 0) {
+            slot = &server->socks[i];
+            break;
+        }
+    }
+    if (slot == NULL && server->config.lru_purge_enable) {
+        for (size_t i = 0; i < server->config.max_open_sockets; i++) {
+            httpd_sock_t *sock = &server->socks[i];
+            if (!sock->async && (slot == NULL || sock->lru < slot->lru)) {
+                slot = sock;
+            }
+        }
+        if (slot != NULL) {
+            ESP_LOGD(TAG, "Purging least recently used socket %d", slot->fd);
+            sock_close(server, slot);
+        }
+    }
+    if (slot == NULL) {
+        ESP_LOGW(TAG, "Error in accept (No free sockets)");
+        close(fd);
+        return;
+    }
+    struct timeval tv = { .tv_sec = server->config.recv_wait_timeout };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    tv.tv_sec = server->config.send_wait_timeout;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (server->config.keep_alive_enable) {
+        int idle = server->config.keep_alive_idle > 0 ? server->config.keep_alive_idle : 5;
+        int interval = server->config.keep_alive_interval > 0 ? server->config.keep_alive_interval : 5;
+        int count = server->config.keep_alive_count > 0 ? server->config.keep_alive_count : 3;
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+    }
+    slot->fd = fd;
+    slot->lru = ++server->lru_counter;
+    slot->rx_len = 0;
+}
+
+static void httpd_server_task(void *arg) {
+    httpd_server_t *server = arg;
+    while (server->running) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(server->listen_fd, &fds);
+        FD_SET(server->wake_pipe[0], &fds);
+        int max_fd = server->listen_fd > server->wake_pipe[0] ? server->listen_fd : server->wake_pipe[0];
+        for (size_t i = 0; i < server->config.max_open_sockets; i++) {
+            int fd = server->socks[i].fd;
+            if (fd >= 0 && !server->socks[i].async) {
+                FD_SET(fd, &fds);
+                max_fd = fd > max_fd ? fd : max_fd;
+            }
+        }
+        struct timeval tv = { .tv_sec = 1 };
+        int ready = select(max_fd + 1, &fds, NULL, NULL, &tv);
+        if (ready <= 0) {
+            continue;
+        }
+        if (FD_ISSET(server->wake_pipe[0], &fds)) {
+            run_queued_work(server);
+        }
+        for (size_t i = 0; i < server->config.max_open_sockets; i++) {
+            httpd_sock_t *sock = &server->socks[i];
+            if (sock->fd >= 0 && !sock->async && FD_ISSET(sock->fd, &fds)) {
+                sock_on_readable(server, sock);
+            }
+        }
+        if (FD_ISSET(server->listen_fd, &fds)) {
+            sock_accept(server);
+        }
+    }
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+    if (handle == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_server_t *server = calloc(1, sizeof(*server));
+    if (server == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    server->config = *config;
+    server->handlers = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    server->socks = calloc(config->max_open_sockets, sizeof(httpd_sock_t));
+    if (server->handlers == NULL || server->socks == NULL) {
+        free(server->handlers);
+        free(server->socks);
+        free(server);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < config->max_open_sockets; i++) {
+        server->socks[i].fd = -1;
+    }
+    pthread_mutex_init(&server->work_lock, NULL);
+    if (pipe(server->wake_pipe) != 0) {
+        free(server->handlers);
+        free(server->socks);
+        free(server);
+        return ESP_FAIL;
+    }
+    fcntl(server->wake_pipe[0], F_SETFL, O_NONBLOCK);
+
+    uint16_t port = port_override != 0 ? port_override : config->server_port;
+    server->listen_fd = socket(AF_INET6, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in6 addr = {
+        .sin6_family = AF_INET6,
+        .sin6_port = htons(port),
+        .sin6_addr = in6addr_any,
+    };
+    if (server->listen_fd < 0 ||
+        bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, config->backlog_conn) != 0) {
+        ESP_LOGE(TAG, "Failed to listen on port %u: %s", port, strerror(errno));
+        if (server->listen_fd >= 0) {
+            close(server->listen_fd);
+        }
+        free(server->handlers);
+        free(server->socks);
+        free(server);
+        return ESP_FAIL;
+    }
+
+    server->running = true;
+    if (xTaskCreate(httpd_server_task, "httpd", config->stack_size, server,
+                    config->task_priority, NULL) != pdPASS) {
+        close(server->listen_fd);
+        free(server->handlers);
+        free(server->socks);
+        free(server);
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Started server on port: '%u'", port);
+    *handle = server;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+    httpd_server_t *server = handle;
+    if (server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The server task exits on its next select() timeout; resources are left
+    // to process teardown since the simulator never restarts a server.
+    server->running = false;
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler) {
+    httpd_server_t *server = handle;
+    if (server == NULL || uri_handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    bool uri_known;
+    if (find_handler(server, uri_handler->uri, uri_handler->method, &uri_known) != NULL) {
+        return ESP_ERR_INVALID_STATE;  // ESP_ERR_HTTPD_HANDLER_EXISTS on the target
+    }
+    if (server->handler_count >= server->config.max_uri_handlers) {
+        return ESP_ERR_NO_MEM;  // ESP_ERR_HTTPD_HANDLERS_FULL on the target
+    }
+    server->handlers[server->handler_count++] = *uri_handler;
+    return ESP_OK;
+}
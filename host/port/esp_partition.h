@@ -0,0 +1,57 @@
+#pragma once
+
+// Host port of the ESP-IDF partition API.
+//
+// The partition table holds a single data partition labelled "history",
+// backed by an image file. Writes follow NOR flash rules (they can only
+// clear bits; erase sets a whole sector back to 0xFF), so storage code that
+// works here will not silently depend on overwrite semantics on the target.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define SPI_FLASH_SEC_SIZE      4096
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+    ESP_PARTITION_TYPE_ANY = 0xff,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+    bool encrypted;
+    bool readonly;
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+// Host only: image file and size for the "history" partition. Must be
+// called before the first esp_partition_find_first().
+void esp_partition_posix_set_image(const char *path, uint32_t size);
+
+typedef struct {
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint32_t erases;
+    uint32_t max_sector_erases;     // Most-erased sector, for wear checks
+    uint32_t min_sector_erases;
+    uint32_t bit_set_violations;    // Writes that tried to turn a 0 bit into 1
+} esp_partition_posix_stats_t;
+
+void esp_partition_posix_get_stats(esp_partition_posix_stats_t *out);
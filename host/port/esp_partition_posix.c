@@ -0,0 +1,164 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+
+// File-backed flash: the image is opened on first lookup and grown to the
+// partition size with 0xFF, so a new file looks like freshly erased flash.
+
+static const char *TAG = "flash_posix";
+
+static pthread_mutex_t flash_lock = PTHREAD_MUTEX_INITIALIZER;
+static const char *image_path = "desk_flash.bin";
+static uint32_t image_size = 0x100000;
+static int image_fd = -1;
+static uint32_t *sector_erases;
+static esp_partition_posix_stats_t stats;
+
+static esp_partition_t history_partition = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = (esp_partition_subtype_t)0x40,
+    .label = "history",
+    .erase_size = SPI_FLASH_SEC_SIZE,
+};
+
+void esp_partition_posix_set_image(const char *path, uint32_t size) {
+    pthread_mutex_lock(&flash_lock);
+    image_path = path;
+    image_size = size;
+    pthread_mutex_unlock(&flash_lock);
+}
+
+static bool image_open(void) {
+    if (image_fd >= 0) {
+        return true;
+    }
+    int fd = open(image_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Cannot open flash image %s", image_path);
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    if (st.st_size < image_size) {
+        uint8_t blank[SPI_FLASH_SEC_SIZE];
+        memset(blank, 0xFF, sizeof(blank));
+        for (off_t off = st.st_size; off < image_size; off += sizeof(blank)) {
+            size_t n = image_size - off < sizeof(blank) ? image_size - off : sizeof(blank);
+            if (pwrite(fd, blank, n, off) != (ssize_t)n) {
+                ESP_LOGE(TAG, "Cannot extend flash image %s", image_path);
+                close(fd);
+                return false;
+            }
+        }
+    }
+    image_fd = fd;
+    history_partition.size = image_size;
+    sector_erases = calloc(image_size / SPI_FLASH_SEC_SIZE, sizeof(uint32_t));
+    ESP_LOGI(TAG, "Flash image %s (%u KiB)", image_path, (unsigned)(image_size / 1024));
+    return true;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label) {
+    if ((type != ESP_PARTITION_TYPE_ANY && type != history_partition.type) ||
+        (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != history_partition.subtype) ||
+        (label != NULL && strcmp(label, history_partition.label) != 0)) {
+        return NULL;
+    }
+    pthread_mutex_lock(&flash_lock);
+    bool ok = image_open();
+    pthread_mutex_unlock(&flash_lock);
+    return ok ? &history_partition : NULL;
+}
+
+static bool range_ok(const esp_partition_t *partition, size_t offset, size_t size) {
+    return partition == &history_partition && image_fd >= 0 &&
+           offset <= partition->size && size <= partition->size - offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    pthread_mutex_lock(&flash_lock);
+    esp_err_t err = ESP_ERR_INVALID_SIZE;
+    if (range_ok(partition, src_offset, size)) {
+        err = pread(image_fd, dst, size, src_offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+        stats.bytes_read += size;
+    }
+    pthread_mutex_unlock(&flash_lock);
+    return err;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    pthread_mutex_lock(&flash_lock);
+    if (!range_ok(partition, dst_offset, size)) {
+        pthread_mutex_unlock(&flash_lock);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Programming can only clear bits: AND the new data into what is there
+    esp_err_t err = ESP_OK;
+    const uint8_t *in = src;
+    uint8_t buf[256];
+    for (size_t done = 0; done < size && err == ESP_OK; done += sizeof(buf)) {
+        size_t n = size - done < sizeof(buf) ? size - done : sizeof(buf);
+        if (pread(image_fd, buf, n, dst_offset + done) != (ssize_t)n) {
+            err = ESP_FAIL;
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (in[done + i] & ~buf[i]) {
+                stats.bit_set_violations++;
+            }
+            buf[i] &= in[done + i];
+        }
+        if (pwrite(image_fd, buf, n, dst_offset + done) != (ssize_t)n) {
+            err = ESP_FAIL;
+        }
+    }
+    stats.bytes_written += size;
+    pthread_mutex_unlock(&flash_lock);
+    return err;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&flash_lock);
+    if (!range_ok(partition, offset, size)) {
+        pthread_mutex_unlock(&flash_lock);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = ESP_OK;
+    uint8_t blank[SPI_FLASH_SEC_SIZE];
+    memset(blank, 0xFF, sizeof(blank));
+    for (size_t off = offset; off < offset + size; off += SPI_FLASH_SEC_SIZE) {
+        if (pwrite(image_fd, blank, sizeof(blank), off) != (ssize_t)sizeof(blank)) {
+            err = ESP_FAIL;
+            break;
+        }
+        sector_erases[off / SPI_FLASH_SEC_SIZE]++;
+        stats.erases++;
+    }
+    pthread_mutex_unlock(&flash_lock);
+    return err;
+}
+
+void esp_partition_posix_get_stats(esp_partition_posix_stats_t *out) {
+    pthread_mutex_lock(&flash_lock);
+    *out = stats;
+    out->max_sector_erases = 0;
+    out->min_sector_erases = 0;
+    if (sector_erases != NULL) {
+        uint32_t sectors = history_partition.size / SPI_FLASH_SEC_SIZE;
+        out->min_sector_erases = UINT32_MAX;
+        for (uint32_t i = 0; i < sectors; i++) {
+            if (sector_erases[i] > out->max_sector_erases) out->max_sector_erases = sector_erases[i];
+            if (sector_erases[i] < out->min_sector_erases) out->min_sector_erases = sector_erases[i];
+        }
+    }
+    pthread_mutex_unlock(&flash_lock);
+}
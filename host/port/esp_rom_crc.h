@@ -0,0 +1,7 @@
+#pragma once
+
+// Host port of the ROM CRC helpers (IEEE 802.3 polynomial, reflected)
+
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len);
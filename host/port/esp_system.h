@@ -0,0 +1,10 @@
+#pragma once
+
+// Host port of the ESP-IDF heap queries. The figures come from the host
+// allocator's arena (bytes it holds but has not handed out), so only their
+// trend is meaningful; the minimum is the lowest value any caller has seen.
+
+#include <stdint.h>
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
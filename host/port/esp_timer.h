@@ -0,0 +1,7 @@
+#pragma once
+
+// Host port of esp_timer_get_time (CLOCK_MONOTONIC, microseconds)
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
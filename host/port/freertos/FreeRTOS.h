@@ -0,0 +1,27 @@
+#pragma once
+
+// Host port of the FreeRTOS types and macros used by the application.
+// Tasks map to pthreads and the tick is fixed at 1 ms.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+
+#define portNUM_PROCESSORS      2   // The ESP32 being simulated
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#define tskNO_AFFINITY          ((BaseType_t)0x7FFFFFFF)
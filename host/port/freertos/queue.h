@@ -0,0 +1,15 @@
+#pragma once
+
+// Host port of FreeRTOS queues (fixed-size items copied in and out)
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+// Length-1 queues only: replace the item if one is waiting
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
@@ -0,0 +1,12 @@
+#pragma once
+
+// Host port of FreeRTOS mutexes (pthread mutexes; no priority inheritance)
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
@@ -0,0 +1,315 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+
+// Tasks are detached pthreads. Priorities and core affinity are accepted
+// for API compatibility only; the host scheduler decides placement. Stacks
+// are allocated here and painted so their high-water mark can be measured.
+// "FromISR" calls are made from simulator threads standing in for interrupts.
+
+#define STACK_FILL      0xA5
+#define STACK_MIN       65536   // Host stacks are generous compared to the target
+
+struct task_handle {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *params;
+    char name[16];
+    uint8_t *stack;             // Lowest address; the stack grows down
+    size_t stack_size;
+    uint32_t stack_depth;       // As requested
+    uint8_t *stack_entry;       // Stack pointer at the task function's entry
+    struct task_handle *next;   // All tasks, for xTaskGetHandle()
+    pthread_mutex_t notify_lock;
+    pthread_cond_t notify_cond;
+    uint32_t notify_value;
+};
+
+static __thread struct task_handle *current_task;
+static pthread_mutex_t tasks_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct task_handle *tasks;
+
+static void *task_trampoline(void *arg) {
+    struct task_handle *task = arg;
+    // glibc puts the thread descriptor and TLS at the top of the stack, so
+    // usage is measured from here
+    uint8_t marker;
+    task->stack_entry = &marker;
+    current_task = task;
+    task->fn(task->params);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *params, UBaseType_t priority, TaskHandle_t *created_task,
+                                   BaseType_t core_id) {
+    (void)priority;
+    (void)core_id;
+    struct task_handle *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->params = params;
+    snprintf(task->name, sizeof(task->name), "%s", name != NULL ? name : "");
+    task->stack_depth = stack_depth;
+    task->stack_size = stack_depth < STACK_MIN ? STACK_MIN : stack_depth;
+    if (posix_memalign((void **)&task->stack, 4096, task->stack_size) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    memset(task->stack, STACK_FILL, task->stack_size);
+    pthread_mutex_init(&task->notify_lock, NULL);
+    pthread_cond_init(&task->notify_cond, NULL);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstack(&attr, task->stack, task->stack_size);
+    int rc = pthread_create(&task->thread, &attr, task_trampoline, task);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        pthread_cond_destroy(&task->notify_cond);
+        pthread_mutex_destroy(&task->notify_lock);
+        free(task->stack);
+        free(task);
+        return pdFAIL;
+    }
+#ifdef __linux__
+    pthread_setname_np(task->thread, task->name);
+#endif
+    pthread_mutex_lock(&tasks_lock);
+    task->next = tasks;
+    tasks = task;
+    pthread_mutex_unlock(&tasks_lock);
+    if (created_task != NULL) {
+        *created_task = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *params, UBaseType_t priority, TaskHandle_t *created_task) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, params, priority, created_task, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != NULL && task != current_task) {
+        fprintf(stderr, "vTaskDelete: deleting another task is not supported\n");
+        abort();
+    }
+    // The handle stays allocated: other tasks may still hold it
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = {
+        .tv_sec = ticks / configTICK_RATE_HZ,
+        .tv_nsec = (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ),
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (1000000 / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current_task;
+}
+
+TaskHandle_t xTaskGetHandle(const char *name) {
+    pthread_mutex_lock(&tasks_lock);
+    struct task_handle *task = tasks;
+    while (task != NULL && strcmp(task->name, name) != 0) {
+        task = task->next;
+    }
+    pthread_mutex_unlock(&tasks_lock);
+    return task;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    if (task == NULL) {
+        task = current_task;
+    }
+    size_t untouched = 0;
+    while (untouched < task->stack_size && task->stack[untouched] == STACK_FILL) {
+        untouched++;
+    }
+    size_t used = task->stack_entry - (task->stack + untouched);
+    return used < task->stack_depth ? (UBaseType_t)(task->stack_depth - used) : 0;
+}
+
+static struct timespec deadline_after(TickType_t ticks);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    struct task_handle *task = current_task;
+    struct timespec deadline = deadline_after(ticks_to_wait == portMAX_DELAY ? 0 : ticks_to_wait);
+    pthread_mutex_lock(&task->notify_lock);
+    while (task->notify_value == 0 && ticks_to_wait != 0) {
+        if (ticks_to_wait == portMAX_DELAY) {
+            pthread_cond_wait(&task->notify_cond, &task->notify_lock);
+        } else if (pthread_cond_timedwait(&task->notify_cond, &task->notify_lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t value = task->notify_value;
+    if (value != 0) {
+        task->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->notify_lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->notify_lock);
+    task->notify_value++;
+    pthread_cond_signal(&task->notify_cond);
+    pthread_mutex_unlock(&task->notify_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken) {
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken != NULL) {
+        *higher_priority_task_woken = pdTRUE;
+    }
+}
+
+struct semaphore {
+    pthread_mutex_t mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+    if (sem != NULL) {
+        pthread_mutex_init(&sem->mutex, NULL);
+    }
+    return sem;
+}
+
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)ticks * (1000000000ULL / configTICK_RATE_HZ);
+    deadline.tv_sec += ns / 1000000000ULL;
+    deadline.tv_nsec = ns % 1000000000ULL;
+    return deadline;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait) {
+    if (ticks_to_wait == portMAX_DELAY) {
+        return pthread_mutex_lock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+    struct timespec deadline = deadline_after(ticks_to_wait);
+    return pthread_mutex_timedlock(&sem->mutex, &deadline) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    return pthread_mutex_unlock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+struct queue {
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t storage[];
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(*queue) + (size_t)length * item_size);
+    if (queue != NULL) {
+        pthread_mutex_init(&queue->mutex, NULL);
+        pthread_cond_init(&queue->not_empty, NULL);
+        pthread_cond_init(&queue->not_full, NULL);
+        queue->length = length;
+        queue->item_size = item_size;
+    }
+    return queue;
+}
+
+// Wait until the queue has space (or an item) or the timeout expires;
+// called with the queue mutex held
+static bool queue_wait(QueueHandle_t queue, pthread_cond_t *cond, bool want_space, TickType_t ticks_to_wait) {
+    struct timespec deadline = deadline_after(ticks_to_wait == portMAX_DELAY ? 0 : ticks_to_wait);
+    while (want_space ? queue->count == queue->length : queue->count == 0) {
+        if (ticks_to_wait == 0) {
+            return false;
+        }
+        if (ticks_to_wait == portMAX_DELAY) {
+            pthread_cond_wait(cond, &queue->mutex);
+        } else if (pthread_cond_timedwait(cond, &queue->mutex, &deadline) == ETIMEDOUT) {
+            return want_space ? queue->count < queue->length : queue->count > 0;
+        }
+    }
+    return true;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&queue->mutex);
+    if (!queue_wait(queue, &queue->not_full, true, ticks_to_wait)) {
+        pthread_mutex_unlock(&queue->mutex);
+        return pdFALSE;
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->storage[(size_t)tail * queue->item_size], item, queue->item_size);
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+    return pdTRUE;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    pthread_mutex_lock(&queue->mutex);
+    memcpy(&queue->storage[(size_t)queue->head * queue->item_size], item, queue->item_size);
+    queue->count = 1;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&queue->mutex);
+    if (!queue_wait(queue, &queue->not_empty, false, ticks_to_wait)) {
+        pthread_mutex_unlock(&queue->mutex);
+        return pdFALSE;
+    }
+    memcpy(item, &queue->storage[(size_t)queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->mutex);
+    free(queue);
+}
@@ -0,0 +1,237 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+
+// Image format: one record per entry, namespace and key NUL-padded to
+// NVS_KEY_NAME_MAX_SIZE, then a 32-bit length and the blob. Commits rewrite
+// a temporary file and rename it over the image, so a crash mid-commit
+// leaves the previous image intact, as NVS does on the target.
+
+static const char *TAG = "nvs_posix";
+
+#define NVS_MAX_ENTRIES     32
+#define NVS_MAX_HANDLES     8
+#define NVS_MAX_BLOB        4000    // Largest single blob NVS takes by default
+
+typedef struct {
+    char ns[NVS_KEY_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint32_t len;
+    uint8_t *data;
+} nvs_entry_t;
+
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static const char *image_path = "desk_nvs.bin";
+static bool loaded;
+static nvs_entry_t entries[NVS_MAX_ENTRIES];
+static size_t entry_count;
+static struct {
+    bool open;
+    bool writable;
+    char ns[NVS_KEY_NAME_MAX_SIZE];
+} handles[NVS_MAX_HANDLES];
+
+void nvs_posix_set_image(const char *path) {
+    pthread_mutex_lock(&nvs_lock);
+    image_path = path;
+    loaded = false;
+    for (size_t i = 0; i < entry_count; i++) {
+        free(entries[i].data);
+    }
+    entry_count = 0;
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+static void image_load(void) {
+    loaded = true;
+    FILE *f = fopen(image_path, "rb");
+    if (f == NULL) {
+        return;  // A missing image is an erased partition
+    }
+    nvs_entry_t e;
+    while (entry_count < NVS_MAX_ENTRIES &&
+           fread(e.ns, sizeof(e.ns), 1, f) == 1 &&
+           fread(e.key, sizeof(e.key), 1, f) == 1 &&
+           fread(&e.len, sizeof(e.len), 1, f) == 1) {
+        if (e.len > NVS_MAX_BLOB || (e.data = malloc(e.len > 0 ? e.len : 1)) == NULL) {
+            break;
+        }
+        if (e.len > 0 && fread(e.data, e.len, 1, f) != 1) {
+            free(e.data);
+            break;
+        }
+        e.ns[sizeof(e.ns) - 1] = '\0';
+        e.key[sizeof(e.key) - 1] = '\0';
+        entries[entry_count++] = e;
+    }
+    fclose(f);
+}
+
+static bool image_store(void) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", image_path);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < entry_count && ok; i++) {
+        const nvs_entry_t *e = &entries[i];
+        ok = fwrite(e->ns, sizeof(e->ns), 1, f) == 1 &&
+             fwrite(e->key, sizeof(e->key), 1, f) == 1 &&
+             fwrite(&e->len, sizeof(e->len), 1, f) == 1 &&
+             (e->len == 0 || fwrite(e->data, e->len, 1, f) == 1);
+    }
+    ok = fclose(f) == 0 && ok;
+    return ok && rename(tmp, image_path) == 0;
+}
+
+static bool name_valid(const char *name) {
+    return name != NULL && name[0] != '\0' && strlen(name) < NVS_KEY_NAME_MAX_SIZE;
+}
+
+static nvs_entry_t *entry_find(const char *ns, const char *key) {
+    for (size_t i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].ns, ns) == 0 && strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Lock held; NULL for a closed or out-of-range handle
+static const char *handle_ns(nvs_handle_t handle, bool write) {
+    if (handle == 0 || handle > NVS_MAX_HANDLES || !handles[handle - 1].open) {
+        return NULL;
+    }
+    if (write && !handles[handle - 1].writable) {
+        return NULL;
+    }
+    return handles[handle - 1].ns;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (!name_valid(name)) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    if (!loaded) {
+        image_load();
+    }
+    esp_err_t err = ESP_ERR_NO_MEM;
+    for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+        if (!handles[i].open) {
+            handles[i].open = true;
+            handles[i].writable = open_mode == NVS_READWRITE;
+            strcpy(handles[i].ns, name);
+            *out_handle = (nvs_handle_t)(i + 1);
+            err = ESP_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    pthread_mutex_lock(&nvs_lock);
+    if (handle_ns(handle, false) != NULL) {
+        handles[handle - 1].open = false;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    if (!name_valid(key)) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    esp_err_t err = ESP_OK;
+    const char *ns = handle_ns(handle, false);
+    const nvs_entry_t *e = ns != NULL ? entry_find(ns, key) : NULL;
+    if (ns == NULL) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (e == NULL) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_value == NULL) {
+        *length = e->len;
+    } else if (*length < e->len) {
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out_value, e->data, e->len);
+        *length = e->len;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    if (!name_valid(key)) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    if (length > NVS_MAX_BLOB) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    uint8_t *data = malloc(length > 0 ? length : 1);
+    if (data == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(data, value, length);
+    pthread_mutex_lock(&nvs_lock);
+    esp_err_t err = ESP_OK;
+    const char *ns = handle_ns(handle, true);
+    nvs_entry_t *e = ns != NULL ? entry_find(ns, key) : NULL;
+    if (ns == NULL) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (e == NULL && entry_count == NVS_MAX_ENTRIES) {
+        err = ESP_ERR_NO_MEM;
+    } else {
+        if (e == NULL) {
+            e = &entries[entry_count++];
+            strcpy(e->ns, ns);
+            strcpy(e->key, key);
+        } else {
+            free(e->data);
+        }
+        e->data = data;
+        e->len = (uint32_t)length;
+        data = NULL;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    free(data);
+    return err;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    pthread_mutex_lock(&nvs_lock);
+    esp_err_t err = ESP_OK;
+    const char *ns = handle_ns(handle, true);
+    nvs_entry_t *e = ns != NULL && name_valid(key) ? entry_find(ns, key) : NULL;
+    if (ns == NULL) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (e == NULL) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else {
+        free(e->data);
+        *e = entries[--entry_count];
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    pthread_mutex_lock(&nvs_lock);
+    esp_err_t err = ESP_OK;
+    if (handle_ns(handle, true) == NULL) {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (!image_store()) {
+        ESP_LOGE(TAG, "Cannot write NVS image %s", image_path);
+        err = ESP_FAIL;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
@@ -0,0 +1,233 @@
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "numfmt.h"
+#include "push.h"
+
+// Receiving end for push telemetry, standing in for a UDP collector or an
+// MQTT broker. Prints one line per batch and warns when a desk's samples
+// are not contiguous with its previous batch (a reboot, or samples lost to
+// a full spool). The MQTT side is just enough of a 3.1.1 broker for the
+// desk: it accepts CONNECT, acknowledges QoS 1 PUBLISH and closes on
+// DISCONNECT. --refuse N turns the first N MQTT connections away, which
+// exercises the desk's spool.
+//
+// usage: push_sink [--udp PORT] [--mqtt PORT] [--refuse N]
+
+#define SINK_DESKS_MAX      64
+#define SINK_IO_TIMEOUT_S   5
+
+typedef struct {
+    char name[PUSH_TOPIC_MAX + 1];
+    uint32_t next_seq;
+} sink_desk_t;
+
+static sink_desk_t desks[SINK_DESKS_MAX];
+static size_t desk_count;
+
+static void print_batch(const char *via, const uint8_t *buf, size_t len) {
+    push_batch_t batch;
+    if (!push_decode(buf, len, &batch)) {
+        printf("%s: undecodable batch of %zu bytes\n", via, len);
+        fflush(stdout);
+        return;
+    }
+    sink_desk_t *desk = NULL;
+    for (size_t i = 0; i < desk_count; i++) {
+        if (strcmp(desks[i].name, batch.name) == 0) {
+            desk = &desks[i];
+        }
+    }
+    if (desk == NULL && desk_count < SINK_DESKS_MAX) {
+        desk = &desks[desk_count++];
+        strcpy(desk->name, batch.name);
+        desk->next_seq = batch.first_seq;
+    }
+    if (desk != NULL && batch.first_seq != desk->next_seq) {
+        printf("%s: %s: gap, expected seq %u, got %u\n", via, batch.name, desk->next_seq, batch.first_seq);
+    }
+    if (desk != NULL) {
+        desk->next_seq = batch.first_seq + batch.count;
+    }
+
+    char line[128];
+    char *p = line;
+    if (batch.count > 0) {
+        push_sample_t last;
+        push_batch_sample(&batch, batch.count - 1, &last);
+        p = PUT_LIT(p, " last ");
+        p = put_deci(p, last.temperature);
+        p = PUT_LIT(p, "C ");
+        p = put_deci(p, last.humidity);
+        p = PUT_LIT(p, "% light ");
+        p = put_deci(p, last.light);
+        p = PUT_LIT(p, "% fan ");
+        p = put_u32(p, last.fan);
+        p = (last.flags & PUSH_FLAG_MOTION) ? PUT_LIT(p, " motion") : p;
+        p = (last.flags & PUSH_FLAG_ANOMALY) ? PUT_LIT(p, " anomaly") : p;
+    }
+    *p = '\0';
+    printf("%s: %s seq %u-%u (%u samples, %zu bytes, %u dropped)%s\n", via, batch.name, batch.first_seq,
+           batch.first_seq + batch.count - 1, batch.count, len, batch.dropped, line);
+    fflush(stdout);
+}
+
+static int listen_on(int type, uint16_t port) {
+    int fd = socket(AF_INET, type, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in sa = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons(port),
+    };
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 || (type == SOCK_STREAM && listen(fd, 4) != 0)) {
+        fprintf(stderr, "cannot listen on port %u: %s\n", port, strerror(errno));
+        exit(1);
+    }
+    return fd;
+}
+
+static bool recv_all(int fd, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+// One MQTT control packet: type byte, remaining length and body
+static bool mqtt_read(int fd, uint8_t *type, uint8_t *body, size_t max, size_t *len) {
+    uint8_t b;
+    if (!recv_all(fd, type, 1)) {
+        return false;
+    }
+    size_t remaining = 0;
+    int shift = 0;
+    do {
+        if (shift > 21 || !recv_all(fd, &b, 1)) {
+            return false;
+        }
+        remaining |= (size_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    *len = remaining;
+    return remaining <= max && recv_all(fd, body, remaining);
+}
+
+// Serve one desk connection until it disconnects
+static void mqtt_session(int fd) {
+    struct timeval timeout = { .tv_sec = SINK_IO_TIMEOUT_S };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    static uint8_t body[16384];
+    uint8_t type;
+    size_t len;
+    while (mqtt_read(fd, &type, body, sizeof(body), &len)) {
+        if ((type & 0xF0) == 0x10) {
+            const uint8_t connack[] = { 0x20, 2, 0, 0 };
+            send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+        } else if ((type & 0xF0) == 0x30) {
+            int qos = (type >> 1) & 3;
+            size_t topic_len = len >= 2 ? (size_t)(body[0] << 8 | body[1]) : len;
+            size_t at = 2 + topic_len + (qos > 0 ? 2 : 0);
+            if (at > len) {
+                break;
+            }
+            char via[16 + PUSH_TOPIC_MAX];
+            snprintf(via, sizeof(via), "mqtt %.*s", (int)(topic_len < PUSH_TOPIC_MAX ? topic_len : PUSH_TOPIC_MAX),
+                     (const char *)body + 2);
+            print_batch(via, body + at, len - at);
+            if (qos > 0) {
+                const uint8_t puback[] = { 0x40, 2, body[2 + topic_len], body[3 + topic_len] };
+                send(fd, puback, sizeof(puback), MSG_NOSIGNAL);
+            }
+        } else if ((type & 0xF0) == 0xC0) {
+            const uint8_t pingresp[] = { 0xD0, 0 };
+            send(fd, pingresp, sizeof(pingresp), MSG_NOSIGNAL);
+        } else {
+            break;  // DISCONNECT, or something a desk does not send
+        }
+    }
+    close(fd);
+}
+
+int main(int argc, char **argv) {
+    uint16_t udp_port = 0;
+    uint16_t mqtt_port = 0;
+    int refuse = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--udp") == 0 && val != NULL) {
+            udp_port = (uint16_t)atoi(val);
+            i++;
+        } else if (strcmp(arg, "--mqtt") == 0 && val != NULL) {
+            mqtt_port = (uint16_t)atoi(val);
+            i++;
+        } else if (strcmp(arg, "--refuse") == 0 && val != NULL) {
+            refuse = atoi(val);
+            i++;
+        } else {
+            fprintf(stderr, "usage: %s [--udp PORT] [--mqtt PORT] [--refuse N]\n", argv[0]);
+            return arg[2] == 'h' ? 0 : 2;
+        }
+    }
+    if (udp_port == 0 && mqtt_port == 0) {
+        fprintf(stderr, "nothing to listen on; give --udp and/or --mqtt\n");
+        return 2;
+    }
+
+    struct pollfd fds[2];
+    int nfds = 0;
+    if (udp_port != 0) {
+        fds[nfds++] = (struct pollfd){ .fd = listen_on(SOCK_DGRAM, udp_port), .events = POLLIN };
+        printf("listening for UDP batches on port %u\n", udp_port);
+    }
+    if (mqtt_port != 0) {
+        fds[nfds++] = (struct pollfd){ .fd = listen_on(SOCK_STREAM, mqtt_port), .events = POLLIN };
+        printf("accepting MQTT publishes on port %u\n", mqtt_port);
+    }
+    fflush(stdout);
+
+    while (1) {
+        if (poll(fds, nfds, -1) < 0) {
+            continue;
+        }
+        for (int i = 0; i < nfds; i++) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            if (udp_port != 0 && i == 0) {
+                uint8_t buf[65536];
+                ssize_t n = recv(fds[i].fd, buf, sizeof(buf), 0);
+                if (n > 0) {
+                    print_batch("udp", buf, (size_t)n);
+                }
+                continue;
+            }
+            int fd = accept(fds[i].fd, NULL, NULL);
+            if (fd < 0) {
+                continue;
+            }
+            if (refuse > 0) {
+                refuse--;
+                printf("mqtt: refusing a connection (%d more)\n", refuse);
+                fflush(stdout);
+                close(fd);
+                continue;
+            }
+            mqtt_session(fd);
+        }
+    }
+}
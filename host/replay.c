@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "desk_logic.h"
+#include "dht22.h"
+#include "motion.h"
+#include "numfmt.h"
+#include "trace.h"
+#include "replay.h"
+
+#define TIMELINE_LINE_MAX   64
+
+typedef struct {
+    desk_logic_t logic;
+    motion_debounce_t debounce;
+    trace_header_t header;
+    int64_t now_us;             // Virtual clock
+    replay_timeline_t *timeline;
+    replay_stats_t *stats;
+} replay_t;
+
+static char *put_2d(char *p, uint32_t v) {
+    *p++ = (char)('0' + v / 10 % 10);
+    *p++ = (char)('0' + v % 10);
+    return p;
+}
+
+// Start a timeline line at the virtual clock; NULL when not recording one
+static char *line_begin(replay_t *r) {
+    replay_timeline_t *t = r->timeline;
+    if (t == NULL) {
+        return NULL;
+    }
+    if (t->cap - t->len < TIMELINE_LINE_MAX) {
+        t->cap = t->cap < 4096 ? 4096 : t->cap * 2;
+        t->text = realloc(t->text, t->cap);
+        if (t->text == NULL) {
+            abort();
+        }
+    }
+    int64_t rel = r->now_us - r->header.start_us;
+    uint64_t ms = rel > 0 ? (uint64_t)rel / 1000 : 0;
+    char *p = t->text + t->len;
+    p = put_2d(p, (uint32_t)(ms / 3600000));
+    *p++ = ':';
+    p = put_2d(p, (uint32_t)(ms / 60000 % 60));
+    *p++ = ':';
+    p = put_2d(p, (uint32_t)(ms / 1000 % 60));
+    *p++ = '.';
+    *p++ = (char)('0' + ms / 100 % 10);
+    p = put_2d(p, (uint32_t)(ms % 100));
+    *p++ = ' ';
+    return p;
+}
+
+static void line_end(replay_t *r, char *p) {
+    *p++ = '\n';
+    r->timeline->len = p - r->timeline->text;
+}
+
+static void on_buzzer(void *ctx, bool on) {
+    replay_t *r = ctx;
+    r->stats->aways += on;
+    char *p = line_begin(r);
+    if (p == NULL) {
+        return;
+    }
+    if (on) {
+        p = PUT_LIT(p, "buzzer on session ");
+        p = put_u32(p, r->logic.session_ended_s);
+    } else {
+        p = PUT_LIT(p, "buzzer off");
+    }
+    line_end(r, p);
+}
+
+static void on_led(void *ctx, bool on) {
+    replay_t *r = ctx;
+    r->stats->led_ons += on;
+    char *p = line_begin(r);
+    if (p != NULL) {
+        line_end(r, on ? PUT_LIT(p, "led on") : PUT_LIT(p, "led off"));
+    }
+}
+
+static void on_fan(void *ctx, uint8_t duty) {
+    replay_t *r = ctx;
+    char *p = line_begin(r);
+    if (p != NULL) {
+        p = PUT_LIT(p, "fan ");
+        line_end(r, put_u32(p, duty));
+    }
+}
+
+static void on_session(void *ctx, uint32_t seconds) {
+}
+
+static const desk_outputs_t replay_outputs = {
+    .buzzer = on_buzzer,
+    .led = on_led,
+    .fan = on_fan,
+    .session = on_session,
+};
+
+static void replay_motion(replay_t *r, const motion_edge_t *edge) {
+    r->stats->pir_edges++;
+    desk_logic_motion(&r->logic, edge->level, edge->time_us);
+}
+
+// Run the virtual clock up to t: everything sensor_task would have woken
+// for on the way (held-back PIR transitions, the away deadline), in order
+static void replay_until(replay_t *r, int64_t t) {
+    while (1) {
+        motion_edge_t edge;
+        int64_t settle_us;
+        while (motion_debounce_settle(&r->debounce, r->now_us, &edge, &settle_us)) {
+            replay_motion(r, &edge);
+        }
+        desk_logic_check_away(&r->logic, r->now_us);
+        int64_t away_us = desk_logic_away_deadline(&r->logic);
+        int64_t next = settle_us < away_us ? settle_us : away_us;
+        if (next > t) {
+            break;
+        }
+        r->now_us = next;
+    }
+    if (t > r->now_us) {
+        r->now_us = t;
+    }
+}
+
+static void replay_record(replay_t *r, const trace_record_t *rec) {
+    replay_until(r, rec->time_us);
+    motion_edge_t edge;
+    int16_t temp, humid;
+    switch (rec->type) {
+    case TRACE_PIR_LOW:
+    case TRACE_PIR_HIGH: {
+        const motion_edge_t raw = { .time_us = rec->time_us, .level = rec->type == TRACE_PIR_HIGH };
+        if (motion_debounce_raw(&r->debounce, &raw, &edge)) {
+            replay_motion(r, &edge);
+        }
+        replay_until(r, r->now_us);
+        break;
+    }
+    case TRACE_DHT:
+        if (dht22_frame_values(rec->frame, &temp, &humid) == ESP_OK) {
+            desk_logic_dht(&r->logic, temp, humid);
+        } else {
+            r->stats->dht_failures++;
+        }
+        break;
+    case TRACE_DHT_FAIL:
+        r->stats->dht_failures++;
+        break;
+    case TRACE_LDR:
+        desk_logic_light(&r->logic, desk_light_deci(rec->mv, r->header.zero_mv, r->header.full_mv));
+        break;
+    case TRACE_SAMPLE:
+        r->stats->samples++;
+        desk_logic_sample(&r->logic, rec->time_us);
+        break;
+    case TRACE_LOST:
+        r->stats->lost += rec->lost;
+        break;
+    }
+}
+
+bool replay_run(const uint8_t *buf, size_t len, const desk_config_t *config, replay_timeline_t *timeline,
+                replay_stats_t *stats) {
+    replay_t r = { .timeline = timeline, .stats = stats };
+    memset(stats, 0, sizeof(*stats));
+    if (!trace_decode_header(buf, len, &r.header)) {
+        return false;
+    }
+    r.now_us = r.header.start_us;
+    desk_logic_init(&r.logic, config, &replay_outputs, &r, r.now_us, r.header.pir_level);
+    motion_debounce_init(&r.debounce, r.header.pir_level, r.now_us, config->pir_debounce_ms);
+
+    trace_codec_t codec;
+    trace_codec_init(&codec, &r.header);
+    size_t at = TRACE_HEADER_LEN;
+    trace_record_t rec;
+    while (at < len) {
+        size_t used = trace_decode(&codec, buf + at, len - at, &rec);
+        if (used == 0) {
+            break;
+        }
+        at += used;
+        stats->records++;
+        replay_record(&r, &rec);
+    }
+    stats->undecoded = len - at;
+    stats->span_us = r.now_us - r.header.start_us;
+    stats->fan_writes = r.logic.fan_writes;
+    return true;
+}
+
+void replay_timeline_free(replay_timeline_t *timeline) {
+    free(timeline->text);
+    *timeline = (replay_timeline_t){ 0 };
+}
+
+static size_t line_len(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', end - p);
+    return (nl != NULL ? nl : end) - p;
+}
+
+size_t replay_diff(const char *got, size_t got_len, const char *want, size_t want_len, size_t max_shown) {
+    const char *g = got, *g_end = got + got_len;
+    const char *w = want, *w_end = want + want_len;
+    size_t differ = 0;
+    for (size_t line = 1; g < g_end || w < w_end; line++) {
+        size_t gl = g < g_end ? line_len(g, g_end) : 0;
+        size_t wl = w < w_end ? line_len(w, w_end) : 0;
+        bool same = g < g_end && w < w_end && gl == wl && memcmp(g, w, gl) == 0;
+        if (!same) {
+            if (differ < max_shown) {
+                printf("line %zu:\n", line);
+                if (w < w_end) {
+                    printf("  -%.*s\n", (int)wl, w);
+                }
+                if (g < g_end) {
+                    printf("  +%.*s\n", (int)gl, g);
+                }
+            }
+            differ++;
+        }
+        g = g < g_end ? g + gl + 1 : g;
+        w = w < w_end ? w + wl + 1 : w;
+    }
+    return differ;
+}
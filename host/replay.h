@@ -0,0 +1,55 @@
+#pragma once
+
+// Trace replay.
+//
+// Runs the firmware's decision path over a recorded sensor trace (trace.h)
+// the way sensor_task would have: PIR edges through the motion debounce,
+// DHT22 frames through the checksum and conversion, LDR voltages through
+// the light scaling, all into desk_logic.c, with the away deadline and
+// held-back PIR transitions fired at their due times. The clock is the
+// trace's own timestamps, so nothing waits and a day replays in a fraction
+// of a second.
+//
+// The decisions come out as a text timeline, one event per line, timed
+// from the start of the recording:
+//   00:41:07.312 buzzer on session 2381    (the user left after 2381 s)
+//   00:43:55.020 buzzer off                (back; a new session starts)
+//   02:03:11.000 fan 153
+//   09:58:12.100 led on
+// A timeline kept with a trace is its golden output: a change to the logic
+// that moves any decision shows up as a diff against it.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+typedef struct {
+    char *text;
+    size_t len;
+    size_t cap;
+} replay_timeline_t;
+
+typedef struct {
+    uint32_t records;
+    uint32_t lost;              // Dropped by the recorder's full ring
+    uint32_t dht_failures;      // No response, bad timing or bad checksum
+    uint32_t pir_edges;         // After the debounce
+    uint32_t samples;
+    uint32_t aways;
+    uint32_t led_ons;
+    uint32_t fan_writes;
+    int64_t span_us;            // Recording start to the last record
+    size_t undecoded;           // Trailing bytes that were not a whole record
+} replay_stats_t;
+
+// Replay the trace in buf under config, appending to timeline (may be
+// NULL). false if buf does not start with a trace header.
+bool replay_run(const uint8_t *buf, size_t len, const desk_config_t *config, replay_timeline_t *timeline,
+                replay_stats_t *stats);
+
+void replay_timeline_free(replay_timeline_t *timeline);
+
+// Line-by-line comparison; prints the first max_shown differing lines as
+// "-want" / "+got" and returns how many lines differ
+size_t replay_diff(const char *got, size_t got_len, const char *want, size_t want_len, size_t max_shown);
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "config.h"
+#include "replay.h"
+
+// Replays a sensor trace recorded by a board (GET /trace) or by
+// desk_sim --record through the decision logic and prints the timeline of
+// buzzer, LED and fan decisions, or checks it against a golden file.
+//
+// usage: replay TRACE [--config FORM] [--expect FILE | --write FILE] [--repeat N]
+//   --config FORM   settings as for POST /config, over the compile-time
+//                   defaults ("awaySeconds=20&lightThreshold=40")
+//   --expect FILE   compare the timeline with FILE; exit 1 if it differs
+//   --write FILE    save the timeline to FILE as the new golden output
+//   --repeat N      replay N times and report the best rate
+// The summary goes to stderr, so the timeline can be piped.
+
+#define DIFF_SHOWN      10
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+    size_t cap = 1 << 16;
+    char *buf = malloc(cap);
+    *len = 0;
+    size_t n;
+    while (buf != NULL && (n = fread(buf + *len, 1, cap - *len, f)) > 0) {
+        *len += n;
+        if (*len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    fclose(f);
+    return buf;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    const char *trace_path = NULL;
+    const char *expect_path = NULL;
+    const char *write_path = NULL;
+    int repeat = 1;
+    desk_config_t config;
+    config_defaults(&config);
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--config") == 0 && val != NULL) {
+            char form[512];
+            snprintf(form, sizeof(form), "%s", val);
+            const char *bad_key = NULL;
+            if (config_parse_form(&config, form, &bad_key) != ESP_OK || !config_valid(&config)) {
+                fprintf(stderr, "invalid setting: %s\n", bad_key != NULL ? bad_key : val);
+                return 2;
+            }
+            i++;
+        } else if (strcmp(arg, "--expect") == 0 && val != NULL) {
+            expect_path = val;
+            i++;
+        } else if (strcmp(arg, "--write") == 0 && val != NULL) {
+            write_path = val;
+            i++;
+        } else if (strcmp(arg, "--repeat") == 0 && val != NULL) {
+            repeat = atoi(val) > 0 ? atoi(val) : 1;
+            i++;
+        } else if (arg[0] != '-' && trace_path == NULL) {
+            trace_path = arg;
+        } else {
+            trace_path = NULL;
+            break;
+        }
+    }
+    if (trace_path == NULL) {
+        fprintf(stderr, "usage: %s TRACE [--config FORM] [--expect FILE | --write FILE] [--repeat N]\n", argv[0]);
+        return 2;
+    }
+
+    size_t len;
+    uint8_t *trace = (uint8_t *)read_file(trace_path, &len);
+    if (trace == NULL) {
+        return 1;
+    }
+    replay_timeline_t timeline = { 0 };
+    replay_stats_t stats;
+    double best = 0;
+    for (int i = 0; i < repeat; i++) {
+        replay_timeline_free(&timeline);
+        double start = now_s();
+        if (!replay_run(trace, len, &config, &timeline, &stats)) {
+            fprintf(stderr, "%s: not a trace (or a different format version)\n", trace_path);
+            return 1;
+        }
+        double elapsed = now_s() - start;
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    int status = 0;
+    if (expect_path != NULL) {
+        size_t want_len;
+        char *want = read_file(expect_path, &want_len);
+        if (want == NULL) {
+            return 1;
+        }
+        size_t differ = replay_diff(timeline.text, timeline.len, want, want_len, DIFF_SHOWN);
+        if (differ > 0) {
+            printf("%zu timeline lines differ from %s\n", differ, expect_path);
+            status = 1;
+        } else {
+            printf("timeline matches %s\n", expect_path);
+        }
+        free(want);
+    } else if (write_path != NULL) {
+        FILE *f = fopen(write_path, "w");
+        if (f == NULL || fwrite(timeline.text, 1, timeline.len, f) != timeline.len || fclose(f) != 0) {
+            perror(write_path);
+            return 1;
+        }
+    } else {
+        fwrite(timeline.text, 1, timeline.len, stdout);
+    }
+
+    double hours = stats.span_us / 3.6e9;
+    fprintf(stderr,
+            "%.2f h simulated, %u records (%zu bytes): %u samples, %u PIR edges, %u DHT22 failures, "
+            "%u away, %u LED on, %u fan writes\n",
+            hours, stats.records, len, stats.samples, stats.pir_edges, stats.dht_failures, stats.aways,
+            stats.led_ons, stats.fan_writes);
+    if (stats.lost > 0) {
+        fprintf(stderr, "warning: the recorder dropped %u records\n", stats.lost);
+    }
+    if (stats.undecoded > 0) {
+        fprintf(stderr, "warning: %zu trailing bytes are not a whole record\n", stats.undecoded);
+    }
+    fprintf(stderr, "replayed in %.1f ms: %.0f simulated hours per second\n", best * 1e3,
+            best > 0 ? hours / best : 0);
+    free(timeline.text);
+    free(trace);
+    return status;
+}
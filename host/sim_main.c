@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_server.h"
+#include "esp_partition.h"
+#include "nvs.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "dlog.h"
+#include "trace.h"
+
+// Linux entry point for the desk simulator: configures the simulated board,
+// runs the unmodified app_main() and then keeps the process alive while the
+// application tasks and HTTP server run.
+
+void app_main(void);
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --port N        HTTP listen port (default 8080)\n"
+            "  --seed N        PRNG seed for the simulated sensors (default 1)\n"
+            "  --dht-fail P    probability of a bad DHT22 frame (default 0.02)\n"
+            "  --i2c-fail P    probability of an I2C NACK (default 0)\n"
+            "  --i2c-hang      failed I2C writes block for their full timeout\n"
+            "  --pir-bounce P  probability that a PIR edge bounces (default 0.05)\n"
+            "  --flash PATH    flash image backing the history partition\n"
+            "                  (default desk_flash.bin, created if missing)\n"
+            "  --nvs PATH      NVS image holding the /config settings\n"
+            "                  (default desk_nvs.bin, created on the first save)\n"
+            "  --lcd           print the LCD model whenever it changes\n"
+            "  --record PATH   record a sensor trace from boot (see host/replay.c)\n"
+            "  --binlog        write deferred log records as \"#DL\" hex lines\n"
+            "                  (expand with dlog_decode)\n"
+            "  --quiet         only log warnings and errors\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    hal_sim_config_t config = {
+        .seed = 1,
+        .dht_fail_rate = 0.02f,
+        .i2c_fail_rate = 0.0f,
+        .pir_bounce_rate = 0.05f,
+    };
+    uint16_t port = 8080;
+    bool lcd_echo = false;
+    FILE *record = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--port") == 0 && val != NULL) {
+            port = (uint16_t)atoi(val);
+            i++;
+        } else if (strcmp(arg, "--seed") == 0 && val != NULL) {
+            config.seed = (uint32_t)strtoul(val, NULL, 0);
+            i++;
+        } else if (strcmp(arg, "--dht-fail") == 0 && val != NULL) {
+            config.dht_fail_rate = strtof(val, NULL);
+            i++;
+        } else if (strcmp(arg, "--i2c-fail") == 0 && val != NULL) {
+            config.i2c_fail_rate = strtof(val, NULL);
+            i++;
+        } else if (strcmp(arg, "--i2c-hang") == 0) {
+            config.i2c_fail_hangs = true;
+        } else if (strcmp(arg, "--pir-bounce") == 0 && val != NULL) {
+            config.pir_bounce_rate = strtof(val, NULL);
+            i++;
+        } else if (strcmp(arg, "--flash") == 0 && val != NULL) {
+            esp_partition_posix_set_image(val, 0x100000);
+            i++;
+        } else if (strcmp(arg, "--nvs") == 0 && val != NULL) {
+            nvs_posix_set_image(val);
+            i++;
+        } else if (strcmp(arg, "--record") == 0 && val != NULL) {
+            record = fopen(val, "wb");
+            if (record == NULL) {
+                perror(val);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "--lcd") == 0) {
+            lcd_echo = true;
+        } else if (strcmp(arg, "--binlog") == 0) {
+            dlog_set_binary(true);
+        } else if (strcmp(arg, "--quiet") == 0) {
+            esp_log_level_set("*", ESP_LOG_WARN);
+        } else {
+            usage(argv[0]);
+            return arg[2] == 'h' ? 0 : 2;
+        }
+    }
+
+    hal_sim_configure(&config);
+    httpd_posix_set_port_override(port);
+    app_main();
+
+    // Record from the moment sensor_task starts; the ring is drained to the
+    // file every pass
+    if (record != NULL) {
+        const trace_header_t header = {
+            .pir_level = hal_pir_read(),
+            .zero_mv = (uint16_t)hal_ldr_raw_to_mv(0),
+            .full_mv = (uint16_t)hal_ldr_raw_to_mv(4095),
+            .start_us = esp_timer_get_time(),
+        };
+        trace_start(&header);
+    }
+
+    char shown[2][17] = { "", "" };
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        if (record != NULL) {
+            uint8_t buf[TRACE_BUF_LEN];
+            size_t len = trace_read(buf, sizeof(buf));
+            if (len > 0) {
+                fwrite(buf, 1, len, record);
+                fflush(record);
+            }
+        }
+        if (!lcd_echo) {
+            continue;
+        }
+        char rows[2][17];
+        hal_sim_lcd_read(rows);
+        if (memcmp(rows, shown, sizeof(rows)) != 0) {
+            memcpy(shown, rows, sizeof(rows));
+            printf("LCD |%s|%s|\n", rows[0], rows[1]);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
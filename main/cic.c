@@ -0,0 +1,38 @@
+#include <string.h>
+#include "cic.h"
+
+void cic_init(cic_t *cic, uint32_t decimation) {
+    memset(cic, 0, sizeof(*cic));
+    cic->decimation = decimation > 0 ? decimation : 1;
+    cic->gain = 1;
+    for (int i = 0; i < CIC_ORDER; i++) {
+        cic->gain *= cic->decimation;
+    }
+}
+
+size_t cic_process(cic_t *cic, const uint16_t *in, size_t n, uint16_t *out, size_t out_max) {
+    size_t produced = 0;
+    for (size_t i = 0; i < n; i++) {
+        // Integrators; wraparound is harmless, the combs difference it out
+        uint64_t acc = in[i];
+        for (int s = 0; s < CIC_ORDER; s++) {
+            cic->integ[s] += acc;
+            acc = cic->integ[s];
+        }
+        if (++cic->phase < cic->decimation) {
+            continue;
+        }
+        cic->phase = 0;
+
+        // Combs at the output rate
+        for (int s = 0; s < CIC_ORDER; s++) {
+            uint64_t prev = cic->comb[s];
+            cic->comb[s] = acc;
+            acc -= prev;
+        }
+        if (produced < out_max) {
+            out[produced++] = (uint16_t)((acc + cic->gain / 2) / cic->gain);
+        }
+    }
+    return produced;
+}
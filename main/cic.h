@@ -0,0 +1,32 @@
+#pragma once
+
+// Fixed-point CIC decimator (cascaded integrator-comb, M = 1).
+//
+// CIC_ORDER integrators run at the input rate and the same number of comb
+// stages at the output rate, so the filter is a moving average of the last
+// R inputs applied CIC_ORDER times, with no multiplies. Registers are
+// 64-bit and wrap freely; a CIC only needs them wide enough for the final
+// output (12 + CIC_ORDER * log2(R) bits), which holds for any R below 2^26.
+//
+// Outputs are scaled back to input units and rounded. Pure computation on
+// caller-owned state, so it runs unchanged on the host (bench_cic).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CIC_ORDER   2
+
+typedef struct {
+    uint32_t decimation;            // R: inputs per output
+    uint32_t phase;                 // Inputs since the last output
+    uint64_t integ[CIC_ORDER];
+    uint64_t comb[CIC_ORDER];       // Comb delay line (previous stage input)
+    uint64_t gain;                  // R^CIC_ORDER
+} cic_t;
+
+void cic_init(cic_t *cic, uint32_t decimation);
+
+// Filter n input samples and store up to out_max outputs (each output is
+// produced when decimation inputs have been consumed). Inputs beyond the
+// last output that fits are still consumed. Returns the outputs written.
+size_t cic_process(cic_t *cic, const uint16_t *in, size_t n, uint16_t *out, size_t out_max);
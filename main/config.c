@@ -0,0 +1,518 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "numfmt.h"
+#include "config.h"
+
+static const char *TAG = "config";
+
+#define CONFIG_NVS_NAMESPACE    "desk"
+#define CONFIG_NVS_KEY          "config"
+#define CONFIG_LAYOUT           2       // Bump when desk_config_t changes
+
+// WiFi network joined until one is set through /config
+#define CONFIG_WIFI_SSID        "Mohanad"
+#define CONFIG_WIFI_PASS        "13572468"
+
+// Push telemetry is off until a target is set through /config
+#define CONFIG_PUSH_PORT        1883
+#define CONFIG_PUSH_TOPIC       "desk"
+#define CONFIG_PUSH_INTERVAL_S  30
+
+// The compile-time settings. Built field by field on zeroed memory so
+// padding is zero too and configs can be compared with memcmp.
+void config_defaults(desk_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->away_s = 10;
+    config->light_low_deci = 500;
+    config->light_delay_s = 5;
+    config->pir_debounce_ms = 50;
+    memcpy(&config->fan, &fan_config_default, sizeof(config->fan));
+    strcpy(config->wifi_ssid, CONFIG_WIFI_SSID);
+    strcpy(config->wifi_pass, CONFIG_WIFI_PASS);
+    config->push.mode = PUSH_OFF;
+    config->push.port = CONFIG_PUSH_PORT;
+    config->push.interval_s = CONFIG_PUSH_INTERVAL_S;
+    strcpy(config->push.topic, CONFIG_PUSH_TOPIC);
+}
+
+// What NVS holds: the struct as-is behind a layout number, so a firmware
+// with a different desk_config_t falls back to defaults instead of
+// misreading it
+typedef struct {
+    uint32_t layout;
+    desk_config_t config;
+} config_blob_t;
+
+static desk_config_t current;
+static atomic_uint current_seq;         // Odd while current is being written
+static SemaphoreHandle_t write_lock;
+static TaskHandle_t save_task;
+static config_blob_t saved;             // Last blob read from or written to NVS
+static config_stats_t stats;
+
+// Settings as they appear in /config, in output order
+typedef enum {
+    FIELD_UINT,         // uint16_t
+    FIELD_DECI,         // int16_t tenths, "-12.3"
+    FIELD_FAN_MODE,     // fan_config_t.pi as "curve" / "pi"
+    FIELD_FAN_CURVE,    // fan_config_t curve as "t:duty,t:duty,..."
+    FIELD_PUSH_MODE,    // push_config_t.mode as one of push_mode_names
+    FIELD_TEXT,         // char[], length min..max
+    FIELD_SECRET,       // FIELD_TEXT that is never reported back
+} field_type_t;
+
+typedef struct {
+    const char *key;
+    field_type_t type;
+    size_t offset;
+    int32_t min;
+    int32_t max;
+} config_field_t;
+
+#define FIELD(key, type, member, min, max) { key, type, offsetof(desk_config_t, member), min, max }
+
+static const config_field_t fields[] = {
+    FIELD("awaySeconds",       FIELD_UINT,      away_s,              1, 3600),
+    FIELD("lightThreshold",    FIELD_DECI,      light_low_deci,      0, 1000),
+    FIELD("lightDelaySeconds", FIELD_UINT,      light_delay_s,       0, 3600),
+    FIELD("pirDebounceMs",     FIELD_UINT,      pir_debounce_ms,     0, 2000),
+    FIELD("fanMode",           FIELD_FAN_MODE,  fan.pi,              0, 1),
+    FIELD("fanCurve",          FIELD_FAN_CURVE, fan,                 -400, 800),
+    FIELD("fanHysteresis",     FIELD_DECI,      fan.hysteresis_deci, 0, 50),
+    FIELD("fanSlew",           FIELD_UINT,      fan.slew_per_s,      0, 1000),
+    FIELD("fanTarget",         FIELD_DECI,      fan.target_deci,     -400, 800),
+    FIELD("fanKp",             FIELD_UINT,      fan.kp,              0, 1000),
+    FIELD("fanKi",             FIELD_UINT,      fan.ki,              0, 1000),
+    FIELD("wifiSsid",          FIELD_TEXT,      wifi_ssid,           1, CONFIG_SSID_MAX),
+    FIELD("wifiPassword",      FIELD_SECRET,    wifi_pass,           8, CONFIG_PASS_MAX),
+    FIELD("pushMode",          FIELD_PUSH_MODE, push.mode,           0, PUSH_MODE_COUNT - 1),
+    FIELD("pushHost",          FIELD_TEXT,      push.host,           0, PUSH_HOST_MAX),
+    FIELD("pushPort",          FIELD_UINT,      push.port,           1, 65535),
+    FIELD("pushTopic",         FIELD_TEXT,      push.topic,          1, PUSH_TOPIC_MAX),
+    FIELD("pushInterval",      FIELD_UINT,      push.interval_s,     1, 3600),
+};
+
+#define FIELD_COUNT (sizeof(fields) / sizeof(fields[0]))
+
+static bool field_valid(const config_field_t *f, const desk_config_t *config) {
+    const void *v = (const uint8_t *)config + f->offset;
+    switch (f->type) {
+    case FIELD_UINT:
+        return *(const uint16_t *)v >= f->min && *(const uint16_t *)v <= f->max;
+    case FIELD_DECI:
+        return *(const int16_t *)v >= f->min && *(const int16_t *)v <= f->max;
+    case FIELD_FAN_MODE:
+        return true;
+    case FIELD_PUSH_MODE:
+        return *(const uint8_t *)v <= f->max;
+    case FIELD_FAN_CURVE: {
+        const fan_config_t *fan = v;
+        if (!fan_config_valid(fan)) {
+            return false;
+        }
+        return fan->curve[0].temp_deci >= f->min && fan->curve[fan->curve_len - 1].temp_deci <= f->max;
+    }
+    case FIELD_TEXT:
+    case FIELD_SECRET: {
+        size_t len = strnlen(v, f->max + 1);
+        // WPA2 passphrases are 8-63 characters (64 is a hex PSK); empty means open
+        return len <= f->max && (len >= f->min || (f->type == FIELD_SECRET && len == 0));
+    }
+    }
+    return false;
+}
+
+bool config_valid(const desk_config_t *config) {
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (!field_valid(&fields[i], config)) {
+            return false;
+        }
+    }
+    // Push needs a host once it is on
+    return push_config_valid(&config->push);
+}
+
+uint32_t config_generation(void) {
+    return atomic_load_explicit(&current_seq, memory_order_acquire);
+}
+
+uint32_t config_get(desk_config_t *out) {
+    while (1) {
+        uint32_t seq = atomic_load_explicit(&current_seq, memory_order_acquire);
+        if (seq & 1) {
+            continue;  // A write is in progress; it is a memcpy away from done
+        }
+        memcpy(out, &current, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&current_seq, memory_order_relaxed) == seq) {
+            return seq;
+        }
+    }
+}
+
+// write_lock held
+static void config_publish(const desk_config_t *config) {
+    uint32_t seq = atomic_load_explicit(&current_seq, memory_order_relaxed);
+    atomic_store_explicit(&current_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&current, config, sizeof(current));
+    atomic_store_explicit(&current_seq, seq + 2, memory_order_release);
+}
+
+esp_err_t config_set(const desk_config_t *config) {
+    if (!config_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+    bool changed = memcmp(config, &current, sizeof(current)) != 0;
+    if (changed) {
+        config_publish(config);
+        stats.updates++;
+    }
+    xSemaphoreGive(write_lock);
+    if (changed) {
+        xTaskNotifyGive(save_task);
+    }
+    return ESP_OK;
+}
+
+static void config_save(void) {
+    config_blob_t blob;
+    blob.layout = CONFIG_LAYOUT;
+    config_get(&blob.config);
+    if (memcmp(&blob, &saved, sizeof(blob)) == 0) {
+        return;  // Edited and edited back
+    }
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, CONFIG_NVS_KEY, &blob, sizeof(blob));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        stats.commit_errors++;
+        ESP_LOGE(TAG, "Saving configuration failed: %s", esp_err_to_name(err));
+        return;
+    }
+    memcpy(&saved, &blob, sizeof(saved));
+    stats.commits++;
+    ESP_LOGI(TAG, "Configuration saved");
+}
+
+// Every config_set() notifies this task. It waits for the first unsaved
+// update, then for CONFIG_SAVE_DELAY_MS without another one (bounded by
+// CONFIG_SAVE_MAX_DELAY_MS), and commits whatever is current by then.
+static void config_save_task(void *pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t first_us = esp_timer_get_time();
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_SAVE_DELAY_MS)) > 0 &&
+               esp_timer_get_time() - first_us < (int64_t)CONFIG_SAVE_MAX_DELAY_MS * 1000) {
+        }
+        config_save();
+    }
+}
+
+static void config_load(desk_config_t *config) {
+    config_defaults(config);
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "No stored configuration, using defaults");
+        return;
+    }
+    config_blob_t blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(nvs, CONFIG_NVS_KEY, &blob, &len);
+    nvs_close(nvs);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGI(TAG, "No stored configuration, using defaults");
+    } else if (err != ESP_OK || len != sizeof(blob) || blob.layout != CONFIG_LAYOUT) {
+        ESP_LOGW(TAG, "Stored configuration unreadable or from another firmware, using defaults");
+    } else if (!config_valid(&blob.config)) {
+        ESP_LOGW(TAG, "Stored configuration out of range, using defaults");
+    } else {
+        memcpy(config, &blob.config, sizeof(*config));
+        memcpy(&saved, &blob, sizeof(saved));
+        ESP_LOGI(TAG, "Configuration loaded from NVS");
+    }
+}
+
+esp_err_t config_init(void) {
+    desk_config_t config;
+    config_load(&config);
+    write_lock = xSemaphoreCreateMutex();
+    if (write_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    config_publish(&config);
+    if (xTaskCreate(config_save_task, "config", 3072, NULL, 1, &save_task) != pdPASS) {
+        ESP_LOGE(TAG, "Cannot start the config save task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void config_get_stats(config_stats_t *out) {
+    *out = stats;
+}
+
+// Form parsing
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Percent-decode in place; false on a malformed escape
+static bool url_decode(char *s) {
+    char *out = s;
+    for (; *s != '\0'; s++) {
+        if (*s == '+') {
+            *out++ = ' ';
+        } else if (*s == '%') {
+            int hi = hex_digit(s[1]);
+            int lo = hi >= 0 ? hex_digit(s[2]) : -1;
+            if (lo < 0 || (hi == 0 && lo == 0)) {
+                return false;
+            }
+            *out++ = (char)(hi << 4 | lo);
+            s += 2;
+        } else {
+            *out++ = *s;
+        }
+    }
+    *out = '\0';
+    return true;
+}
+
+// Integer or one-decimal number ("25", "-3.5") in tenths; end is set past it
+static bool parse_deci(const char *s, const char **end, int32_t *out) {
+    bool neg = *s == '-';
+    s += neg;
+    if (*s < '0' || *s > '9') {
+        return false;
+    }
+    int32_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        if (v > 100000) {
+            return false;
+        }
+        v = v * 10 + (*s++ - '0');
+    }
+    v *= 10;
+    if (*s == '.') {
+        s++;
+        if (*s < '0' || *s > '9') {
+            return false;
+        }
+        v += *s++ - '0';
+    }
+    *out = neg ? -v : v;
+    *end = s;
+    return true;
+}
+
+static bool parse_uint(const char *s, const char **end, int32_t *out) {
+    if (*s < '0' || *s > '9') {
+        return false;
+    }
+    int32_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        if (v > 100000) {
+            return false;
+        }
+        v = v * 10 + (*s++ - '0');
+    }
+    *out = v;
+    *end = s;
+    return true;
+}
+
+// "20:76,25.5:153": points of temperature (°C) and duty (0-255)
+static bool parse_curve(const char *s, fan_config_t *fan) {
+    fan_config_t parsed = *fan;
+    parsed.curve_len = 0;
+    while (1) {
+        int32_t temp, duty;
+        if (parsed.curve_len == FAN_CURVE_MAX ||
+            !parse_deci(s, &s, &temp) || *s++ != ':' ||
+            !parse_uint(s, &s, &duty) || duty > 255 || temp < INT16_MIN || temp > INT16_MAX) {
+            return false;
+        }
+        parsed.curve[parsed.curve_len++] = (fan_point_t){ .temp_deci = (int16_t)temp, .duty = (uint8_t)duty };
+        if (*s == '\0') {
+            break;
+        }
+        if (*s++ != ',') {
+            return false;
+        }
+    }
+    // Points past the end are zeroed so equal curves compare equal
+    memset(&parsed.curve[parsed.curve_len], 0, (FAN_CURVE_MAX - parsed.curve_len) * sizeof(fan_point_t));
+    *fan = parsed;
+    return true;
+}
+
+static bool field_parse(const config_field_t *f, desk_config_t *config, const char *value) {
+    void *v = (uint8_t *)config + f->offset;
+    const char *end;
+    int32_t n;
+    switch (f->type) {
+    case FIELD_UINT:
+        if (!parse_uint(value, &end, &n) || *end != '\0' || n < f->min || n > f->max) {
+            return false;
+        }
+        *(uint16_t *)v = (uint16_t)n;
+        return true;
+    case FIELD_DECI:
+        if (!parse_deci(value, &end, &n) || *end != '\0' || n < f->min || n > f->max) {
+            return false;
+        }
+        *(int16_t *)v = (int16_t)n;
+        return true;
+    case FIELD_FAN_MODE:
+        if (strcmp(value, "curve") != 0 && strcmp(value, "pi") != 0) {
+            return false;
+        }
+        *(bool *)v = strcmp(value, "pi") == 0;
+        return true;
+    case FIELD_PUSH_MODE:
+        for (int m = 0; m < PUSH_MODE_COUNT; m++) {
+            if (strcmp(value, push_mode_names[m]) == 0) {
+                *(uint8_t *)v = (uint8_t)m;
+                return true;
+            }
+        }
+        return false;
+    case FIELD_FAN_CURVE:
+        return parse_curve(value, v) && field_valid(f, config);
+    case FIELD_TEXT:
+    case FIELD_SECRET: {
+        size_t len = strlen(value);
+        if (len > f->max) {
+            return false;
+        }
+        // strncpy zero-fills the rest, so equal strings compare equal
+        strncpy(v, value, f->max + 1);
+        return field_valid(f, config);
+    }
+    }
+    return false;
+}
+
+esp_err_t config_parse_form(desk_config_t *config, char *form, const char **bad_key) {
+    desk_config_t edited;
+    memcpy(&edited, config, sizeof(edited));
+    char *pair = form;
+    while (*pair != '\0') {
+        char *next = strchr(pair, '&');
+        if (next != NULL) {
+            *next++ = '\0';
+        } else {
+            next = pair + strlen(pair);
+        }
+        char *value = strchr(pair, '=');
+        if (value != NULL) {
+            *value++ = '\0';
+        }
+        *bad_key = pair;
+        if (*pair == '\0' || value == NULL || !url_decode(pair) || !url_decode(value)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        const config_field_t *f = NULL;
+        for (size_t i = 0; i < FIELD_COUNT; i++) {
+            if (strcmp(fields[i].key, pair) == 0) {
+                f = &fields[i];
+            }
+        }
+        if (f == NULL || !field_parse(f, &edited, value)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        pair = next;
+    }
+    memcpy(config, &edited, sizeof(edited));
+    return ESP_OK;
+}
+
+// JSON output
+
+static char *put_json_string(char *p, const char *s) {
+    *p++ = '"';
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            *p++ = '\\';
+            *p++ = (char)c;
+        } else if (c < 0x20) {
+            p = PUT_LIT(p, "\\u00");
+            *p++ = "0123456789abcdef"[c >> 4];
+            *p++ = "0123456789abcdef"[c & 15];
+        } else {
+            *p++ = (char)c;
+        }
+    }
+    *p++ = '"';
+    return p;
+}
+
+char *config_put_json(char *p, const desk_config_t *config) {
+    *p++ = '{';
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        const config_field_t *f = &fields[i];
+        const void *v = (const uint8_t *)config + f->offset;
+        if (i > 0) {
+            *p++ = ',';
+        }
+        *p++ = '"';
+        p = put_bytes(p, f->key, strlen(f->key));
+        p = f->type == FIELD_SECRET ? PUT_LIT(p, "Set\":") : PUT_LIT(p, "\":");
+        switch (f->type) {
+        case FIELD_UINT:
+            p = put_u32(p, *(const uint16_t *)v);
+            break;
+        case FIELD_DECI:
+            p = put_deci(p, *(const int16_t *)v);
+            break;
+        case FIELD_FAN_MODE:
+            p = *(const bool *)v ? PUT_LIT(p, "\"pi\"") : PUT_LIT(p, "\"curve\"");
+            break;
+        case FIELD_PUSH_MODE:
+            p = put_json_string(p, push_mode_names[*(const uint8_t *)v]);
+            break;
+        case FIELD_FAN_CURVE: {
+            const fan_config_t *fan = v;
+            *p++ = '[';
+            for (int c = 0; c < fan->curve_len; c++) {
+                p = c > 0 ? PUT_LIT(p, ",[") : PUT_LIT(p, "[");
+                p = put_deci(p, fan->curve[c].temp_deci);
+                *p++ = ',';
+                p = put_u32(p, fan->curve[c].duty);
+                *p++ = ']';
+            }
+            *p++ = ']';
+            break;
+        }
+        case FIELD_TEXT:
+            p = put_json_string(p, v);
+            break;
+        case FIELD_SECRET:
+            p = put_bool(p, *(const char *)v != '\0');
+            break;
+        }
+    }
+    *p++ = '}';
+    return p;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Runtime configuration.
+//
+// The settings that shape the desk's behaviour live in one desk_config_t in
+// RAM. It is loaded from NVS at boot (the compile-time defaults when NVS
+// holds none, or holds an older layout) and edited through /config; every
+// change takes effect without a reboot.
+//
+// Reads never lock. Updates are published under a sequence counter that is
+// odd while a write is in progress: config_get() copies the struct and
+// retries if the counter moved meanwhile. Tasks that apply settings poll
+// config_generation(), a single atomic load, and copy only when it changed.
+//
+// Writes to NVS are left to a low-priority task. Each update restarts a
+// CONFIG_SAVE_DELAY_MS quiet period and the config is committed once it
+// passes, or CONFIG_SAVE_MAX_DELAY_MS after the first unsaved update if
+// edits keep coming, so a burst of edits costs a single commit. A commit
+// that would store what NVS already holds is skipped.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "fan.h"
+#include "push.h"
+
+#define CONFIG_SAVE_DELAY_MS        2000
+#define CONFIG_SAVE_MAX_DELAY_MS    10000
+#define CONFIG_SSID_MAX             32
+#define CONFIG_PASS_MAX             64
+#define CONFIG_JSON_MAX             1536    // Longest config_put_json() output
+
+typedef struct {
+    uint16_t away_s;                // No motion for this long sounds the buzzer
+    int16_t light_low_deci;         // Light % x10 below which...
+    uint16_t light_delay_s;         // ...the LED turns on after this long
+    uint16_t pir_debounce_ms;
+    fan_config_t fan;
+    char wifi_ssid[CONFIG_SSID_MAX + 1];
+    char wifi_pass[CONFIG_PASS_MAX + 1];    // Empty for an open network
+    push_config_t push;
+} desk_config_t;
+
+typedef struct {
+    uint32_t updates;           // Accepted changes
+    uint32_t commits;           // NVS commits
+    uint32_t commit_errors;
+} config_stats_t;
+
+// Load the stored config and start the save task. Needs NVS initialized.
+esp_err_t config_init(void);
+
+// Changes whenever an update is published
+uint32_t config_generation(void);
+
+// Copy the current config; returns the generation copied
+uint32_t config_get(desk_config_t *out);
+
+// Publish a new config. ESP_ERR_INVALID_ARG if any field is out of range
+// (the current config stays). Only the server task calls this.
+esp_err_t config_set(const desk_config_t *config);
+
+bool config_valid(const desk_config_t *config);
+
+// The compile-time settings
+void config_defaults(desk_config_t *config);
+
+// Apply an application/x-www-form-urlencoded body ("awaySeconds=20&...")
+// to config, decoding it in place. Keys that are absent keep their value.
+// On ESP_ERR_INVALID_ARG *bad_key names the unknown or invalid key.
+esp_err_t config_parse_form(desk_config_t *config, char *form, const char **bad_key);
+
+// JSON object with every setting; the WiFi password is only reported as set
+// or not. Writes at most CONFIG_JSON_MAX bytes, returns the end.
+char *config_put_json(char *p, const desk_config_t *config);
+
+void config_get_stats(config_stats_t *out);
@@ -0,0 +1,125 @@
+#include <string.h>
+#include "desk_logic.h"
+
+void desk_logic_init(desk_logic_t *d, const desk_config_t *config, const desk_outputs_t *out, void *ctx,
+                     int64_t now_us, bool pir_level) {
+    *d = (desk_logic_t){
+        .out = out,
+        .ctx = ctx,
+        .motion_detected = pir_level,
+        .motion_end_us = now_us,
+        .session_active = true,
+    };
+    fan_ctrl_init(&d->fan, &config->fan);
+    desk_logic_configure(d, config);
+}
+
+void desk_logic_configure(desk_logic_t *d, const desk_config_t *config) {
+    d->away_s = config->away_s;
+    d->light_low_deci = config->light_low_deci;
+    d->light_delay_s = config->light_delay_s;
+    if (memcmp(&d->fan.config, &config->fan, sizeof(config->fan)) != 0) {
+        fan_ctrl_configure(&d->fan, &config->fan);
+    }
+}
+
+void desk_logic_motion(desk_logic_t *d, bool level, int64_t time_us) {
+    d->motion_detected = level;
+    if (!level) {
+        d->motion_end_us = time_us;
+        return;
+    }
+    d->motion_count++;
+    d->motion_this_tick = true;
+    if (d->buzzer_on) {
+        // Back at the desk: silence the buzzer and restart the session from 0
+        d->buzzer_on = false;
+        d->session_active = true;
+        d->session_s = 0;
+        d->out->buzzer(d->ctx, false);
+    }
+}
+
+int64_t desk_logic_away_deadline(const desk_logic_t *d) {
+    if (d->motion_detected || d->buzzer_on) {
+        return INT64_MAX;
+    }
+    return d->motion_end_us + (int64_t)d->away_s * 1000000;
+}
+
+void desk_logic_check_away(desk_logic_t *d, int64_t now_us) {
+    if (now_us < desk_logic_away_deadline(d)) {
+        return;
+    }
+    // Time limit reached: sound the buzzer and end the session
+    d->buzzer_on = true;
+    d->session_active = false;
+    d->session_ended_s = d->session_s;
+    d->session_s = 0;
+    d->out->buzzer(d->ctx, true);
+}
+
+void desk_logic_dht(desk_logic_t *d, int16_t temp_deci, int16_t humid_deci) {
+    d->temperature = temp_deci;
+    d->humidity = humid_deci;
+    d->temperature_valid = true;
+}
+
+void desk_logic_light(desk_logic_t *d, int16_t light_deci) {
+    d->light = light_deci;
+    d->light_valid = true;
+}
+
+// Stepped once per sample so the slew runs between DHT readings
+static void fan_update(desk_logic_t *d, int64_t now_us) {
+    if (!d->temperature_valid) {
+        return;
+    }
+    uint8_t duty = fan_ctrl_update(&d->fan, d->temperature, now_us);
+    if (duty == d->fan_duty) {
+        return;
+    }
+    d->fan_duty = duty;
+    d->fan_writes++;
+    d->out->fan(d->ctx, duty);
+}
+
+bool desk_logic_sample(desk_logic_t *d, int64_t now_us) {
+    fan_update(d, now_us);
+
+    // The LED comes on after light_delay_s of low light and goes off as
+    // soon as the light is good again
+    if (d->light < d->light_low_deci) {
+        d->low_light_s++;
+        if (d->low_light_s >= d->light_delay_s && !d->led_on) {
+            d->led_on = true;
+            d->out->led(d->ctx, true);
+        }
+    } else {
+        d->low_light_s = 0;
+        if (d->led_on) {
+            d->led_on = false;
+            d->out->led(d->ctx, false);
+        }
+    }
+
+    // The session clock runs whether or not the PIR fires; it stops only
+    // while the buzzer says the user is away
+    if (d->session_active && !d->buzzer_on) {
+        d->session_s++;
+        d->out->session(d->ctx, d->session_s);
+    }
+
+    // A second counts as motion if the PIR fired at any point during it
+    bool motion = d->motion_detected || d->motion_this_tick;
+    d->motion_this_tick = false;
+    return motion;
+}
+
+int16_t desk_light_deci(uint32_t mv, uint32_t zero_mv, uint32_t full_mv) {
+    // Scaled on the calibrated voltage, which corrects the ADC's gain and
+    // offset error
+    mv = mv < zero_mv ? zero_mv : mv > full_mv ? full_mv : mv;
+    uint32_t span = full_mv - zero_mv;
+    return (int16_t)(((full_mv - mv) * 1000 + span / 2) / span);
+}
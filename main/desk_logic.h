@@ -0,0 +1,87 @@
+#pragma once
+
+// Desk decision logic: away detection and the session clock, the reading
+// LED and the fan.
+//
+// A state machine over sensor readings with explicit timestamps. It touches
+// no hardware, task or clock and reports every decision through the
+// desk_outputs_t callbacks, so sensor_task runs it against the board and
+// the trace replay (host/replay.c) runs the same code on a virtual clock.
+//
+// Inputs, as sensor_task applies them:
+//   desk_logic_motion()       a debounced PIR edge
+//   desk_logic_check_away()   whenever the loop wakes; nothing happens
+//                             before desk_logic_away_deadline()
+//   desk_logic_dht()          a reading with a good checksum
+//   desk_logic_light()        a filtered LDR reading
+//   desk_logic_sample()       once per second: fan, LED and session clock
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+#include "fan.h"
+
+typedef struct {
+    void (*buzzer)(void *ctx, bool on);             // On: the user went away
+    void (*led)(void *ctx, bool on);
+    void (*fan)(void *ctx, uint8_t duty);           // Only when the duty changes
+    void (*session)(void *ctx, uint32_t seconds);   // Session clock advanced
+} desk_outputs_t;
+
+typedef struct {
+    const desk_outputs_t *out;
+    void *ctx;
+
+    // Settings
+    uint16_t away_s;
+    int16_t light_low_deci;
+    uint16_t light_delay_s;
+
+    // Latest readings, deci-units
+    int16_t temperature;
+    int16_t humidity;
+    bool temperature_valid;     // A DHT22 reading has arrived
+    int16_t light;
+    bool light_valid;           // A light reading has arrived
+
+    bool motion_detected;       // Debounced PIR level
+    uint32_t motion_count;      // Rising edges
+    int64_t motion_end_us;      // When the PIR last went quiet
+    bool motion_this_tick;      // Any motion since the last sample
+
+    bool buzzer_on;
+    bool session_active;
+    uint32_t session_s;
+    uint32_t session_ended_s;   // Length of the session the last away closed
+
+    uint32_t low_light_s;
+    bool led_on;
+
+    fan_ctrl_t fan;
+    uint8_t fan_duty;
+    uint32_t fan_writes;
+} desk_logic_t;
+
+// Start with the PIR at pir_level and an active session at now_us
+void desk_logic_init(desk_logic_t *d, const desk_config_t *config, const desk_outputs_t *out, void *ctx,
+                     int64_t now_us, bool pir_level);
+
+// Apply changed settings (away time, LED thresholds, fan configuration)
+void desk_logic_configure(desk_logic_t *d, const desk_config_t *config);
+
+void desk_logic_motion(desk_logic_t *d, bool level, int64_t time_us);
+
+// Time at which the user counts as away, or INT64_MAX while that cannot happen
+int64_t desk_logic_away_deadline(const desk_logic_t *d);
+void desk_logic_check_away(desk_logic_t *d, int64_t now_us);
+
+void desk_logic_dht(desk_logic_t *d, int16_t temp_deci, int16_t humid_deci);
+void desk_logic_light(desk_logic_t *d, int16_t light_deci);
+
+// One sample period ends at now_us. Returns whether it saw motion, which
+// also clears the per-period flag.
+bool desk_logic_sample(desk_logic_t *d, int64_t now_us);
+
+// Light % x10 from a calibrated LDR voltage between the ADC's zero- and
+// full-scale voltages. Inverted: higher readings mean darker.
+int16_t desk_light_deci(uint32_t mv, uint32_t zero_mv, uint32_t full_mv);
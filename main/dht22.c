@@ -0,0 +1,59 @@
+#include <stdbool.h>
+#include <string.h>
+#include "dht22.h"
+
+// Tolerances are wide enough for sensor and capture jitter but keep the
+// response preamble (80/80 us) apart from data bits (50 us low)
+#define RESP_MIN_US         65
+#define RESP_MAX_US         110
+#define BIT_LOW_MIN_US      30
+#define BIT_LOW_MAX_US      64
+#define BIT_HIGH_MIN_US     10
+#define BIT_HIGH_MAX_US     100
+#define BIT_ONE_MIN_US      48      // Midway between the 0 and 1 high times
+
+static bool in_range(const dht22_pulse_t *p, uint8_t level, uint16_t min_us, uint16_t max_us) {
+    return p->level == level && p->duration_us >= min_us && p->duration_us <= max_us;
+}
+
+esp_err_t dht22_decode(const dht22_pulse_t *pulses, size_t count, uint8_t data[5]) {
+    memset(data, 0, 5);
+
+    // The capture may start part-way through the host start pulse, so look
+    // for the response preamble rather than assuming a fixed position
+    size_t i = 0;
+    while (i + 1 < count && !(in_range(&pulses[i], 0, RESP_MIN_US, RESP_MAX_US) &&
+                              in_range(&pulses[i + 1], 1, RESP_MIN_US, RESP_MAX_US))) {
+        i++;
+    }
+    if (i + 1 >= count) {
+        return ESP_ERR_TIMEOUT;
+    }
+    i += 2;
+
+    for (int bit = 0; bit < 40; bit++, i += 2) {
+        if (i + 1 >= count) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (!in_range(&pulses[i], 0, BIT_LOW_MIN_US, BIT_LOW_MAX_US) ||
+            !in_range(&pulses[i + 1], 1, BIT_HIGH_MIN_US, BIT_HIGH_MAX_US)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        if (pulses[i + 1].duration_us >= BIT_ONE_MIN_US) {
+            data[bit / 8] |= 1 << (7 - bit % 8);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t dht22_frame_values(const uint8_t data[5], int16_t *temp, int16_t *humid) {
+    if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    *humid = (int16_t)((data[0] << 8) | data[1]);
+    *temp = (int16_t)(((data[2] & 0x7F) << 8) | data[3]);
+    if (data[2] & 0x80) {
+        *temp = -*temp;
+    }
+    return ESP_OK;
+}
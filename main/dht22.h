@@ -0,0 +1,35 @@
+#pragma once
+
+// DHT22 / AM2302 frame decoder.
+//
+// The HAL captures the data line as a train of pulses (level + duration),
+// either with the RMT peripheral on the board or from a waveform model on
+// the host, and hands it to dht22_decode(). Decoding is pure: no hardware
+// access and no timing constraints, so it runs after the capture completes
+// and can be exercised against recorded waveforms on Linux.
+//
+// Nominal timing after the host releases the line:
+//   response   80 us low, 80 us high
+//   each bit   50 us low, then 26-28 us high for 0 or 70 us high for 1
+//   end        50 us low, then the line idles high
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define DHT22_MAX_PULSES    96      // 2 per bit plus preamble, with headroom
+
+typedef struct {
+    uint16_t duration_us;
+    uint8_t level;          // Line level during the pulse (0 or 1)
+} dht22_pulse_t;
+
+// Decode one 40-bit frame (humidity hi/lo, temp hi/lo, checksum). The
+// checksum is not verified here.
+//   ESP_ERR_TIMEOUT           no sensor response, or the frame is incomplete
+//   ESP_ERR_INVALID_RESPONSE  a pulse is outside the datasheet tolerances
+esp_err_t dht22_decode(const dht22_pulse_t *pulses, size_t count, uint8_t data[5]);
+
+// Check the checksum of a decoded frame and convert it to deci-units, which
+// is the sensor's native resolution. ESP_ERR_INVALID_CRC on a bad checksum.
+esp_err_t dht22_frame_values(const uint8_t data[5], int16_t *temp, int16_t *humid);
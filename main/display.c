@@ -0,0 +1,114 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lcd.h"
+#include "metrics.h"
+#include "display.h"
+
+#define DISPLAY_TASK_PRIORITY   1   // Below the sensor and flash log tasks
+#define DISPLAY_TASK_STACK      3072
+#define DISPLAY_TASK_CORE       0   // With the network stack, off the acquisition core
+
+typedef enum {
+    DISPLAY_CMD_CLEAR,
+    DISPLAY_CMD_SESSION,
+    DISPLAY_CMD_AWAY,
+} display_cmd_type_t;
+
+typedef struct {
+    display_cmd_type_t type;
+    uint32_t seconds;       // DISPLAY_CMD_SESSION
+} display_cmd_t;
+
+static const char *TAG = "DISPLAY";
+
+static QueueHandle_t mailbox;
+static uint8_t display_lcd_addr;
+static display_stats_t stats;
+
+static void display_render(const display_cmd_t *cmd) {
+    switch (cmd->type) {
+    case DISPLAY_CMD_CLEAR:
+        lcd_clear();
+        break;
+    case DISPLAY_CMD_SESSION: {
+        char time_str[32];  // Larger buffer to avoid compiler warnings
+        snprintf(time_str, sizeof(time_str), "    %02" PRIu32 ":%02" PRIu32 ":%02" PRIu32 "    ",
+                 cmd->seconds / 3600, (cmd->seconds % 3600) / 60, cmd->seconds % 60);
+        lcd_write_line(0, "Session Time:");
+        lcd_write_line(1, time_str);
+        break;
+    }
+    case DISPLAY_CMD_AWAY:
+        lcd_write_line(0, "User Away!");
+        lcd_write_line(1, "Session Reset");
+        break;
+    }
+    lcd_flush();
+}
+
+static void display_task(void *pvParameters) {
+    lcd_init(display_lcd_addr);
+    while (1) {
+        display_cmd_t cmd;
+        if (xQueueReceive(mailbox, &cmd, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        display_render(&cmd);
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+        stats.frames++;
+        metrics_observe(METRICS_LCD_FRAME, elapsed);
+        if (elapsed > stats.render_max_us) {
+            stats.render_max_us = elapsed;
+        }
+    }
+}
+
+esp_err_t display_init(uint8_t lcd_addr) {
+    display_lcd_addr = lcd_addr;
+    mailbox = xQueueCreate(1, sizeof(display_cmd_t));
+    if (mailbox == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(display_task, "display_task", DISPLAY_TASK_STACK, NULL,
+                                DISPLAY_TASK_PRIORITY, NULL, DISPLAY_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start the display task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void display_post(const display_cmd_t *cmd) {
+    if (mailbox == NULL) {
+        return;
+    }
+    stats.posted++;
+    if (uxQueueMessagesWaiting(mailbox) != 0) {
+        stats.coalesced++;
+    }
+    xQueueOverwrite(mailbox, cmd);
+}
+
+void display_clear(void) {
+    const display_cmd_t cmd = { .type = DISPLAY_CMD_CLEAR };
+    display_post(&cmd);
+}
+
+void display_show_session(uint32_t seconds) {
+    const display_cmd_t cmd = { .type = DISPLAY_CMD_SESSION, .seconds = seconds };
+    display_post(&cmd);
+}
+
+void display_show_away(void) {
+    const display_cmd_t cmd = { .type = DISPLAY_CMD_AWAY };
+    display_post(&cmd);
+}
+
+void display_get_stats(display_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Asynchronous LCD front end.
+//
+// The LCD is owned by a low-priority display task. Other tasks describe the
+// screen they want with a render command; posting never blocks. Commands go
+// through a one-slot mailbox that the newest command overwrites, so a display
+// that falls behind (a stuck I2C bus can take 100 ms per write) skips stale
+// frames instead of queueing them, and only the latest screen is drawn.
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct {
+    uint32_t posted;        // Commands posted
+    uint32_t coalesced;     // Commands replaced before the task drew them
+    uint32_t frames;        // Commands rendered
+    uint32_t render_max_us; // Longest render, I2C included
+} display_stats_t;
+
+// Start the display task. LCD init runs on that task, so this returns at once.
+esp_err_t display_init(uint8_t lcd_addr);
+
+void display_clear(void);
+
+// "Session Time:" over the elapsed time as hh:mm:ss
+void display_show_session(uint32_t seconds);
+
+// "User Away!" / "Session Reset" banner
+void display_show_away(void);
+
+void display_get_stats(display_stats_t *out);
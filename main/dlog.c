@@ -0,0 +1,164 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "dlog.h"
+
+#define DLOG_TASK_PRIORITY  0       // Idle: runs only when everything else is blocked
+#define DLOG_TASK_STACK     3072
+#define DLOG_TASK_CORE      0       // With the network stack, off the acquisition core
+#define DLOG_DRAIN_MS       50
+
+// Slot sequence numbers: the slot for position pos is free when its
+// sequence is pos and holds pos's record when it is pos + 1; draining sets
+// it to pos + DLOG_RING_LEN, the position that reuses it. Compared with
+// wraparound, so the positions may run past 2^32. Stored relative to the
+// slot index so that the zeroed ring starts out free.
+typedef struct {
+    atomic_uint seq;
+    dlog_record_t rec;
+} dlog_slot_t;
+
+static const char *TAG = "DLOG";
+
+static dlog_slot_t ring[DLOG_RING_LEN];
+static atomic_uint head;            // Next position to claim, so also records queued
+static unsigned tail;               // Next position to drain (dlog task only)
+static atomic_uint dropped;
+static unsigned dropped_reported;
+static unsigned drained;
+static atomic_bool binary;
+
+static inline unsigned slot_seq(const dlog_slot_t *slot, memory_order order) {
+    return atomic_load_explicit(&slot->seq, order) + (unsigned)(slot - ring);
+}
+
+static inline void slot_set_seq(dlog_slot_t *slot, unsigned seq) {
+    atomic_store_explicit(&slot->seq, seq - (unsigned)(slot - ring), memory_order_release);
+}
+
+void dlog_write(dlog_id_t id, const int32_t *args, size_t nargs) {
+    unsigned pos = atomic_load_explicit(&head, memory_order_relaxed);
+    dlog_slot_t *slot;
+    for (;;) {
+        slot = &ring[pos % DLOG_RING_LEN];
+        int diff = (int)(slot_seq(slot, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            // pos was reloaded by the failed exchange
+        } else if (diff < 0) {
+            // Still holds the record from one lap ago: the ring is full
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&head, memory_order_relaxed);
+        }
+    }
+
+    slot->rec.id = (uint16_t)id;
+    slot->rec.nargs = (uint8_t)(nargs < DLOG_MAX_ARGS ? nargs : DLOG_MAX_ARGS);
+    slot->rec.time_ms = esp_log_timestamp();
+    memcpy(slot->rec.args, args, slot->rec.nargs * sizeof(int32_t));
+    slot_set_seq(slot, pos + 1);
+}
+
+// Records obey the log level set for their tag, as ESP_LOGx calls do. The
+// check is made here rather than in dlog_write() to keep producers cheap.
+static bool dlog_enabled(const dlog_record_t *rec) {
+    esp_log_level_t level;
+    switch (dlog_format_level(rec->id)) {
+    case 'E': level = ESP_LOG_ERROR; break;
+    case 'W': level = ESP_LOG_WARN; break;
+    case 'I': level = ESP_LOG_INFO; break;
+    case 'D': level = ESP_LOG_DEBUG; break;
+    default:  level = ESP_LOG_VERBOSE; break;
+    }
+    return level <= esp_log_level_get(dlog_format_tag(rec->id));
+}
+
+static void dlog_emit(FILE *out, const dlog_record_t *rec) {
+    if (!dlog_enabled(rec)) {
+        return;
+    }
+    if (atomic_load_explicit(&binary, memory_order_relaxed)) {
+        static const char hex[] = "0123456789abcdef";
+        uint8_t wire[DLOG_WIRE_MAX];
+        size_t len = dlog_encode(rec, wire);
+        char line[sizeof(DLOG_BINARY_LINE) + 2 * DLOG_WIRE_MAX + 1];
+        char *p = line;
+        memcpy(p, DLOG_BINARY_LINE, sizeof(DLOG_BINARY_LINE) - 1);
+        p += sizeof(DLOG_BINARY_LINE) - 1;
+        for (size_t i = 0; i < len; i++) {
+            *p++ = hex[wire[i] >> 4];
+            *p++ = hex[wire[i] & 0xF];
+        }
+        *p++ = '\n';
+        fwrite(line, 1, p - line, out);
+    } else {
+        char text[DLOG_TEXT_MAX];
+        size_t len = dlog_render(rec, text, sizeof(text));
+        fwrite(text, 1, len, out);
+    }
+}
+
+size_t dlog_drain(FILE *out) {
+    size_t count = 0;
+    for (;;) {
+        dlog_slot_t *slot = &ring[tail % DLOG_RING_LEN];
+        if (slot_seq(slot, memory_order_acquire) != tail + 1) {
+            break;
+        }
+        dlog_record_t rec = slot->rec;
+        slot_set_seq(slot, tail + DLOG_RING_LEN);
+        tail++;
+        dlog_emit(out, &rec);
+        count++;
+    }
+
+    unsigned lost = atomic_load_explicit(&dropped, memory_order_relaxed);
+    if (lost != dropped_reported) {
+        const dlog_record_t rec = {
+            .id = DLOG_DROPPED,
+            .nargs = 1,
+            .time_ms = esp_log_timestamp(),
+            .args = { (int32_t)(lost - dropped_reported) },
+        };
+        dropped_reported = lost;
+        dlog_emit(out, &rec);
+    }
+    if (count > 0) {
+        fflush(out);
+    }
+    drained += count;
+    return count;
+}
+
+static void dlog_task(void *pvParameters) {
+    while (1) {
+        dlog_drain(stdout);
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_MS));
+    }
+}
+
+esp_err_t dlog_init(void) {
+    if (xTaskCreatePinnedToCore(dlog_task, "dlog", DLOG_TASK_STACK, NULL,
+                                DLOG_TASK_PRIORITY, NULL, DLOG_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start the log drain task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void dlog_set_binary(bool enable) {
+    atomic_store(&binary, enable);
+}
+
+void dlog_get_stats(dlog_stats_t *out) {
+    out->written = atomic_load_explicit(&head, memory_order_relaxed);
+    out->dropped = atomic_load_explicit(&dropped, memory_order_relaxed);
+    out->drained = drained;
+}
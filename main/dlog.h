@@ -0,0 +1,54 @@
+#pragma once
+
+// Deferred logging for hot paths.
+//
+// DLOG() stores a format ID, the log timestamp and the integer arguments in
+// a fixed-size slot of a lock-free ring and returns; nothing is formatted
+// and nothing waits for the UART. The ring is a bounded multi-producer
+// queue: a producer claims a position with one compare-and-swap on the head
+// and publishes the slot with a release store of its sequence number, so
+// any task may log without taking a lock. When the ring is full the record
+// is dropped and counted, and the drain reports the count as a DLOG_DROPPED
+// record.
+//
+// The dlog task runs at idle priority and drains the ring to the console.
+// In text mode it renders each record like an ESP_LOGx line. In binary mode
+// it writes "#DL <hex>" lines instead, which host/dlog_decode expands back
+// to text from a captured console log.
+//
+// Formats and their IDs are in dlog_format.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "dlog_format.h"
+
+#define DLOG_RING_LEN       64      // Slots, a power of two
+
+typedef struct {
+    uint32_t written;       // Records queued
+    uint32_t dropped;       // Records lost to a full ring
+    uint32_t drained;       // Records written to the console
+} dlog_stats_t;
+
+// DLOG(DLOG_FAN, duty, percent, temp_deci): up to DLOG_MAX_ARGS integers
+#define DLOG(id, ...) do { \
+        const int32_t dlog_args_[] = { 0, ##__VA_ARGS__ }; \
+        dlog_write((id), dlog_args_ + 1, sizeof(dlog_args_) / sizeof(dlog_args_[0]) - 1); \
+    } while (0)
+
+// Start the drain task. Records logged before this are kept in the ring.
+esp_err_t dlog_init(void);
+
+// Drain as rendered text (the default) or as "#DL" hex lines
+void dlog_set_binary(bool binary);
+
+void dlog_write(dlog_id_t id, const int32_t *args, size_t nargs);
+
+// Write everything queued to out; returns the records written. Called by
+// the dlog task with stdout (the console); single consumer only.
+size_t dlog_drain(FILE *out);
+
+void dlog_get_stats(dlog_stats_t *out);
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+#include "numfmt.h"
+#include "dlog_format.h"
+
+typedef struct {
+    char level;
+    const char *tag;
+    const char *fmt;
+} dlog_format_t;
+
+static const dlog_format_t formats[DLOG_FORMAT_COUNT] = {
+#define DLOG_TABLE_ENTRY(id, lvl, tg, f) [id] = { .level = lvl, .tag = tg, .fmt = f },
+    DLOG_FORMATS(DLOG_TABLE_ENTRY)
+#undef DLOG_TABLE_ENTRY
+};
+
+static void put_le(uint8_t *out, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_le(const uint8_t *in, int bytes) {
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; i++) {
+        v |= (uint32_t)in[i] << (8 * i);
+    }
+    return v;
+}
+
+size_t dlog_encode(const dlog_record_t *rec, uint8_t *out) {
+    put_le(out, rec->id, 2);
+    out[2] = rec->nargs;
+    put_le(out + 3, rec->time_ms, 4);
+    for (int i = 0; i < rec->nargs; i++) {
+        put_le(out + 7 + 4 * i, (uint32_t)rec->args[i], 4);
+    }
+    return 7 + 4 * (size_t)rec->nargs;
+}
+
+bool dlog_decode(const uint8_t *in, size_t len, dlog_record_t *rec) {
+    if (len < 7) {
+        return false;
+    }
+    rec->id = (uint16_t)get_le(in, 2);
+    rec->nargs = in[2];
+    rec->time_ms = get_le(in + 3, 4);
+    if (rec->id >= DLOG_FORMAT_COUNT || rec->nargs > DLOG_MAX_ARGS || len != 7 + 4 * (size_t)rec->nargs) {
+        return false;
+    }
+    for (int i = 0; i < rec->nargs; i++) {
+        rec->args[i] = (int32_t)get_le(in + 7 + 4 * i, 4);
+    }
+    return true;
+}
+
+static const dlog_format_t *format_of(uint16_t id) {
+    return &formats[id < DLOG_FORMAT_COUNT ? id : DLOG_DROPPED];
+}
+
+char dlog_format_level(uint16_t id) {
+    return format_of(id)->level;
+}
+
+const char *dlog_format_tag(uint16_t id) {
+    return format_of(id)->tag;
+}
+
+size_t dlog_render(const dlog_record_t *rec, char *out, size_t size) {
+    // Worst-case expansion of one conversion is 11 characters ("-2147483648")
+    char buf[DLOG_TEXT_MAX + 16];
+    const dlog_format_t *f = format_of(rec->id);
+    char *p = buf;
+    char *end = buf + DLOG_TEXT_MAX - 1;
+    *p++ = f->level;
+    p = PUT_LIT(p, " (");
+    p = put_u32(p, rec->time_ms);
+    p = PUT_LIT(p, ") ");
+    p = put_bytes(p, f->tag, strlen(f->tag));
+    p = PUT_LIT(p, ": ");
+
+    int arg = 0;
+    for (const char *s = f->fmt; *s != '\0' && p < end; s++) {
+        if (*s != '%') {
+            *p++ = *s;
+            continue;
+        }
+        char conv = *++s;
+        if (conv == '%') {
+            *p++ = '%';
+            continue;
+        }
+        if (conv == '\0') {
+            break;
+        }
+        int32_t v = arg < rec->nargs ? rec->args[arg] : 0;
+        arg++;
+        switch (conv) {
+        case 'd':
+            p = put_i32(p, v);
+            break;
+        case 'u':
+            p = put_u32(p, (uint32_t)v);
+            break;
+        case 'x':
+            p += snprintf(p, 9, "%x", (unsigned)v);
+            break;
+        case 'D':
+            p = put_deci(p, v);
+            break;
+        case 'Y':
+            p = v ? PUT_LIT(p, "YES") : PUT_LIT(p, "NO");
+            break;
+        default:
+            *p++ = '?';
+            break;
+        }
+    }
+    if (p > end) {
+        p = end;
+    }
+    *p++ = '\n';
+
+    size_t len = p - buf;
+    if (len >= size) {
+        len = size - 1;
+    }
+    memcpy(out, buf, len);
+    out[len] = '\0';
+    return len;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Deferred log records: the format table and the record codec, shared by
+// the firmware (dlog.c) and the host decoder (host/dlog_decode.c).
+//
+// Every deferred message is an entry in DLOG_FORMATS: an ID, an ESP-IDF log
+// level letter, a tag and a format string. Arguments are int32 and formats
+// take %d, %u, %x, %D (deci-units as "-12.3"), %Y ("YES"/"NO") and %%.
+// Records identify their format by position in the table, so the decoder
+// must be built from the same table as the firmware that logged them: add
+// new entries at the end and never reorder.
+//
+// Wire format, little-endian: id (2), argument count (1), timestamp in ms
+// since boot (4), then 4 bytes per argument.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DLOG_MAX_ARGS       4
+#define DLOG_WIRE_MAX       (7 + 4 * DLOG_MAX_ARGS)
+#define DLOG_TEXT_MAX       160     // Longest rendered line, newline included
+#define DLOG_BINARY_LINE    "#DL "  // Console prefix of a hex-encoded record
+
+#define DLOG_TAG_APP        "ESP32_DASHBOARD"
+
+#define DLOG_FORMATS(X) \
+    X(DLOG_DROPPED,  'W', "DLOG",       "%u log records dropped") \
+    X(DLOG_SAMPLE,   'I', DLOG_TAG_APP, "Temp: %D°C, Humid: %D%%, Light: %D%%, Motion: %Y") \
+    X(DLOG_FAN,      'I', DLOG_TAG_APP, "Fan speed set to %u/255 (%u%%) for temp %D°C") \
+    X(DLOG_LED_ON,   'I', DLOG_TAG_APP, "LED ON - Low light for %u+ seconds") \
+    X(DLOG_LED_OFF,  'I', DLOG_TAG_APP, "LED OFF - Light level above %D%%") \
+    X(DLOG_BUZZ_ON,  'I', DLOG_TAG_APP, "Buzzer ON - No motion for %d seconds, session reset") \
+    X(DLOG_BUZZ_OFF, 'I', DLOG_TAG_APP, "Buzzer OFF - Motion detected, session restarted")
+
+typedef enum {
+#define DLOG_ENUM_ENTRY(id, level, tag, fmt) id,
+    DLOG_FORMATS(DLOG_ENUM_ENTRY)
+#undef DLOG_ENUM_ENTRY
+    DLOG_FORMAT_COUNT,
+} dlog_id_t;
+
+typedef struct {
+    uint16_t id;
+    uint8_t nargs;
+    uint32_t time_ms;
+    int32_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+// Serialize a record; returns the bytes written (at most DLOG_WIRE_MAX)
+size_t dlog_encode(const dlog_record_t *rec, uint8_t *out);
+
+// Parse one record; false if len is wrong for it or the ID is unknown
+bool dlog_decode(const uint8_t *in, size_t len, dlog_record_t *rec);
+
+// Level letter ('E', 'W', 'I', ...) and tag of a format
+char dlog_format_level(uint16_t id);
+const char *dlog_format_tag(uint16_t id);
+
+// Expand a record into "I (1234) TAG: text\n" like an ESP_LOGx line.
+// Returns the length, truncated to size - 1.
+size_t dlog_render(const dlog_record_t *rec, char *out, size_t size);
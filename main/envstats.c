@@ -0,0 +1,163 @@
+#include <string.h>
+#include "envstats.h"
+#include "numfmt.h"
+
+#define Q12             4096
+#define Z_DECI_MAX      99999
+
+void envstats_init(envstats_t *st, const envstats_config_t *config, envstats_slot_t *slots) {
+    memset(st, 0, sizeof(*st));
+    st->config = *config;
+    st->min_q = (envstats_deque_t){ .slots = slots, .cap = config->window };
+    st->max_q = (envstats_deque_t){ .slots = slots + config->window, .cap = config->window };
+}
+
+static uint32_t isqrt64(uint64_t v) {
+    if (v == 0) {
+        return 0;
+    }
+    uint64_t root = 0;
+    uint64_t bit = 1ull << ((63 - __builtin_clzll(v)) & ~1);  // Highest power of 4 <= v
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static int32_t round_q12(int64_t v) {
+    return (int32_t)(v >= 0 ? (v + Q12 / 2) / Q12 : (v - Q12 / 2) / Q12);
+}
+
+static uint16_t deque_index(const envstats_deque_t *q, uint32_t n) {
+    uint32_t i = q->head + n;
+    return (uint16_t)(i >= q->cap ? i - q->cap : i);
+}
+
+// Slide the window on by one sample. keep_lower: the deque tracks the min.
+static void deque_push(envstats_deque_t *q, int16_t value, uint16_t seq, uint16_t window, bool keep_lower) {
+    // Samples arrive one at a time, so at most the front can have left
+    if (q->len > 0 && (uint16_t)(seq - q->slots[q->head].seq) >= window) {
+        q->head = deque_index(q, 1);
+        q->len--;
+    }
+    // Samples the new one beats can never be the extreme again
+    while (q->len > 0) {
+        int16_t back = q->slots[deque_index(q, q->len - 1)].value;
+        if (keep_lower ? back < value : back > value) {
+            break;
+        }
+        q->len--;
+    }
+    q->slots[deque_index(q, q->len)] = (envstats_slot_t){ .value = value, .seq = seq };
+    q->len++;
+}
+
+uint8_t envstats_add(envstats_t *st, int16_t value) {
+    const envstats_config_t *cfg = &st->config;
+    uint8_t flags = 0;
+
+    if (st->count == 0) {
+        st->mean_q12 = value * Q12;
+    } else {
+        // Score against the statistics from before this sample. The test
+        // squares both sides, so no square root is taken per sample; z
+        // itself is only worked out when it is reported.
+        int32_t diff_q12 = value * Q12 - st->mean_q12;
+        int64_t floor_q12 = (int64_t)cfg->std_floor_deci * Q12;
+        st->diff_q12 = diff_q12;
+        st->score_var_q24 = st->var_q24 > floor_q12 * floor_q12 ? st->var_q24 : floor_q12 * floor_q12;
+
+        // 100 * diff^2 >= z_limit_deci^2 * var, both sides taken down to
+        // Q12 so they fit 64 bits. The left side stays below 2^51; a right
+        // side that overflows is a limit no sample can reach.
+        uint64_t diff2_q12 = (uint64_t)((int64_t)diff_q12 * diff_q12) >> 12;
+        uint64_t limit2_q12;
+        bool reachable = !__builtin_mul_overflow((uint64_t)st->score_var_q24 >> 12,
+                                                 (uint64_t)cfg->z_limit_deci * cfg->z_limit_deci, &limit2_q12);
+        bool settled = st->count >= (1u << cfg->ewma_shift);
+        if (settled && reachable && diff2_q12 * 100 >= limit2_q12) {
+            flags |= ENVSTATS_SPIKE;
+        }
+
+        // Weighted Welford: mean += a*diff, var = (1-a)*(var + diff*a*diff)
+        int32_t incr_q12 = diff_q12 / (1 << cfg->ewma_shift);
+        st->mean_q12 += incr_q12;
+        int64_t var = st->var_q24 + (int64_t)diff_q12 * incr_q12;
+        st->var_q24 = var - (var >> cfg->ewma_shift);
+    }
+
+    int16_t *lagged = &st->lag[st->count % ENVSTATS_ROC_LAG];
+    if (st->count >= ENVSTATS_ROC_LAG) {
+        st->roc = value - *lagged;
+        if (st->roc > cfg->roc_limit_deci) {
+            flags |= ENVSTATS_RISING;
+        } else if (-st->roc > cfg->roc_limit_deci) {
+            flags |= ENVSTATS_FALLING;
+        }
+    }
+    *lagged = value;
+
+    uint16_t seq = (uint16_t)st->count;
+    deque_push(&st->min_q, value, seq, cfg->window, true);
+    deque_push(&st->max_q, value, seq, cfg->window, false);
+
+    if (flags != 0 && st->flags == 0) {
+        st->anomalies++;
+    }
+    st->flags = flags;
+    st->count++;
+    return flags;
+}
+
+int16_t envstats_mean(const envstats_t *st) {
+    return (int16_t)round_q12(st->mean_q12);
+}
+
+uint32_t envstats_std(const envstats_t *st) {
+    return (uint32_t)round_q12(isqrt64((uint64_t)st->var_q24));
+}
+
+int32_t envstats_z(const envstats_t *st) {
+    uint32_t std_q12 = isqrt64((uint64_t)st->score_var_q24);
+    if (std_q12 == 0) {
+        return 0;
+    }
+    int64_t z = (int64_t)st->diff_q12 * 10 / std_q12;
+    return (int32_t)(z > Z_DECI_MAX ? Z_DECI_MAX : z < -Z_DECI_MAX ? -Z_DECI_MAX : z);
+}
+
+int16_t envstats_min(const envstats_t *st) {
+    return st->min_q.slots[st->min_q.head].value;
+}
+
+int16_t envstats_max(const envstats_t *st) {
+    return st->max_q.slots[st->max_q.head].value;
+}
+
+char *envstats_put_json(char *p, const envstats_t *st) {
+    if (st->count == 0) {
+        return PUT_LIT(p, "{\"mean\":null,\"std\":null,\"min\":null,\"max\":null,\"z\":null,\"roc\":null,\"flags\":0}");
+    }
+    p = PUT_LIT(p, "{\"mean\":");
+    p = put_deci(p, envstats_mean(st));
+    p = PUT_LIT(p, ",\"std\":");
+    p = put_deci(p, (int32_t)envstats_std(st));
+    p = PUT_LIT(p, ",\"min\":");
+    p = put_deci(p, envstats_min(st));
+    p = PUT_LIT(p, ",\"max\":");
+    p = put_deci(p, envstats_max(st));
+    p = PUT_LIT(p, ",\"z\":");
+    p = put_deci(p, envstats_z(st));
+    p = PUT_LIT(p, ",\"roc\":");
+    p = put_deci(p, st->roc);
+    p = PUT_LIT(p, ",\"flags\":");
+    p = put_u32(p, st->flags);
+    *p++ = '}';
+    return p;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// Streaming statistics and anomaly flags for one environmental channel.
+//
+// Fed one deci-unit sample per second, each channel keeps:
+//   mean, std   exponentially weighted, with weight 1/2^ewma_shift for the
+//               newest sample. The variance uses Welford's update in its
+//               weighted form (mean and spread from the same difference),
+//               so it needs no running sums and cannot drift.
+//   min, max    over the last window samples, from monotonic deques: each
+//               sample is pushed once and popped at most once, so a sample
+//               costs O(1) amortized whatever the window
+//   z           the newest sample's distance from the mean, in std
+//   roc         change over the last ENVSTATS_ROC_LAG samples
+// and raises flags on the sample that is scored:
+//   ENVSTATS_SPIKE    |z| at or beyond z_limit, scored against the
+//                     statistics from before the sample so a spike cannot
+//                     mask itself
+//   ENVSTATS_RISING   roc beyond +roc_limit...
+//   ENVSTATS_FALLING  ...or -roc_limit
+// Nothing is flagged until the mean has settled (2^ewma_shift samples) and
+// the rate has a full lag behind it. std_floor keeps a channel that sits
+// on one reading from calling every quantization step a spike.
+//
+// Fixed-point, pure computation on caller state; the deques live in
+// caller-provided storage of ENVSTATS_SLOTS(window) slots. Runs unchanged
+// on the host (bench_envstats).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ENVSTATS_ROC_LAG        60
+#define ENVSTATS_WINDOW_MAX     65535
+#define ENVSTATS_SLOTS(window)  (2 * (window))
+
+// Longest envstats_put_json() output
+#define ENVSTATS_JSON_MAX       112
+
+#define ENVSTATS_SPIKE          0x01
+#define ENVSTATS_RISING         0x02
+#define ENVSTATS_FALLING        0x04
+
+typedef struct {
+    uint16_t window;            // Samples the rolling min/max covers (1-ENVSTATS_WINDOW_MAX)
+    uint8_t ewma_shift;         // Weight of the newest sample is 1/2^shift (0-12)
+    uint16_t z_limit_deci;      // |z| x10 that makes a spike
+    uint16_t std_floor_deci;    // Smallest std a z-score is taken against
+    uint16_t roc_limit_deci;    // Change over ENVSTATS_ROC_LAG samples that is flagged
+} envstats_config_t;
+
+typedef struct {
+    int16_t value;
+    uint16_t seq;               // Sample number, wrapping
+} envstats_slot_t;
+
+// Ring of slots with values monotonic from front to back
+typedef struct {
+    envstats_slot_t *slots;
+    uint16_t cap;
+    uint16_t head;
+    uint16_t len;
+} envstats_deque_t;
+
+typedef struct {
+    envstats_config_t config;
+    uint32_t count;             // Samples added
+    int32_t mean_q12;           // Deci-units x4096
+    int64_t var_q24;            // Deci-units^2 x4096^2
+    int32_t diff_q12;           // Newest sample less the mean before it...
+    int64_t score_var_q24;      // ...and the (floored) variance it was scored against
+    int32_t roc;
+    envstats_deque_t min_q;     // Increasing: front is the window's min
+    envstats_deque_t max_q;     // Decreasing: front is the window's max
+    int16_t lag[ENVSTATS_ROC_LAG];
+    uint8_t flags;              // Of the newest sample
+    uint32_t anomalies;         // Samples flagged after an unflagged one
+} envstats_t;
+
+// slots must hold ENVSTATS_SLOTS(config->window) entries
+void envstats_init(envstats_t *st, const envstats_config_t *config, envstats_slot_t *slots);
+
+// Add the next sample; returns its ENVSTATS_* flags
+uint8_t envstats_add(envstats_t *st, int16_t value);
+
+// Deci-units; min and max are of the last window samples and need count > 0
+int16_t envstats_mean(const envstats_t *st);
+uint32_t envstats_std(const envstats_t *st);
+
+// z-score x10 of the newest sample, clamped to +-9999.9
+int32_t envstats_z(const envstats_t *st);
+int16_t envstats_min(const envstats_t *st);
+int16_t envstats_max(const envstats_t *st);
+
+// {"mean":...,"std":...,"min":...,"max":...,"z":...,"roc":...,"flags":n},
+// with nulls until the first sample
+char *envstats_put_json(char *p, const envstats_t *st);
@@ -0,0 +1,114 @@
+#include <string.h>
+#include "fan.h"
+
+#define DUTY_MAX_Q8     (255 << 8)
+
+const fan_config_t fan_config_default = {
+    .curve = {
+        { 200, 76 },    // 20 °C: 30 %, off below
+        { 250, 153 },   // 25 °C: 60 %
+        { 300, 217 },   // 30 °C: 85 %
+        { 350, 255 },   // 35 °C and up: 100 %
+    },
+    .curve_len = 4,
+    .hysteresis_deci = 5,
+    .slew_per_s = 32,
+    .pi = false,
+    .target_deci = 260,
+    .kp = 80,
+    .ki = 10,
+};
+
+bool fan_config_valid(const fan_config_t *config) {
+    if (config->curve_len == 0 || config->curve_len > FAN_CURVE_MAX) {
+        return false;
+    }
+    for (int i = 1; i < config->curve_len; i++) {
+        if (config->curve[i].temp_deci <= config->curve[i - 1].temp_deci) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void fan_ctrl_init(fan_ctrl_t *ctrl, const fan_config_t *config) {
+    memset(ctrl, 0, sizeof(*ctrl));
+    ctrl->config = fan_config_valid(config) ? *config : fan_config_default;
+}
+
+esp_err_t fan_ctrl_configure(fan_ctrl_t *ctrl, const fan_config_t *config) {
+    if (!fan_config_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ctrl->config = *config;
+    ctrl->integral_q8 = ctrl->duty_q8;  // Bumpless switch into PI
+    return ESP_OK;
+}
+
+uint8_t fan_curve_duty(const fan_config_t *config, int16_t temp_deci) {
+    const fan_point_t *c = config->curve;
+    int n = config->curve_len;
+    if (temp_deci < c[0].temp_deci) {
+        return 0;
+    }
+    for (int i = 1; i < n; i++) {
+        if (temp_deci < c[i].temp_deci) {
+            int32_t span = c[i].temp_deci - c[i - 1].temp_deci;
+            int32_t rise = (int32_t)c[i].duty - c[i - 1].duty;
+            return (uint8_t)(c[i - 1].duty + (rise * (temp_deci - c[i - 1].temp_deci) + span / 2) / span);
+        }
+    }
+    return c[n - 1].duty;
+}
+
+static int32_t clamp_q8(int32_t v) {
+    return v < 0 ? 0 : v > DUTY_MAX_Q8 ? DUTY_MAX_Q8 : v;
+}
+
+uint8_t fan_ctrl_update(fan_ctrl_t *ctrl, int16_t temp_deci, int64_t now_us) {
+    const fan_config_t *cfg = &ctrl->config;
+    int32_t dt_ms = 0;
+    if (!ctrl->started) {
+        ctrl->started = true;
+        ctrl->follow_deci = temp_deci;
+    } else {
+        int64_t dt = (now_us - ctrl->last_us) / 1000;
+        dt_ms = dt < 0 ? 0 : dt > 60000 ? 60000 : (int32_t)dt;
+    }
+    ctrl->last_us = now_us;
+
+    // Backlash: move only when the reading leaves the band around follow
+    int16_t below = cfg->hysteresis_deci / 2;
+    int16_t above = cfg->hysteresis_deci - below;
+    if (temp_deci > ctrl->follow_deci + above) {
+        ctrl->follow_deci = temp_deci - above;
+    } else if (temp_deci < ctrl->follow_deci - below) {
+        ctrl->follow_deci = temp_deci + below;
+    }
+
+    int32_t want_q8;
+    if (cfg->pi) {
+        // Positive error (too warm) means more fan
+        int32_t err = ctrl->follow_deci - cfg->target_deci;
+        if (err > cfg->hysteresis_deci || err < -(int32_t)cfg->hysteresis_deci) {
+            // ki is per °C per minute: err/10 * ki * dt/60000, in Q8
+            int64_t step = (int64_t)err * cfg->ki * dt_ms * 256 / (10 * 60000);
+            ctrl->integral_q8 = clamp_q8(ctrl->integral_q8 + (int32_t)step);
+        }
+        want_q8 = clamp_q8(err * cfg->kp * 256 / 10 + ctrl->integral_q8);
+    } else {
+        want_q8 = fan_curve_duty(cfg, ctrl->follow_deci) << 8;
+    }
+
+    int32_t delta = want_q8 - ctrl->duty_q8;
+    if (cfg->slew_per_s > 0) {
+        int32_t max_step = (int32_t)((int64_t)cfg->slew_per_s * dt_ms * 256 / 1000);
+        if (delta > max_step) {
+            delta = max_step;
+        } else if (delta < -max_step) {
+            delta = -max_step;
+        }
+    }
+    ctrl->duty_q8 += delta;
+    return (uint8_t)((ctrl->duty_q8 + 128) >> 8);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Fan controller.
+//
+// Temperature is mapped to PWM duty (0-255) either through a lookup table
+// (linear between points, off below the first, the last duty above the last)
+// or by PI control toward a target temperature. Two things stop the fan
+// hunting on sensor noise around a breakpoint:
+//   hysteresis  the controller acts on a temperature that only moves when a
+//               reading leaves a band hysteresis_deci wide around it, so
+//               noise inside the band never moves the output. In PI mode
+//               errors inside the band also stop the integrator.
+//   slew        the duty moves by at most slew_per_s counts per second
+//
+// fan_ctrl_update() returns the duty to apply. Callers touch the peripheral
+// only when it differs from the previous value. Pure computation on caller
+// state, so it runs unchanged on the host (bench_fan).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define FAN_CURVE_MAX       8
+
+typedef struct {
+    int16_t temp_deci;
+    uint8_t duty;
+} fan_point_t;
+
+typedef struct {
+    fan_point_t curve[FAN_CURVE_MAX];   // Strictly increasing temperatures
+    uint8_t curve_len;
+    uint16_t hysteresis_deci;
+    uint16_t slew_per_s;                // 0 = unlimited
+    bool pi;                            // PI toward target_deci instead of the curve
+    int16_t target_deci;
+    uint16_t kp;                        // Duty per °C of error
+    uint16_t ki;                        // Duty per °C of error per minute
+} fan_config_t;
+
+typedef struct {
+    fan_config_t config;
+    bool started;
+    int16_t follow_deci;                // Curve input after the hysteresis
+    int64_t last_us;
+    int32_t duty_q8;                    // Slewed duty, x256
+    int32_t integral_q8;                // PI integral term in duty, x256
+} fan_ctrl_t;
+
+// Compile-time default: the original 20/25/30/35 °C curve, 0.5 °C of
+// hysteresis and a full-range swing in about 8 s
+extern const fan_config_t fan_config_default;
+
+// A curve of 1 to FAN_CURVE_MAX points with strictly increasing temperatures
+bool fan_config_valid(const fan_config_t *config);
+
+void fan_ctrl_init(fan_ctrl_t *ctrl, const fan_config_t *config);
+
+// Replace the configuration at runtime; the current duty is kept and slews
+// to the new curve. ESP_ERR_INVALID_ARG for an empty, oversized or
+// unsorted curve (the old configuration stays).
+esp_err_t fan_ctrl_configure(fan_ctrl_t *ctrl, const fan_config_t *config);
+
+// Duty for the latest temperature at now_us
+uint8_t fan_ctrl_update(fan_ctrl_t *ctrl, int16_t temp_deci, int64_t now_us);
+
+// Curve lookup without hysteresis or slew
+uint8_t fan_curve_duty(const fan_config_t *config, int16_t temp_deci);
@@ -0,0 +1,380 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "flashlog.h"
+
+#define LOG_PARTITION_LABEL     "history"
+#define LOG_RECORD_MAGIC        0x474F4C44u     // "DLOG"
+#define LOG_MOTION_FLAG         0x0001
+#define LOG_QUEUE_DEPTH         2
+
+static const char *TAG = "FLASHLOG";
+
+typedef struct {
+    int16_t values[HISTORY_CHANNELS];
+    uint16_t flags;
+} log_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t first_seq;
+    uint16_t count;
+    uint16_t boot;
+    uint32_t crc;           // Over the header fields above and count entries
+    log_entry_t entries[FLASHLOG_RECORD_SAMPLES];
+} log_record_t;
+
+_Static_assert(sizeof(log_record_t) == FLASHLOG_RECORD_SIZE, "record must fill its slot exactly");
+
+static const esp_partition_t *log_part;
+static uint32_t sector_count;
+static uint32_t records_per_sector;
+
+// Sector index, guarded by index_lock: first sample seq held in each sector
+// (0 = empty or about to be erased), the sector being filled and the next
+// free record slot in it. Flash I/O itself happens outside the lock.
+static SemaphoreHandle_t index_lock;
+static uint32_t *sector_first;
+static uint32_t head_sector;
+static uint32_t write_slot;
+static uint32_t first_seq_stored;
+static uint32_t last_seq_stored;
+static flashlog_stats_t stats;
+
+static QueueHandle_t write_queue;
+static bool inline_writes;
+
+// RAM batch, only touched by sensor_task
+static log_record_t pending;
+static uint32_t next_seq;
+static uint16_t boot_id;
+
+static uint32_t record_crc(const log_record_t *rec) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)rec, offsetof(log_record_t, crc));
+    return esp_rom_crc32_le(crc, (const uint8_t *)rec->entries, rec->count * sizeof(log_entry_t));
+}
+
+static bool record_valid(const log_record_t *rec) {
+    return rec->magic == LOG_RECORD_MAGIC && rec->count > 0 &&
+           rec->count <= FLASHLOG_RECORD_SAMPLES && rec->crc == record_crc(rec);
+}
+
+static bool record_erased(const log_record_t *rec) {
+    const uint32_t *words = (const uint32_t *)rec;
+    for (size_t i = 0; i < sizeof(*rec) / sizeof(uint32_t); i++) {
+        if (words[i] != 0xFFFFFFFFu) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t record_offset(uint32_t sector, uint32_t slot) {
+    return (size_t)sector * log_part->erase_size + (size_t)slot * FLASHLOG_RECORD_SIZE;
+}
+
+// Rebuild the sector index from flash and find where the log ends
+static esp_err_t log_mount(void) {
+    log_record_t rec;
+    uint32_t newest_end = 0;
+    uint16_t newest_boot = 0;
+    uint32_t newest_used = 0;
+    uint32_t corrupt = 0;
+    bool found = false;
+
+    for (uint32_t s = 0; s < sector_count; s++) {
+        uint32_t used = 0;
+        sector_first[s] = 0;
+        for (uint32_t slot = 0; slot < records_per_sector; slot++) {
+            esp_err_t err = esp_partition_read(log_part, record_offset(s, slot), &rec, sizeof(rec));
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (record_erased(&rec)) {
+                continue;
+            }
+            used = slot + 1;
+            if (!record_valid(&rec)) {
+                corrupt++;
+                continue;
+            }
+            if (sector_first[s] == 0) {
+                sector_first[s] = rec.first_seq;
+            }
+            uint32_t end = rec.first_seq + rec.count;
+            if (!found || end > newest_end) {
+                found = true;
+                newest_end = end;
+                newest_boot = rec.boot;
+                head_sector = s;
+            }
+        }
+        if (found && head_sector == s) {
+            newest_used = used;
+        }
+    }
+
+    if (found) {
+        write_slot = newest_used;
+        next_seq = newest_end;
+        boot_id = newest_boot + 1;
+        last_seq_stored = newest_end - 1;
+    } else {
+        // Empty log: the first append erases sector 0 and starts there
+        head_sector = sector_count - 1;
+        write_slot = records_per_sector;
+        next_seq = 1;
+        boot_id = 1;
+        last_seq_stored = 0;
+    }
+    first_seq_stored = last_seq_stored + 1;
+    for (uint32_t i = 1; i <= sector_count; i++) {
+        uint32_t first = sector_first[(head_sector + i) % sector_count];
+        if (first != 0) {
+            first_seq_stored = first;
+            break;
+        }
+    }
+    stats.crc_errors = corrupt;
+    return ESP_OK;
+}
+
+// Writer side: erase ahead when the head sector is full, then program one
+// record. Only one task appends, so the index lock covers bookkeeping only.
+static esp_err_t log_append(log_record_t *rec) {
+    rec->magic = LOG_RECORD_MAGIC;
+    rec->crc = record_crc(rec);
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    bool new_sector = write_slot >= records_per_sector;
+    if (new_sector) {
+        head_sector = (head_sector + 1) % sector_count;
+        write_slot = 0;
+        // Readers skip the sector from here on, so it can be erased unlocked
+        sector_first[head_sector] = 0;
+    }
+    uint32_t sector = head_sector;
+    uint32_t slot = write_slot++;
+    xSemaphoreGive(index_lock);
+
+    esp_err_t err = ESP_OK;
+    if (new_sector) {
+        err = esp_partition_erase_range(log_part, (size_t)sector * log_part->erase_size, log_part->erase_size);
+    }
+    if (err == ESP_OK) {
+        err = esp_partition_write(log_part, record_offset(sector, slot), rec, sizeof(*rec));
+    }
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    if (new_sector) {
+        stats.sectors_erased++;
+        // The erased sector held the oldest data; the log now starts at the
+        // next non-empty sector
+        first_seq_stored = rec->first_seq;
+        for (uint32_t i = 1; i < sector_count; i++) {
+            uint32_t first = sector_first[(sector + i) % sector_count];
+            if (first != 0) {
+                first_seq_stored = first;
+                break;
+            }
+        }
+    }
+    if (err == ESP_OK) {
+        if (sector_first[sector] == 0) {
+            sector_first[sector] = rec->first_seq;
+        }
+        last_seq_stored = rec->first_seq + rec->count - 1;
+        stats.records_written++;
+    } else {
+        stats.records_dropped++;
+    }
+    xSemaphoreGive(index_lock);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write to sector %u failed: %s", (unsigned)sector, esp_err_to_name(err));
+    }
+    return err;
+}
+
+static void flashlog_writer_task(void *pvParameters) {
+    static log_record_t rec;
+    while (1) {
+        if (xQueueReceive(write_queue, &rec, portMAX_DELAY) == pdTRUE) {
+            log_append(&rec);
+        }
+    }
+}
+
+esp_err_t flashlog_init(bool writer_task) {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, LOG_PARTITION_LABEL);
+    if (part == NULL) {
+        ESP_LOGW(TAG, "No \"%s\" partition, flash log disabled", LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (part->erase_size % FLASHLOG_RECORD_SIZE != 0 || part->size < 2 * part->erase_size) {
+        ESP_LOGE(TAG, "Partition \"%s\" is too small", LOG_PARTITION_LABEL);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (index_lock == NULL) {
+        index_lock = xSemaphoreCreateMutex();
+    }
+
+    sector_count = part->size / part->erase_size;
+    records_per_sector = part->erase_size / FLASHLOG_RECORD_SIZE;
+    free(sector_first);
+    sector_first = calloc(sector_count, sizeof(uint32_t));
+    if (index_lock == NULL || sector_first == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    log_part = part;
+    memset(&stats, 0, sizeof(stats));
+    esp_err_t err = log_mount();
+    if (err != ESP_OK) {
+        log_part = NULL;
+        return err;
+    }
+    memset(&pending, 0xFF, sizeof(pending));
+    pending.count = 0;
+
+    inline_writes = !writer_task;
+    if (writer_task && write_queue == NULL) {
+        write_queue = xQueueCreate(LOG_QUEUE_DEPTH, sizeof(log_record_t));
+        if (write_queue == NULL ||
+            xTaskCreate(flashlog_writer_task, "flashlog", 3072, NULL, 2, NULL) != pdPASS) {
+            log_part = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    ESP_LOGI(TAG, "Mounted %u KiB log: samples %u..%u, boot %u, %u corrupt records",
+             (unsigned)(part->size / 1024), (unsigned)first_seq_stored, (unsigned)last_seq_stored,
+             (unsigned)boot_id, (unsigned)stats.crc_errors);
+    return ESP_OK;
+}
+
+void flashlog_add(const int16_t values[HISTORY_CHANNELS], bool motion) {
+    if (log_part == NULL) {
+        return;
+    }
+    if (pending.count == 0) {
+        pending.first_seq = next_seq;
+        pending.boot = boot_id;
+    }
+    log_entry_t *entry = &pending.entries[pending.count++];
+    memcpy(entry->values, values, sizeof(entry->values));
+    entry->flags = motion ? LOG_MOTION_FLAG : 0;
+    next_seq++;
+
+    if (pending.count < FLASHLOG_RECORD_SAMPLES) {
+        return;
+    }
+    if (inline_writes) {
+        log_append(&pending);
+    } else if (xQueueSend(write_queue, &pending, 0) != pdTRUE) {
+        // Writer is behind (or flash is stuck); never make the caller wait
+        xSemaphoreTake(index_lock, portMAX_DELAY);
+        stats.records_dropped++;
+        xSemaphoreGive(index_lock);
+    }
+    // Unused entries stay 0xFF so a partly filled record programs no extra bits
+    memset(&pending, 0xFF, sizeof(pending));
+    pending.count = 0;
+}
+
+esp_err_t flashlog_range(uint32_t *first, uint32_t *last) {
+    if (log_part == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    *first = first_seq_stored;
+    *last = last_seq_stored;
+    xSemaphoreGive(index_lock);
+    return ESP_OK;
+}
+
+esp_err_t flashlog_read(uint32_t from, uint32_t to, flashlog_visit_t visit, void *ctx) {
+    if (log_part == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Start at the newest sector whose first sample is <= from, or at the
+    // oldest sector when from predates the log. Positions count from the
+    // oldest sector (the one after the head).
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    uint32_t head = head_sector;
+    uint32_t start = sector_count;
+    for (uint32_t pos = 0; pos < sector_count; pos++) {
+        uint32_t first = sector_first[(head + 1 + pos) % sector_count];
+        if (first == 0) {
+            continue;
+        }
+        if (start == sector_count || first <= from) {
+            start = pos;
+        }
+        if (first > from) {
+            break;
+        }
+    }
+    xSemaphoreGive(index_lock);
+
+    log_record_t rec;
+    flashlog_sample_t sample;
+    for (uint32_t pos = start; pos < sector_count; pos++) {
+        uint32_t sector = (head + 1 + pos) % sector_count;
+        xSemaphoreTake(index_lock, portMAX_DELAY);
+        uint32_t first = sector_first[sector];
+        xSemaphoreGive(index_lock);
+        if (first == 0) {
+            continue;
+        }
+        if (first > to) {
+            break;
+        }
+        for (uint32_t slot = 0; slot < records_per_sector; slot++) {
+            esp_err_t err = esp_partition_read(log_part, record_offset(sector, slot), &rec, sizeof(rec));
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (rec.magic == 0xFFFFFFFFu) {
+                break;      // Rest of the sector is unwritten
+            }
+            if (!record_valid(&rec) || rec.first_seq + rec.count - 1 < from) {
+                continue;
+            }
+            for (uint32_t i = 0; i < rec.count; i++) {
+                sample.seq = rec.first_seq + i;
+                if (sample.seq < from) {
+                    continue;
+                }
+                if (sample.seq > to) {
+                    return ESP_OK;
+                }
+                sample.boot = rec.boot;
+                sample.motion = rec.entries[i].flags & LOG_MOTION_FLAG;
+                memcpy(sample.values, rec.entries[i].values, sizeof(sample.values));
+                if (!visit(&sample, ctx)) {
+                    return ESP_OK;
+                }
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+void flashlog_get_stats(flashlog_stats_t *out) {
+    if (index_lock == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(index_lock);
+}
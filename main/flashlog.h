@@ -0,0 +1,59 @@
+#pragma once
+
+// Append-only sample log in the "history" flash partition.
+//
+// Samples are batched in RAM into 512-byte records (header + up to
+// FLASHLOG_RECORD_SAMPLES samples, CRC32-protected) and appended to the
+// partition as a circular log: sectors are filled in order and the oldest
+// sector is erased only when the head wraps onto it, so every sector sees
+// the same number of erase cycles. A record that was torn by a reset fails
+// its CRC and is skipped.
+//
+// Sample sequence numbers continue across reboots; each record also carries
+// a boot counter so readers can tell where the device restarted.
+//
+// sensor_task calls flashlog_add() once per sample. It only copies into the
+// RAM batch; full batches are handed to a low-priority writer task through
+// a queue, so flash erases and writes never stall the sampling loop. A reset
+// loses at most the unflushed batch (about a minute of samples).
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "history.h"
+
+#define FLASHLOG_RECORD_SIZE        512
+#define FLASHLOG_RECORD_SAMPLES     62
+
+typedef struct {
+    uint32_t seq;
+    uint16_t boot;
+    bool motion;
+    int16_t values[HISTORY_CHANNELS];   // Deci-units, in history_channel_t order
+} flashlog_sample_t;
+
+typedef struct {
+    uint32_t records_written;
+    uint32_t records_dropped;   // Writer queue full or flash error
+    uint32_t sectors_erased;
+    uint32_t crc_errors;        // Torn or corrupt records skipped by readers
+} flashlog_stats_t;
+
+// Return false to stop the scan early
+typedef bool (*flashlog_visit_t)(const flashlog_sample_t *sample, void *ctx);
+
+// Mount the log and, with writer_task set, start the flash writer. Host
+// tools pass false to have full batches written inline by flashlog_add().
+esp_err_t flashlog_init(bool writer_task);
+
+// Append one sample. Only sensor_task may call this.
+void flashlog_add(const int16_t values[HISTORY_CHANNELS], bool motion);
+
+// Oldest and newest sequence numbers stored in flash (first > last if empty)
+esp_err_t flashlog_range(uint32_t *first, uint32_t *last);
+
+// Visit stored samples with from <= seq <= to in order. Safe from any task;
+// readers never wait for an erase.
+esp_err_t flashlog_read(uint32_t from, uint32_t to, flashlog_visit_t visit, void *ctx);
+
+void flashlog_get_stats(flashlog_stats_t *out);
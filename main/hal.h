@@ -0,0 +1,59 @@
+#pragma once
+
+// Hardware abstraction layer for the study desk.
+//
+// main.c only talks to the board through these calls. hal_esp32.c implements
+// them with the ESP-IDF drivers; host/hal_sim.c implements them with simulated
+// sensors and an in-memory LCD so the same application logic runs on Linux.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Board bring-up: NVS, GPIO directions, I2C master, fan PWM and ADC
+esp_err_t hal_board_init(void);
+
+// Connect to the network and block until an IP address is assigned
+void hal_wifi_connect(const char *ssid, const char *password);
+
+// Switch to other credentials: drops the current association and reconnects
+// in the background. An empty password joins an open network.
+void hal_wifi_set_credentials(const char *ssid, const char *password);
+
+// Modem sleep between beacons. Off by default: clients polling the board
+// need the radio awake, a board that pushes its samples in bursts does not.
+void hal_wifi_set_power_save(bool enable);
+
+// Digital outputs / inputs
+void hal_buzzer_set(bool on);
+void hal_led_set(bool on);
+bool hal_pir_read(void);
+
+// Called from interrupt context on every PIR level change with the new level
+// and the esp_timer time of the edge. Must be IRAM-safe on the target.
+typedef void (*hal_pir_edge_cb_t)(bool level, int64_t time_us, void *arg);
+
+// Enable the PIR edge interrupt and route it to cb
+esp_err_t hal_pir_set_edge_callback(hal_pir_edge_cb_t cb, void *arg);
+
+// LDR acquisition. The ADC converts continuously at sample_hz into DMA
+// buffers; hal_ldr_read() blocks until a buffer is complete (or timeout_ms
+// passes) and copies out up to max raw 12-bit samples (0-4095, higher means
+// darker). Returns the number of samples copied.
+esp_err_t hal_ldr_start(uint32_t sample_hz);
+size_t hal_ldr_read(uint16_t *raw, size_t max, uint32_t timeout_ms);
+
+// Calibrated millivolts for a raw reading, from the eFuse ADC characteristics
+uint32_t hal_ldr_raw_to_mv(uint32_t raw);
+
+// Read one 40-bit DHT22 frame (humidity hi/lo, temp hi/lo, checksum).
+// The checksum is not verified here. Fails with ESP_ERR_TIMEOUT when the
+// sensor does not answer and ESP_ERR_INVALID_RESPONSE on out-of-spec timing.
+esp_err_t hal_dht22_read_frame(uint8_t data[5]);
+
+// Single I2C master write transaction
+esp_err_t hal_i2c_write(uint8_t addr, const uint8_t *buf, size_t len, uint32_t timeout_ms);
+
+// Fan PWM duty (0-255)
+void hal_fan_set_duty(uint32_t duty);
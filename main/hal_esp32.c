@@ -0,0 +1,450 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "esp_system.h"
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "driver/gpio.h"
+#include "hal/gpio_ll.h"  // ISR-safe level read
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc_cal.h"
+#include "esp_rom_sys.h"  // Required for esp_rom_delay_us
+#include "driver/i2c.h"   // For I2C LCD
+#include "driver/ledc.h"  // For PWM fan control
+#include "driver/rmt_rx.h"  // DHT22 edge capture
+#include "hal.h"
+#include "dht22.h"
+
+// GPIO Pin definitions
+#define DHT_PIN         GPIO_NUM_4
+#define LDR_PIN         GPIO_NUM_34
+#define PIR_PIN         GPIO_NUM_25
+#define BUZZER_PIN      GPIO_NUM_23
+#define LED_PIN         GPIO_NUM_12
+#define FAN_PIN         GPIO_NUM_26  // PWM for fan speed control
+#define I2C_SDA_PIN     GPIO_NUM_21
+#define I2C_SCL_PIN     GPIO_NUM_22
+
+// I2C Configuration
+#define I2C_MASTER_NUM         I2C_NUM_0
+#define I2C_MASTER_FREQ_HZ     100000
+
+// ADC channels
+#define LDR_CHANNEL     ADC_CHANNEL_6   // ADC1, GPIO 34
+
+// Continuous LDR conversion: results are 2-byte TYPE1 words, and a DMA
+// frame of 256 of them completes every 12.8 ms at 20 kHz
+#define LDR_FRAME_BYTES (256 * SOC_ADC_DIGI_RESULT_BYTES)
+#define LDR_POOL_BYTES  (4 * LDR_FRAME_BYTES)
+
+// Fan PWM Configuration
+#define FAN_PWM_TIMER          LEDC_TIMER_0
+#define FAN_PWM_MODE           LEDC_LOW_SPEED_MODE
+#define FAN_PWM_CHANNEL        LEDC_CHANNEL_0
+#define FAN_PWM_DUTY_RES       LEDC_TIMER_8_BIT  // 8-bit resolution (0-255)
+#define FAN_PWM_FREQUENCY      25000             // 25kHz for smooth fan operation
+
+static const char *TAG = "HAL";
+
+// ADC calibration
+static esp_adc_cal_characteristics_t adc_chars;
+static adc_continuous_handle_t ldr_adc;
+
+// WiFi event group
+static EventGroupHandle_t wifi_event_group;
+#define WIFI_CONNECTED_BIT BIT0
+static int wifi_retry_count = 0;
+#define MAX_WIFI_RETRY 5
+
+static void fan_init(void) {
+    // Configure PWM timer
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode       = FAN_PWM_MODE,
+        .timer_num        = FAN_PWM_TIMER,
+        .duty_resolution  = FAN_PWM_DUTY_RES,
+        .freq_hz          = FAN_PWM_FREQUENCY,
+        .clk_cfg          = LEDC_AUTO_CLK
+    };
+    ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
+
+    // Configure PWM channel
+    ledc_channel_config_t ledc_channel = {
+        .speed_mode     = FAN_PWM_MODE,
+        .channel        = FAN_PWM_CHANNEL,
+        .timer_sel      = FAN_PWM_TIMER,
+        .intr_type      = LEDC_INTR_DISABLE,
+        .gpio_num       = FAN_PIN,
+        .duty           = 0,  // Start with fan off
+        .hpoint         = 0
+    };
+    ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
+
+    ESP_LOGI(TAG, "Fan PWM initialized on GPIO %d", FAN_PIN);
+}
+
+// DHT22 capture. The RMT receiver timestamps every edge in hardware, so a
+// read no longer depends on this task being scheduled at the right
+// microsecond; the task just blocks until the frame is in and then decodes
+// the pulse train with dht22_decode().
+#define DHT_RMT_RESOLUTION_HZ   1000000     // 1 tick = 1 us
+#define DHT_RMT_SYMBOLS         64          // One memory block; a frame is ~43
+#define DHT_START_LOW_US        1100        // Host start pulse, >= 1 ms
+#define DHT_CAPTURE_TIMEOUT_MS  20          // A full frame takes ~5 ms
+
+static rmt_channel_handle_t dht_rx_chan;
+static QueueHandle_t dht_rx_queue;
+static rmt_symbol_word_t dht_symbols[DHT_RMT_SYMBOLS];
+
+static bool IRAM_ATTR dht_rx_done(rmt_channel_handle_t chan, const rmt_rx_done_event_data_t *edata,
+                                  void *user_ctx) {
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(dht_rx_queue, edata, &woken);
+    return woken == pdTRUE;
+}
+
+static void dht_init(void) {
+    dht_rx_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+    rmt_rx_channel_config_t rx_conf = {
+        .gpio_num = DHT_PIN,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DHT_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT_RMT_SYMBOLS,
+    };
+    ESP_ERROR_CHECK(rmt_new_rx_channel(&rx_conf, &dht_rx_chan));
+    rmt_rx_event_callbacks_t cbs = {
+        .on_recv_done = dht_rx_done,
+    };
+    ESP_ERROR_CHECK(rmt_rx_register_event_callbacks(dht_rx_chan, &cbs, NULL));
+    ESP_ERROR_CHECK(rmt_enable(dht_rx_chan));
+
+    // The same pin drives the start pulse. Open-drain output keeps the RMT
+    // input routed while the line is pulled low.
+    gpio_set_direction(DHT_PIN, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(DHT_PIN, GPIO_PULLUP_ONLY);
+    gpio_set_level(DHT_PIN, 1);
+}
+
+esp_err_t hal_board_init(void) {
+    // Initialize NVS
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    // Initialize GPIOs
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << PIR_PIN),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+
+    // Initialize I2C for LCD
+    ESP_LOGI(TAG, "Initializing I2C: SDA=%d, SCL=%d", I2C_SDA_PIN, I2C_SCL_PIN);
+    i2c_config_t i2c_conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = I2C_SDA_PIN,
+        .scl_io_num = I2C_SCL_PIN,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = I2C_MASTER_FREQ_HZ,
+    };
+    ESP_ERROR_CHECK(i2c_param_config(I2C_MASTER_NUM, &i2c_conf));
+    ESP_ERROR_CHECK(i2c_driver_install(I2C_MASTER_NUM, i2c_conf.mode, 0, 0, 0));
+    ESP_LOGI(TAG, "I2C driver installed successfully");
+
+    // Initialize Fan PWM
+    fan_init();
+
+    // DHT22 data line: RMT capture plus open-drain start pulse
+    dht_init();
+
+    // Initialize Buzzer GPIO
+    gpio_config_t buzzer_conf = {
+        .pin_bit_mask = (1ULL << BUZZER_PIN),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&buzzer_conf);
+    gpio_set_level(BUZZER_PIN, 0);  // Start with buzzer OFF
+
+    // Initialize LED GPIO
+    gpio_config_t led_conf = {
+        .pin_bit_mask = (1ULL << LED_PIN),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&led_conf);
+    gpio_set_level(LED_PIN, 0);  // Start with LED OFF
+
+    // ADC calibration (eFuse Vref or two-point values, 1100 mV default).
+    // Conversion itself starts with hal_ldr_start().
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_12, ADC_WIDTH_BIT_12, 1100, &adc_chars);
+
+    return ESP_OK;
+}
+
+// WiFi event handler
+static void wifi_event_handler(void* arg, esp_event_base_t event_base,
+                               int32_t event_id, void* event_data) {
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        esp_wifi_connect();
+        ESP_LOGI(TAG, "WiFi connecting...");
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        if (wifi_retry_count < MAX_WIFI_RETRY) {
+            esp_wifi_connect();
+            wifi_retry_count++;
+            ESP_LOGI(TAG, "Disconnected, retry attempt %d/%d", wifi_retry_count, MAX_WIFI_RETRY);
+        } else {
+            ESP_LOGI(TAG, "Max retry reached, waiting 10s before retry...");
+            vTaskDelay(pdMS_TO_TICKS(10000));
+            wifi_retry_count = 0;
+            esp_wifi_connect();
+        }
+        xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        ESP_LOGI(TAG, "========================================");
+        ESP_LOGI(TAG, "WiFi Connected!");
+        ESP_LOGI(TAG, "IP Address: " IPSTR, IP2STR(&event->ip_info.ip));
+        ESP_LOGI(TAG, "Dashboard URL: http://" IPSTR, IP2STR(&event->ip_info.ip));
+        ESP_LOGI(TAG, "========================================");
+        wifi_retry_count = 0;
+        xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
+    }
+}
+
+// Initialize WiFi
+static void wifi_init(void) {
+    wifi_event_group = xEventGroupCreate();
+
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    // No power save while the dashboard polls; see hal_wifi_set_power_save()
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
+
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
+
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+}
+
+static esp_err_t wifi_set_sta_config(const char *ssid, const char *password) {
+    wifi_config_t wifi_config = {
+        .sta = {
+            .threshold.authmode = password[0] != '\0' ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN,
+        },
+    };
+    strlcpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid));
+    strlcpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password));
+    return esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config);
+}
+
+void hal_wifi_connect(const char *ssid, const char *password) {
+    wifi_init();
+    ESP_ERROR_CHECK(wifi_set_sta_config(ssid, password));
+    ESP_ERROR_CHECK(esp_wifi_start());
+    ESP_LOGI(TAG, "WiFi initialized, connecting to %s", ssid);
+
+    // Wait for WiFi connection
+    xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, false, true, portMAX_DELAY);
+}
+
+void hal_wifi_set_credentials(const char *ssid, const char *password) {
+    // The disconnect event handler reconnects, now with the new config
+    esp_err_t err = wifi_set_sta_config(ssid, password);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi config rejected: %s", esp_err_to_name(err));
+        return;
+    }
+    wifi_retry_count = 0;
+    esp_wifi_disconnect();
+    ESP_LOGI(TAG, "WiFi credentials changed, reconnecting to %s", ssid);
+}
+
+void hal_wifi_set_power_save(bool enable) {
+    // Minimum modem sleep wakes for every DTIM beacon, so the board stays
+    // reachable (with a beacon interval of added latency)
+    esp_err_t err = esp_wifi_set_ps(enable ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi power save change failed: %s", esp_err_to_name(err));
+        return;
+    }
+    ESP_LOGI(TAG, "WiFi power save %s", enable ? "on" : "off");
+}
+
+void hal_buzzer_set(bool on) {
+    gpio_set_level(BUZZER_PIN, on ? 1 : 0);
+}
+
+void hal_led_set(bool on) {
+    gpio_set_level(LED_PIN, on ? 1 : 0);
+}
+
+bool hal_pir_read(void) {
+    return gpio_get_level(PIR_PIN) == 1;
+}
+
+static hal_pir_edge_cb_t pir_edge_cb;
+static void *pir_edge_arg;
+
+// Runs with the flash cache possibly disabled (flash log erase), so only
+// IRAM code and register access here
+static void IRAM_ATTR pir_isr(void *arg) {
+    pir_edge_cb(gpio_ll_get_level(&GPIO, PIR_PIN) != 0, esp_timer_get_time(), pir_edge_arg);
+}
+
+esp_err_t hal_pir_set_edge_callback(hal_pir_edge_cb_t cb, void *arg) {
+    pir_edge_cb = cb;
+    pir_edge_arg = arg;
+    esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  // Already installed is fine
+        return err;
+    }
+    gpio_set_intr_type(PIR_PIN, GPIO_INTR_ANYEDGE);
+    return gpio_isr_handler_add(PIR_PIN, pir_isr, NULL);
+}
+
+esp_err_t hal_ldr_start(uint32_t sample_hz) {
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = LDR_POOL_BYTES,
+        .conv_frame_size = LDR_FRAME_BYTES,
+    };
+    esp_err_t err = adc_continuous_new_handle(&handle_cfg, &ldr_adc);
+    if (err != ESP_OK) {
+        return err;
+    }
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_12,
+        .channel = LDR_CHANNEL,
+        .unit = ADC_UNIT_1,
+        .bit_width = ADC_BITWIDTH_12,
+    };
+    adc_continuous_config_t adc_conf = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = sample_hz,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    err = adc_continuous_config(ldr_adc, &adc_conf);
+    if (err == ESP_OK) {
+        err = adc_continuous_start(ldr_adc);
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "LDR ADC running at %" PRIu32 " Hz", sample_hz);
+    }
+    return err;
+}
+
+size_t hal_ldr_read(uint16_t *raw, size_t max, uint32_t timeout_ms) {
+    static uint8_t frame[LDR_FRAME_BYTES];
+    uint32_t len = 0;
+    size_t want = max * SOC_ADC_DIGI_RESULT_BYTES;
+    if (want > sizeof(frame)) {
+        want = sizeof(frame);
+    }
+    if (adc_continuous_read(ldr_adc, frame, want, &len, timeout_ms) != ESP_OK) {
+        return 0;
+    }
+    size_t count = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *word = (const adc_digi_output_data_t *)&frame[i];
+        if (word->type1.channel == LDR_CHANNEL) {
+            raw[count++] = word->type1.data;
+        }
+    }
+    return count;
+}
+
+uint32_t hal_ldr_raw_to_mv(uint32_t raw) {
+    return esp_adc_cal_raw_to_voltage(raw, &adc_chars);
+}
+
+// Dump a failed capture in the bench_dht22 fixture format ("level:us ...")
+static void dht_log_capture(const dht22_pulse_t *pulses, size_t count, esp_err_t err) {
+    ESP_LOGD(TAG, "DHT22 capture failed (%s), %u pulses:", esp_err_to_name(err), (unsigned)count);
+    char line[16 * 8];
+    for (size_t i = 0; i < count; i += 16) {
+        int len = 0;
+        for (size_t j = i; j < count && j < i + 16; j++) {
+            len += snprintf(line + len, sizeof(line) - len, "%u:%u ",
+                            pulses[j].level, pulses[j].duration_us);
+        }
+        ESP_LOGD(TAG, "%s", line);
+    }
+}
+
+esp_err_t hal_dht22_read_frame(uint8_t data[5]) {
+    static const rmt_receive_config_t rx_cfg = {
+        .signal_range_min_ns = 2000,        // Glitch filter
+        .signal_range_max_ns = 200000,      // 200 us without an edge ends the frame
+    };
+    memset(data, 0, 5);
+    xQueueReset(dht_rx_queue);
+
+    // Start pulse. Arm the receiver before releasing the line: the sensor
+    // answers 20-40 us after release.
+    gpio_set_level(DHT_PIN, 0);
+    esp_rom_delay_us(DHT_START_LOW_US);
+    esp_err_t err = rmt_receive(dht_rx_chan, dht_symbols, sizeof(dht_symbols), &rx_cfg);
+    gpio_set_level(DHT_PIN, 1);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    rmt_rx_done_event_data_t done;
+    if (xQueueReceive(dht_rx_queue, &done, pdMS_TO_TICKS(DHT_CAPTURE_TIMEOUT_MS)) != pdTRUE) {
+        // Cancel the pending receive so the next read can arm again
+        rmt_disable(dht_rx_chan);
+        rmt_enable(dht_rx_chan);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    dht22_pulse_t pulses[DHT22_MAX_PULSES];
+    size_t count = 0;
+    for (size_t i = 0; i < done.num_symbols && count + 2 <= DHT22_MAX_PULSES; i++) {
+        const rmt_symbol_word_t *sym = &done.received_symbols[i];
+        if (sym->duration0 != 0) {
+            pulses[count++] = (dht22_pulse_t){ .duration_us = sym->duration0, .level = sym->level0 };
+        }
+        if (sym->duration1 != 0) {
+            pulses[count++] = (dht22_pulse_t){ .duration_us = sym->duration1, .level = sym->level1 };
+        }
+    }
+    err = dht22_decode(pulses, count, data);
+    if (err != ESP_OK) {
+        dht_log_capture(pulses, count, err);
+    }
+    return err;
+}
+
+esp_err_t hal_i2c_write(uint8_t addr, const uint8_t *buf, size_t len, uint32_t timeout_ms) {
+    return i2c_master_write_to_device(I2C_MASTER_NUM, addr, buf, len, pdMS_TO_TICKS(timeout_ms));
+}
+
+void hal_fan_set_duty(uint32_t duty) {
+    ESP_ERROR_CHECK(ledc_set_duty(FAN_PWM_MODE, FAN_PWM_CHANNEL, duty));
+    ESP_ERROR_CHECK(ledc_update_duty(FAN_PWM_MODE, FAN_PWM_CHANNEL));
+}
@@ -0,0 +1,184 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "history.h"
+
+#define SAMPLES_PER_MINUTE  60
+#define MINUTES_PER_HOUR    60
+
+// Running min/sum/max for the bucket currently being filled
+typedef struct {
+    int32_t sum[HISTORY_CHANNELS];
+    int16_t min[HISTORY_CHANNELS];
+    int16_t max[HISTORY_CHANNELS];
+    uint32_t samples;
+    uint32_t motion;
+} rollup_acc_t;
+
+typedef struct {
+    history_row_t *rows;
+    uint32_t size;
+    uint32_t seq;       // Newest completed row (0 = none)
+    uint32_t count;
+    rollup_acc_t acc;
+} rollup_tier_t;
+
+// 1 s tier: raw deci-unit samples plus a motion bitset
+#define SECOND_SLOTS        (HISTORY_SIZE + HISTORY_SPARE)
+
+static int16_t second_values[HISTORY_CHANNELS][SECOND_SLOTS];
+static uint32_t second_motion[(SECOND_SLOTS + 31) / 32];
+static uint32_t second_seq = 0;
+static uint32_t second_count = 0;
+
+static history_row_t minute_rows[HISTORY_MINUTES];
+static history_row_t hour_rows[HISTORY_HOURS];
+static rollup_tier_t minute_tier = { .rows = minute_rows, .size = HISTORY_MINUTES };
+static rollup_tier_t hour_tier = { .rows = hour_rows, .size = HISTORY_HOURS };
+
+// Guards tier storage against readers in other tasks. Held only for the
+// few hundred cycles a write or a batch copy takes.
+static SemaphoreHandle_t history_lock;
+
+static void acc_reset(rollup_acc_t *acc) {
+    memset(acc, 0, sizeof(*acc));
+}
+
+static void acc_add_sample(rollup_acc_t *acc, const int16_t values[HISTORY_CHANNELS], bool motion) {
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        if (acc->samples == 0 || values[c] < acc->min[c]) acc->min[c] = values[c];
+        if (acc->samples == 0 || values[c] > acc->max[c]) acc->max[c] = values[c];
+        acc->sum[c] += values[c];
+    }
+    acc->samples++;
+    acc->motion += motion ? 1 : 0;
+}
+
+// Fold a completed finer bucket into a coarser accumulator, weighting by
+// sample count so the coarse average stays exact
+static void acc_merge(rollup_acc_t *dst, const rollup_acc_t *src) {
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        if (dst->samples == 0 || src->min[c] < dst->min[c]) dst->min[c] = src->min[c];
+        if (dst->samples == 0 || src->max[c] > dst->max[c]) dst->max[c] = src->max[c];
+        dst->sum[c] += src->sum[c];
+    }
+    dst->samples += src->samples;
+    dst->motion += src->motion;
+}
+
+static void tier_push(rollup_tier_t *tier) {
+    const rollup_acc_t *acc = &tier->acc;
+    history_row_t *row = &tier->rows[tier->seq % tier->size];
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        int32_t sum = acc->sum[c];
+        int32_t half = (int32_t)acc->samples / 2;
+        row->min[c] = acc->min[c];
+        row->max[c] = acc->max[c];
+        row->avg[c] = (int16_t)((sum + (sum < 0 ? -half : half)) / (int32_t)acc->samples);
+    }
+    row->motion_pct = (uint8_t)((acc->motion * 100 + acc->samples / 2) / acc->samples);
+    tier->seq++;
+    if (tier->count < tier->size) {
+        tier->count++;
+    }
+}
+
+void history_init(void) {
+    history_lock = xSemaphoreCreateMutex();
+}
+
+void history_add(const int16_t values[HISTORY_CHANNELS], bool motion) {
+    xSemaphoreTake(history_lock, portMAX_DELAY);
+
+    int idx = second_seq % SECOND_SLOTS;
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        second_values[c][idx] = values[c];
+    }
+    if (motion) {
+        second_motion[idx / 32] |= 1u << (idx % 32);
+    } else {
+        second_motion[idx / 32] &= ~(1u << (idx % 32));
+    }
+    second_seq++;
+    if (second_count < HISTORY_SIZE) {
+        second_count++;
+    }
+
+    acc_add_sample(&minute_tier.acc, values, motion);
+    if (minute_tier.acc.samples == SAMPLES_PER_MINUTE) {
+        tier_push(&minute_tier);
+        acc_merge(&hour_tier.acc, &minute_tier.acc);
+        acc_reset(&minute_tier.acc);
+        if (hour_tier.acc.samples == SAMPLES_PER_MINUTE * MINUTES_PER_HOUR) {
+            tier_push(&hour_tier);
+            acc_reset(&hour_tier.acc);
+        }
+    }
+
+    xSemaphoreGive(history_lock);
+}
+
+uint32_t history_seq(history_res_t res) {
+    switch (res) {
+        case HISTORY_RES_MINUTE: return minute_tier.seq;
+        case HISTORY_RES_HOUR:   return hour_tier.seq;
+        default:                 return second_seq;
+    }
+}
+
+uint32_t history_count(history_res_t res) {
+    switch (res) {
+        case HISTORY_RES_MINUTE: return minute_tier.count;
+        case HISTORY_RES_HOUR:   return hour_tier.count;
+        default:                 return second_count;
+    }
+}
+
+uint32_t history_period_s(history_res_t res) {
+    switch (res) {
+        case HISTORY_RES_MINUTE: return SAMPLES_PER_MINUTE;
+        case HISTORY_RES_HOUR:   return SAMPLES_PER_MINUTE * MINUTES_PER_HOUR;
+        default:                 return 1;
+    }
+}
+
+int16_t history_second_value(history_channel_t ch, uint32_t seq) {
+    return second_values[ch][(seq - 1) % SECOND_SLOTS];
+}
+
+bool history_second_motion(uint32_t seq) {
+    uint32_t idx = (seq - 1) % SECOND_SLOTS;
+    return (second_motion[idx / 32] >> (idx % 32)) & 1u;
+}
+
+size_t history_read(history_res_t res, uint32_t *first, history_row_t *rows, size_t max_rows) {
+    xSemaphoreTake(history_lock, portMAX_DELAY);
+
+    uint32_t seq = history_seq(res);
+    uint32_t held = history_count(res);
+    if (res == HISTORY_RES_SECOND) {
+        held = seq < SECOND_SLOTS ? seq : SECOND_SLOTS;
+    }
+    uint32_t oldest = seq - held + 1;
+    if (*first < oldest) {
+        *first = oldest;
+    }
+    size_t n = 0;
+    for (uint32_t s = *first; s <= seq && n < max_rows; s++, n++) {
+        if (res == HISTORY_RES_SECOND) {
+            for (int c = 0; c < HISTORY_CHANNELS; c++) {
+                int16_t v = history_second_value(c, s);
+                rows[n].min[c] = v;
+                rows[n].avg[c] = v;
+                rows[n].max[c] = v;
+            }
+            rows[n].motion_pct = history_second_motion(s) ? 100 : 0;
+        } else {
+            const rollup_tier_t *tier = res == HISTORY_RES_MINUTE ? &minute_tier : &hour_tier;
+            rows[n] = tier->rows[(s - 1) % tier->size];
+        }
+    }
+
+    xSemaphoreGive(history_lock);
+    return n;
+}
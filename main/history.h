@@ -0,0 +1,73 @@
+#pragma once
+
+// Multi-resolution sample history.
+//
+// Three tiers share one row format:
+//   HISTORY_RES_SECOND  raw 1 s samples, last minute     (HISTORY_SIZE rows)
+//   HISTORY_RES_MINUTE  1 min min/avg/max, last day      (HISTORY_MINUTES rows)
+//   HISTORY_RES_HOUR    1 h min/avg/max, last week       (HISTORY_HOURS rows)
+//
+// sensor_task calls history_add() once per sample. Rollups are kept in
+// running accumulators and pushed when a bucket fills, so every sample costs
+// O(1) and RAM is fixed at roughly 32 KiB. Each tier numbers its rows with a
+// sequence number starting at 1; row n lives in slot (n - 1) % tier size.
+//
+// Buckets are counted in samples from boot (the desk has no wall clock), so
+// a minute is 60 samples and an hour is 60 minutes.
+//
+// The 1 s tier stores HISTORY_SPARE rows beyond the HISTORY_SIZE it
+// advertises, so a reader streaming the advertised rows has that many
+// seconds before the oldest of them is overwritten.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HISTORY_SIZE
+#define HISTORY_SIZE        60      // 1 s samples
+#endif
+#define HISTORY_SPARE       4
+#define HISTORY_MINUTES     1440    // 1 min rollups
+#define HISTORY_HOURS       168     // 1 h rollups
+
+typedef enum {
+    HISTORY_RES_SECOND,
+    HISTORY_RES_MINUTE,
+    HISTORY_RES_HOUR,
+    HISTORY_RES_COUNT,
+} history_res_t;
+
+// Deci-unit channels, in row order
+typedef enum {
+    HISTORY_TEMP,
+    HISTORY_HUMID,
+    HISTORY_LIGHT,
+    HISTORY_CHANNELS,
+} history_channel_t;
+
+typedef struct {
+    int16_t min[HISTORY_CHANNELS];
+    int16_t avg[HISTORY_CHANNELS];
+    int16_t max[HISTORY_CHANNELS];
+    uint8_t motion_pct;             // Share of samples with motion, 0-100
+} history_row_t;
+
+void history_init(void);
+
+// Append one 1 s sample (deci-units). Only sensor_task may call this.
+void history_add(const int16_t values[HISTORY_CHANNELS], bool motion);
+
+// Newest row sequence number of a tier (0 = empty) and number of rows held
+uint32_t history_seq(history_res_t res);
+uint32_t history_count(history_res_t res);
+uint32_t history_period_s(history_res_t res);
+
+// Copy up to max_rows rows starting at *first (clamped forward to the oldest
+// row still stored, spares included). On return *first is the sequence
+// number of rows[0].
+// Safe from any task.
+size_t history_read(history_res_t res, uint32_t *first, history_row_t *rows, size_t max_rows);
+
+// Lock-free access to the 1 s tier for the writer task (sensor_task) only
+int16_t history_second_value(history_channel_t ch, uint32_t seq);
+bool history_second_motion(uint32_t seq);
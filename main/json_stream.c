@@ -0,0 +1,48 @@
+#include <string.h>
+#include "json_stream.h"
+
+void json_stream_init(json_stream_t *js, char *window, size_t size, json_stream_sink_t sink, void *ctx) {
+    *js = (json_stream_t){
+        .window = window,
+        .size = size,
+        .p = window,
+        .sink = sink,
+        .ctx = ctx,
+    };
+}
+
+bool json_stream_flush(json_stream_t *js) {
+    size_t len = js->p - js->window;
+    if (!js->failed && len > 0) {
+        js->failed = !js->sink(js->ctx, js->window, len);
+        js->flushes++;
+        js->sent += len;
+    }
+    js->p = js->window;
+    return !js->failed;
+}
+
+char *json_stream_room(json_stream_t *js, size_t n) {
+    if ((size_t)(js->window + js->size - js->p) < n && !json_stream_flush(js)) {
+        return NULL;
+    }
+    return js->failed ? NULL : js->p;
+}
+
+bool json_stream_bytes(json_stream_t *js, const char *buf, size_t len) {
+    while (len > 0) {
+        if (js->p == js->window + js->size && !json_stream_flush(js)) {
+            return false;
+        }
+        if (js->failed) {
+            return false;
+        }
+        size_t room = js->window + js->size - js->p;
+        size_t n = len < room ? len : room;
+        memcpy(js->p, buf, n);
+        js->p += n;
+        buf += n;
+        len -= n;
+    }
+    return !js->failed;
+}
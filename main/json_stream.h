@@ -0,0 +1,53 @@
+#pragma once
+
+// Streaming writer for responses of any length through a fixed window.
+//
+// The numfmt put_* writers fill the window directly: json_stream_room()
+// returns a write pointer with at least n bytes of room, handing the
+// window to the sink first if it is too full, and json_stream_commit()
+// records how far the writer got. The sink sends what it is given (on the
+// server, one httpd_resp_send_chunk per window), so a response costs the
+// window and nothing more however many rows it carries. Once the sink
+// fails, the stream stays failed and further writes are discarded.
+//
+//   char *p = json_stream_room(&js, ROW_MAX);
+//   if (p == NULL) return ESP_FAIL;
+//   p = put_deci(p, v);
+//   json_stream_commit(&js, p);
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Send len bytes; false stops the stream
+typedef bool (*json_stream_sink_t)(void *ctx, const char *buf, size_t len);
+
+typedef struct {
+    char *window;
+    size_t size;
+    char *p;                    // End of the bytes not yet handed to the sink
+    json_stream_sink_t sink;
+    void *ctx;
+    bool failed;
+    uint32_t flushes;
+    uint32_t sent;              // Bytes handed to the sink
+} json_stream_t;
+
+void json_stream_init(json_stream_t *js, char *window, size_t size, json_stream_sink_t sink, void *ctx);
+
+// Write pointer with room for n bytes (n at most the window size), or NULL
+// if the stream has failed
+char *json_stream_room(json_stream_t *js, size_t n);
+
+static inline void json_stream_commit(json_stream_t *js, char *end) {
+    js->p = end;
+}
+
+// Copy len bytes of any length, across as many windows as it takes
+bool json_stream_bytes(json_stream_t *js, const char *buf, size_t len);
+
+#define JSON_STREAM_LIT(js, lit) json_stream_bytes((js), (lit), sizeof(lit) - 1)
+
+// Hand the rest of the window to the sink. false if the stream failed at
+// any point.
+bool json_stream_flush(json_stream_t *js);
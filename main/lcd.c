@@ -0,0 +1,144 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "hal.h"
+#include "lcd.h"
+
+// PCF8574 pins: P0 RS, P2 EN, P3 backlight, P4-P7 data nibble
+#define LCD_RS          0x01
+#define LCD_ENABLE      0x04
+#define LCD_BACKLIGHT   0x08
+
+#define LCD_CMD_CLEAR   0x01
+#define LCD_CMD_DDRAM   0x80
+
+// Worst case frame: every other cell changed, so a cursor move per cell
+#define LCD_TX_MAX      (LCD_ROWS * LCD_COLS * 2 * 4)
+#define LCD_TIMEOUT_MS  100
+
+static const char *TAG = "LCD";
+
+static uint8_t lcd_addr;
+static char frame[LCD_ROWS][LCD_COLS];  // What should be on screen
+static char shown[LCD_ROWS][LCD_COLS];  // What the controller holds
+static bool shown_valid;
+static int cursor = -1;                 // DDRAM address counter, -1 unknown
+
+static uint8_t tx[LCD_TX_MAX];
+static size_t tx_len;
+static lcd_stats_t stats;
+
+static uint8_t row_addr(int row) {
+    return row == 0 ? 0x00 : 0x40;
+}
+
+// Queue one controller byte as two nibbles, each latched by an EN pulse
+static void tx_byte(uint8_t value, uint8_t mode) {
+    uint8_t high = value & 0xF0;
+    uint8_t low = (value << 4) & 0xF0;
+    tx[tx_len++] = high | mode | LCD_BACKLIGHT | LCD_ENABLE;
+    tx[tx_len++] = high | mode | LCD_BACKLIGHT;
+    tx[tx_len++] = low | mode | LCD_BACKLIGHT | LCD_ENABLE;
+    tx[tx_len++] = low | mode | LCD_BACKLIGHT;
+}
+
+static esp_err_t tx_send(void) {
+    esp_err_t ret = hal_i2c_write(lcd_addr, tx, tx_len, LCD_TIMEOUT_MS);
+    stats.transactions++;
+    stats.bytes += tx_len;
+    if (ret != ESP_OK) {
+        stats.errors++;
+        ESP_LOGE(TAG, "LCD I2C write failed: %s", esp_err_to_name(ret));
+    }
+    tx_len = 0;
+    return ret;
+}
+
+// Init commands go out one per transaction with the settle times they need
+static esp_err_t lcd_command(uint8_t cmd, uint32_t settle_ms) {
+    tx_byte(cmd, 0);
+    esp_err_t ret = tx_send();
+    vTaskDelay(pdMS_TO_TICKS(settle_ms));
+    return ret;
+}
+
+esp_err_t lcd_init(uint8_t i2c_addr) {
+    lcd_addr = i2c_addr;
+    ESP_LOGI(TAG, "Initializing LCD at address 0x%02X...", lcd_addr);
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    // Initialize in 8-bit mode first, then switch to 4-bit mode
+    uint32_t errors = stats.errors;
+    lcd_command(0x33, 5);
+    lcd_command(0x32, 5);
+    lcd_command(0x28, 1);  // Function set: 4-bit, 2 lines, 5x8 font
+    lcd_command(0x0C, 1);  // Display ON, cursor OFF, blink OFF
+    lcd_command(0x06, 1);  // Entry mode: increment cursor, no shift
+    lcd_command(LCD_CMD_CLEAR, 2);
+    esp_err_t ret = stats.errors == errors ? ESP_OK : ESP_FAIL;
+    if (ret == ESP_OK) {
+        memset(shown, ' ', sizeof(shown));
+        shown_valid = true;
+        cursor = 0;
+    }
+    lcd_clear();
+
+    ESP_LOGI(TAG, "LCD initialization complete");
+    return ret;
+}
+
+void lcd_clear(void) {
+    memset(frame, ' ', sizeof(frame));
+}
+
+void lcd_write_line(uint8_t row, const char *text) {
+    if (row >= LCD_ROWS) {
+        return;
+    }
+    size_t len = strnlen(text, LCD_COLS);
+    memcpy(frame[row], text, len);
+    memset(frame[row] + len, ' ', LCD_COLS - len);
+}
+
+esp_err_t lcd_flush(void) {
+    uint16_t cells = 0;
+    for (int row = 0; row < LCD_ROWS; row++) {
+        for (int col = 0; col < LCD_COLS; col++) {
+            if (shown_valid && frame[row][col] == shown[row][col]) {
+                continue;
+            }
+            // Consecutive dirty cells ride the controller's auto-increment
+            uint8_t addr = row_addr(row) + col;
+            if (cursor != addr) {
+                tx_byte(LCD_CMD_DDRAM | addr, 0);
+            }
+            tx_byte((uint8_t)frame[row][col], LCD_RS);
+            cursor = addr + 1;
+            cells++;
+        }
+    }
+    if (tx_len == 0) {
+        return ESP_OK;
+    }
+
+    stats.frames++;
+    stats.cells += cells;
+    stats.last_bytes = tx_len;
+    stats.last_cells = cells;
+    esp_err_t ret = tx_send();
+    if (ret == ESP_OK) {
+        memcpy(shown, frame, sizeof(shown));
+        shown_valid = true;
+    } else {
+        // Part of the frame may have landed; redraw all of it next time
+        shown_valid = false;
+        cursor = -1;
+    }
+    ESP_LOGD(TAG, "Frame: %u cells, %u bytes", cells, stats.last_bytes);
+    return ret;
+}
+
+void lcd_get_stats(lcd_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// HD44780 2x16 character LCD behind a PCF8574 I2C backpack.
+//
+// Drawing only touches a RAM shadow of the screen. lcd_flush() diffs it
+// against what the controller already shows and sends just the changed
+// cells, moving the cursor only where a run of changes is broken. Every
+// nibble of the frame is packed into one buffer and sent as a single I2C
+// write, so a frame costs at most one transaction (and none when nothing
+// changed) instead of one per character.
+//
+// Not thread safe: draw and flush from one task.
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define LCD_COLS    16
+#define LCD_ROWS    2
+
+typedef struct {
+    uint32_t frames;            // Flushes that sent anything
+    uint32_t transactions;      // I2C writes, including init
+    uint32_t bytes;             // I2C payload bytes, including init
+    uint32_t cells;             // Characters written to the controller
+    uint32_t errors;            // Failed I2C writes
+    uint16_t last_bytes;        // Payload of the most recent frame
+    uint16_t last_cells;
+} lcd_stats_t;
+
+// Run the 4-bit init sequence and clear the controller and the shadow
+esp_err_t lcd_init(uint8_t i2c_addr);
+
+// Blank the shadow (no I2C traffic until the next flush)
+void lcd_clear(void);
+
+// Set a whole row in the shadow, padding with spaces or truncating to 16
+void lcd_write_line(uint8_t row, const char *text);
+
+// Send the cells that differ from the screen. On an I2C error the screen
+// contents are treated as unknown and the next flush redraws everything.
+esp_err_t lcd_flush(void);
+
+void lcd_get_stats(lcd_stats_t *out);
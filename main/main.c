@@ -1,113 +1,111 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/socket.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/event_groups.h"
-#include "esp_system.h"
-#include "esp_wifi.h"
-#include "esp_event.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
+#include "esp_timer.h"
+#include "esp_system.h"
 #include "esp_http_server.h"
-#include "driver/gpio.h"
-#include "driver/adc.h"
-#include "esp_adc_cal.h"
-#include "esp_rom_sys.h"  // Required for esp_rom_delay_us
-#include "driver/i2c.h"   // For I2C LCD
-#include "driver/ledc.h"  // For PWM fan control
-// WiFi credentials
-#define WIFI_SSID "Mohanad"
-#define WIFI_PASS "13572468"
-
-// GPIO Pin definitions
-#define DHT_PIN         GPIO_NUM_4
-#define LDR_PIN         GPIO_NUM_34
-#define PIR_PIN         GPIO_NUM_25
-#define BUZZER_PIN      GPIO_NUM_23
-#define LED_PIN         GPIO_NUM_12
-#define FAN_PIN         GPIO_NUM_26  // PWM for fan speed control
-#define I2C_SDA_PIN     GPIO_NUM_21
-#define I2C_SCL_PIN     GPIO_NUM_22
+#include "esp_rom_crc.h"
+#include "hal.h"
+#include "numfmt.h"
+#include "history.h"
+#include "flashlog.h"
+#include "motion.h"
+#include "lcd.h"
+#include "display.h"
+#include "periodic.h"
+#include "cic.h"
+#include "metrics.h"
+#include "fan.h"
+#include "dlog.h"
+#include "config.h"
+#include "push.h"
+#include "dht22.h"
+#include "desk_logic.h"
+#include "trace.h"
+#include "resp_pool.h"
+#include "json_stream.h"
+#include "series_json.h"
+#include "sessions.h"
+#include "envstats.h"
 
 // I2C LCD Configuration
-#define I2C_MASTER_NUM         I2C_NUM_0
-#define I2C_MASTER_FREQ_HZ     100000
 #define LCD_ADDR               0x27  // I2C address detected by scanner
 
-// ADC channels
-#define LDR_CHANNEL     ADC1_CHANNEL_6  // GPIO 34
+// Acquisition
+#define SENSOR_PERIOD_MS       1000  // Session clock and history cadence
+#define DHT_PERIOD_MS          2000  // DHT22 maximum rate is 0.5 Hz
+#define LDR_SAMPLE_HZ          20000 // Continuous ADC rate (the ESP32 minimum)...
+#define LDR_OUTPUT_HZ          10    // ...decimated by a CIC filter to this
+#define LDR_FRAME_SAMPLES      256   // One DMA frame
+#define SAMPLE_BUS_LEN         16
 
-// Fan PWM Configuration
-#define FAN_PWM_TIMER          LEDC_TIMER_0
-#define FAN_PWM_MODE           LEDC_LOW_SPEED_MODE
-#define FAN_PWM_CHANNEL        LEDC_CHANNEL_0
-#define FAN_PWM_DUTY_RES       LEDC_TIMER_8_BIT  // 8-bit resolution (0-255)
-#define FAN_PWM_FREQUENCY      25000             // 25kHz for smooth fan operation
+// Timing-critical acquisition runs on the APP CPU, WiFi, lwIP and the HTTP
+// server on the PRO CPU
+#define NET_CORE               0
+#define ACQ_CORE               (portNUM_PROCESSORS > 1 ? 1 : 0)
 
 static const char *TAG = "ESP32_DASHBOARD";
 
-// Global sensor data
-static float humidity = 0;
-static float temperature = 0;
-static float temperatureF = 0;
+// Global sensor data. Measurements are fixed-point deci-units (tenths), which
+// is what the DHT22 delivers and all the dashboard ever displays. Readings
+// the decision logic uses, and everything it decides (buzzer, LED, fan,
+// session), live in desk, which only sensor_task writes.
+static desk_logic_t desk;
+static int16_t temperatureF = 0;     // °F x10
 static int ldrValue = 0;
-static float lightPercentage = 0;
-static bool motionDetected = false;
-static int motionCount = 0;
-static int noMotionSeconds = 0;
-static bool buzzerOn = false;
-static int buzzerDuration = 10;
-static int lowLightSeconds = 0;
-static bool ledOn = false;
-static uint32_t sessionSeconds = 0;  // Session time in seconds
-static bool sessionActive = true;     // Session is active when user is present
-
-// Historical data storage (circular buffer for last 60 readings)
-#define HISTORY_SIZE 60
-static float temp_history[HISTORY_SIZE] = {0};
-static float humid_history[HISTORY_SIZE] = {0};
-static float light_history[HISTORY_SIZE] = {0};
-static int motion_history[HISTORY_SIZE] = {0};
-static int history_index = 0;
-static int history_count = 0;
-static uint8_t fanSpeed = 0;  // Track fan PWM duty (0-255)
-
-// ADC calibration
-static esp_adc_cal_characteristics_t adc_chars;
-
-// WiFi event group
-static EventGroupHandle_t wifi_event_group;
-#define WIFI_CONNECTED_BIT BIT0
-static int wifi_retry_count = 0;
-#define MAX_WIFI_RETRY 5
-
-// LCD I2C Commands
-#define LCD_BACKLIGHT   0x08
-#define LCD_NOBACKLIGHT 0x00
-#define LCD_ENABLE      0x04
-
-// I2C LCD Functions
-static esp_err_t lcd_send_byte(uint8_t data, uint8_t mode) {
-    uint8_t high = data & 0xF0;
-    uint8_t low = (data << 4) & 0xF0;
-    uint8_t buf[4];
-    buf[0] = high | mode | LCD_BACKLIGHT | LCD_ENABLE;
-    buf[1] = high | mode | LCD_BACKLIGHT;
-    buf[2] = low | mode | LCD_BACKLIGHT | LCD_ENABLE;
-    buf[3] = low | mode | LCD_BACKLIGHT;
-    esp_err_t ret = i2c_master_write_to_device(I2C_MASTER_NUM, LCD_ADDR, buf, 4, pdMS_TO_TICKS(100));
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "LCD I2C write failed: %s", esp_err_to_name(ret));
-    }
-    return ret;
-}
+static uint32_t ldrMillivolts = 0;   // Calibrated
+static uint32_t dhtReads = 0;     // DHT22 read attempts since boot
+static uint32_t dhtFailures = 0;  // No response, bad timing or bad checksum
+static uint32_t dhtTimeouts = 0;       // ...of which no response or a short frame
+static uint32_t dhtBadPulses = 0;      // ...a pulse outside the datasheet timing
+static uint32_t dhtChecksumErrors = 0; // ...a frame that failed its checksum
+static uint32_t sampleMaxUs = 0;  // Longest sensor_sample() run, the loop's busy time
+static atomic_uint busDropped;    // Sensor readings lost to a full sample bus, from either sensor task
+
+// Streaming statistics and anomaly flags for each history channel
+// (envstats.h), fed by sensor_task with every sample. Rolling min/max cover
+// the last ENV_WINDOW_S samples; the mean and std follow about the last
+// minute. A change is flagged when it beats a minute's worth of roc_limit.
+#define ENV_WINDOW_S   300
+
+static const char *const env_channel_names[HISTORY_CHANNELS] = { "temperature", "humidity", "light" };
+
+static const envstats_config_t envStatsConfig[HISTORY_CHANNELS] = {
+    [HISTORY_TEMP]  = { .window = ENV_WINDOW_S, .ewma_shift = 6, .z_limit_deci = 50, .std_floor_deci = 2,
+                        .roc_limit_deci = 10 },
+    [HISTORY_HUMID] = { .window = ENV_WINDOW_S, .ewma_shift = 6, .z_limit_deci = 50, .std_floor_deci = 5,
+                        .roc_limit_deci = 50 },
+    [HISTORY_LIGHT] = { .window = ENV_WINDOW_S, .ewma_shift = 6, .z_limit_deci = 50, .std_floor_deci = 10,
+                        .roc_limit_deci = 200 },
+};
+
+static envstats_t envStats[HISTORY_CHANNELS];
+static envstats_slot_t envStatsSlots[HISTORY_CHANNELS][ENVSTATS_SLOTS(ENV_WINDOW_S)];
+
+// Session and break analytics (sessions.h), ticked by sensor_task and read
+// by /sessions, each under sessionsLock
+static sessions_t deskSessions;
+static SemaphoreHandle_t sessionsLock;
+
+// sensor_task's copy of the runtime config, refreshed when it changes
+static desk_config_t deskConfig;
+static uint32_t deskConfigGeneration = 0;
 
 static void i2c_scanner(void) {
     ESP_LOGI(TAG, "I2C Scanner - Scanning bus...");
     uint8_t devices_found = 0;
     for (uint8_t addr = 1; addr < 127; addr++) {
         uint8_t data = 0;
-        esp_err_t ret = i2c_master_write_to_device(I2C_MASTER_NUM, addr, &data, 1, pdMS_TO_TICKS(50));
+        esp_err_t ret = hal_i2c_write(addr, &data, 1, 50);
         if (ret == ESP_OK) {
             ESP_LOGI(TAG, "I2C device found at address 0x%02X", addr);
             devices_found++;
@@ -120,695 +118,1430 @@ static void i2c_scanner(void) {
     }
 }
 
-static void lcd_init(void) {
-    ESP_LOGI(TAG, "Initializing LCD at address 0x%02X...", LCD_ADDR);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    
-    // Initialize in 8-bit mode first
-    lcd_send_byte(0x33, 0);
-    vTaskDelay(pdMS_TO_TICKS(5));
-    lcd_send_byte(0x32, 0);
-    vTaskDelay(pdMS_TO_TICKS(5));
-    
-    // Now in 4-bit mode
-    lcd_send_byte(0x28, 0);  // Function set: 4-bit, 2 lines, 5x8 font
-    vTaskDelay(pdMS_TO_TICKS(1));
-    lcd_send_byte(0x0C, 0);  // Display ON, cursor OFF, blink OFF
-    vTaskDelay(pdMS_TO_TICKS(1));
-    lcd_send_byte(0x06, 0);  // Entry mode: increment cursor, no shift
-    vTaskDelay(pdMS_TO_TICKS(1));
-    lcd_send_byte(0x01, 0);  // Clear display
-    vTaskDelay(pdMS_TO_TICKS(2));
-    
-    ESP_LOGI(TAG, "LCD initialization complete");
+// Outputs of the decision logic (desk_logic.c). The fan is table-driven
+// with hysteresis and slew limiting (fan.c); its LEDC registers and the
+// (deferred) log are touched only when the duty changes.
+static void desk_buzzer(void *ctx, bool on) {
+    hal_buzzer_set(on);
+    if (on) {
+        display_show_away();
+        DLOG(DLOG_BUZZ_ON, deskConfig.away_s);
+    } else {
+        display_show_session(0);
+        DLOG(DLOG_BUZZ_OFF);
+    }
 }
 
-static void lcd_clear(void) {
-    lcd_send_byte(0x01, 0);
-    vTaskDelay(pdMS_TO_TICKS(2));
+static void desk_led(void *ctx, bool on) {
+    hal_led_set(on);
+    if (on) {
+        DLOG(DLOG_LED_ON, deskConfig.light_delay_s);
+    } else {
+        DLOG(DLOG_LED_OFF, deskConfig.light_low_deci);
+    }
 }
 
-static void lcd_set_cursor(uint8_t col, uint8_t row) {
-    uint8_t addr = (row == 0) ? (0x80 + col) : (0xC0 + col);
-    lcd_send_byte(addr, 0);
+static void desk_fan(void *ctx, uint8_t duty) {
+    hal_fan_set_duty(duty);
+    DLOG(DLOG_FAN, duty, (duty * 100 + 127) / 255, desk.temperature);
 }
 
-// Print exactly 16 characters to LCD, padding with spaces if needed
-static void lcd_print_line(const char* text) {
-    char line[17];  // 16 chars + null
-    int i;
-    
-    // Copy text or pad with spaces
-    for (i = 0; i < 16; i++) {
-        if (text[i] != '\0') {
-            line[i] = text[i];
+static void desk_session(void *ctx, uint32_t seconds) {
+    display_show_session(seconds);
+}
+
+static const desk_outputs_t deskOutputs = {
+    .buzzer = desk_buzzer,
+    .led = desk_led,
+    .fan = desk_fan,
+    .session = desk_session,
+};
+
+// Dashboard assets: main/web/*, gzipped at build time and linked into flash
+// (see main/CMakeLists.txt). They are served as stored, with a strong ETag
+// derived from the compressed bytes so browsers revalidate with a 304.
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[] asm("_binary_index_html_gz_end");
+extern const uint8_t chart_js_gz_start[] asm("_binary_chart_js_gz_start");
+extern const uint8_t chart_js_gz_end[] asm("_binary_chart_js_gz_end");
+
+typedef struct {
+    const char *uri;
+    const char *type;
+    const uint8_t *start;
+    const uint8_t *end;
+    char etag[11];  // CRC32 of the gzipped bytes, quoted
+} web_asset_t;
+
+static web_asset_t web_assets[] = {
+    { "/", "text/html; charset=utf-8", index_html_gz_start, index_html_gz_end, "" },
+    { "/chart.js", "application/javascript", chart_js_gz_start, chart_js_gz_end, "" },
+};
+
+static void web_assets_init(void) {
+    for (size_t i = 0; i < sizeof(web_assets) / sizeof(web_assets[0]); i++) {
+        web_asset_t *asset = &web_assets[i];
+        uint32_t crc = esp_rom_crc32_le(0, asset->start, asset->end - asset->start);
+        snprintf(asset->etag, sizeof(asset->etag), "\"%08" PRIx32 "\"", crc);
+    }
+}
+
+// DHT22 reading: raw frame from the HAL, checksum and conversion in
+// dht22.c. The sensor reports tenths natively, so values stay in deci-units.
+static bool dht22_read(int16_t *temp, int16_t *humid) {
+    uint8_t data[5];
+    dhtReads++;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = hal_dht22_read_frame(data);
+    trace_dht(esp_timer_get_time(), err == ESP_OK, data);
+    if (err == ESP_OK) {
+        err = dht22_frame_values(data, temp, humid);
+    }
+    metrics_observe(METRICS_DHT22_READ, (uint32_t)(esp_timer_get_time() - start));
+    if (err != ESP_OK) {
+        dhtFailures++;
+        if (err == ESP_ERR_TIMEOUT) {
+            dhtTimeouts++;
+        } else if (err == ESP_ERR_INVALID_CRC) {
+            dhtChecksumErrors++;
         } else {
-            line[i] = ' ';  // Pad remaining with spaces
+            dhtBadPulses++;
         }
+        ESP_LOGW(TAG, "DHT22 read failed: %s (%" PRIu32 "/%" PRIu32 " reads failed)",
+                 esp_err_to_name(err), dhtFailures, dhtReads);
+        return false;
     }
-    line[16] = '\0';  // Null terminate
+    return true;
+}
+
+// HTTP handlers
+static esp_err_t asset_handler(httpd_req_t *req) {
+    const web_asset_t *asset = req->user_ctx;
+    // Every browser sends gzip in Accept-Encoding, so there is no identity
+    // fallback. no-cache still lets the browser keep the copy; it just has
+    // to revalidate, which costs a header-only 304.
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
     
-    // Send exactly 16 characters
-    for (i = 0; i < 16; i++) {
-        lcd_send_byte(line[i], 0x01);
+    char match[64];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", match, sizeof(match)) == ESP_OK &&
+        strstr(match, asset->etag) != NULL) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
     }
+    
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
 }
 
-static void lcd_update_session_time(uint32_t seconds) {
-    uint32_t hours = seconds / 3600;
-    uint32_t minutes = (seconds % 3600) / 60;
-    uint32_t secs = seconds % 60;
+// Pre-serialized live values of the latest tick. sensor_task formats them
+// once per sample; /data and /events copy them out with memcpy and stream
+// the sample series after them from the 1 s history tier (series_json.h).
+//
+// Two buffers are published by pointer swap: sensor_task fills the one that
+// is not current and then makes it current. A reader pins a buffer for the
+// few microseconds it takes to copy it out, and the writer skips a tick
+// rather than overwrite a pinned buffer, so readers never see a torn sample.
+#define SNAPSHOT_BUFFERS     2
+#define SNAPSHOT_LIVE_SIZE   1152 // Worst case with every field at its widest is ~1070
+#define DATA_LIVE_MAX        (SNAPSHOT_LIVE_SIZE + 24)  // Plus "firstSeq"
+
+typedef struct {
+    uint32_t seq;          // Newest sample (0 = none yet)
+    uint32_t oldest_seq;
+    uint16_t live_len;
+    char live[SNAPSHOT_LIVE_SIZE];  // {"temperature":...,"historySize":60,
+} snapshot_t;
+
+static snapshot_t snapshots[SNAPSHOT_BUFFERS];
+static atomic_int snapshot_current = -1;
+static atomic_int snapshot_readers[SNAPSHOT_BUFFERS];
+
+// Called by sensor_task after every sample
+static void snapshot_publish(void) {
+    int current = atomic_load(&snapshot_current);
+    int slot = -1;
+    for (int i = 0; i < SNAPSHOT_BUFFERS; i++) {
+        if (i != current && atomic_load(&snapshot_readers[i]) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return;  // A reader is still copying; the next tick publishes instead
+    }
     
-    char time_str[32];  // Larger buffer to avoid compiler warnings
-    snprintf(time_str, sizeof(time_str), "    %02lu:%02lu:%02lu    ", hours, minutes, secs);
+    snapshot_t *snap = &snapshots[slot];
+    snap->seq = history_seq(HISTORY_RES_SECOND);
+    snap->oldest_seq = snap->seq - history_count(HISTORY_RES_SECOND) + 1;
+    char *p = snap->live;
+    p = PUT_LIT(p, "{\"temperature\":");
+    p = put_deci(p, desk.temperature);
+    p = PUT_LIT(p, ",\"temperatureF\":");
+    p = put_deci(p, temperatureF);
+    p = PUT_LIT(p, ",\"humidity\":");
+    p = put_deci(p, desk.humidity);
+    p = PUT_LIT(p, ",\"ldrValue\":");
+    p = put_i32(p, ldrValue);
+    p = PUT_LIT(p, ",\"ldrMillivolts\":");
+    p = put_u32(p, ldrMillivolts);
+    p = PUT_LIT(p, ",\"lightPercentage\":");
+    p = put_deci(p, desk.light);
+    p = PUT_LIT(p, ",\"motionDetected\":");
+    p = put_bool(p, desk.motion_detected);
+    p = PUT_LIT(p, ",\"motionCount\":");
+    p = put_u32(p, desk.motion_count);
+    // Latest debounced edges as [time_us, level], on the uptimeUs clock
+    motion_edge_t edges[MOTION_RECENT_LEN];
+    size_t edge_count = motion_recent(edges, MOTION_RECENT_LEN);
+    p = PUT_LIT(p, ",\"motionEvents\":[");
+    for (size_t i = 0; i < edge_count; i++) {
+        p = PUT_LIT(p, "[");
+        p = put_u64(p, edges[i].time_us);
+        p = edges[i].level ? PUT_LIT(p, ",1]") : PUT_LIT(p, ",0]");
+        if (i + 1 < edge_count) {
+            *p++ = ',';
+        }
+    }
+    p = PUT_LIT(p, "],\"uptimeUs\":");
+    p = put_u64(p, esp_timer_get_time());
+    p = PUT_LIT(p, ",\"ledOn\":");
+    p = put_bool(p, desk.led_on);
+    p = PUT_LIT(p, ",\"buzzerOn\":");
+    p = put_bool(p, desk.buzzer_on);
+    p = PUT_LIT(p, ",\"fanSpeed\":");
+    p = put_u32(p, desk.fan_duty);
+    p = PUT_LIT(p, ",\"sessionActive\":");
+    p = put_bool(p, desk.session_active);
+    p = PUT_LIT(p, ",\"sessionSeconds\":");
+    p = put_u32(p, desk.session_s);
+    p = PUT_LIT(p, ",\"dhtReads\":");
+    p = put_u32(p, dhtReads);
+    p = PUT_LIT(p, ",\"dhtFailures\":");
+    p = put_u32(p, dhtFailures);
+    lcd_stats_t lcd;
+    lcd_get_stats(&lcd);
+    p = PUT_LIT(p, ",\"lcdTransactions\":");
+    p = put_u32(p, lcd.transactions);
+    p = PUT_LIT(p, ",\"lcdBytes\":");
+    p = put_u32(p, lcd.bytes);
+    p = PUT_LIT(p, ",\"sampleMaxUs\":");
+    p = put_u32(p, sampleMaxUs);
+    p = PUT_LIT(p, ",\"envStats\":{");
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        *p++ = '"';
+        p = put_bytes(p, env_channel_names[c], strlen(env_channel_names[c]));
+        p = PUT_LIT(p, "\":");
+        p = envstats_put_json(p, &envStats[c]);
+        *p++ = c + 1 < HISTORY_CHANNELS ? ',' : '}';
+    }
+    p = PUT_LIT(p, ",\"seq\":");
+    p = put_u32(p, snap->seq);
+    p = PUT_LIT(p, ",\"historySize\":");
+    p = put_u32(p, HISTORY_SIZE);
+    *p++ = ',';
+    snap->live_len = p - snap->live;
     
-    lcd_set_cursor(0, 1);
-    lcd_print_line(time_str);
+    atomic_store(&snapshot_current, slot);
 }
 
-// Fan PWM Functions
-static void fan_init(void) {
-    // Configure PWM timer
-    ledc_timer_config_t ledc_timer = {
-        .speed_mode       = FAN_PWM_MODE,
-        .timer_num        = FAN_PWM_TIMER,
-        .duty_resolution  = FAN_PWM_DUTY_RES,
-        .freq_hz          = FAN_PWM_FREQUENCY,
-        .clk_cfg          = LEDC_AUTO_CLK
-    };
-    ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
-    
-    // Configure PWM channel
-    ledc_channel_config_t ledc_channel = {
-        .speed_mode     = FAN_PWM_MODE,
-        .channel        = FAN_PWM_CHANNEL,
-        .timer_sel      = FAN_PWM_TIMER,
-        .intr_type      = LEDC_INTR_DISABLE,
-        .gpio_num       = FAN_PIN,
-        .duty           = 0,  // Start with fan off
-        .hpoint         = 0
-    };
-    ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
-    
-    ESP_LOGI(TAG, "Fan PWM initialized on GPIO %d", FAN_PIN);
-}
-
-static void fan_set_speed(float temp_celsius) {
-    // Calculate fan speed based on temperature
-    // Temperature ranges:
-    // < 20°C: Fan off (0%)
-    // 20-25°C: Fan low (30%)
-    // 25-30°C: Fan medium (60%)
-    // 30-35°C: Fan high (85%)
-    // > 35°C: Fan max (100%)
-    
-    uint32_t duty = 0;
-    
-    if (temp_celsius < 20.0) {
-        duty = 0;  // Fan off
-    } else if (temp_celsius < 25.0) {
-        // Linear interpolation: 20°C=30%, 25°C=60%
-        duty = (uint32_t)(76 + (temp_celsius - 20.0) * 15.3);  // 30%-60%
-    } else if (temp_celsius < 30.0) {
-        // Linear interpolation: 25°C=60%, 30°C=85%
-        duty = (uint32_t)(153 + (temp_celsius - 25.0) * 12.75);  // 60%-85%
-    } else if (temp_celsius < 35.0) {
-        // Linear interpolation: 30°C=85%, 35°C=100%
-        duty = (uint32_t)(217 + (temp_celsius - 30.0) * 7.6);  // 85%-100%
-    } else {
-        duty = 255;  // Fan max
-    }
-    
-    // Set PWM duty cycle
-    ESP_ERROR_CHECK(ledc_set_duty(FAN_PWM_MODE, FAN_PWM_CHANNEL, duty));
-    ESP_ERROR_CHECK(ledc_update_duty(FAN_PWM_MODE, FAN_PWM_CHANNEL));
-    
-    // Store fan speed for dashboard
-    fanSpeed = (uint8_t)duty;
-    
-    ESP_LOGI(TAG, "Fan speed set to %lu/255 (%.1f%%) for temp %.1f°C", 
-             duty, (duty * 100.0 / 255.0), temp_celsius);
-}
-
-// WiFi event group
-
-// HTML dashboard (truncated for size - same as before)
-static const char* html_page_part1 = 
-"<!DOCTYPE html><html><head><meta charset=\"UTF-8\">"
-"<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">"
-"<title>ESP32 Sensor Dashboard</title>"
-"<script src=\"https://cdn.jsdelivr.net/npm/chart.js@4.4.0/dist/chart.umd.min.js\"></script>"
-"<style>"
-"*{margin:0;padding:0;box-sizing:border-box;}"
-"body{font-family:'Segoe UI',Tahoma,Geneva,Verdana,sans-serif;"
-"background:linear-gradient(135deg,#667eea 0%,#764ba2 100%);"
-"min-height:100vh;padding:20px;}"
-".container{max-width:1400px;margin:0 auto;}"
-"h1{text-align:center;color:white;margin-bottom:30px;font-size:2.5em;"
-"text-shadow:2px 2px 4px rgba(0,0,0,0.3);}"
-".dashboard{display:grid;grid-template-columns:repeat(auto-fit,minmax(250px,1fr));"
-"gap:20px;margin-bottom:30px;}"
-".card{background:white;border-radius:15px;padding:20px;"
-"box-shadow:0 10px 30px rgba(0,0,0,0.3);transition:transform 0.3s ease;}"
-".card:hover{transform:translateY(-5px);}"
-".card-header{display:flex;align-items:center;margin-bottom:10px;}"
-".icon{font-size:2em;margin-right:10px;}"
-".card-title{font-size:1em;color:#555;font-weight:600;}"
-".card-value{font-size:2em;font-weight:bold;color:#333;margin:10px 0;}"
-".card-unit{font-size:0.5em;color:#888;font-weight:normal;}"
-".status-badge{display:inline-block;padding:5px 15px;border-radius:20px;"
-"font-size:0.9em;font-weight:600;margin-top:5px;}"
-".status-on{background:#4ade80;color:white;}"
-".status-off{background:#94a3b8;color:white;}"
-".charts{display:grid;grid-template-columns:repeat(auto-fit,minmax(400px,1fr));"
-"gap:20px;margin-top:20px;}"
-".chart-container{background:white;border-radius:15px;padding:20px;"
-"box-shadow:0 10px 30px rgba(0,0,0,0.3);}"
-".chart-title{font-size:1.2em;color:#333;font-weight:600;margin-bottom:15px;"
-"text-align:center;}"
-".status{text-align:center;color:white;font-size:0.9em;margin-top:20px;}"
-"canvas{max-height:300px;}"
-"</style></head><body><div class=\"container\">"
-"<h1>🌡 ESP32 Sensor Dashboard</h1><div class=\"dashboard\">";
-
-static const char* html_page_part2 = 
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">🌡</div>"
-"<div class=\"card-title\">Temperature</div></div>"
-"<div class=\"card-value\"><span id=\"temp\">--</span><span class=\"card-unit\">°C</span></div></div>"
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">💧</div>"
-"<div class=\"card-title\">Humidity</div></div>"
-"<div class=\"card-value\"><span id=\"humid\">--</span><span class=\"card-unit\">%</span></div></div>"
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">💡</div>"
-"<div class=\"card-title\">Light Level</div></div>"
-"<div class=\"card-value\"><span id=\"light\">--</span><span class=\"card-unit\">%</span></div></div>"
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">🚶</div>"
-"<div class=\"card-title\">Motion</div></div>"
-"<div class=\"card-value\"><span id=\"motion\">--</span></div></div>"
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">💡</div>"
-"<div class=\"card-title\">LED Status</div></div>"
-"<span id=\"led\" class=\"status-badge status-off\">OFF</span></div>"
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">🔔</div>"
-"<div class=\"card-title\">Buzzer</div></div>"
-"<span id=\"buzzer\" class=\"status-badge status-off\">OFF</span></div>"
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">🌀</div>"
-"<div class=\"card-title\">Fan Speed</div></div>"
-"<div class=\"card-value\"><span id=\"fan\">--</span><span class=\"card-unit\">%</span></div></div>"
-"<div class=\"card\"><div class=\"card-header\"><div class=\"icon\">⏱</div>"
-"<div class=\"card-title\">Session Time</div></div>"
-"<div class=\"card-value\"><span id=\"session\">00:00:00</span></div></div>"
-"</div><div class=\"charts\">"
-"<div class=\"chart-container\"><div class=\"chart-title\">📈 Temperature History</div>"
-"<canvas id=\"tempChart\"></canvas></div>"
-"<div class=\"chart-container\"><div class=\"chart-title\">💧 Humidity History</div>"
-"<canvas id=\"humidChart\"></canvas></div>"
-"<div class=\"chart-container\"><div class=\"chart-title\">💡 Light Level History</div>"
-"<canvas id=\"lightChart\"></canvas></div>"
-"<div class=\"chart-container\"><div class=\"chart-title\">🚶 Motion Events</div>"
-"<canvas id=\"motionChart\"></canvas></div>"
-"</div><div class=\"status\"><div id=\"status\">● Connected</div></div></div>"
-"<script>"
-"let tempChart,humidChart,lightChart,motionChart;"
-"function initCharts(){"
-"const commonOpts={responsive:true,maintainAspectRatio:true,"
-"scales:{y:{beginAtZero:true},x:{display:false}},"
-"plugins:{legend:{display:false}}};"
-"tempChart=new Chart(document.getElementById('tempChart'),{"
-"type:'line',data:{labels:[],datasets:[{label:'Temp (°C)',"
-"data:[],borderColor:'#ef4444',backgroundColor:'rgba(239,68,68,0.1)',"
-"tension:0.4,fill:true}]},options:commonOpts});"
-"humidChart=new Chart(document.getElementById('humidChart'),{"
-"type:'line',data:{labels:[],datasets:[{label:'Humidity (%)',"
-"data:[],borderColor:'#3b82f6',backgroundColor:'rgba(59,130,246,0.1)',"
-"tension:0.4,fill:true}]},options:commonOpts});"
-"lightChart=new Chart(document.getElementById('lightChart'),{"
-"type:'line',data:{labels:[],datasets:[{label:'Light (%)',"
-"data:[],borderColor:'#fbbf24',backgroundColor:'rgba(251,191,36,0.1)',"
-"tension:0.4,fill:true}]},options:commonOpts});"
-"motionChart=new Chart(document.getElementById('motionChart'),{"
-"type:'bar',data:{labels:[],datasets:[{label:'Motion Detected',"
-"data:[],backgroundColor:'#10b981'}]},options:commonOpts});}"
-"function updateCharts(data){"
-"const labels=Array.from({length:data.historyCount},(_,i)=>i);"
-"tempChart.data.labels=labels;tempChart.data.datasets[0].data=data.tempHistory;tempChart.update('none');"
-"humidChart.data.labels=labels;humidChart.data.datasets[0].data=data.humidHistory;humidChart.update('none');"
-"lightChart.data.labels=labels;lightChart.data.datasets[0].data=data.lightHistory;lightChart.update('none');"
-"motionChart.data.labels=labels;motionChart.data.datasets[0].data=data.motionHistory;motionChart.update('none');}"
-"function formatTime(secs){"
-"const h=Math.floor(secs/3600);const m=Math.floor((secs%3600)/60);const s=secs%60;"
-"return String(h).padStart(2,'0')+':'+String(m).padStart(2,'0')+':'+String(s).padStart(2,'0');}"
-"function update(){fetch('/data').then(r=>r.json()).then(d=>{"
-"document.getElementById('temp').textContent=d.temperature.toFixed(1);"
-"document.getElementById('humid').textContent=d.humidity.toFixed(1);"
-"document.getElementById('light').textContent=d.lightPercentage.toFixed(1);"
-"document.getElementById('motion').textContent=d.motionDetected?'🔴 MOTION':'🟢 No Motion';"
-"const ledEl=document.getElementById('led');"
-"ledEl.textContent=d.ledOn?'ON':'OFF';"
-"ledEl.className='status-badge '+(d.ledOn?'status-on':'status-off');"
-"const buzzEl=document.getElementById('buzzer');"
-"buzzEl.textContent=d.buzzerOn?'ALERT':'OFF';"
-"buzzEl.className='status-badge '+(d.buzzerOn?'status-on':'status-off');"
-"document.getElementById('fan').textContent=Math.round((d.fanSpeed/255)*100);"
-"document.getElementById('session').textContent=formatTime(d.sessionSeconds);"
-"updateCharts(d);"
-"document.getElementById('status').textContent='● Connected';}).catch(e=>{"
-"document.getElementById('status').textContent='● Error';});}initCharts();update();setInterval(update,2000);"
-"</script></body></html>";
-
-// DHT22 timing and reading functions (bit-banging)
-#define DHT_TIMEOUT_US 1000
-
-static inline void dht_delay_us(uint32_t us) {
-    esp_rom_delay_us(us);
-}
-
-static bool dht22_read(gpio_num_t pin, float *temp, float *humid) {
-    uint8_t data[5] = {0};
-    
-    // Send start signal
-    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
-    gpio_set_level(pin, 0);
-    dht_delay_us(1000);
-    gpio_set_level(pin, 1);
-    dht_delay_us(30);
-    
-    // Wait for response
-    gpio_set_direction(pin, GPIO_MODE_INPUT);
-    
-    // Wait for low
-    uint32_t timeout = 100;
-    while (gpio_get_level(pin) == 1 && timeout--) dht_delay_us(1);
-    if (timeout == 0) return false;
-    
-    // Wait for high
-    timeout = 100;
-    while (gpio_get_level(pin) == 0 && timeout--) dht_delay_us(1);
-    if (timeout == 0) return false;
-    
-    // Wait for low
-    timeout = 100;
-    while (gpio_get_level(pin) == 1 && timeout--) dht_delay_us(1);
-    if (timeout == 0) return false;
-    
-    // Read 40 bits
-    for (int i = 0; i < 40; i++) {
-        // Wait for high
-        timeout = 100;
-        while (gpio_get_level(pin) == 0 && timeout--) dht_delay_us(1);
-        if (timeout == 0) return false;
-        
-        dht_delay_us(30);
-        
-        if (gpio_get_level(pin) == 1) {
-            data[i / 8] |= (1 << (7 - (i % 8)));
+static const snapshot_t *snapshot_acquire(int *slot) {
+    while (1) {
+        int i = atomic_load(&snapshot_current);
+        if (i < 0) {
+            return NULL;
         }
-        
-        // Wait for low
-        timeout = 100;
-        while (gpio_get_level(pin) == 1 && timeout--) dht_delay_us(1);
+        atomic_fetch_add(&snapshot_readers[i], 1);
+        // Only trust the pin if the buffer was still current after taking it
+        if (atomic_load(&snapshot_current) == i) {
+            *slot = i;
+            return &snapshots[i];
+        }
+        atomic_fetch_sub(&snapshot_readers[i], 1);
+    }
+}
+
+static void snapshot_release(int slot) {
+    atomic_fetch_sub(&snapshot_readers[slot], 1);
+}
+
+// Start of a /data body for samples from first_seq: the live values and
+// firstSeq. Writes at most DATA_LIVE_MAX bytes.
+static char *data_put_live(char *p, const snapshot_t *snap, uint32_t first_seq) {
+    p = put_bytes(p, snap->live, snap->live_len);
+    p = PUT_LIT(p, "\"firstSeq\":");
+    p = put_u32(p, first_seq);
+    *p++ = ',';
+    return p;
+}
+
+// Handlers that assemble a response borrow a buffer from the pool and wait
+// this long for one before giving up with 503. Streamed responses use it
+// as their window (json_stream.h).
+#define RESP_WAIT_MS         250
+
+_Static_assert(DATA_LIVE_MAX + 32 <= RESP_POOL_BUF_SIZE, "an event's live values must fit one window");
+
+typedef struct {
+    httpd_req_t *req;
+    uint32_t send_us;
+} resp_sink_t;
+
+static bool resp_chunk_sink(void *ctx, const char *buf, size_t len) {
+    resp_sink_t *sink = ctx;
+    int64_t start = esp_timer_get_time();
+    bool ok = httpd_resp_send_chunk(sink->req, buf, len) == ESP_OK;
+    sink->send_us += (uint32_t)(esp_timer_get_time() - start);
+    return ok;
+}
+
+// Finish a response streamed through resp_chunk_sink. A body that never
+// outgrew the window goes out in one piece with a Content-Length, so small
+// ?since polls stay a single send; a longer one ends with its last chunks.
+static esp_err_t resp_stream_end(resp_sink_t *sink, json_stream_t *js) {
+    if (js->failed) {
+        return ESP_FAIL;
+    }
+    if (js->flushes == 0) {
+        int64_t start = esp_timer_get_time();
+        esp_err_t ret = httpd_resp_send(sink->req, js->window, js->p - js->window);
+        sink->send_us += (uint32_t)(esp_timer_get_time() - start);
+        return ret;
+    }
+    if (!json_stream_flush(js)) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(sink->req, NULL, 0);
+}
+
+static esp_err_t resp_busy(httpd_req_t *req) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_hdr(req, "Retry-After", "1");
+    return httpd_resp_send(req, "Server busy", HTTPD_RESP_USE_STRLEN);
+}
+
+// Request workers. Handlers registered through http_offload run on one of
+// HTTP_WORKERS tasks via the async request API: the server task hands the
+// request over and goes back to select(), so a client that reads slowly
+// holds up one worker rather than every connection. A socket has at most
+// one request out at a time, so the job queue holds one per socket.
+#define HTTP_WORKERS         2
+#define HTTP_MAX_SOCKETS     12
+#define HTTP_JOB_QUEUE_LEN   HTTP_MAX_SOCKETS
+
+typedef struct {
+    esp_err_t (*handler)(httpd_req_t *req);
+} http_offload_t;
+
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t (*handler)(httpd_req_t *req);
+} http_job_t;
+
+static QueueHandle_t httpJobs;
+static atomic_uint httpRejected;
+
+static void http_worker(void *arg) {
+    http_job_t job;
+    while (1) {
+        xQueueReceive(httpJobs, &job, portMAX_DELAY);
+        // Same contract as a handler on the server task: failure closes
+        if (job.handler(job.req) != ESP_OK) {
+            httpd_sess_trigger_close(job.req->handle, httpd_req_to_sockfd(job.req));
+        }
+        httpd_req_async_handler_complete(job.req);
+    }
+}
+
+static esp_err_t http_offload(httpd_req_t *req) {
+    const http_offload_t *offload = req->user_ctx;
+    http_job_t job = { .handler = offload->handler };
+    if (httpd_req_async_handler_begin(req, &job.req) != ESP_OK) {
+        return offload->handler(req);
+    }
+    if (xQueueSend(httpJobs, &job, 0) != pdTRUE) {
+        atomic_fetch_add(&httpRejected, 1);
+        resp_busy(job.req);
+        httpd_req_async_handler_complete(job.req);
+    }
+    return ESP_OK;
+}
+
+static void http_workers_start(void) {
+    httpJobs = xQueueCreate(HTTP_JOB_QUEUE_LEN, sizeof(http_job_t));
+    for (int i = 0; i < HTTP_WORKERS; i++) {
+        char name[12] = "httpd_w0";
+        name[7] = (char)('0' + i);
+        xTaskCreatePinnedToCore(http_worker, name, 6144, NULL, 5, NULL, NET_CORE);
+    }
+}
+
+static esp_err_t data_handler(httpd_req_t *req) {
+    // Optional ?since=<seq>: only send samples newer than the client's last one
+    uint32_t since = 0;
+    char query[32];
+    char value[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+        since = strtoul(value, NULL, 10);
     }
     
-    // Verify checksum
-    if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF)) {
-        return false;
+    char *buf = resp_pool_take(RESP_WAIT_MS);
+    if (buf == NULL) {
+        return resp_busy(req);
+    }
+    int slot;
+    const snapshot_t *snap = snapshot_acquire(&slot);
+    if (snap == NULL) {
+        resp_pool_give(buf);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
     }
     
-    // Convert to values
-    *humid = ((data[0] << 8) | data[1]) / 10.0;
-    *temp = (((data[2] & 0x7F) << 8) | data[3]) / 10.0;
-    if (data[2] & 0x80) *temp = -*temp;
+    // A since outside the ring (too old, or from before a reboot) gets the
+    // full history; the client detects the gap from firstSeq and redraws
+    uint32_t first_seq = snap->oldest_seq;
+    uint32_t last_seq = snap->seq;
+    if (since >= snap->oldest_seq && since <= snap->seq) {
+        first_seq = since + 1;
+    }
+    int64_t start = esp_timer_get_time();
+    resp_sink_t sink = { .req = req };
+    json_stream_t js;
+    json_stream_init(&js, buf, RESP_POOL_BUF_SIZE, resp_chunk_sink, &sink);
+    httpd_resp_set_type(req, "application/json");
+    json_stream_commit(&js, data_put_live(json_stream_room(&js, DATA_LIVE_MAX), snap, first_seq));
+    snapshot_release(slot);
     
+    // A series that fails part way, on a send or on rows overwritten since
+    // the snapshot, leaves the stream failed and resp_stream_end() returns
+    // ESP_FAIL. The headers may already be out, so closing the connection
+    // is the only way left to tell the client.
+    if (series_json_write(&js, first_seq, last_seq)) {
+        JSON_STREAM_LIT(&js, "}");
+    }
+    esp_err_t ret = resp_stream_end(&sink, &js);
+    resp_pool_give(buf);
+    // Encoding and sending interleave; whatever was not spent in a send
+    // was spent encoding
+    uint32_t total_us = (uint32_t)(esp_timer_get_time() - start);
+    metrics_observe(METRICS_DATA_JSON, total_us - sink.send_us);
+    metrics_observe(METRICS_DATA_SEND, sink.send_us);
+    return ret;
+}
+
+// /history?res=1s|1m|1h&since=<seq>: min/avg/max rows from one history tier.
+// /history?from=<seq>&to=<seq>&step=<n>: samples from the flash log, averaged
+// over step samples. A day of rows is far larger than any static buffer, so
+// rows are read in small batches and streamed through a pool buffer.
+#define HISTORY_BATCH_ROWS   16
+#define HISTORY_ROW_MAX      96   // 9 deci values, motion and separators
+
+static const char *const history_res_names[HISTORY_RES_COUNT] = { "1s", "1m", "1h" };
+
+#define HISTORY_MAX_STEP     86400
+
+// Streaming state for one flash range response
+typedef struct {
+    json_stream_t *js;
+    uint32_t from;
+    uint32_t step;
+    uint32_t count;
+    // Current step window
+    uint32_t win_seq;
+    uint16_t win_boot;
+    uint32_t win_samples;
+    uint32_t win_motion;
+    int32_t win_sum[HISTORY_CHANNELS];
+} history_stream_t;
+
+static bool history_stream_row(history_stream_t *st) {
+    char *p = json_stream_room(st->js, HISTORY_ROW_MAX);
+    if (p == NULL) {
+        return false;
+    }
+    if (st->count > 0) {
+        *p++ = ',';
+    }
+    *p++ = '[';
+    p = put_u32(p, st->win_seq);
+    *p++ = ',';
+    p = put_u32(p, st->win_boot);
+    int32_t n = (int32_t)st->win_samples;
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        int32_t sum = st->win_sum[c];
+        *p++ = ',';
+        p = put_deci(p, (sum + (sum < 0 ? -n / 2 : n / 2)) / n);
+    }
+    *p++ = ',';
+    p = put_u32(p, (st->win_motion * 100 + st->win_samples / 2) / st->win_samples);
+    *p++ = ']';
+    json_stream_commit(st->js, p);
+    st->count++;
     return true;
 }
 
-// WiFi event handler
-static void wifi_event_handler(void* arg, esp_event_base_t event_base,
-                               int32_t event_id, void* event_data) {
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
-        ESP_LOGI(TAG, "WiFi connecting...");
-    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (wifi_retry_count < MAX_WIFI_RETRY) {
-            esp_wifi_connect();
-            wifi_retry_count++;
-            ESP_LOGI(TAG, "Disconnected, retry attempt %d/%d", wifi_retry_count, MAX_WIFI_RETRY);
-        } else {
-            ESP_LOGI(TAG, "Max retry reached, waiting 10s before retry...");
-            vTaskDelay(pdMS_TO_TICKS(10000));
-            wifi_retry_count = 0;
-            esp_wifi_connect();
-        }
-        xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT);
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        ESP_LOGI(TAG, "========================================");
-        ESP_LOGI(TAG, "WiFi Connected!");
-        ESP_LOGI(TAG, "IP Address: " IPSTR, IP2STR(&event->ip_info.ip));
-        ESP_LOGI(TAG, "Dashboard URL: http://" IPSTR, IP2STR(&event->ip_info.ip));
-        ESP_LOGI(TAG, "========================================");
-        wifi_retry_count = 0;
-        xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
-    }
-}
-
-// Initialize WiFi
-static void wifi_init(void) {
-    wifi_event_group = xEventGroupCreate();
-    
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-    
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    
-    // Set WiFi power save mode to NONE for stable connection
-    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
-    
-    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
-    
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = WIFI_SSID,
-            .password = WIFI_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
+static bool history_stream_sample(const flashlog_sample_t *sample, void *ctx) {
+    history_stream_t *st = ctx;
+    uint32_t win_seq = sample->seq - (sample->seq - st->from) % st->step;
+    if (st->win_samples > 0 && win_seq != st->win_seq) {
+        if (!history_stream_row(st)) {
+            return false;
+        }
+        st->win_samples = 0;
+    }
+    if (st->win_samples == 0) {
+        st->win_seq = win_seq;
+        st->win_boot = sample->boot;
+        st->win_motion = 0;
+        memset(st->win_sum, 0, sizeof(st->win_sum));
+    }
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        st->win_sum[c] += sample->values[c];
+    }
+    st->win_motion += sample->motion ? 1 : 0;
+    st->win_samples++;
+    return true;
+}
+
+static esp_err_t history_flash_send(httpd_req_t *req, const char *query, char *buf) {
+    uint32_t first, last;
+    if (flashlog_range(&first, &last) != ESP_OK) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_send(req, "Flash log unavailable", HTTPD_RESP_USE_STRLEN);
+        return ESP_OK;
+    }
+    char value[12];
+    uint32_t from = first;
+    uint32_t to = last;
+    uint32_t step = 1;
+    if (httpd_query_key_value(query, "from", value, sizeof(value)) == ESP_OK) {
+        from = strtoul(value, NULL, 10);
+    }
+    if (httpd_query_key_value(query, "to", value, sizeof(value)) == ESP_OK) {
+        to = strtoul(value, NULL, 10);
+    }
+    if (httpd_query_key_value(query, "step", value, sizeof(value)) == ESP_OK) {
+        step = strtoul(value, NULL, 10);
+    }
+    if (step == 0 || step > HISTORY_MAX_STEP) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "step must be 1-86400");
+        return ESP_OK;
+    }
+    if (from < first) from = first;
+    if (to > last) to = last;
     
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
+    resp_sink_t sink = { .req = req };
+    json_stream_t js;
+    json_stream_init(&js, buf, RESP_POOL_BUF_SIZE, resp_chunk_sink, &sink);
+    history_stream_t st = { .js = &js, .from = from, .step = step };
+    httpd_resp_set_type(req, "application/json");
+    char *p = PUT_LIT(buf, "{\"from\":");
+    p = put_u32(p, from);
+    p = PUT_LIT(p, ",\"to\":");
+    p = put_u32(p, to);
+    p = PUT_LIT(p, ",\"step\":");
+    p = put_u32(p, step);
+    p = PUT_LIT(p, ",\"firstSeq\":");
+    p = put_u32(p, first);
+    p = PUT_LIT(p, ",\"lastSeq\":");
+    p = put_u32(p, last);
+    p = PUT_LIT(p, ",\"columns\":[\"seq\",\"boot\",\"temperature\",\"humidity\",\"light\",\"motion\"],\"rows\":[");
+    json_stream_commit(&js, p);
     
-    ESP_LOGI(TAG, "WiFi initialized, connecting to %s", WIFI_SSID);
+    if (from <= to) {
+        flashlog_read(from, to, history_stream_sample, &st);
+        if (!js.failed && st.win_samples > 0) {
+            history_stream_row(&st);
+        }
+    }
+    p = json_stream_room(&js, 32);
+    if (p == NULL) {
+        return ESP_FAIL;
+    }
+    p = PUT_LIT(p, "],\"count\":");
+    p = put_u32(p, st.count);
+    *p++ = '}';
+    json_stream_commit(&js, p);
+    return resp_stream_end(&sink, &js);
 }
 
-// HTTP handlers
-static esp_err_t root_handler(httpd_req_t *req) {
-    httpd_resp_send_chunk(req, html_page_part1, strlen(html_page_part1));
-    httpd_resp_send_chunk(req, html_page_part2, strlen(html_page_part2));
-    httpd_resp_send_chunk(req, NULL, 0);
-    return ESP_OK;
+static esp_err_t history_send(httpd_req_t *req, char *buf) {
+    history_res_t res = HISTORY_RES_MINUTE;
+    uint32_t since = 0;
+    char query[64];
+    char value[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "from", value, sizeof(value)) == ESP_OK ||
+            httpd_query_key_value(query, "to", value, sizeof(value)) == ESP_OK ||
+            httpd_query_key_value(query, "step", value, sizeof(value)) == ESP_OK) {
+            return history_flash_send(req, query, buf);
+        }
+        if (httpd_query_key_value(query, "res", value, sizeof(value)) == ESP_OK) {
+            res = HISTORY_RES_COUNT;
+            for (int r = 0; r < HISTORY_RES_COUNT; r++) {
+                if (strcmp(value, history_res_names[r]) == 0) {
+                    res = r;
+                }
+            }
+            if (res == HISTORY_RES_COUNT) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "res must be 1s, 1m or 1h");
+                return ESP_OK;
+            }
+        }
+        if (httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+            since = strtoul(value, NULL, 10);
+        }
+    }
+    
+    // Same contract as /data: a since the tier no longer holds (or one from
+    // before a reboot) gets everything, and firstSeq tells the client so
+    uint32_t seq = history_seq(res);
+    uint32_t first_seq = seq - history_count(res) + 1;
+    if (since >= first_seq && since <= seq) {
+        first_seq = since + 1;
+    }
+    
+    resp_sink_t sink = { .req = req };
+    json_stream_t js;
+    json_stream_init(&js, buf, RESP_POOL_BUF_SIZE, resp_chunk_sink, &sink);
+    httpd_resp_set_type(req, "application/json");
+    char *p = PUT_LIT(buf, "{\"res\":\"");
+    p = put_bytes(p, history_res_names[res], 2);
+    p = PUT_LIT(p, "\",\"period\":");
+    p = put_u32(p, history_period_s(res));
+    p = PUT_LIT(p, ",\"seq\":");
+    p = put_u32(p, seq);
+    p = PUT_LIT(p, ",\"firstSeq\":");
+    p = put_u32(p, first_seq);
+    p = PUT_LIT(p, ",\"columns\":[\"tMin\",\"tAvg\",\"tMax\",\"hMin\",\"hAvg\",\"hMax\","
+                   "\"lMin\",\"lAvg\",\"lMax\",\"motion\"],\"rows\":[");
+    json_stream_commit(&js, p);
+    
+    // Stop at the seq advertised in the header even if the tier moves on
+    history_row_t rows[HISTORY_BATCH_ROWS];
+    uint32_t count = 0;
+    uint32_t next = first_seq;
+    while (next <= seq) {
+        size_t want = seq - next + 1;
+        uint32_t batch_first = next;
+        size_t n = history_read(res, &batch_first, rows,
+                                want < HISTORY_BATCH_ROWS ? want : HISTORY_BATCH_ROWS);
+        if (n == 0 || batch_first > seq) {
+            break;
+        }
+        for (size_t i = 0; i < n && batch_first + i <= seq; i++) {
+            p = json_stream_room(&js, HISTORY_ROW_MAX);
+            if (p == NULL) {
+                return ESP_FAIL;
+            }
+            if (count > 0) {
+                *p++ = ',';
+            }
+            *p++ = '[';
+            for (int c = 0; c < HISTORY_CHANNELS; c++) {
+                p = put_deci(p, rows[i].min[c]);
+                *p++ = ',';
+                p = put_deci(p, rows[i].avg[c]);
+                *p++ = ',';
+                p = put_deci(p, rows[i].max[c]);
+                *p++ = ',';
+            }
+            p = put_u32(p, rows[i].motion_pct);
+            *p++ = ']';
+            json_stream_commit(&js, p);
+            count++;
+        }
+        next = batch_first + n;
+    }
+    
+    p = json_stream_room(&js, 32);
+    if (p == NULL) {
+        return ESP_FAIL;
+    }
+    p = PUT_LIT(p, "],\"count\":");
+    p = put_u32(p, count);
+    *p++ = '}';
+    json_stream_commit(&js, p);
+    return resp_stream_end(&sink, &js);
 }
 
-static esp_err_t data_handler(httpd_req_t *req) {
-    // Allocate JSON buffer on heap to avoid stack overflow
-    char *json = (char*)malloc(4096);
-    if (json == NULL) {
-        httpd_resp_send_500(req);
+static esp_err_t history_handler(httpd_req_t *req) {
+    char *buf = resp_pool_take(RESP_WAIT_MS);
+    if (buf == NULL) {
+        return resp_busy(req);
+    }
+    esp_err_t ret = history_send(req, buf);
+    resp_pool_give(buf);
+    return ret;
+}
+
+// Server-sent events: /events keeps the socket open and receives one event
+// per sample. sensor_task queues sse_broadcast on the server task after each
+// publish; the subscriber table is only touched from the server task
+// (handler, work and close callbacks), so it needs no lock.
+#define MAX_SSE_CLIENTS   4
+
+typedef struct {
+    int fd;
+    uint32_t seq;  // Last sample sent on this stream
+} sse_client_t;
+
+static httpd_handle_t server = NULL;
+static sse_client_t sse_clients[MAX_SSE_CLIENTS] = {{-1, 0}, {-1, 0}, {-1, 0}, {-1, 0}};
+
+static esp_err_t events_handler(httpd_req_t *req) {
+    int slot = -1;
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        if (sse_clients[i].fd < 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        // The page falls back to polling /data until a slot frees up
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_send(req, "Too many event streams", HTTPD_RESP_USE_STRLEN);
+        return ESP_OK;
+    }
+    
+    static const char hdr[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n\r\n"
+        "retry: 2000\n\n";
+    if (httpd_send(req, hdr, sizeof(hdr) - 1) != sizeof(hdr) - 1) {
         return ESP_FAIL;
     }
+    sse_clients[slot].fd = httpd_req_to_sockfd(req);
+    sse_clients[slot].seq = 0;
+    ESP_LOGI(TAG, "Event stream opened on socket %d", sse_clients[slot].fd);
+    return ESP_OK;
+}
+
+// Called by the server whenever it closes a session
+static void session_close(httpd_handle_t hd, int sockfd) {
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        if (sse_clients[i].fd == sockfd) {
+            sse_clients[i].fd = -1;
+            ESP_LOGI(TAG, "Event stream closed on socket %d", sockfd);
+        }
+    }
+    close(sockfd);
+}
+
+static bool sse_overflow(void *ctx, const char *buf, size_t len) {
+    return false;
+}
+
+static void sse_broadcast(void *arg) {
+    int slot;
+    const snapshot_t *snap = snapshot_acquire(&slot);
+    if (snap == NULL) {
+        return;
+    }
     
-    // Build JSON with current status and historical data
-    int len = snprintf(json, 4096,
-        "{\"temperature\":%.1f,\"temperatureF\":%.1f,\"humidity\":%.1f,"
-        "\"ldrValue\":%d,\"lightPercentage\":%.1f,"
-        "\"motionDetected\":%s,\"motionCount\":%d,"
-        "\"ledOn\":%s,\"buzzerOn\":%s,\"fanSpeed\":%d,"
-        "\"sessionActive\":%s,\"sessionSeconds\":%lu,"
-        "\"tempHistory\":[",
-        temperature, temperatureF, humidity, ldrValue, lightPercentage,
-        motionDetected ? "true" : "false", motionCount,
-        ledOn ? "true" : "false", buzzerOn ? "true" : "false", fanSpeed,
-        sessionActive ? "true" : "false", sessionSeconds);
+    // Render the newest sample once; if broadcasts queued up behind a busy
+    // server, the later ones find every stream current and send nothing.
+    // The server task never waits for a buffer: with the pool drained by
+    // workers the streams skip this sample and get the next one.
+    uint32_t seq = snap->seq;
+    char *buf = NULL;
+    for (int i = 0; i < MAX_SSE_CLIENTS && buf == NULL; i++) {
+        if (sse_clients[i].fd >= 0 && sse_clients[i].seq != seq) {
+            buf = resp_pool_take(0);
+            if (buf == NULL) {
+                break;
+            }
+        }
+    }
+    if (buf == NULL) {
+        snapshot_release(slot);
+        return;
+    }
+    // One sample always fits the window, so the stream never flushes and
+    // each client gets the event in a single send
+    json_stream_t js;
+    json_stream_init(&js, buf, RESP_POOL_BUF_SIZE, sse_overflow, NULL);
+    char *p = PUT_LIT(buf, "id: ");
+    p = put_u32(p, seq);
+    p = PUT_LIT(p, "\ndata: ");
+    json_stream_commit(&js, data_put_live(p, snap, seq));
+    snapshot_release(slot);
+    if (!series_json_write(&js, seq, seq) || !JSON_STREAM_LIT(&js, "}\n\n")) {
+        resp_pool_give(buf);
+        return;
+    }
+    int len = js.p - buf;
     
-    // Add temperature history
-    for (int i = 0; i < history_count; i++) {
-        int idx = (history_index - history_count + i + HISTORY_SIZE) % HISTORY_SIZE;
-        len += snprintf(json + len, 4096 - len, "%.1f%s", 
-                       temp_history[idx], (i < history_count - 1) ? "," : "");
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        int fd = sse_clients[i].fd;
+        if (fd < 0 || sse_clients[i].seq == seq) {
+            continue;
+        }
+        // Never block the server task on one client: a client whose socket
+        // buffer cannot take the whole event is dropped and reconnects later
+        int sent = httpd_socket_send(server, fd, buf, len, MSG_DONTWAIT);
+        if (sent != len) {
+            ESP_LOGW(TAG, "Dropping slow event stream on socket %d", fd);
+            sse_clients[i].fd = -1;
+            httpd_sess_trigger_close(server, fd);
+        } else {
+            sse_clients[i].seq = seq;
+        }
     }
-    len += snprintf(json + len, 4096 - len, "],\"humidHistory\":[");
+    resp_pool_give(buf);
+}
+
+// /tasks: rate and timing statistics of the periodic acquisition loops
+#define TASKS_ENTRY_MAX      192
+
+static esp_err_t tasks_handler(httpd_req_t *req) {
+    char buf[PERIODIC_MAX * TASKS_ENTRY_MAX + 64];
+    char *p = PUT_LIT(buf, "{\"tasks\":[");
+    for (size_t i = 0; i < periodic_count(); i++) {
+        const periodic_t *loop = periodic_get(i);
+        if (i > 0) {
+            *p++ = ',';
+        }
+        p = PUT_LIT(p, "{\"name\":\"");
+        p = put_bytes(p, loop->name, strnlen(loop->name, 32));
+        p = PUT_LIT(p, "\",\"periodMs\":");
+        p = put_u32(p, loop->period_us / 1000);
+        p = PUT_LIT(p, ",\"cycles\":");
+        p = put_u32(p, loop->cycles);
+        p = PUT_LIT(p, ",\"deadlineMisses\":");
+        p = put_u32(p, loop->misses);
+        p = PUT_LIT(p, ",\"jitterLastUs\":");
+        p = put_u32(p, loop->jitter_last_us);
+        p = PUT_LIT(p, ",\"jitterAvgUs\":");
+        p = put_u32(p, loop->jitter_avg_us);
+        p = PUT_LIT(p, ",\"jitterMaxUs\":");
+        p = put_u32(p, loop->jitter_max_us);
+        *p++ = '}';
+    }
+    p = PUT_LIT(p, "],\"busDropped\":");
+    p = put_u32(p, atomic_load(&busDropped));
+    *p++ = '}';
     
-    // Add humidity history
-    for (int i = 0; i < history_count; i++) {
-        int idx = (history_index - history_count + i + HISTORY_SIZE) % HISTORY_SIZE;
-        len += snprintf(json + len, 4096 - len, "%.1f%s", 
-                       humid_history[idx], (i < history_count - 1) ? "," : "");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, buf, p - buf);
+}
+
+// /metrics: Prometheus text exposition, streamed through a pool buffer.
+// Every header, sample and histogram asks the stream for room for the
+// longest it can be, so no number of series can overrun the buffer.
+_Static_assert(METRICS_LATENCY_MAX <= RESP_POOL_BUF_SIZE, "a latency histogram must fit a pool buffer");
+
+// Tasks whose stack high-water mark is exported; missing ones are skipped
+static const char *const metrics_tasks[] = {
+    "sensor_task", "dht_task", "ldr_task", "display_task", "flashlog", "dlog", "config", "push", "httpd",
+    "httpd_w0", "httpd_w1",
+};
+
+static void metrics_header(json_stream_t *js, const char *name, const char *type, const char *help) {
+    char *p = json_stream_room(js, METRICS_HEADER_MAX);
+    if (p != NULL) {
+        json_stream_commit(js, metrics_put_header(p, name, type, help));
+    }
+}
+
+static void metrics_sample(json_stream_t *js, const char *name, const char *labels, uint64_t value) {
+    char *p = json_stream_room(js, METRICS_SAMPLE_MAX);
+    if (p != NULL) {
+        json_stream_commit(js, metrics_put_sample(p, name, labels, value));
     }
-    len += snprintf(json + len, 4096 - len, "],\"lightHistory\":[");
+}
+
+static esp_err_t metrics_send(httpd_req_t *req, char *buf) {
+    resp_sink_t sink = { .req = req };
+    json_stream_t js;
+    json_stream_init(&js, buf, RESP_POOL_BUF_SIZE, resp_chunk_sink, &sink);
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
     
-    // Add light history
-    for (int i = 0; i < history_count; i++) {
-        int idx = (history_index - history_count + i + HISTORY_SIZE) % HISTORY_SIZE;
-        len += snprintf(json + len, 4096 - len, "%.1f%s", 
-                       light_history[idx], (i < history_count - 1) ? "," : "");
+    for (int op = 0; op < METRICS_OP_COUNT; op++) {
+        char *p = json_stream_room(&js, METRICS_LATENCY_MAX);
+        if (p == NULL) {
+            return ESP_FAIL;
+        }
+        json_stream_commit(&js, metrics_put_latency(p, (metrics_op_t)op, op == 0));
     }
-    len += snprintf(json + len, 4096 - len, "],\"motionHistory\":[");
     
-    // Add motion history
-    for (int i = 0; i < history_count; i++) {
-        int idx = (history_index - history_count + i + HISTORY_SIZE) % HISTORY_SIZE;
-        len += snprintf(json + len, 4096 - len, "%d%s", 
-                       motion_history[idx], (i < history_count - 1) ? "," : "");
+    metrics_header(&js, "desk_dht_reads_total", "counter", "DHT22 read attempts");
+    metrics_sample(&js, "desk_dht_reads_total", NULL, dhtReads);
+    metrics_header(&js, "desk_dht_failures_total", "counter", "Failed DHT22 reads by cause");
+    metrics_sample(&js, "desk_dht_failures_total", "reason=\"timeout\"", dhtTimeouts);
+    metrics_sample(&js, "desk_dht_failures_total", "reason=\"timing\"", dhtBadPulses);
+    metrics_sample(&js, "desk_dht_failures_total", "reason=\"checksum\"", dhtChecksumErrors);
+    
+    lcd_stats_t lcd;
+    lcd_get_stats(&lcd);
+    display_stats_t display;
+    display_get_stats(&display);
+    metrics_header(&js, "desk_lcd_i2c_errors_total", "counter", "Failed LCD I2C writes");
+    metrics_sample(&js, "desk_lcd_i2c_errors_total", NULL, lcd.errors);
+    metrics_header(&js, "desk_lcd_i2c_transactions_total", "counter", "LCD I2C writes");
+    metrics_sample(&js, "desk_lcd_i2c_transactions_total", NULL, lcd.transactions);
+    metrics_header(&js, "desk_lcd_frames_coalesced_total", "counter",
+                   "Display commands replaced before they were drawn");
+    metrics_sample(&js, "desk_lcd_frames_coalesced_total", NULL, display.coalesced);
+    
+    metrics_header(&js, "desk_fan_duty_writes_total", "counter", "Fan duty changes written to the LEDC");
+    metrics_sample(&js, "desk_fan_duty_writes_total", NULL, desk.fan_writes);
+    dlog_stats_t dlog;
+    dlog_get_stats(&dlog);
+    metrics_header(&js, "desk_log_records_total", "counter", "Deferred log records queued");
+    metrics_sample(&js, "desk_log_records_total", NULL, dlog.written);
+    metrics_header(&js, "desk_log_dropped_total", "counter", "Deferred log records lost to a full ring");
+    metrics_sample(&js, "desk_log_dropped_total", NULL, dlog.dropped);
+    config_stats_t cfg;
+    config_get_stats(&cfg);
+    metrics_header(&js, "desk_config_updates_total", "counter", "Accepted /config changes");
+    metrics_sample(&js, "desk_config_updates_total", NULL, cfg.updates);
+    metrics_header(&js, "desk_config_commits_total", "counter", "Configuration commits to NVS");
+    metrics_sample(&js, "desk_config_commits_total", NULL, cfg.commits);
+    push_stats_t push;
+    push_get_stats(&push);
+    metrics_header(&js, "desk_push_samples_total", "counter", "Samples delivered by push telemetry");
+    metrics_sample(&js, "desk_push_samples_total", NULL, push.samples);
+    metrics_header(&js, "desk_push_errors_total", "counter", "Push bursts that failed");
+    metrics_sample(&js, "desk_push_errors_total", NULL, push.errors);
+    metrics_header(&js, "desk_push_dropped_total", "counter", "Samples lost to a full push spool");
+    metrics_sample(&js, "desk_push_dropped_total", NULL, push.dropped);
+    metrics_header(&js, "desk_push_spooled", "gauge", "Samples waiting to be pushed");
+    metrics_sample(&js, "desk_push_spooled", NULL, push.spooled);
+    metrics_header(&js, "desk_sample_bus_dropped_total", "counter",
+                   "Sensor readings lost to a full sample bus");
+    metrics_sample(&js, "desk_sample_bus_dropped_total", NULL, atomic_load(&busDropped));
+    
+    resp_pool_stats_t pool;
+    resp_pool_get_stats(&pool);
+    metrics_header(&js, "desk_http_buffer_takes_total", "counter", "Response buffers lent out");
+    metrics_sample(&js, "desk_http_buffer_takes_total", NULL, pool.takes);
+    metrics_header(&js, "desk_http_buffer_waits_total", "counter", "Buffer requests that found the pool empty");
+    metrics_sample(&js, "desk_http_buffer_waits_total", NULL, pool.waits);
+    metrics_header(&js, "desk_http_buffer_timeouts_total", "counter",
+                   "Buffer requests that gave up (503 or a skipped event)");
+    metrics_sample(&js, "desk_http_buffer_timeouts_total", NULL, pool.timeouts);
+    metrics_header(&js, "desk_http_buffers_in_use_max", "gauge", "Most response buffers lent out at once");
+    metrics_sample(&js, "desk_http_buffers_in_use_max", NULL, pool.in_use_max);
+    metrics_header(&js, "desk_http_rejected_total", "counter", "Requests answered 503 with every worker busy");
+    metrics_sample(&js, "desk_http_rejected_total", NULL, atomic_load(&httpRejected));
+    
+    metrics_header(&js, "desk_env_anomalies_total", "counter",
+                   "Anomalies (spike, fast rise or fall) flagged by the streaming statistics");
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        char labels[32];
+        char *l = PUT_LIT(labels, "channel=\"");
+        l = put_bytes(l, env_channel_names[c], strlen(env_channel_names[c]));
+        l = PUT_LIT(l, "\"");
+        *l = '\0';
+        metrics_sample(&js, "desk_env_anomalies_total", labels, envStats[c].anomalies);
     }
-    len += snprintf(json + len, 4096 - len, "],\"historyCount\":%d}", history_count);
     
+    metrics_header(&js, "desk_heap_free_bytes", "gauge", "Free heap");
+    metrics_sample(&js, "desk_heap_free_bytes", NULL, esp_get_free_heap_size());
+    metrics_header(&js, "desk_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    metrics_sample(&js, "desk_heap_min_free_bytes", NULL, esp_get_minimum_free_heap_size());
+    metrics_header(&js, "desk_task_stack_min_free_bytes", "gauge",
+                   "Least stack a task has had unused since it started");
+    for (size_t i = 0; i < sizeof(metrics_tasks) / sizeof(metrics_tasks[0]); i++) {
+        TaskHandle_t task = xTaskGetHandle(metrics_tasks[i]);
+        if (task == NULL) {
+            continue;
+        }
+        char labels[32];
+        char *l = PUT_LIT(labels, "task=\"");
+        l = put_bytes(l, metrics_tasks[i], strlen(metrics_tasks[i]));
+        l = PUT_LIT(l, "\"");
+        *l = '\0';
+        metrics_sample(&js, "desk_task_stack_min_free_bytes", labels, uxTaskGetStackHighWaterMark(task));
+    }
+    return resp_stream_end(&sink, &js);
+}
+
+static esp_err_t metrics_handler(httpd_req_t *req) {
+    char *buf = resp_pool_take(RESP_WAIT_MS);
+    if (buf == NULL) {
+        return resp_busy(req);
+    }
+    esp_err_t ret = metrics_send(req, buf);
+    resp_pool_give(buf);
+    return ret;
+}
+
+// /config: GET returns the runtime settings, POST changes any of them with
+// a form-encoded body ("awaySeconds=20&fanCurve=20:76,30:255"). Changes
+// apply within one sensor_task pass and are saved to NVS once edits pause.
+#define CONFIG_FORM_MAX      512
+
+static esp_err_t config_send(httpd_req_t *req, const desk_config_t *config) {
+    char buf[CONFIG_JSON_MAX];
+    char *p = config_put_json(buf, config);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json, strlen(json));
+    return httpd_resp_send(req, buf, p - buf);
+}
+
+static esp_err_t config_get_handler(httpd_req_t *req) {
+    desk_config_t config;
+    config_get(&config);
+    return config_send(req, &config);
+}
+
+static esp_err_t config_post_handler(httpd_req_t *req) {
+    char form[CONFIG_FORM_MAX + 1];
+    if (req->content_len > CONFIG_FORM_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Form too large");
+        return ESP_OK;
+    }
+    size_t len = 0;
+    while (len < req->content_len) {
+        int n = httpd_req_recv(req, form + len, req->content_len - len);
+        if (n == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (n <= 0) {
+            return ESP_FAIL;
+        }
+        len += n;
+    }
+    form[len] = '\0';
     
-    free(json);
-    return ESP_OK;
+    desk_config_t config;
+    config_get(&config);
+    const char *bad_key = NULL;
+    if (config_parse_form(&config, form, &bad_key) != ESP_OK) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "Invalid or unknown setting: %.32s", bad_key);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, msg);
+        return ESP_OK;
+    }
+    if (config_set(&config) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid configuration");
+        return ESP_OK;
+    }
+    return config_send(req, &config);
+}
+
+// /trace: records the raw sensor inputs for the host replay (trace.h). A
+// GET starts a recording if none runs and returns what was buffered since
+// the previous GET, so a client that polls well within the time the ring
+// takes to fill (about a minute) and appends the bodies gets a complete
+// trace file. GET /trace?stop ends the recording with the last of it.
+static esp_err_t trace_handler(httpd_req_t *req) {
+    static uint8_t buf[TRACE_BUF_LEN];  // Server task only
+    char query[16];
+    bool stop = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK && strcmp(query, "stop") == 0;
+    if (stop) {
+        trace_stop();
+    } else if (!trace_running()) {
+        const trace_header_t header = {
+            .pir_level = hal_pir_read(),
+            .zero_mv = (uint16_t)hal_ldr_raw_to_mv(0),
+            .full_mv = (uint16_t)hal_ldr_raw_to_mv(4095),
+            .start_us = esp_timer_get_time(),
+        };
+        trace_start(&header);
+        ESP_LOGI(TAG, "Trace recording started");
+    }
+    size_t len = trace_read(buf, sizeof(buf));
+    httpd_resp_set_type(req, "application/octet-stream");
+    return httpd_resp_send(req, (const char *)buf, len);
+}
+
+// /sessions: completed sessions and breaks with their running aggregates.
+// The engine is copied out under its lock and rendered from the copy, so
+// sensor_task never waits for more than a memcpy.
+static esp_err_t sessions_handler(httpd_req_t *req) {
+    static sessions_t copy;                 // Server task only
+    static char buf[SESSIONS_JSON_MAX];     // Server task only
+    xSemaphoreTake(sessionsLock, portMAX_DELAY);
+    copy = deskSessions;
+    xSemaphoreGive(sessionsLock);
+    char *p = sessions_put_json(buf, &copy);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, buf, p - buf);
 }
 
 // Start web server
 static httpd_handle_t start_webserver(void) {
+    static const http_offload_t data_offload = { data_handler };
+    static const http_offload_t history_offload = { history_handler };
+    static const http_offload_t metrics_offload = { metrics_handler };
+    
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.stack_size = 8192;  // Increase stack size from default 4096 to 8192
-    httpd_handle_t server = NULL;
+    config.close_fn = session_close;  // Forget event streams when their socket closes
+    config.core_id = NET_CORE;
+    config.max_uri_handlers = 16;
+    // Every dashboard keeps a connection alive and may hold an event stream.
+    // LWIP has 16 sockets (sdkconfig.defaults); the server keeps 3 for
+    // itself and push telemetry needs 1.
+    config.max_open_sockets = HTTP_MAX_SOCKETS;
+    config.backlog_conn = 8;
+    // When all are taken, close the connection that has gone longest
+    // without a request instead of refusing the new one. Event streams
+    // never send one, so they go first; the page reopens them.
+    config.lru_purge_enable = true;
+    // Probe idle peers so a laptop that left the network frees its slot
+    config.keep_alive_enable = true;
+    config.keep_alive_idle = 30;
+    config.keep_alive_interval = 5;
+    config.keep_alive_count = 3;
     
+    web_assets_init();
+    ESP_ERROR_CHECK(resp_pool_init());
+    http_workers_start();
     if (httpd_start(&server, &config) == ESP_OK) {
-        httpd_uri_t root = {
-            .uri = "/",
+        for (size_t i = 0; i < sizeof(web_assets) / sizeof(web_assets[0]); i++) {
+            httpd_uri_t asset = {
+                .uri = web_assets[i].uri,
+                .method = HTTP_GET,
+                .handler = asset_handler,
+                .user_ctx = &web_assets[i]
+            };
+            httpd_register_uri_handler(server, &asset);
+        }
+        
+        httpd_uri_t data = {
+            .uri = "/data",
+            .method = HTTP_GET,
+            .handler = http_offload,
+            .user_ctx = (void *)&data_offload
+        };
+        httpd_register_uri_handler(server, &data);
+        
+        httpd_uri_t events = {
+            .uri = "/events",
             .method = HTTP_GET,
-            .handler = root_handler,
+            .handler = events_handler,
             .user_ctx = NULL
         };
-        httpd_register_uri_handler(server, &root);
+        httpd_register_uri_handler(server, &events);
         
-        httpd_uri_t data = {
-            .uri = "/data",
+        httpd_uri_t history = {
+            .uri = "/history",
+            .method = HTTP_GET,
+            .handler = http_offload,
+            .user_ctx = (void *)&history_offload
+        };
+        httpd_register_uri_handler(server, &history);
+        
+        httpd_uri_t tasks = {
+            .uri = "/tasks",
             .method = HTTP_GET,
-            .handler = data_handler,
+            .handler = tasks_handler,
             .user_ctx = NULL
         };
-        httpd_register_uri_handler(server, &data);
+        httpd_register_uri_handler(server, &tasks);
+        
+        httpd_uri_t metrics = {
+            .uri = "/metrics",
+            .method = HTTP_GET,
+            .handler = http_offload,
+            .user_ctx = (void *)&metrics_offload
+        };
+        httpd_register_uri_handler(server, &metrics);
+        
+        httpd_uri_t config_read = {
+            .uri = "/config",
+            .method = HTTP_GET,
+            .handler = config_get_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(server, &config_read);
+        
+        httpd_uri_t config_write = {
+            .uri = "/config",
+            .method = HTTP_POST,
+            .handler = config_post_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(server, &config_write);
+        
+        httpd_uri_t trace = {
+            .uri = "/trace",
+            .method = HTTP_GET,
+            .handler = trace_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(server, &trace);
+        
+        httpd_uri_t sessions = {
+            .uri = "/sessions",
+            .method = HTTP_GET,
+            .handler = sessions_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(server, &sessions);
         
         ESP_LOGI(TAG, "Web server started");
     }
     return server;
 }
 
-// Sensor reading task
-static void sensor_task(void *pvParameters) {
+// Sample bus. Each sensor has its own producer task and rate; readings are
+// posted here and sensor_task, which owns all derived state (fan, LED,
+// session, history, snapshot), applies them as they arrive.
+typedef enum {
+    BUS_DHT,
+    BUS_LDR,
+} bus_source_t;
+
+typedef struct {
+    bus_source_t source;
+    int64_t time_us;
+    int16_t temperature;    // BUS_DHT, deci-units
+    int16_t humidity;       // BUS_DHT, deci-units
+    int ldr_raw;            // BUS_LDR, filtered
+    uint32_t ldr_mv;        // BUS_LDR, calibrated
+} bus_msg_t;
+
+static QueueHandle_t sampleBus;
+static TaskHandle_t sensorTask;
+
+static void bus_post(const bus_msg_t *msg) {
+    if (xQueueSend(sampleBus, msg, 0) != pdTRUE) {
+        atomic_fetch_add(&busDropped, 1);
+    }
+    xTaskNotifyGive(sensorTask);
+}
+
+// DHT22 producer: the sensor must not be polled faster than every 2 s
+static void dht_task(void *pvParameters) {
+    static periodic_t loop;
+    periodic_init(&loop, "dht", DHT_PERIOD_MS);
     while (1) {
-        // Read DHT22
-        float temp, humid;
-        if (dht22_read(DHT_PIN, &temp, &humid)) {
-            temperature = temp;
-            humidity = humid;
-            temperatureF = temp * 1.8 + 32.0;
-            
-            // Control fan speed based on temperature
-            fan_set_speed(temperature);
+        periodic_wait(&loop);
+        int16_t temp, humid;
+        if (dht22_read(&temp, &humid)) {
+            const bus_msg_t msg = {
+                .source = BUS_DHT,
+                .time_us = esp_timer_get_time(),
+                .temperature = temp,
+                .humidity = humid,
+            };
+            bus_post(&msg);
         }
-        
-        // Read LDR (inverted)
-        ldrValue = adc1_get_raw(LDR_CHANNEL);
-        lightPercentage = ((4095.0 - ldrValue) / 4095.0) * 100.0;
-        
-        // LED control based on light level
-        if (lightPercentage < 50.0) {
-            // Low light - increment counter
-            lowLightSeconds += 1;  // Task runs every 1 second
-            if (lowLightSeconds >= 5 && !ledOn) {
-                gpio_set_level(LED_PIN, 1);
-                ledOn = true;
-                ESP_LOGI(TAG, "LED ON - Low light for 5+ seconds");
-            }
-        } else {
-            // Good light - turn off LED and reset counter
-            lowLightSeconds = 0;
-            if (ledOn) {
-                gpio_set_level(LED_PIN, 0);
-                ledOn = false;
-                ESP_LOGI(TAG, "LED OFF - Light level above 50%%");
+        periodic_done(&loop);
+    }
+}
+
+// LDR producer: the ADC converts continuously into DMA frames, and a CIC
+// decimator turns LDR_SAMPLE_HZ of noisy conversions into LDR_OUTPUT_HZ
+// filtered readings
+static void ldr_task(void *pvParameters) {
+    static uint16_t frame[LDR_FRAME_SAMPLES];
+    uint16_t filtered[4];
+    cic_t cic;
+    cic_init(&cic, LDR_SAMPLE_HZ / LDR_OUTPUT_HZ);
+    int warmup = CIC_ORDER;  // The first outputs still see the filter's zero state
+    
+    esp_err_t err = hal_ldr_start(LDR_SAMPLE_HZ);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "LDR ADC start failed: %s", esp_err_to_name(err));
+        vTaskDelete(NULL);
+        return;
+    }
+    while (1) {
+        size_t n = hal_ldr_read(frame, LDR_FRAME_SAMPLES, 1000);
+        size_t count = cic_process(&cic, frame, n, filtered, sizeof(filtered) / sizeof(filtered[0]));
+        for (size_t i = 0; i < count; i++) {
+            if (warmup > 0) {
+                warmup--;
+                continue;
             }
+            const bus_msg_t msg = {
+                .source = BUS_LDR,
+                .time_us = esp_timer_get_time(),
+                .ldr_raw = filtered[i],
+                .ldr_mv = hal_ldr_raw_to_mv(filtered[i]),
+            };
+            trace_ldr(msg.time_us, filtered[i], msg.ldr_mv);
+            bus_post(&msg);
+        }
+    }
+}
+
+static void bus_apply(const bus_msg_t *msg) {
+    switch (msg->source) {
+    case BUS_DHT: {
+        int16_t t = msg->temperature;
+        desk_logic_dht(&desk, t, msg->humidity);
+        temperatureF = (t * 9 + (t < 0 ? -2 : 2)) / 5 + 320;  // x1.8 + 32, rounded
+        break;
+    }
+    case BUS_LDR:
+        ldrValue = msg->ldr_raw;
+        ldrMillivolts = msg->ldr_mv;
+        desk_logic_light(&desk, desk_light_deci(ldrMillivolts, hal_ldr_raw_to_mv(0), hal_ldr_raw_to_mv(4095)));
+        break;
+    }
+}
+
+// Store one sample: RAM history tiers, the flash log for reboots, the
+// statistics and the push spool
+static void sample_store(bool motion) {
+    const int16_t sample[HISTORY_CHANNELS] = { desk.temperature, desk.humidity, desk.light };
+    history_add(sample, motion);
+    flashlog_add(sample, motion);
+    
+    uint8_t anomaly = 0;
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        anomaly |= envstats_add(&envStats[c], sample[c]);
+    }
+    const push_sample_t pushed = {
+        .seq = history_seq(HISTORY_RES_SECOND),
+        .temperature = desk.temperature,
+        .humidity = desk.humidity,
+        .light = desk.light,
+        .fan = desk.fan_duty,
+        .flags = (motion ? PUSH_FLAG_MOTION : 0) | (desk.session_active ? PUSH_FLAG_SESSION : 0) |
+                 (anomaly != 0 ? PUSH_FLAG_ANOMALY : 0),
+    };
+    push_sample(&pushed);
+}
+
+// Once per SENSOR_PERIOD_MS: LED, session clock and history from the latest
+// readings on the bus
+static void sensor_sample(int64_t now_us) {
+    trace_sample(now_us);
+    bool motion = desk_logic_sample(&desk, now_us);
+    xSemaphoreTake(sessionsLock, portMAX_DELAY);
+    sessions_tick(&deskSessions, desk.session_active);
+    xSemaphoreGive(sessionsLock);
+    
+    // The sensor tasks report on their own schedule; until both have
+    // delivered once there is no reading to store, only zeros
+    if (desk.temperature_valid && desk.light_valid) {
+        sample_store(motion);
+    }
+    
+    // Publish the new snapshot and push it to any open event streams
+    snapshot_publish();
+    if (server != NULL) {
+        httpd_queue_work(server, sse_broadcast, NULL);
+    }
+    
+    DLOG(DLOG_SAMPLE, desk.temperature, desk.humidity, desk.light, motion);
+}
+
+// Apply /config edits. Costs one atomic load per pass while nothing changed.
+static void config_refresh(void) {
+    if (config_generation() == deskConfigGeneration) {
+        return;
+    }
+    desk_config_t old = deskConfig;
+    deskConfigGeneration = config_get(&deskConfig);
+    if (deskConfig.pir_debounce_ms != old.pir_debounce_ms) {
+        motion_set_debounce_ms(deskConfig.pir_debounce_ms);
+    }
+    desk_logic_configure(&desk, &deskConfig);
+    if (strcmp(deskConfig.wifi_ssid, old.wifi_ssid) != 0 || strcmp(deskConfig.wifi_pass, old.wifi_pass) != 0) {
+        hal_wifi_set_credentials(deskConfig.wifi_ssid, deskConfig.wifi_pass);
+    }
+    if (memcmp(&deskConfig.push, &old.push, sizeof(old.push)) != 0) {
+        push_configure(&deskConfig.push);
+        if ((deskConfig.push.mode != PUSH_OFF) != (old.push.mode != PUSH_OFF)) {
+            hal_wifi_set_power_save(deskConfig.push.mode != PUSH_OFF);
+        }
+    }
+    ESP_LOGI(TAG, "Configuration applied");
+}
+
+// Sensor task: merges the sample bus and PIR edges and samples once per
+// second. It sleeps until the next sample, a bus message, a PIR edge or the
+// away deadline, whichever is first.
+static void sensor_task(void *pvParameters) {
+    static periodic_t loop;
+    periodic_init(&loop, "sample", SENSOR_PERIOD_MS);
+    deskConfigGeneration = config_get(&deskConfig);
+    motion_init(xTaskGetCurrentTaskHandle(), deskConfig.pir_debounce_ms);
+    desk_logic_init(&desk, &deskConfig, &deskOutputs, NULL, esp_timer_get_time(), motion_level());
+    while (1) {
+        config_refresh();
+        int64_t now = esp_timer_get_time();
+        motion_edge_t edge;
+        int64_t wake_us;
+        while (motion_next(now, &edge, &wake_us)) {
+            desk_logic_motion(&desk, edge.level, edge.time_us);
         }
+        desk_logic_check_away(&desk, now);
         
-        // Read PIR
-        int pir = gpio_get_level(PIR_PIN);
-        if (pir == 1 && !motionDetected) {
-            motionCount++;
+        bus_msg_t msg;
+        while (xQueueReceive(sampleBus, &msg, 0) == pdTRUE) {
+            bus_apply(&msg);
         }
-        motionDetected = (pir == 1);
         
-        // Buzzer control logic
-        if (motionDetected) {
-            // Motion detected - reset no-motion counter
-            noMotionSeconds = 0;
-            if (buzzerOn) {
-                // Turn off buzzer and restart session from 0
-                gpio_set_level(BUZZER_PIN, 0);
-                buzzerOn = false;
-                sessionActive = true;
-                sessionSeconds = 0;  // Reset session time on motion after buzzer
-                
-                // Clear display completely
-                lcd_clear();
-                vTaskDelay(pdMS_TO_TICKS(50));  // Wait for clear to complete
-                
-                // Write line 1
-                lcd_set_cursor(0, 0);
-                lcd_print_line("Session Time:");
-                vTaskDelay(pdMS_TO_TICKS(10));
-                
-                // Write line 2
-                lcd_set_cursor(0, 1);
-                lcd_print_line("    00:00:00");
-                
-                ESP_LOGI(TAG, "Buzzer OFF - Motion detected, session restarted");
-            }
-        } else {
-            // No motion - increment counter
-            noMotionSeconds += 1;  // Task runs every 1 second
-            if (noMotionSeconds >= buzzerDuration && !buzzerOn) {
-                // Time limit reached - trigger buzzer and reset session
-                gpio_set_level(BUZZER_PIN, 1);
-                buzzerOn = true;
-                sessionActive = false;
-                sessionSeconds = 0;  // Reset session time
-                
-                // Clear display completely
-                lcd_clear();
-                vTaskDelay(pdMS_TO_TICKS(50));  // Wait for clear to complete
-                
-                // Write line 1
-                lcd_set_cursor(0, 0);
-                lcd_print_line("User Away!");
-                vTaskDelay(pdMS_TO_TICKS(10));
-                
-                // Write line 2
-                lcd_set_cursor(0, 1);
-                lcd_print_line("Session Reset");
-                
-                ESP_LOGI(TAG, "Buzzer ON - No motion for %d seconds, session reset", buzzerDuration);
+        if (now >= periodic_next_release(&loop)) {
+            periodic_begin(&loop);
+            sensor_sample(now);
+            uint32_t busy_us = (uint32_t)(esp_timer_get_time() - now);
+            if (busy_us > sampleMaxUs) {
+                sampleMaxUs = busy_us;
             }
+            periodic_done(&loop);
+            continue;
         }
         
-        // Always increment session time when session is active (regardless of motion)
-        // Only update LCD if buzzer is not on
-        if (sessionActive && !buzzerOn) {
-            sessionSeconds += 1;  // Add 1 second per cycle
-            lcd_update_session_time(sessionSeconds);
+        if (periodic_next_release(&loop) < wake_us) {
+            wake_us = periodic_next_release(&loop);
         }
-        
-        // Store historical data (circular buffer)
-        temp_history[history_index] = temperature;
-        humid_history[history_index] = humidity;
-        light_history[history_index] = lightPercentage;
-        motion_history[history_index] = motionDetected ? 1 : 0;
-        
-        history_index = (history_index + 1) % HISTORY_SIZE;
-        if (history_count < HISTORY_SIZE) {
-            history_count++;
+        if (desk_logic_away_deadline(&desk) < wake_us) {
+            wake_us = desk_logic_away_deadline(&desk);
         }
-        
-        ESP_LOGI(TAG, "Temp: %.1f°C, Humid: %.1f%%, Light: %.1f%%, Motion: %s",
-                 temperature, humidity, lightPercentage,
-                 motionDetected ? "YES" : "NO");
-        
-        vTaskDelay(pdMS_TO_TICKS(1000));  // Run every 1 second
+        const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+        ulTaskNotifyTake(pdTRUE, (TickType_t)((wake_us - now + tick_us - 1) / tick_us));
     }
 }
 
 void app_main(void) { 
     ESP_LOGI(TAG, "ESP32 Dashboard Starting...");
+    dlog_init();
     
-    // Initialize NVS
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
-    
-    // Initialize GPIOs
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << PIR_PIN),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&io_conf);
-    
-    // Initialize I2C for LCD
-    ESP_LOGI(TAG, "Initializing I2C: SDA=%d, SCL=%d", I2C_SDA_PIN, I2C_SCL_PIN);
-    i2c_config_t i2c_conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_SDA_PIN,
-        .scl_io_num = I2C_SCL_PIN,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
-    };
-    ESP_ERROR_CHECK(i2c_param_config(I2C_MASTER_NUM, &i2c_conf));
-    ESP_ERROR_CHECK(i2c_driver_install(I2C_MASTER_NUM, i2c_conf.mode, 0, 0, 0));
-    ESP_LOGI(TAG, "I2C driver installed successfully");
+    // Initialize NVS, GPIOs, I2C, fan PWM and ADC
+    ESP_ERROR_CHECK(hal_board_init());
+    ESP_ERROR_CHECK(config_init());
+    ESP_ERROR_CHECK(trace_init());
     
     // Scan I2C bus
     i2c_scanner();
     
-    // Initialize LCD
-    lcd_init();
-    lcd_clear();
-    lcd_set_cursor(0, 0);
-    lcd_print_line("Session Time:");
-    lcd_set_cursor(0, 1);
-    lcd_print_line("    00:00:00");
+    // Initialize LCD on its own task
+    display_init(LCD_ADDR);
+    display_show_session(0);
     vTaskDelay(pdMS_TO_TICKS(2000));
     
-    // Initialize Fan PWM
-    fan_init();
-    
-    // Initialize Buzzer GPIO
-    gpio_config_t buzzer_conf = {
-        .pin_bit_mask = (1ULL << BUZZER_PIN),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&buzzer_conf);
-    gpio_set_level(BUZZER_PIN, 0);  // Start with buzzer OFF
-    
-    // Initialize LED GPIO
-    gpio_config_t led_conf = {
-        .pin_bit_mask = (1ULL << LED_PIN),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&led_conf);
-    gpio_set_level(LED_PIN, 0);  // Start with LED OFF
-    
-    // Initialize ADC
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(LDR_CHANNEL, ADC_ATTEN_DB_12);
-    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_12, ADC_WIDTH_BIT_12, 1100, &adc_chars);
-    
-    // Initialize WiFi
-    wifi_init();
+    // Initialize WiFi and wait for connection
+    desk_config_t boot_config;
+    config_get(&boot_config);
+    hal_wifi_connect(boot_config.wifi_ssid, boot_config.wifi_pass);
     
-    // Wait for WiFi connection
-    xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, false, true, portMAX_DELAY);
+    // Pushing boards are not polled, so their radio may sleep between bursts
+    ESP_ERROR_CHECK(push_init(&boot_config.push));
+    if (boot_config.push.mode != PUSH_OFF) {
+        hal_wifi_set_power_save(true);
+    }
     
-    // Start web server
+    // Start web server with an initial (empty) snapshot to serve
+    history_init();
+    flashlog_init(true);
+    sessionsLock = xSemaphoreCreateMutex();
+    sessions_init(&deskSessions, true);  // The decision logic starts with a session running
+    for (int c = 0; c < HISTORY_CHANNELS; c++) {
+        envstats_init(&envStats[c], &envStatsConfig[c], envStatsSlots[c]);
+    }
+    snapshot_publish();
     start_webserver();
     
-    // Create sensor reading task
-    xTaskCreate(sensor_task, "sensor_task", 4096, NULL, 5, NULL);
+    // Acquisition tasks on their own core, away from WiFi and the server.
+    // sensor_task installs the PIR interrupt, so it is serviced there too.
+    sampleBus = xQueueCreate(SAMPLE_BUS_LEN, sizeof(bus_msg_t));
+    xTaskCreatePinnedToCore(sensor_task, "sensor_task", 4096, NULL, 5, &sensorTask, ACQ_CORE);
+    xTaskCreatePinnedToCore(dht_task, "dht_task", 3072, NULL, 6, NULL, ACQ_CORE);
+    xTaskCreatePinnedToCore(ldr_task, "ldr_task", 2048, NULL, 6, NULL, ACQ_CORE);
     
     ESP_LOGI(TAG, "System ready!");
 }
@@ -0,0 +1,125 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "numfmt.h"
+#include "metrics.h"
+
+typedef struct {
+    atomic_uint count[METRICS_BUCKETS];
+    atomic_uint sum_lo;         // Sum of observations in us
+    atomic_uint sum_hi;
+} metrics_hist_t;
+
+// Upper bounds in us; the last bucket is +Inf
+static const uint32_t bucket_us[METRICS_BUCKETS - 1] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+};
+
+static const char *const bucket_le[METRICS_BUCKETS] = {
+    "5e-05", "0.0001", "0.00025", "0.0005", "0.001", "0.0025",
+    "0.005", "0.01", "0.025", "0.05", "0.1", "+Inf",
+};
+
+static const char *const op_names[METRICS_OP_COUNT] = {
+    [METRICS_DHT22_READ] = "dht22_read",
+    [METRICS_LCD_FRAME] = "lcd_frame",
+    [METRICS_DATA_JSON] = "data_json",
+    [METRICS_DATA_SEND] = "data_send",
+};
+
+static metrics_hist_t histograms[METRICS_OP_COUNT];
+
+void metrics_observe(metrics_op_t op, uint32_t us) {
+    metrics_hist_t *hist = &histograms[op];
+    int b = 0;
+    while (b < METRICS_BUCKETS - 1 && us > bucket_us[b]) {
+        b++;
+    }
+    atomic_fetch_add_explicit(&hist->count[b], 1, memory_order_relaxed);
+    // Exactly one add crosses each wrap of the low word, and it carries
+    unsigned lo = atomic_fetch_add_explicit(&hist->sum_lo, us, memory_order_relaxed);
+    if (lo + us < lo) {
+        atomic_fetch_add_explicit(&hist->sum_hi, 1, memory_order_relaxed);
+    }
+}
+
+// Copy s, cut to max bytes
+static char *put_str(char *p, const char *s, size_t max) {
+    size_t len = strnlen(s, max);
+    return put_bytes(p, s, len);
+}
+
+char *metrics_put_header(char *p, const char *name, const char *type, const char *help) {
+    p = PUT_LIT(p, "# HELP ");
+    p = put_str(p, name, METRICS_NAME_MAX);
+    *p++ = ' ';
+    p = put_str(p, help, METRICS_HELP_MAX);
+    p = PUT_LIT(p, "\n# TYPE ");
+    p = put_str(p, name, METRICS_NAME_MAX);
+    *p++ = ' ';
+    p = put_str(p, type, METRICS_TYPE_MAX);
+    *p++ = '\n';
+    return p;
+}
+
+char *metrics_put_sample(char *p, const char *name, const char *labels, uint64_t value) {
+    p = put_str(p, name, METRICS_NAME_MAX);
+    if (labels != NULL) {
+        *p++ = '{';
+        p = put_str(p, labels, METRICS_LABELS_MAX);
+        *p++ = '}';
+    }
+    *p++ = ' ';
+    p = put_u64(p, value);
+    *p++ = '\n';
+    return p;
+}
+
+// Microseconds as seconds with six decimals
+static char *put_seconds(char *p, uint64_t us) {
+    p = put_u64(p, us / 1000000);
+    *p++ = '.';
+    uint32_t frac = (uint32_t)(us % 1000000);
+    for (uint32_t div = 100000; div > 0; div /= 10) {
+        *p++ = '0' + frac / div % 10;
+    }
+    return p;
+}
+
+char *metrics_put_latency(char *p, metrics_op_t op, bool with_header) {
+    const metrics_hist_t *hist = &histograms[op];
+    const char *name = op_names[op];
+    if (with_header) {
+        p = metrics_put_header(p, "desk_latency_seconds", "histogram",
+                               "Duration of timed hot-path operations");
+    }
+
+    // Buckets are read one at a time, so a scrape may be an observation or
+    // two behind in places; count is the +Inf bucket, so they always agree
+    uint64_t cumulative = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        cumulative += atomic_load_explicit(&hist->count[b], memory_order_relaxed);
+        p = PUT_LIT(p, "desk_latency_seconds_bucket{op=\"");
+        p = put_bytes(p, name, strlen(name));
+        p = PUT_LIT(p, "\",le=\"");
+        p = put_bytes(p, bucket_le[b], strlen(bucket_le[b]));
+        p = PUT_LIT(p, "\"} ");
+        p = put_u64(p, cumulative);
+        *p++ = '\n';
+    }
+
+    unsigned hi, lo;
+    do {
+        hi = atomic_load_explicit(&hist->sum_hi, memory_order_relaxed);
+        lo = atomic_load_explicit(&hist->sum_lo, memory_order_relaxed);
+    } while (hi != atomic_load_explicit(&hist->sum_hi, memory_order_relaxed));
+    p = PUT_LIT(p, "desk_latency_seconds_sum{op=\"");
+    p = put_bytes(p, name, strlen(name));
+    p = PUT_LIT(p, "\"} ");
+    p = put_seconds(p, ((uint64_t)hi << 32) | lo);
+    p = PUT_LIT(p, "\ndesk_latency_seconds_count{op=\"");
+    p = put_bytes(p, name, strlen(name));
+    p = PUT_LIT(p, "\"} ");
+    p = put_u64(p, cumulative);
+    *p++ = '\n';
+    return p;
+}
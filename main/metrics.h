@@ -0,0 +1,49 @@
+#pragma once
+
+// Latency histograms and Prometheus text exposition for /metrics.
+//
+// Each timed operation has a fixed set of log-spaced buckets from 50 us to
+// 100 ms plus +Inf. Recording is a bucket search and two relaxed atomic
+// adds, with no lock and no allocation, so it can run on any task (not from
+// an ISR). The sum is kept in microseconds as two 32-bit words so that it
+// stays lock-free on the ESP32, which has no 64-bit atomics. A scrape that
+// races the low word wrapping can see the sum 2^32 us short for that
+// one read.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define METRICS_BUCKETS     12      // Including +Inf
+
+typedef enum {
+    METRICS_DHT22_READ,             // Capture, decode and checksum of one frame
+    METRICS_LCD_FRAME,              // Render and I2C write of one LCD frame
+    METRICS_DATA_JSON,              // /data response assembly
+    METRICS_DATA_SEND,              // /data response send
+    METRICS_OP_COUNT,
+} metrics_op_t;
+
+// Bytes metrics_put_latency() writes at most for one operation
+#define METRICS_LATENCY_MAX 1280
+
+// Names, types, help and labels longer than these are cut, so a header or
+// sample line never writes more than its _MAX
+#define METRICS_NAME_MAX    48
+#define METRICS_TYPE_MAX    16
+#define METRICS_HELP_MAX    96
+#define METRICS_LABELS_MAX  48
+#define METRICS_HEADER_MAX  (18 + 2 * METRICS_NAME_MAX + METRICS_TYPE_MAX + METRICS_HELP_MAX)
+#define METRICS_SAMPLE_MAX  (24 + METRICS_NAME_MAX + METRICS_LABELS_MAX)   // 20-digit value
+
+void metrics_observe(metrics_op_t op, uint32_t us);
+
+// "# HELP" and "# TYPE" lines for a metric family
+char *metrics_put_header(char *p, const char *name, const char *type, const char *help);
+
+// One sample line: name{labels} value. labels may be NULL.
+char *metrics_put_sample(char *p, const char *name, const char *labels, uint64_t value);
+
+// Header and cumulative buckets, sum and count of the latency histogram.
+// Every operation is a series of desk_latency_seconds{op="..."}; pass
+// with_header for the first one written.
+char *metrics_put_latency(char *p, metrics_op_t op, bool with_header);
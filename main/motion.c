@@ -0,0 +1,155 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "hal.h"
+#include "motion.h"
+#include "trace.h"
+
+static const char *TAG = "MOTION";
+
+// Raw edge ring. The interrupt owns head, the consumer owns tail; each side
+// only reads the other's index, so plain acquire/release ordering suffices.
+static motion_edge_t ring[MOTION_QUEUE_LEN];
+static atomic_uint ring_head;
+static atomic_uint ring_tail;
+static atomic_uint raw_edges;
+static atomic_uint dropped;
+
+static TaskHandle_t consumer;
+
+// Debounce state, consumer task only
+static motion_debounce_t debounce;
+static uint32_t dropped_seen;
+
+static motion_edge_t recent[MOTION_RECENT_LEN];
+static uint32_t recent_count;
+
+static void IRAM_ATTR motion_isr(bool pir_level, int64_t time_us, void *arg) {
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+    atomic_fetch_add_explicit(&raw_edges, 1, memory_order_relaxed);
+    if (head - tail < MOTION_QUEUE_LEN) {
+        ring[head % MOTION_QUEUE_LEN] = (motion_edge_t){ .time_us = time_us, .level = pir_level };
+        atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+    } else {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(consumer, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void motion_debounce_init(motion_debounce_t *d, bool level, int64_t now_us, uint32_t debounce_ms) {
+    *d = (motion_debounce_t){
+        .debounce_us = (int64_t)debounce_ms * 1000,
+        .level = level,
+        .raw_level = level,
+    };
+    d->level_since_us = now_us - d->debounce_us;
+    d->raw_since_us = d->level_since_us;
+}
+
+static void debounce_accept(motion_debounce_t *d, bool level, int64_t time_us, motion_edge_t *edge) {
+    d->level = level;
+    d->level_since_us = time_us;
+    d->edges++;
+    *edge = (motion_edge_t){ .time_us = time_us, .level = level };
+}
+
+bool motion_debounce_raw(motion_debounce_t *d, const motion_edge_t *raw, motion_edge_t *edge) {
+    d->raw_level = raw->level;
+    d->raw_since_us = raw->time_us;
+    if (raw->level == d->level) {
+        return false;  // Back to the debounced level inside the window
+    }
+    if (raw->time_us - d->level_since_us >= d->debounce_us) {
+        debounce_accept(d, raw->level, raw->time_us, edge);
+        return true;
+    }
+    d->bounces++;
+    return false;
+}
+
+bool motion_debounce_settle(motion_debounce_t *d, int64_t now_us, motion_edge_t *edge, int64_t *settle_us) {
+    // A transition held back by the lockout takes effect when it ends
+    *settle_us = INT64_MAX;
+    if (d->raw_level != d->level) {
+        int64_t due = d->level_since_us + d->debounce_us;
+        if (now_us >= due) {
+            debounce_accept(d, d->raw_level, d->raw_since_us, edge);
+            return true;
+        }
+        *settle_us = due;
+    }
+    return false;
+}
+
+esp_err_t motion_init(TaskHandle_t notify_task, uint32_t debounce_ms) {
+    consumer = notify_task;
+    motion_debounce_init(&debounce, hal_pir_read(), esp_timer_get_time(), debounce_ms);
+    esp_err_t err = hal_pir_set_edge_callback(motion_isr, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "PIR interrupt setup failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void motion_set_debounce_ms(uint32_t debounce_ms) {
+    debounce.debounce_us = (int64_t)debounce_ms * 1000;
+}
+
+bool motion_level(void) {
+    return debounce.level;
+}
+
+static bool motion_keep(const motion_edge_t *edge) {
+    recent[recent_count++ % MOTION_RECENT_LEN] = *edge;
+    return true;
+}
+
+bool motion_next(int64_t now_us, motion_edge_t *edge, int64_t *settle_us) {
+    unsigned tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_acquire);
+    while (tail != head) {
+        motion_edge_t raw = ring[tail % MOTION_QUEUE_LEN];
+        atomic_store_explicit(&ring_tail, ++tail, memory_order_release);
+        trace_pir(raw.time_us, raw.level);
+        if (motion_debounce_raw(&debounce, &raw, edge)) {
+            return motion_keep(edge);
+        }
+    }
+
+    // Edges lost to a full queue leave raw_level stale; resample the pin
+    uint32_t lost = atomic_load_explicit(&dropped, memory_order_relaxed);
+    if (lost != dropped_seen) {
+        dropped_seen = lost;
+        debounce.raw_level = hal_pir_read();
+        debounce.raw_since_us = now_us;
+        trace_pir(now_us, debounce.raw_level);
+    }
+
+    if (motion_debounce_settle(&debounce, now_us, edge, settle_us)) {
+        return motion_keep(edge);
+    }
+    return false;
+}
+
+size_t motion_recent(motion_edge_t *out, size_t max) {
+    size_t n = recent_count < MOTION_RECENT_LEN ? recent_count : MOTION_RECENT_LEN;
+    if (n > max) {
+        n = max;
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[i] = recent[(recent_count - n + i) % MOTION_RECENT_LEN];
+    }
+    return n;
+}
+
+void motion_get_stats(motion_stats_t *out) {
+    out->raw_edges = atomic_load(&raw_edges);
+    out->edges = debounce.edges;
+    out->bounces = debounce.bounces;
+    out->dropped = atomic_load(&dropped);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// PIR motion edges.
+//
+// The HAL reports every level change of the PIR output from its GPIO
+// interrupt with an esp_timer timestamp. The interrupt side only appends the
+// raw edge to a single-producer/single-consumer ring (two atomic indices, no
+// lock) and wakes the consumer task with a task notification. The consumer
+// pulls debounced edges with motion_next().
+//
+// Debounce is a lockout: an edge that changes the debounced level is passed
+// through immediately with its own timestamp, and further transitions during
+// the next debounce interval are held back. When the interval ends, the
+// current raw level wins, so a short glitch is dropped and a real change
+// inside the window is reported late but never lost.
+//
+// Everything except the interrupt callback must be called from the consumer
+// task. The debounce itself is a plain state machine over timestamped raw
+// edges (motion_debounce_*), which the trace replay drives directly.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+#define MOTION_QUEUE_LEN    32      // Raw edges buffered between polls (power of 2)
+#define MOTION_RECENT_LEN   8       // Accepted edges kept for telemetry
+
+typedef struct {
+    int64_t time_us;        // esp_timer_get_time() at the edge
+    bool level;             // PIR output after the edge
+} motion_edge_t;
+
+typedef struct {
+    uint32_t raw_edges;     // Edges seen by the interrupt
+    uint32_t edges;         // Edges passed by the debounce
+    uint32_t bounces;       // Transitions suppressed by the debounce
+    uint32_t dropped;       // Raw edges lost to a full queue
+} motion_stats_t;
+
+typedef struct {
+    int64_t debounce_us;
+    bool level;             // Debounced
+    int64_t level_since_us;
+    bool raw_level;         // Latest raw edge
+    int64_t raw_since_us;
+    uint32_t edges;
+    uint32_t bounces;
+} motion_debounce_t;
+
+void motion_debounce_init(motion_debounce_t *d, bool level, int64_t now_us, uint32_t debounce_ms);
+
+// Feed one raw edge; true with *edge set when it changes the debounced level
+bool motion_debounce_raw(motion_debounce_t *d, const motion_edge_t *raw, motion_edge_t *edge);
+
+// A held-back transition, if due at now_us. Otherwise false, with *settle_us
+// set to when it is due (INT64_MAX if none).
+bool motion_debounce_settle(motion_debounce_t *d, int64_t now_us, motion_edge_t *edge, int64_t *settle_us);
+
+// Attach to the PIR interrupt. notify_task (normally the caller) receives a
+// task notification for every raw edge.
+esp_err_t motion_init(TaskHandle_t notify_task, uint32_t debounce_ms);
+
+void motion_set_debounce_ms(uint32_t debounce_ms);
+
+// Debounced PIR level
+bool motion_level(void);
+
+// Next debounced edge, if one is ready at now_us. When none is, returns false
+// and sets *settle_us to the time a held-back transition is due (INT64_MAX if
+// none), which is when the caller should poll again at the latest.
+bool motion_next(int64_t now_us, motion_edge_t *edge, int64_t *settle_us);
+
+// Most recent accepted edges, oldest first; returns how many were copied
+size_t motion_recent(motion_edge_t *out, size_t max);
+
+void motion_get_stats(motion_stats_t *out);
@@ -0,0 +1,79 @@
+#pragma once
+
+// Allocation-free number and string writers for building HTTP payloads.
+//
+// Each function writes at p and returns the new end; callers size their
+// buffers for the worst case up front, so there is no bounds checking here.
+// Sensor values are carried as deci-units (tenths) in int16_t/int32_t, which
+// keeps float printf off the response path entirely.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Log helpers for deci-unit values: ESP_LOGI(TAG, "T=" DECI_FMT, DECI_ARG(t))
+#define DECI_FMT        "%s%d.%d"
+#define DECI_ARG(v)     ((v) < 0 ? "-" : ""), (int)((v) < 0 ? -(v) : (v)) / 10, (int)((v) < 0 ? -(v) : (v)) % 10
+
+static inline char *put_bytes(char *p, const char *s, size_t len) {
+    memcpy(p, s, len);
+    return p + len;
+}
+
+// Copy a string literal without the terminating NUL
+#define PUT_LIT(p, lit) put_bytes((p), (lit), sizeof(lit) - 1)
+
+static inline char *put_u32(char *p, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v != 0);
+    while (n > 0) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+// Microsecond timestamps outgrow 32 bits after 71 minutes. 64-bit division
+// is a libgcc call on the ESP32, so values that fit take the 32-bit path.
+static inline char *put_u64(char *p, uint64_t v) {
+    if (v <= UINT32_MAX) {
+        return put_u32(p, (uint32_t)v);
+    }
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v != 0);
+    while (n > 0) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+static inline char *put_i32(char *p, int32_t v) {
+    if (v < 0) {
+        *p++ = '-';
+        return put_u32(p, 0u - (uint32_t)v);
+    }
+    return put_u32(p, (uint32_t)v);
+}
+
+// Tenths as a decimal with one fractional digit: -57 -> "-5.7", 3 -> "0.3"
+static inline char *put_deci(char *p, int32_t tenths) {
+    uint32_t mag = tenths < 0 ? 0u - (uint32_t)tenths : (uint32_t)tenths;
+    if (tenths < 0) {
+        *p++ = '-';
+    }
+    p = put_u32(p, mag / 10);
+    *p++ = '.';
+    *p++ = '0' + mag % 10;
+    return p;
+}
+
+static inline char *put_bool(char *p, bool v) {
+    return v ? PUT_LIT(p, "true") : PUT_LIT(p, "false");
+}
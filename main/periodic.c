@@ -0,0 +1,67 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "periodic.h"
+
+static periodic_t *loops[PERIODIC_MAX];
+static size_t loop_count;
+
+void periodic_init(periodic_t *loop, const char *name, uint32_t period_ms) {
+    *loop = (periodic_t){
+        .name = name,
+        .period_us = period_ms * 1000,
+        .release_us = esp_timer_get_time(),
+    };
+    // Loops are created at boot, before anything lists them
+    if (loop_count < PERIODIC_MAX) {
+        loops[loop_count++] = loop;
+    }
+}
+
+int64_t periodic_next_release(const periodic_t *loop) {
+    return loop->cycles == 0 ? loop->release_us : loop->release_us + loop->period_us;
+}
+
+void periodic_begin(periodic_t *loop) {
+    loop->release_us = periodic_next_release(loop);
+    int64_t late = esp_timer_get_time() - loop->release_us;
+    uint32_t jitter = late > 0 ? (uint32_t)late : 0;
+    loop->jitter_last_us = jitter;
+    loop->jitter_avg_us = loop->cycles == 0 ? jitter
+                                            : (uint32_t)(((uint64_t)loop->jitter_avg_us * 15 + jitter) / 16);
+    if (jitter > loop->jitter_max_us) {
+        loop->jitter_max_us = jitter;
+    }
+    loop->cycles++;
+}
+
+void periodic_wait(periodic_t *loop) {
+    int64_t release = periodic_next_release(loop);
+    int64_t now = esp_timer_get_time();
+    if (release > now) {
+        // Round up: waking a tick late is jitter, waking early is a bug
+        const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+        vTaskDelay((TickType_t)((release - now + tick_us - 1) / tick_us));
+    }
+    periodic_begin(loop);
+}
+
+void periodic_done(periodic_t *loop) {
+    int64_t now = esp_timer_get_time();
+    if (now < loop->release_us + loop->period_us) {
+        return;
+    }
+    // Overran: skip the releases already in the past
+    int64_t late = now - loop->release_us;
+    int64_t skipped = late / loop->period_us;
+    loop->misses++;
+    loop->release_us += skipped * loop->period_us;
+}
+
+size_t periodic_count(void) {
+    return loop_count;
+}
+
+const periodic_t *periodic_get(size_t index) {
+    return index < loop_count ? loops[index] : NULL;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Fixed-rate task loops with timing statistics.
+//
+// A producer task calls periodic_wait() at the top of each cycle and
+// periodic_done() at the end; an event loop that sleeps on something else
+// checks periodic_next_release() and calls periodic_begin() instead.
+// Releases are scheduled on an absolute timeline (start + n * period), so a
+// slow cycle does not push later ones back. Per loop it tracks:
+//   jitter   how late the task woke relative to its release time
+//   misses   cycles whose work was still running at the next release; the
+//            overrun releases are skipped rather than run back to back
+//
+// Every periodic_t registers itself by name so the statistics can be listed
+// over HTTP. Fields are written only by the owning task; readers get a
+// snapshot that may be a cycle out of date.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PERIODIC_MAX        8
+
+typedef struct {
+    const char *name;
+    uint32_t period_us;
+    int64_t release_us;         // Current cycle's release time
+    uint32_t cycles;
+    uint32_t misses;
+    uint32_t jitter_max_us;
+    uint32_t jitter_last_us;
+    uint32_t jitter_avg_us;     // Moving average over ~16 cycles
+} periodic_t;
+
+// Register the loop; the first release is immediate
+void periodic_init(periodic_t *loop, const char *name, uint32_t period_ms);
+
+// Time of the next release
+int64_t periodic_next_release(const periodic_t *loop);
+
+// Start a cycle at or after its release time and record the jitter
+void periodic_begin(periodic_t *loop);
+
+// Sleep until the next release, then periodic_begin()
+void periodic_wait(periodic_t *loop);
+
+// End of the cycle's work; counts a miss if it overran the next release
+void periodic_done(periodic_t *loop);
+
+// Registered loops, in registration order
+size_t periodic_count(void);
+const periodic_t *periodic_get(size_t index);
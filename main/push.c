@@ -0,0 +1,418 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "push.h"
+
+#define PUSH_TASK_STACK         4096
+#define PUSH_TASK_PRIORITY      2
+#define PUSH_IO_TIMEOUT_MS      5000
+#define PUSH_MQTT_KEEPALIVE_S   60
+#define PUSH_MQTT_CLIENT_MAX    23      // Longest client ID every MQTT 3.1.1 broker accepts
+
+// MQTT 3.1.1 control packets
+#define MQTT_CONNECT            0x10
+#define MQTT_CONNACK            0x20
+#define MQTT_PUBLISH_QOS1       0x32
+#define MQTT_PUBACK             0x40
+#define MQTT_DISCONNECT         0xE0
+
+static const char *TAG = "PUSH";
+
+const char *const push_mode_names[PUSH_MODE_COUNT] = { "off", "udp", "mqtt" };
+
+// Spool ring, guarded by spool_lock. head and tail count samples since
+// boot; tail is the oldest one not yet delivered.
+static SemaphoreHandle_t spool_lock;
+static push_sample_t spool[PUSH_SPOOL_LEN];
+static uint32_t spool_head;
+static uint32_t spool_tail;
+static push_config_t active;            // Also under spool_lock
+static push_stats_t stats;
+static atomic_bool enabled;
+
+static TaskHandle_t push_task_handle;
+
+// Push task buffers
+static push_sample_t batch[PUSH_BATCH_MAX];
+static uint8_t payload[PUSH_PAYLOAD_MAX];
+static uint8_t packet[5 + 2 + PUSH_TOPIC_MAX + 2 + PUSH_PAYLOAD_MAX];
+
+static uint8_t *put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_le32(uint8_t *p, uint32_t v) {
+    p = put_le16(p, (uint16_t)v);
+    return put_le16(p, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return get_le16(p) | (uint32_t)get_le16(p + 2) << 16;
+}
+
+size_t push_encode(const char *name, uint32_t dropped, const push_sample_t *samples, size_t count,
+                   uint8_t *out, size_t *used) {
+    size_t n = 0;
+    while (n < count && n < PUSH_BATCH_MAX && (n == 0 || samples[n].seq == samples[n - 1].seq + 1)) {
+        n++;
+    }
+    size_t name_len = strnlen(name, PUSH_TOPIC_MAX);
+    uint8_t *p = out;
+    *p++ = 'D';
+    *p++ = 'K';
+    *p++ = PUSH_FORMAT_VERSION;
+    *p++ = (uint8_t)name_len;
+    memcpy(p, name, name_len);
+    p += name_len;
+    p = put_le32(p, n > 0 ? samples[0].seq : 0);
+    p = put_le32(p, dropped);
+    p = put_le16(p, (uint16_t)n);
+    for (size_t i = 0; i < n; i++) {
+        p = put_le16(p, (uint16_t)samples[i].temperature);
+        p = put_le16(p, (uint16_t)samples[i].humidity);
+        p = put_le16(p, (uint16_t)samples[i].light);
+        *p++ = samples[i].fan;
+        *p++ = samples[i].flags;
+    }
+    *used = n;
+    return p - out;
+}
+
+bool push_decode(const uint8_t *buf, size_t len, push_batch_t *out) {
+    if (len < 4 || buf[0] != 'D' || buf[1] != 'K' || buf[2] != PUSH_FORMAT_VERSION) {
+        return false;
+    }
+    size_t name_len = buf[3];
+    if (name_len > PUSH_TOPIC_MAX || len < 4 + name_len + 10) {
+        return false;
+    }
+    memcpy(out->name, buf + 4, name_len);
+    out->name[name_len] = '\0';
+    const uint8_t *p = buf + 4 + name_len;
+    out->first_seq = get_le32(p);
+    out->dropped = get_le32(p + 4);
+    out->count = get_le16(p + 8);
+    out->samples = p + 10;
+    return len == 4 + name_len + 10 + (size_t)out->count * PUSH_SAMPLE_BYTES;
+}
+
+void push_batch_sample(const push_batch_t *batch, size_t i, push_sample_t *out) {
+    const uint8_t *p = batch->samples + i * PUSH_SAMPLE_BYTES;
+    out->seq = batch->first_seq + (uint32_t)i;
+    out->temperature = (int16_t)get_le16(p);
+    out->humidity = (int16_t)get_le16(p + 2);
+    out->light = (int16_t)get_le16(p + 4);
+    out->fan = p[6];
+    out->flags = p[7];
+}
+
+bool push_config_valid(const push_config_t *config) {
+    if (config->mode >= PUSH_MODE_COUNT) {
+        return false;
+    }
+    if (config->mode == PUSH_OFF) {
+        return true;
+    }
+    // MQTT wildcards are only for subscriptions
+    return config->host[0] != '\0' && config->port != 0 && config->interval_s != 0 &&
+           config->topic[0] != '\0' && strpbrk(config->topic, "+#") == NULL;
+}
+
+void push_sample(const push_sample_t *sample) {
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) {
+        return;
+    }
+    xSemaphoreTake(spool_lock, portMAX_DELAY);
+    if (spool_head - spool_tail == PUSH_SPOOL_LEN) {
+        spool_tail++;
+        stats.dropped++;
+    }
+    spool[spool_head % PUSH_SPOOL_LEN] = *sample;
+    spool_head++;
+    xSemaphoreGive(spool_lock);
+}
+
+static void push_log_target(const push_config_t *config) {
+    if (config->mode == PUSH_OFF) {
+        ESP_LOGI(TAG, "Push off");
+    } else {
+        ESP_LOGI(TAG, "Pushing over %s to %s:%u every %u s", push_mode_names[config->mode],
+                 config->host, config->port, config->interval_s);
+    }
+}
+
+void push_configure(const push_config_t *config) {
+    xSemaphoreTake(spool_lock, portMAX_DELAY);
+    memcpy(&active, config, sizeof(active));
+    if (config->mode == PUSH_OFF) {
+        spool_tail = spool_head;
+    }
+    atomic_store(&enabled, config->mode != PUSH_OFF);
+    xSemaphoreGive(spool_lock);
+    xTaskNotifyGive(push_task_handle);
+    push_log_target(config);
+}
+
+void push_get_stats(push_stats_t *out) {
+    xSemaphoreTake(spool_lock, portMAX_DELAY);
+    *out = stats;
+    out->spooled = spool_head - spool_tail;
+    xSemaphoreGive(spool_lock);
+}
+
+// Transport
+
+typedef struct {
+    int fd;
+    uint8_t mode;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    uint16_t packet_id;
+    const char *topic;
+} push_link_t;
+
+static bool send_all(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool recv_all(int fd, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static uint8_t *put_mqtt_string(uint8_t *p, const char *s, size_t len) {
+    *p++ = (uint8_t)(len >> 8);
+    *p++ = (uint8_t)len;
+    memcpy(p, s, len);
+    return p + len;
+}
+
+// Fixed header: type and the remaining length as a base-128 varint
+static uint8_t *put_mqtt_header(uint8_t *p, uint8_t type, size_t remaining) {
+    *p++ = type;
+    do {
+        uint8_t b = remaining & 0x7F;
+        remaining >>= 7;
+        *p++ = remaining > 0 ? b | 0x80 : b;
+    } while (remaining > 0);
+    return p;
+}
+
+static bool mqtt_connect(push_link_t *link) {
+    // "desk-" and the topic, with '/' made readable in broker logs
+    char client[PUSH_MQTT_CLIENT_MAX + 1];
+    int len = snprintf(client, sizeof(client), "desk-%s", link->topic);
+    len = len < (int)sizeof(client) ? len : (int)sizeof(client) - 1;
+    for (char *c = client; *c != '\0'; c++) {
+        if (*c == '/') {
+            *c = '-';
+        }
+    }
+
+    uint8_t body[10 + 2 + PUSH_MQTT_CLIENT_MAX];
+    uint8_t *b = put_mqtt_string(body, "MQTT", 4);
+    *b++ = 4;           // Protocol level 3.1.1
+    *b++ = 0x02;        // Clean session, no will, no credentials
+    *b++ = 0;
+    *b++ = PUSH_MQTT_KEEPALIVE_S;
+    b = put_mqtt_string(b, client, len);
+    uint8_t *p = put_mqtt_header(packet, MQTT_CONNECT, b - body);
+    memcpy(p, body, b - body);
+    p += b - body;
+
+    uint8_t ack[4];
+    if (!send_all(link->fd, packet, p - packet) || !recv_all(link->fd, ack, sizeof(ack))) {
+        return false;
+    }
+    if (ack[0] != MQTT_CONNACK || ack[1] != 2 || ack[3] != 0) {
+        ESP_LOGW(TAG, "Broker refused the connection (code %u)", ack[3]);
+        return false;
+    }
+    return true;
+}
+
+static bool link_open(push_link_t *link, const push_config_t *config) {
+    link->mode = config->mode;
+    link->topic = config->topic;
+    link->packet_id = 0;
+    int type = config->mode == PUSH_MQTT ? SOCK_STREAM : SOCK_DGRAM;
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = type };
+    struct addrinfo *res = NULL;
+    char port[6];
+    snprintf(port, sizeof(port), "%u", config->port);
+    if (getaddrinfo(config->host, port, &hints, &res) != 0 || res == NULL) {
+        return false;
+    }
+    memcpy(&link->addr, res->ai_addr, res->ai_addrlen);
+    link->addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    link->fd = socket(link->addr.ss_family, type, 0);
+    if (link->fd < 0) {
+        return false;
+    }
+    struct timeval timeout = {
+        .tv_sec = PUSH_IO_TIMEOUT_MS / 1000,
+        .tv_usec = PUSH_IO_TIMEOUT_MS % 1000 * 1000,
+    };
+    setsockopt(link->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(link->fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (config->mode == PUSH_MQTT &&
+        (connect(link->fd, (struct sockaddr *)&link->addr, link->addr_len) != 0 || !mqtt_connect(link))) {
+        close(link->fd);
+        return false;
+    }
+    return true;
+}
+
+// true once the batch is delivered as far as the transport can tell
+static bool link_send(push_link_t *link, const uint8_t *buf, size_t len) {
+    if (link->mode == PUSH_UDP) {
+        return sendto(link->fd, buf, len, 0, (struct sockaddr *)&link->addr, link->addr_len) == (ssize_t)len;
+    }
+    size_t topic_len = strlen(link->topic);
+    link->packet_id = link->packet_id == 0xFFFF ? 1 : link->packet_id + 1;
+    uint8_t *p = put_mqtt_header(packet, MQTT_PUBLISH_QOS1, 2 + topic_len + 2 + len);
+    p = put_mqtt_string(p, link->topic, topic_len);
+    *p++ = (uint8_t)(link->packet_id >> 8);
+    *p++ = (uint8_t)link->packet_id;
+    memcpy(p, buf, len);
+    p += len;
+
+    uint8_t ack[4];
+    if (!send_all(link->fd, packet, p - packet) || !recv_all(link->fd, ack, sizeof(ack))) {
+        return false;
+    }
+    return ack[0] == MQTT_PUBACK && ack[1] == 2 && (ack[2] << 8 | ack[3]) == link->packet_id;
+}
+
+static void link_close(push_link_t *link) {
+    if (link->mode == PUSH_MQTT) {
+        const uint8_t disconnect[] = { MQTT_DISCONNECT, 0 };
+        send_all(link->fd, disconnect, sizeof(disconnect));
+    }
+    close(link->fd);
+}
+
+// Send everything spooled. Returns false if a step failed; what was not
+// delivered stays spooled for the next burst.
+static bool push_burst(const push_config_t *config) {
+    xSemaphoreTake(spool_lock, portMAX_DELAY);
+    bool pending = spool_head != spool_tail;
+    xSemaphoreGive(spool_lock);
+    if (!pending) {
+        return true;
+    }
+
+    push_link_t link;
+    if (!link_open(&link, config)) {
+        return false;
+    }
+    bool ok = true;
+    while (ok) {
+        xSemaphoreTake(spool_lock, portMAX_DELAY);
+        uint32_t start = spool_tail;
+        size_t n = spool_head - spool_tail;
+        n = n < PUSH_BATCH_MAX ? n : PUSH_BATCH_MAX;
+        for (size_t i = 0; i < n; i++) {
+            batch[i] = spool[(start + i) % PUSH_SPOOL_LEN];
+        }
+        uint32_t dropped = stats.dropped;
+        xSemaphoreGive(spool_lock);
+        if (n == 0) {
+            break;
+        }
+
+        size_t used;
+        size_t len = push_encode(config->topic, dropped, batch, n, payload, &used);
+        ok = link_send(&link, payload, len);
+        if (ok) {
+            xSemaphoreTake(spool_lock, portMAX_DELAY);
+            // The spool may have dropped some of these while they were sent
+            if ((int32_t)(start + used - spool_tail) > 0) {
+                spool_tail = start + used;
+            }
+            stats.samples += used;
+            stats.batches++;
+            xSemaphoreGive(spool_lock);
+        }
+    }
+    link_close(&link);
+    return ok;
+}
+
+static void push_task(void *pvParameters) {
+    bool failing = false;
+    while (1) {
+        push_config_t config;
+        xSemaphoreTake(spool_lock, portMAX_DELAY);
+        memcpy(&config, &active, sizeof(config));
+        xSemaphoreGive(spool_lock);
+
+        // A new config restarts the wait with the new interval
+        TickType_t wait = config.mode == PUSH_OFF ? portMAX_DELAY : pdMS_TO_TICKS(config.interval_s * 1000);
+        if (ulTaskNotifyTake(pdTRUE, wait) > 0) {
+            failing = false;
+            continue;
+        }
+
+        bool ok = push_burst(&config);
+        if (!ok) {
+            xSemaphoreTake(spool_lock, portMAX_DELAY);
+            stats.errors++;
+            xSemaphoreGive(spool_lock);
+        }
+        if (!ok && !failing) {
+            ESP_LOGW(TAG, "Push to %s:%u failed, spooling samples", config.host, config.port);
+        } else if (ok && failing) {
+            ESP_LOGI(TAG, "Push to %s:%u delivered again", config.host, config.port);
+        }
+        failing = !ok;
+    }
+}
+
+esp_err_t push_init(const push_config_t *config) {
+    spool_lock = xSemaphoreCreateMutex();
+    if (spool_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(&active, config, sizeof(active));
+    atomic_store(&enabled, config->mode != PUSH_OFF);
+    if (xTaskCreate(push_task, "push", PUSH_TASK_STACK, NULL, PUSH_TASK_PRIORITY, &push_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Cannot start the push task");
+        return ESP_ERR_NO_MEM;
+    }
+    if (config->mode != PUSH_OFF) {
+        push_log_target(config);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+// Batched push telemetry.
+//
+// With push enabled, sensor_task hands every sample to push_sample(), which
+// appends it to a bounded spool in RAM and returns. The push task wakes
+// once per interval, encodes what is spooled into compact binary batches
+// and sends them in one burst: UDP datagrams, or MQTT QoS 1 publishes over
+// a connection that lasts only for the burst. Between bursts nothing needs
+// the radio, so WiFi power save is turned on while push is enabled and the
+// modem sleeps between beacons (see hal_wifi_set_power_save()).
+//
+// Samples leave the spool only once delivered: a datagram the stack
+// accepted, a publish the broker acknowledged. While the link or the
+// receiver is down they accumulate; with PUSH_SPOOL_LEN waiting, each new
+// sample drops the oldest and counts it.
+//
+// Batch format, little-endian, at most PUSH_PAYLOAD_MAX bytes:
+//   "DK"           magic
+//   u8             PUSH_FORMAT_VERSION
+//   u8 n, n bytes  desk name (the configured topic)
+//   u32            seq of the first sample; the others follow one apart
+//   u32            samples dropped from the spool since boot
+//   u16            sample count
+//   8 bytes each   i16 temperature, i16 humidity, i16 light (deci-units),
+//                  u8 fan duty, u8 flags (PUSH_FLAG_*)
+// A minute of samples is 504 bytes with a 10-character name, against
+// about 1.5 KB for the same minute from /data.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define PUSH_SPOOL_LEN          600     // Samples held while undelivered (10 min)
+#define PUSH_BATCH_MAX          120     // Samples per datagram or publish
+#define PUSH_HOST_MAX           63
+#define PUSH_TOPIC_MAX          63
+#define PUSH_FORMAT_VERSION     1
+#define PUSH_HEADER_MAX         (4 + PUSH_TOPIC_MAX + 10)
+#define PUSH_SAMPLE_BYTES       8
+#define PUSH_PAYLOAD_MAX        (PUSH_HEADER_MAX + PUSH_BATCH_MAX * PUSH_SAMPLE_BYTES)
+
+#define PUSH_FLAG_MOTION        0x01
+#define PUSH_FLAG_SESSION       0x02
+#define PUSH_FLAG_ANOMALY       0x04    // A channel's statistics flagged the sample (envstats.h)
+
+typedef enum {
+    PUSH_OFF,
+    PUSH_UDP,
+    PUSH_MQTT,
+    PUSH_MODE_COUNT,
+} push_mode_t;
+
+// Names as used in /config
+extern const char *const push_mode_names[PUSH_MODE_COUNT];
+
+typedef struct {
+    uint8_t mode;                       // push_mode_t
+    uint16_t port;
+    uint16_t interval_s;                // Between bursts
+    char host[PUSH_HOST_MAX + 1];       // Name or address of the broker or collector
+    char topic[PUSH_TOPIC_MAX + 1];     // MQTT topic; also the desk name in every batch
+} push_config_t;
+
+typedef struct {
+    uint32_t seq;
+    int16_t temperature;        // Deci-units
+    int16_t humidity;
+    int16_t light;
+    uint8_t fan;
+    uint8_t flags;
+} push_sample_t;
+
+typedef struct {
+    uint32_t samples;           // Delivered
+    uint32_t batches;
+    uint32_t errors;            // Failed bursts (resolve, connect, send, no ack)
+    uint32_t dropped;           // Lost to a full spool
+    uint32_t spooled;           // Waiting now
+} push_stats_t;
+
+// A decoded batch; samples points into the buffer it was decoded from
+typedef struct {
+    char name[PUSH_TOPIC_MAX + 1];
+    uint32_t first_seq;
+    uint32_t dropped;
+    uint16_t count;
+    const uint8_t *samples;
+} push_batch_t;
+
+// Start the push task with the boot config
+esp_err_t push_init(const push_config_t *config);
+
+// Apply a changed config; the next burst uses it. Turning push off
+// discards the spool.
+void push_configure(const push_config_t *config);
+
+bool push_config_valid(const push_config_t *config);
+
+// Spool one sample; never blocks on the network. No-op while push is off.
+void push_sample(const push_sample_t *sample);
+
+// Encode samples from the start of the array into one batch at out (at
+// least PUSH_PAYLOAD_MAX bytes). Stops at PUSH_BATCH_MAX or a gap in seq;
+// *used is set to the samples taken. Returns the batch length.
+size_t push_encode(const char *name, uint32_t dropped, const push_sample_t *samples, size_t count,
+                   uint8_t *out, size_t *used);
+
+// false if buf is not a complete batch
+bool push_decode(const uint8_t *buf, size_t len, push_batch_t *out);
+void push_batch_sample(const push_batch_t *batch, size_t i, push_sample_t *out);
+
+void push_get_stats(push_stats_t *out);
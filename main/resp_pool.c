@@ -0,0 +1,57 @@
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "resp_pool.h"
+
+static char buffers[RESP_POOL_BUFFERS][RESP_POOL_BUF_SIZE];
+static QueueHandle_t free_buffers;  // char * to each buffer not lent out
+
+static atomic_uint takes;
+static atomic_uint waits;
+static atomic_uint timeouts;
+static atomic_uint in_use;
+static atomic_uint in_use_max;
+
+esp_err_t resp_pool_init(void) {
+    free_buffers = xQueueCreate(RESP_POOL_BUFFERS, sizeof(char *));
+    if (free_buffers == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < RESP_POOL_BUFFERS; i++) {
+        char *buf = buffers[i];
+        xQueueSend(free_buffers, &buf, 0);
+    }
+    return ESP_OK;
+}
+
+char *resp_pool_take(uint32_t wait_ms) {
+    char *buf;
+    if (xQueueReceive(free_buffers, &buf, 0) != pdTRUE) {
+        atomic_fetch_add(&waits, 1);
+        if (wait_ms == 0 || xQueueReceive(free_buffers, &buf, pdMS_TO_TICKS(wait_ms)) != pdTRUE) {
+            atomic_fetch_add(&timeouts, 1);
+            return NULL;
+        }
+    }
+    atomic_fetch_add(&takes, 1);
+    unsigned n = atomic_fetch_add(&in_use, 1) + 1;
+    unsigned max = atomic_load(&in_use_max);
+    while (n > max && !atomic_compare_exchange_weak(&in_use_max, &max, n)) {
+    }
+    return buf;
+}
+
+void resp_pool_give(char *buf) {
+    atomic_fetch_sub(&in_use, 1);
+    xQueueSend(free_buffers, &buf, 0);
+}
+
+void resp_pool_get_stats(resp_pool_stats_t *out) {
+    *out = (resp_pool_stats_t){
+        .takes = atomic_load(&takes),
+        .waits = atomic_load(&waits),
+        .timeouts = atomic_load(&timeouts),
+        .in_use = atomic_load(&in_use),
+        .in_use_max = atomic_load(&in_use_max),
+    };
+}
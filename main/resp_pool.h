@@ -0,0 +1,35 @@
+#pragma once
+
+// Response buffer pool.
+//
+// The HTTP handlers that assemble a response in RAM (/data, /history,
+// /metrics and the event stream broadcast) borrow one of a few fixed
+// buffers instead of each keeping its own. The buffers are static and the
+// free ones sit in a FreeRTOS queue, so nothing is allocated per request
+// and the heap never sees response traffic. A taker says how long it may
+// wait; when every buffer stays in use for that long it gets NULL and the
+// handler answers 503 with Retry-After, so a burst of clients costs
+// latency instead of memory.
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define RESP_POOL_BUFFERS   2
+#define RESP_POOL_BUF_SIZE  1536    // Largest user: a /metrics chunk
+
+typedef struct {
+    uint32_t takes;
+    uint32_t waits;         // Takes that found the pool empty and blocked
+    uint32_t timeouts;      // Takes that gave up
+    uint32_t in_use;
+    uint32_t in_use_max;
+} resp_pool_stats_t;
+
+esp_err_t resp_pool_init(void);
+
+// A free buffer of RESP_POOL_BUF_SIZE bytes, or NULL if none came free
+// within wait_ms. Every buffer taken must be given back.
+char *resp_pool_take(uint32_t wait_ms);
+void resp_pool_give(char *buf);
+
+void resp_pool_get_stats(resp_pool_stats_t *out);
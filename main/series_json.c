@@ -0,0 +1,61 @@
+#include "history.h"
+#include "numfmt.h"
+#include "series_json.h"
+
+#define SERIES_BATCH_ROWS   16
+
+enum { SERIES_TEMP, SERIES_HUMID, SERIES_LIGHT, SERIES_MOTION, SERIES_COUNT };
+
+static const char *const series_keys[SERIES_COUNT] = {
+    "\"tempHistory\":[", "],\"humidHistory\":[", "],\"lightHistory\":[", "],\"motionHistory\":[",
+};
+
+static bool series_write(json_stream_t *js, int s, uint32_t first, uint32_t last) {
+    history_row_t rows[SERIES_BATCH_ROWS];
+    for (uint32_t next = first; next <= last;) {
+        uint32_t want = last - next + 1;
+        uint32_t batch_first = next;
+        size_t n = history_read(HISTORY_RES_SECOND, &batch_first, rows,
+                                want < SERIES_BATCH_ROWS ? want : SERIES_BATCH_ROWS);
+        if (n == 0 || batch_first != next) {
+            js->failed = true;  // Overwritten since it was advertised
+            return false;
+        }
+        char *p = json_stream_room(js, SERIES_BATCH_ROWS * SERIES_JSON_VALUE_MAX);
+        if (p == NULL) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (s == SERIES_MOTION) {
+                *p++ = rows[i].motion_pct != 0 ? '1' : '0';
+            } else {
+                p = put_deci(p, rows[i].avg[s]);
+            }
+            *p++ = ',';
+        }
+        json_stream_commit(js, p);
+        next += n;
+    }
+    // Drop the trailing comma of the last element
+    if (last >= first) {
+        json_stream_commit(js, js->p - 1);
+    }
+    return true;
+}
+
+bool series_json_write(json_stream_t *js, uint32_t first, uint32_t last) {
+    for (int s = 0; s < SERIES_COUNT; s++) {
+        if (!json_stream_bytes(js, series_keys[s], strlen(series_keys[s])) ||
+            !series_write(js, s, first, last)) {
+            return false;
+        }
+    }
+    char *p = json_stream_room(js, 32);
+    if (p == NULL) {
+        return false;
+    }
+    p = PUT_LIT(p, "],\"historyCount\":");
+    p = put_u32(p, last >= first ? last - first + 1 : 0);
+    json_stream_commit(js, p);
+    return true;
+}
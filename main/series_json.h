@@ -0,0 +1,26 @@
+#pragma once
+
+// The sample series of /data, streamed from the 1 s history tier.
+//
+// /data carries the tier as four parallel arrays, one per channel plus
+// motion, written one after the other for samples first..last:
+//   "tempHistory":[21.5,...],"humidHistory":[...],"lightHistory":[...],
+//   "motionHistory":[0,1,...],"historyCount":N
+// Rows are copied out of the tier a small batch at a time under its lock,
+// so the series can be as long as the tier and the only buffer is the
+// stream's window.
+//
+// first..last must be rows the tier advertised (history_count) no more
+// than HISTORY_SPARE seconds before the stream ends. A stream that runs
+// longer finds its oldest rows overwritten and fails, rather than send
+// arrays of different lengths; the stream is marked failed with it, so
+// the response is never ended as if it were complete.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "json_stream.h"
+
+// Longest element: "-3276.8,"
+#define SERIES_JSON_VALUE_MAX   8
+
+bool series_json_write(json_stream_t *js, uint32_t first, uint32_t last);
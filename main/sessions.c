@@ -0,0 +1,124 @@
+#include <string.h>
+#include "numfmt.h"
+#include "sessions.h"
+
+void sessions_init(sessions_t *s, bool present) {
+    memset(s, 0, sizeof(*s));
+    s->present = present;
+}
+
+static void period_close(sessions_t *s) {
+    uint32_t length = s->now_s - s->period_start_s;
+    s->log[s->completed % SESSIONS_LOG_LEN] = (session_period_t){
+        .start_s = s->period_start_s,
+        .length_s = length,
+        .focus = s->present,
+    };
+    s->completed++;
+    if (s->present) {
+        s->sessions++;
+        if (length > s->longest_s) {
+            s->longest_s = length;
+        }
+    } else {
+        s->breaks++;
+        s->break_total_s += length;
+    }
+}
+
+void sessions_tick(sessions_t *s, bool present) {
+    if (present != s->present) {
+        period_close(s);
+        s->present = present;
+        s->period_start_s = s->now_s;
+    }
+
+    // Seconds tick one at a time, so a new day is always the next one
+    uint32_t day = s->now_s / SESSIONS_DAY_S;
+    if (day != s->day) {
+        s->day = day;
+        s->day_focused_s[day % SESSIONS_DAYS] = 0;
+    }
+    uint32_t hour = s->now_s / 3600 % SESSIONS_HOURS;
+    s->hour_total_s[hour]++;
+    if (present) {
+        s->hour_present_s[hour]++;
+        s->day_focused_s[day % SESSIONS_DAYS]++;
+        s->focused_s++;
+    }
+    s->now_s++;
+}
+
+bool sessions_period(const sessions_t *s, uint32_t n, session_period_t *out) {
+    uint32_t held = s->completed < SESSIONS_LOG_LEN ? s->completed : SESSIONS_LOG_LEN;
+    if (n >= held) {
+        return false;
+    }
+    *out = s->log[(s->completed - 1 - n) % SESSIONS_LOG_LEN];
+    return true;
+}
+
+char *sessions_put_json(char *p, const sessions_t *s) {
+    uint32_t running_s = s->now_s - s->period_start_s;
+    uint32_t longest = s->present && running_s > s->longest_s ? running_s : s->longest_s;
+
+    p = PUT_LIT(p, "{\"uptime\":");
+    p = put_u32(p, s->now_s);
+    p = PUT_LIT(p, ",\"present\":");
+    p = put_bool(p, s->present);
+    p = PUT_LIT(p, ",\"periodStart\":");
+    p = put_u32(p, s->period_start_s);
+    p = PUT_LIT(p, ",\"periodSeconds\":");
+    p = put_u32(p, running_s);
+    p = PUT_LIT(p, ",\"sessions\":");
+    p = put_u32(p, s->sessions);
+    p = PUT_LIT(p, ",\"longestSession\":");
+    p = put_u32(p, longest);
+    p = PUT_LIT(p, ",\"breaks\":");
+    p = put_u32(p, s->breaks);
+    p = PUT_LIT(p, ",\"meanBreak\":");
+    p = put_u32(p, s->breaks > 0 ? (uint32_t)((s->break_total_s + s->breaks / 2) / s->breaks) : 0);
+    p = PUT_LIT(p, ",\"focusedSeconds\":");
+    p = put_u64(p, s->focused_s);
+    p = PUT_LIT(p, ",\"day\":");
+    p = put_u32(p, s->day);
+
+    // Oldest day first, today last
+    uint32_t days = s->day + 1 < SESSIONS_DAYS ? s->day + 1 : SESSIONS_DAYS;
+    p = PUT_LIT(p, ",\"dayFocused\":[");
+    for (uint32_t d = s->day + 1 - days; d <= s->day; d++) {
+        p = put_u32(p, s->day_focused_s[d % SESSIONS_DAYS]);
+        *p++ = d < s->day ? ',' : ']';
+    }
+
+    // Per mille of each hour spent at the desk; null for hours not yet seen
+    p = PUT_LIT(p, ",\"hourPresence\":[");
+    for (int h = 0; h < SESSIONS_HOURS; h++) {
+        uint32_t total = s->hour_total_s[h];
+        if (total == 0) {
+            p = PUT_LIT(p, "null");
+        } else {
+            p = put_u32(p, (uint32_t)(((uint64_t)s->hour_present_s[h] * 1000 + total / 2) / total));
+        }
+        *p++ = h + 1 < SESSIONS_HOURS ? ',' : ']';
+    }
+
+    // Completed periods, oldest first
+    p = PUT_LIT(p, ",\"columns\":[\"start\",\"seconds\",\"focus\"],\"periods\":[");
+    session_period_t period;
+    for (uint32_t n = SESSIONS_LOG_LEN; n-- > 0;) {
+        if (!sessions_period(s, n, &period)) {
+            continue;
+        }
+        *p++ = '[';
+        p = put_u32(p, period.start_s);
+        *p++ = ',';
+        p = put_u32(p, period.length_s);
+        p = period.focus ? PUT_LIT(p, ",1]") : PUT_LIT(p, ",0]");
+        if (n > 0) {
+            *p++ = ',';
+        }
+    }
+    p = PUT_LIT(p, "]}");
+    return p;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// Study-session analytics.
+//
+// Fed once per sample with whether the desk counts as occupied (the
+// decision logic's session clock is running), the engine splits time into
+// alternating periods: a session runs from the first second at the desk to
+// the buzzer, a break from the buzzer to the return. Completed periods go
+// into a log of the last SESSIONS_LOG_LEN, and every aggregate /sessions
+// reports is kept up to date as the seconds arrive, so a tick is a handful
+// of additions and rendering never rescans history:
+//   - focused seconds per day for the last SESSIONS_DAYS days
+//   - the longest session and the mean break
+//   - the share of each hour of the day spent at the desk
+//
+// Like the history tiers, days and hours are counted in samples from boot
+// (the desk has no wall clock): day 0 is the first 86400 samples, and hour
+// h of every day is the h-th hour after a multiple of 24 h of uptime.
+//
+// Pure computation on caller state, so it runs unchanged on the host
+// (bench_sessions). Callers that read it from another task serialize
+// access themselves.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SESSIONS_LOG_LEN    32
+#define SESSIONS_DAYS       7
+#define SESSIONS_DAY_S      86400
+#define SESSIONS_HOURS      24
+
+// Longest sessions_put_json() output
+#define SESSIONS_JSON_MAX   (384 + SESSIONS_DAYS * 11 + SESSIONS_HOURS * 5 + SESSIONS_LOG_LEN * 26)
+
+typedef struct {
+    uint32_t start_s;           // Sample count from boot at its first second
+    uint32_t length_s;
+    bool focus;                 // A session; otherwise a break
+} session_period_t;
+
+typedef struct {
+    uint32_t now_s;             // Seconds ticked so far
+    bool present;               // Kind of the running period
+    uint32_t period_start_s;
+
+    session_period_t log[SESSIONS_LOG_LEN];     // Ring, indexed by completed % LEN
+    uint32_t completed;         // Periods closed since boot
+
+    uint32_t sessions;          // Completed sessions...
+    uint32_t longest_s;         // ...and the longest of them
+    uint32_t breaks;            // Completed breaks...
+    uint64_t break_total_s;     // ...and their total length
+    uint64_t focused_s;         // Every second at the desk, running session included
+
+    uint32_t day;               // Current day from boot
+    uint32_t day_focused_s[SESSIONS_DAYS];      // Ring, indexed by day % DAYS
+    uint32_t hour_present_s[SESSIONS_HOURS];
+    uint32_t hour_total_s[SESSIONS_HOURS];
+} sessions_t;
+
+// Start at second 0 with a session running if present
+void sessions_init(sessions_t *s, bool present);
+
+// One sample period: present is the occupancy for the second now ending
+void sessions_tick(sessions_t *s, bool present);
+
+// Completed periods, newest first: n = 0 is the last one closed. False once
+// n reaches the number held.
+bool sessions_period(const sessions_t *s, uint32_t n, session_period_t *out);
+
+// The /sessions body, at most SESSIONS_JSON_MAX bytes
+char *sessions_put_json(char *p, const sessions_t *s);
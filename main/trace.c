@@ -0,0 +1,250 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "trace.h"
+
+// Ring with absolute head/tail byte counters, under the lock
+static SemaphoreHandle_t lock;
+static atomic_bool running;
+static uint8_t ring[TRACE_BUF_LEN];
+static uint32_t head;
+static uint32_t tail;
+static trace_codec_t codec;
+static uint32_t lost;
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint8_t *put_zigzag(uint8_t *p, int64_t v) {
+    return put_varint(p, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static const uint8_t *get_zigzag(const uint8_t *p, const uint8_t *end, int64_t *v) {
+    uint64_t u;
+    p = get_varint(p, end, &u);
+    *v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    return p;
+}
+
+void trace_codec_init(trace_codec_t *c, const trace_header_t *header) {
+    *c = (trace_codec_t){ .time_us = header->start_us };
+}
+
+size_t trace_encode_header(const trace_header_t *header, uint8_t out[TRACE_HEADER_LEN]) {
+    memcpy(out, "DKTR", 4);
+    out[4] = TRACE_FORMAT_VERSION;
+    out[5] = header->pir_level;
+    out[6] = (uint8_t)header->zero_mv;
+    out[7] = (uint8_t)(header->zero_mv >> 8);
+    out[8] = (uint8_t)header->full_mv;
+    out[9] = (uint8_t)(header->full_mv >> 8);
+    for (int i = 0; i < 8; i++) {
+        out[10 + i] = (uint8_t)((uint64_t)header->start_us >> (8 * i));
+    }
+    return TRACE_HEADER_LEN;
+}
+
+bool trace_decode_header(const uint8_t *buf, size_t len, trace_header_t *out) {
+    if (len < TRACE_HEADER_LEN || memcmp(buf, "DKTR", 4) != 0 || buf[4] != TRACE_FORMAT_VERSION) {
+        return false;
+    }
+    uint64_t start = 0;
+    for (int i = 0; i < 8; i++) {
+        start |= (uint64_t)buf[10 + i] << (8 * i);
+    }
+    *out = (trace_header_t){
+        .pir_level = buf[5] != 0,
+        .zero_mv = (uint16_t)(buf[6] | buf[7] << 8),
+        .full_mv = (uint16_t)(buf[8] | buf[9] << 8),
+        .start_us = (int64_t)start,
+    };
+    return out->full_mv > out->zero_mv;
+}
+
+size_t trace_encode(trace_codec_t *c, const trace_record_t *rec, uint8_t out[TRACE_RECORD_MAX]) {
+    uint8_t *p = out;
+    *p++ = rec->type;
+    p = put_zigzag(p, rec->time_us - c->time_us);
+    c->time_us = rec->time_us;
+    switch (rec->type) {
+    case TRACE_DHT:
+        memcpy(p, rec->frame, 5);
+        p += 5;
+        break;
+    case TRACE_LDR:
+        p = put_zigzag(p, (int64_t)rec->raw - c->raw);
+        p = put_zigzag(p, (int64_t)rec->mv - c->mv);
+        c->raw = rec->raw;
+        c->mv = rec->mv;
+        break;
+    case TRACE_LOST:
+        p = put_varint(p, rec->lost);
+        break;
+    }
+    return p - out;
+}
+
+size_t trace_decode(trace_codec_t *c, const uint8_t *buf, size_t len, trace_record_t *out) {
+    const uint8_t *end = buf + len;
+    const uint8_t *p = buf;
+    if (len == 0 || *p < TRACE_DHT || *p > TRACE_LOST) {
+        return 0;
+    }
+    out->type = *p++;
+    int64_t dt;
+    if ((p = get_zigzag(p, end, &dt)) == NULL) {
+        return 0;
+    }
+    int64_t draw, dmv;
+    uint64_t count;
+    switch (out->type) {
+    case TRACE_DHT:
+        if (end - p < 5) {
+            return 0;
+        }
+        memcpy(out->frame, p, 5);
+        p += 5;
+        break;
+    case TRACE_LDR:
+        if ((p = get_zigzag(p, end, &draw)) == NULL || (p = get_zigzag(p, end, &dmv)) == NULL) {
+            return 0;
+        }
+        c->raw = (uint16_t)(c->raw + draw);
+        c->mv = (uint32_t)(c->mv + dmv);
+        out->raw = c->raw;
+        out->mv = c->mv;
+        break;
+    case TRACE_LOST:
+        if ((p = get_varint(p, end, &count)) == NULL) {
+            return 0;
+        }
+        out->lost = (uint32_t)count;
+        break;
+    }
+    c->time_us += dt;
+    out->time_us = c->time_us;
+    return p - buf;
+}
+
+esp_err_t trace_init(void) {
+    lock = xSemaphoreCreateMutex();
+    return lock != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// Copy bytes in at the head; the caller checked they fit
+static void ring_put(const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        ring[(head + i) % TRACE_BUF_LEN] = buf[i];
+    }
+    head += len;
+}
+
+void trace_start(const trace_header_t *header) {
+    uint8_t buf[TRACE_HEADER_LEN];
+    trace_encode_header(header, buf);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    head = tail = 0;
+    lost = 0;
+    trace_codec_init(&codec, header);
+    ring_put(buf, sizeof(buf));
+    atomic_store(&running, true);
+    xSemaphoreGive(lock);
+}
+
+void trace_stop(void) {
+    atomic_store(&running, false);
+}
+
+bool trace_running(void) {
+    return atomic_load_explicit(&running, memory_order_relaxed);
+}
+
+// Encode against a copy of the delta state and commit it only if the
+// record fits, so a dropped record leaves the stream consistent
+static void trace_append(const trace_record_t *rec) {
+    uint8_t buf[2 * TRACE_RECORD_MAX];
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (atomic_load(&running)) {
+        trace_codec_t next = codec;
+        size_t len = 0;
+        if (lost > 0) {
+            const trace_record_t note = { .type = TRACE_LOST, .time_us = rec->time_us, .lost = lost };
+            len = trace_encode(&next, &note, buf);
+        }
+        len += trace_encode(&next, rec, buf + len);
+        if (TRACE_BUF_LEN - (head - tail) >= len) {
+            ring_put(buf, len);
+            codec = next;
+            lost = 0;
+        } else {
+            lost++;
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+void trace_dht(int64_t time_us, bool captured, const uint8_t frame[5]) {
+    if (!trace_running()) {
+        return;
+    }
+    trace_record_t rec = { .type = captured ? TRACE_DHT : TRACE_DHT_FAIL, .time_us = time_us };
+    memcpy(rec.frame, frame, 5);
+    trace_append(&rec);
+}
+
+void trace_ldr(int64_t time_us, uint16_t raw, uint32_t mv) {
+    if (!trace_running()) {
+        return;
+    }
+    const trace_record_t rec = { .type = TRACE_LDR, .time_us = time_us, .raw = raw, .mv = mv };
+    trace_append(&rec);
+}
+
+void trace_pir(int64_t time_us, bool level) {
+    if (!trace_running()) {
+        return;
+    }
+    const trace_record_t rec = { .type = level ? TRACE_PIR_HIGH : TRACE_PIR_LOW, .time_us = time_us };
+    trace_append(&rec);
+}
+
+void trace_sample(int64_t time_us) {
+    if (!trace_running()) {
+        return;
+    }
+    const trace_record_t rec = { .type = TRACE_SAMPLE, .time_us = time_us };
+    trace_append(&rec);
+}
+
+size_t trace_read(uint8_t *out, size_t max) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t n = head - tail;
+    if (n > max) {
+        n = max;
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ring[(tail + i) % TRACE_BUF_LEN];
+    }
+    tail += n;
+    xSemaphoreGive(lock);
+    return n;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// Sensor trace recording.
+//
+// While a recording runs, every input the decision logic (desk_logic.h)
+// sees is appended to a RAM ring as compact binary records: DHT22 frames as
+// captured, before checksum and conversion; filtered LDR counts with their
+// calibrated voltage; PIR edges before the debounce; and the instants
+// sensor_task sampled at. GET /trace drains the ring, and host/replay.c runs
+// the logic over the file on a virtual clock. The 20 kHz ADC conversions
+// themselves are not recorded: the CIC decimator in front of the logic is
+// deterministic, so its 10 Hz output is where the trace starts.
+//
+// When the ring is full a record is dropped, and a TRACE_LOST record with
+// the count goes in ahead of the next one that fits. Producers check one
+// atomic flag while no recording runs.
+//
+// Format, little-endian:
+//   header, TRACE_HEADER_LEN bytes
+//     "DKTR"   magic
+//     u8       TRACE_FORMAT_VERSION
+//     u8       PIR level when the recording started
+//     u16      LDR voltage at zero scale, mV
+//     u16      LDR voltage at full scale, mV
+//     i64      esp_timer time of the start, us
+//   records
+//     u8       trace_type_t
+//     varint   us since the previous record, zigzag (producers on different
+//              tasks may append slightly out of order)
+//     payload  TRACE_DHT:  the 5 frame bytes
+//              TRACE_LDR:  count and mV as zigzag varint deltas from the
+//                          previous TRACE_LDR
+//              TRACE_LOST: varint count of dropped records
+//              others:     none
+// LDR readings dominate: about 6 bytes each, 5 MB for a 24 h recording.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define TRACE_BUF_LEN           4096    // Ring between drains, about a minute
+#define TRACE_FORMAT_VERSION    1
+#define TRACE_HEADER_LEN        18
+#define TRACE_RECORD_MAX        24      // Longest encoded record
+
+typedef enum {
+    TRACE_DHT = 1,          // A frame was captured (the checksum may be bad)
+    TRACE_DHT_FAIL,         // No response or bad pulse timing
+    TRACE_LDR,
+    TRACE_PIR_LOW,
+    TRACE_PIR_HIGH,
+    TRACE_SAMPLE,           // sensor_task's once-per-second sample
+    TRACE_LOST,
+} trace_type_t;
+
+typedef struct {
+    bool pir_level;
+    uint16_t zero_mv;
+    uint16_t full_mv;
+    int64_t start_us;
+} trace_header_t;
+
+typedef struct {
+    uint8_t type;           // trace_type_t
+    int64_t time_us;
+    uint8_t frame[5];       // TRACE_DHT
+    uint16_t raw;           // TRACE_LDR
+    uint32_t mv;            // TRACE_LDR
+    uint32_t lost;          // TRACE_LOST
+} trace_record_t;
+
+// Delta state shared by the encoder and the decoder; start both from
+// trace_codec_init() with the header
+typedef struct {
+    int64_t time_us;
+    uint16_t raw;
+    uint32_t mv;
+} trace_codec_t;
+
+// Create the recorder's lock; call once at boot
+esp_err_t trace_init(void);
+
+// Start a recording, discarding anything not yet read. The header is the
+// first thing trace_read() returns.
+void trace_start(const trace_header_t *header);
+
+// Stop appending; what is buffered can still be read
+void trace_stop(void);
+bool trace_running(void);
+
+// Producers: no-ops unless a recording runs
+void trace_dht(int64_t time_us, bool captured, const uint8_t frame[5]);
+void trace_ldr(int64_t time_us, uint16_t raw, uint32_t mv);
+void trace_pir(int64_t time_us, bool level);
+void trace_sample(int64_t time_us);
+
+// Move up to max buffered bytes to out; returns how many
+size_t trace_read(uint8_t *out, size_t max);
+
+// Pure encoding and decoding, shared with the host tools
+void trace_codec_init(trace_codec_t *codec, const trace_header_t *header);
+size_t trace_encode_header(const trace_header_t *header, uint8_t out[TRACE_HEADER_LEN]);
+size_t trace_encode(trace_codec_t *codec, const trace_record_t *rec, uint8_t out[TRACE_RECORD_MAX]);
+bool trace_decode_header(const uint8_t *buf, size_t len, trace_header_t *out);
+
+// Decode one record; returns the bytes it took, 0 if buf holds no complete,
+// valid record
+size_t trace_decode(trace_codec_t *codec, const uint8_t *buf, size_t len, trace_record_t *out);
@@ -0,0 +1,141 @@
+// Minimal canvas charts for the dashboard.
+//
+// Implements the small part of the Chart.js API the page uses: `new Chart(
+// canvas, {type, data: {labels, datasets: [dataset]}, options})` with a
+// single line or bar dataset, a hidden x axis, an optional zero-based y axis
+// and `chart.update()`. Bundled with the firmware so the dashboard works on
+// networks without internet access.
+(function () {
+  'use strict';
+
+  const TICKS = 5;
+  const MAX_HEIGHT = 300;
+
+  function niceStep(range) {
+    const raw = range / TICKS;
+    const mag = Math.pow(10, Math.floor(Math.log10(raw)));
+    const norm = raw / mag;
+    return (norm <= 1 ? 1 : norm <= 2 ? 2 : norm <= 5 ? 5 : 10) * mag;
+  }
+
+  // Path through the samples; when smoothed, curves run through segment
+  // midpoints with the samples as control points
+  function tracePath(ctx, values, xOf, yOf, smooth) {
+    ctx.beginPath();
+    values.forEach((v, i) => {
+      const x = xOf(i);
+      const y = yOf(v);
+      if (i === 0) {
+        ctx.moveTo(x, y);
+      } else if (smooth) {
+        const px = xOf(i - 1);
+        const py = yOf(values[i - 1]);
+        ctx.quadraticCurveTo(px, py, (px + x) / 2, (py + y) / 2);
+        if (i === values.length - 1) {
+          ctx.lineTo(x, y);
+        }
+      } else {
+        ctx.lineTo(x, y);
+      }
+    });
+  }
+
+  function Chart(canvas, config) {
+    this.canvas = canvas;
+    this.ctx = canvas.getContext('2d');
+    this.type = config.type;
+    this.data = config.data;
+    this.options = config.options || {};
+    window.addEventListener('resize', () => this.update());
+    this.update();
+  }
+
+  // Match the backing store to the laid-out size (2:1, capped like the CSS)
+  Chart.prototype.resize = function () {
+    const ratio = window.devicePixelRatio || 1;
+    const width = this.canvas.parentNode.clientWidth -
+      parseFloat(getComputedStyle(this.canvas.parentNode).paddingLeft) * 2;
+    const height = Math.min(Math.round(width / 2), MAX_HEIGHT);
+    if (this.canvas.width !== Math.round(width * ratio) || this.canvas.height !== Math.round(height * ratio)) {
+      this.canvas.width = Math.round(width * ratio);
+      this.canvas.height = Math.round(height * ratio);
+      this.canvas.style.width = width + 'px';
+      this.canvas.style.height = height + 'px';
+    }
+    this.ctx.setTransform(ratio, 0, 0, ratio, 0, 0);
+    return { width: width, height: height };
+  };
+
+  Chart.prototype.update = function () {
+    const size = this.resize();
+    const ctx = this.ctx;
+    const dataset = this.data.datasets[0];
+    const values = dataset.data;
+    const yOpts = (this.options.scales && this.options.scales.y) || {};
+    ctx.clearRect(0, 0, size.width, size.height);
+
+    let min = Infinity;
+    let max = -Infinity;
+    values.forEach(v => { min = Math.min(min, v); max = Math.max(max, v); });
+    if (!values.length) { min = 0; max = 1; }
+    if (yOpts.beginAtZero) { min = Math.min(min, 0); max = Math.max(max, 0); }
+    if (max === min) { max = min + 1; }
+    const step = niceStep(max - min);
+    min = Math.floor(min / step) * step;
+    max = Math.ceil(max / step) * step;
+    const decimals = step < 1 ? 1 : 0;
+
+    const left = 40;
+    const right = size.width - 8;
+    const top = 8;
+    const bottom = size.height - 8;
+    const yOf = v => bottom - (v - min) / (max - min) * (bottom - top);
+
+    // Horizontal grid with y labels
+    ctx.font = '11px sans-serif';
+    ctx.textAlign = 'right';
+    ctx.textBaseline = 'middle';
+    ctx.lineWidth = 1;
+    ctx.strokeStyle = 'rgba(0,0,0,0.1)';
+    ctx.fillStyle = '#666';
+    for (let v = min; v <= max + step / 2; v += step) {
+      const y = Math.round(yOf(v)) + 0.5;
+      ctx.beginPath();
+      ctx.moveTo(left, y);
+      ctx.lineTo(right, y);
+      ctx.stroke();
+      ctx.fillText(v.toFixed(decimals), left - 6, y);
+    }
+
+    const n = values.length;
+    if (!n) {
+      return;
+    }
+    const base = yOf(Math.max(min, Math.min(0, max)));
+    if (this.type === 'bar') {
+      const slot = (right - left) / n;
+      ctx.fillStyle = dataset.backgroundColor;
+      values.forEach((v, i) => {
+        const y = yOf(v);
+        ctx.fillRect(left + i * slot + slot * 0.1, Math.min(y, base), slot * 0.8, Math.abs(base - y));
+      });
+      return;
+    }
+
+    const xOf = i => n === 1 ? (left + right) / 2 : left + i * (right - left) / (n - 1);
+    if (dataset.fill) {
+      tracePath(ctx, values, xOf, yOf, dataset.tension > 0);
+      ctx.lineTo(xOf(n - 1), base);
+      ctx.lineTo(xOf(0), base);
+      ctx.closePath();
+      ctx.fillStyle = dataset.backgroundColor;
+      ctx.fill();
+    }
+    tracePath(ctx, values, xOf, yOf, dataset.tension > 0);
+    ctx.strokeStyle = dataset.borderColor;
+    ctx.lineWidth = 2;
+    ctx.stroke();
+  };
+
+  window.Chart = Chart;
+})();
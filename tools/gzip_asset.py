@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+"""Gzip a dashboard asset for embedding in the firmware.
+
+The output is reproducible (no file name or timestamp in the gzip header),
+so the ETag the firmware derives from it only changes with the content.
+
+usage: gzip_asset.py <input> <output>
+"""
+import gzip
+import sys
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    with open(sys.argv[1], 'rb') as f:
+        data = f.read()
+    with open(sys.argv[2], 'wb') as out:
+        with gzip.GzipFile(filename='', mode='wb', fileobj=out, compresslevel=9, mtime=0) as gz:
+            gz.write(data)
+
+
+if __name__ == '__main__':
+    main()